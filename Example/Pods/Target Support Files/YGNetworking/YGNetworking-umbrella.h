@@ -10,11 +10,24 @@
 #endif
 #endif
 
+#import "YGCache.h"
 #import "YGCenter.h"
+#import "YGCircuitBreaker.h"
+#import "YGConcurrencyLimiter.h"
 #import "YGConst.h"
+#import "YGDownloadResumeStore.h"
 #import "YGEngine.h"
+#import "YGHedgingPolicy.h"
+#import "YGJSONStreamParser.h"
+#import "YGLock.h"
+#import "YGModelMapper.h"
 #import "YGNetworking.h"
+#import "YGOfflineQueue.h"
+#import "YGRecordReplayTransport.h"
 #import "YGRequest.h"
+#import "YGRequestMetrics.h"
+#import "YGRetryPolicy.h"
+#import "YGUploadResumeStore.h"
 
 FOUNDATION_EXPORT double YGNetworkingVersionNumber;
 FOUNDATION_EXPORT const unsigned char YGNetworkingVersionString[];
@@ -0,0 +1,105 @@
+//
+//  YGBenchmark.h
+//  YGNetworking_Tests
+//
+//  Created by Sun on 2020/4/27.
+//  Copyright © 2020 oneofai. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class YGBenchmarkServer;
+
+/**
+ 基准测试驱动的客户端类型枚举.
+ */
+typedef NS_ENUM(NSInteger, YGBenchmarkClient) {
+    kYGBenchmarkClientYGCenter              = 0,    //!< `+[YGCenter sendRequest:onFinished:]`，响应体不解码 (`kYGResponseSerializerRAW`).
+    kYGBenchmarkClientAFURLSessionManager   = 1,    //!< 直接使用 `AFURLSessionManager`，响应序列化为 `AFHTTPResponseSerializer`.
+    kYGBenchmarkClientNSURLSession          = 2,    //!< 直接使用 `NSURLSession`.
+};
+
+/**
+ 一次基准测试的配置.
+ */
+@interface YGBenchmarkConfiguration : NSObject
+
+@property (nonatomic, assign) YGBenchmarkClient client;
+
+/**
+ 同时在途的请求数，默认为 `8`.
+ */
+@property (nonatomic, assign) NSUInteger concurrency;
+
+/**
+ 响应体长度(字节)，默认为 `1024`.
+ */
+@property (nonatomic, assign) NSUInteger payloadLength;
+
+/**
+ 计入结果的请求数，默认为 `2000`.
+ */
+@property (nonatomic, assign) NSUInteger requestCount;
+
+/**
+ 正式测量前预热的请求数，用来建立连接和填充缓存，默认为 `100`.
+ */
+@property (nonatomic, assign) NSUInteger warmupCount;
+
++ (NSString *)nameForClient:(YGBenchmarkClient)client;
+
+@end
+
+/**
+ 一次基准测试的结果.
+ */
+@interface YGBenchmarkResult : NSObject
+
+@property (nonatomic, strong, readonly) YGBenchmarkConfiguration *configuration;
+@property (nonatomic, assign, readonly) NSTimeInterval duration;            //!< 测量阶段的总耗时(秒).
+@property (nonatomic, assign, readonly) double throughput;                  //!< 每秒完成的请求数.
+@property (nonatomic, assign, readonly) NSTimeInterval p50Latency;          //!< 延迟(秒)的 p50.
+@property (nonatomic, assign, readonly) NSTimeInterval p99Latency;          //!< 延迟(秒)的 p99.
+@property (nonatomic, assign, readonly) NSTimeInterval p999Latency;         //!< 延迟(秒)的 p99.9.
+@property (nonatomic, assign, readonly) double allocationsPerRequest;       //!< 每个请求在客户端线程上的内存分配次数.
+@property (nonatomic, assign, readonly) NSTimeInterval cpuTimePerRequest;   //!< 每个请求消耗的客户端 CPU 时间(秒)，不包括服务器线程.
+@property (nonatomic, assign, readonly) NSUInteger failureCount;            //!< 失败的请求数.
+
+/**
+ 可以序列化为 JSON 的字典，时间单位为微秒，便于和之前的结果对比.
+ */
+- (NSDictionary<NSString *, id> *)dictionaryRepresentation;
+
+@end
+
+/**
+ `YGBenchmark` 通过本地服务器测量 YGCenter、YGEngine 和 AFNetworking 相对于 `NSURLSession` 增加的开销.
+ 
+ 每次测量以固定的并发数持续发送请求 (闭环)，记录每个请求的延迟、测量期间的内存分配次数和进程 CPU 时间.
+ NOTE: 分配次数通过 `malloc_logger` 统计，只在 DEBUG 或测试环境中使用; 服务器线程上的分配和 CPU 时间会被排除.
+ */
+@interface YGBenchmark : NSObject
+
+- (instancetype)initWithServer:(YGBenchmarkServer *)server NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ 同步执行一次基准测试，不能在主线程调用.
+ */
+- (YGBenchmarkResult *)runWithConfiguration:(YGBenchmarkConfiguration *)configuration;
+
+/**
+ 将结果写入 JSON 文件，文件中包含设备和系统版本，便于在不同提交之间对比.
+
+ @param results 基准测试的结果.
+ @param path 文件路径.
+ @param error 写入失败时返回的错误.
+ @return 写入成功时返回 `YES`.
+ */
++ (BOOL)writeResults:(NSArray<YGBenchmarkResult *> *)results toFile:(NSString *)path error:(NSError * _Nullable __autoreleasing *)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,277 @@
+//
+//  YGBenchmark.m
+//  YGNetworking_Tests
+//
+//  Created by Sun on 2020/4/27.
+//  Copyright © 2020 oneofai. All rights reserved.
+//
+
+#import "YGBenchmark.h"
+#import "YGBenchmarkServer.h"
+#import <YGNetworking/YGNetworking.h>
+#import <AFNetworking/AFURLSessionManager.h>
+#import <stdatomic.h>
+#import <sys/resource.h>
+#import <sys/utsname.h>
+
+#pragma mark - Allocation Counter
+
+// `malloc_logger` is exported by libmalloc and called for every allocation while it is set.
+typedef void (YGMallocLogger)(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t numHotFramesToSkip);
+extern YGMallocLogger *malloc_logger;
+
+static const uint32_t YGMallocLogTypeAllocate = 2;
+static _Atomic(uint64_t) YGAllocationCount;
+
+static void YGCountingMallocLogger(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t numHotFramesToSkip) {
+    if ((type & YGMallocLogTypeAllocate) && !YGBenchmarkServerIsCurrentThread()) {
+        atomic_fetch_add_explicit(&YGAllocationCount, 1, memory_order_relaxed);
+    }
+}
+
+static NSTimeInterval YGProcessCPUTime(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / (double)USEC_PER_SEC;
+}
+
+/**
+ 最近秩法的分位数，`latencies` 必须已经排序.
+ */
+static NSTimeInterval YGPercentile(const NSTimeInterval *latencies, NSUInteger count, double percentile) {
+    if (count == 0) return 0;
+    NSUInteger rank = (NSUInteger)ceil(percentile * count);
+    return latencies[MIN(MAX(rank, 1), count) - 1];
+}
+
+static int YGCompareLatency(const void *a, const void *b) {
+    NSTimeInterval lhs = *(const NSTimeInterval *)a;
+    NSTimeInterval rhs = *(const NSTimeInterval *)b;
+    return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+}
+
+#pragma mark - YGBenchmarkConfiguration
+
+@implementation YGBenchmarkConfiguration
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _client = kYGBenchmarkClientYGCenter;
+    _concurrency = 8;
+    _payloadLength = 1024;
+    _requestCount = 2000;
+    _warmupCount = 100;
+    
+    return self;
+}
+
++ (NSString *)nameForClient:(YGBenchmarkClient)client {
+    switch (client) {
+        case kYGBenchmarkClientYGCenter:
+            return @"YGCenter";
+        case kYGBenchmarkClientAFURLSessionManager:
+            return @"AFURLSessionManager";
+        case kYGBenchmarkClientNSURLSession:
+            return @"NSURLSession";
+    }
+    return @"Unknown";
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"%@ concurrency: %lu, payload: %lu bytes, requests: %lu", [[self class] nameForClient:self.client], (unsigned long)self.concurrency, (unsigned long)self.payloadLength, (unsigned long)self.requestCount];
+}
+
+@end
+
+#pragma mark - YGBenchmarkResult
+
+@implementation YGBenchmarkResult
+
+- (NSDictionary<NSString *, id> *)dictionaryRepresentation {
+    return @{@"client": [YGBenchmarkConfiguration nameForClient:self.configuration.client],
+             @"concurrency": @(self.configuration.concurrency),
+             @"payload_bytes": @(self.configuration.payloadLength),
+             @"requests": @(self.configuration.requestCount),
+             @"failures": @(self.failureCount),
+             @"duration_us": @(self.duration * USEC_PER_SEC),
+             @"throughput_rps": @(self.throughput),
+             @"p50_us": @(self.p50Latency * USEC_PER_SEC),
+             @"p99_us": @(self.p99Latency * USEC_PER_SEC),
+             @"p999_us": @(self.p999Latency * USEC_PER_SEC),
+             @"allocations_per_request": @(self.allocationsPerRequest),
+             @"cpu_us_per_request": @(self.cpuTimePerRequest * USEC_PER_SEC)};
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"%@ => %.0f req/s, p50: %.1fus, p99: %.1fus, p999: %.1fus, %.1f allocs/req, %.1fus cpu/req, %lu failures", self.configuration, self.throughput, self.p50Latency * USEC_PER_SEC, self.p99Latency * USEC_PER_SEC, self.p999Latency * USEC_PER_SEC, self.allocationsPerRequest, self.cpuTimePerRequest * USEC_PER_SEC, (unsigned long)self.failureCount];
+}
+
+@end
+
+#pragma mark - YGBenchmark
+
+@interface YGBenchmark ()
+
+@property (nonatomic, strong) YGBenchmarkServer *server;
+@property (nonatomic, strong) AFURLSessionManager *sessionManager;
+@property (nonatomic, strong) NSURLSession *session;
+
+@end
+
+@implementation YGBenchmark
+
+- (instancetype)initWithServer:(YGBenchmarkServer *)server {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _server = server;
+    // the same session configuration as YGEngine, so only the client stack differs.
+    _sessionManager = [[AFURLSessionManager alloc] initWithSessionConfiguration:nil];
+    _sessionManager.responseSerializer = [AFHTTPResponseSerializer serializer];
+    _session = [NSURLSession sessionWithConfiguration:[NSURLSessionConfiguration defaultSessionConfiguration]];
+    
+    return self;
+}
+
+- (void)dealloc {
+    [_sessionManager invalidateSessionCancelingTasks:YES resetSession:NO];
+    [_session invalidateAndCancel];
+}
+
+#pragma mark - Public Methods
+
+- (YGBenchmarkResult *)runWithConfiguration:(YGBenchmarkConfiguration *)configuration {
+    NSAssert(![NSThread isMainThread], @"The benchmark blocks the calling thread, YGCenter may call back on the main queue.");
+    
+    NSURL *URL = [self.server URLWithPayloadLength:configuration.payloadLength];
+    [self yg_sendRequestCount:configuration.warmupCount concurrency:configuration.concurrency URL:URL client:configuration.client latencies:NULL];
+    
+    NSUInteger requestCount = configuration.requestCount;
+    NSTimeInterval *latencies = calloc(MAX(requestCount, 1), sizeof(NSTimeInterval));
+    
+    NSTimeInterval serverCPUTime = self.server.serverCPUTime;
+    NSTimeInterval processCPUTime = YGProcessCPUTime();
+    atomic_store(&YGAllocationCount, 0);
+    malloc_logger = YGCountingMallocLogger;
+    NSTimeInterval startTimestamp = [NSProcessInfo processInfo].systemUptime;
+    
+    NSUInteger failureCount = [self yg_sendRequestCount:requestCount concurrency:configuration.concurrency URL:URL client:configuration.client latencies:latencies];
+    
+    NSTimeInterval duration = [NSProcessInfo processInfo].systemUptime - startTimestamp;
+    malloc_logger = NULL;
+    uint64_t allocationCount = atomic_load(&YGAllocationCount);
+    NSTimeInterval clientCPUTime = (YGProcessCPUTime() - processCPUTime) - (self.server.serverCPUTime - serverCPUTime);
+    
+    qsort(latencies, requestCount, sizeof(NSTimeInterval), YGCompareLatency);
+    
+    YGBenchmarkResult *result = [[YGBenchmarkResult alloc] init];
+    [result setValue:configuration forKey:@"_configuration"];
+    [result setValue:@(duration) forKey:@"_duration"];
+    [result setValue:@(duration > 0 ? requestCount / duration : 0) forKey:@"_throughput"];
+    [result setValue:@(YGPercentile(latencies, requestCount, 0.5)) forKey:@"_p50Latency"];
+    [result setValue:@(YGPercentile(latencies, requestCount, 0.99)) forKey:@"_p99Latency"];
+    [result setValue:@(YGPercentile(latencies, requestCount, 0.999)) forKey:@"_p999Latency"];
+    [result setValue:@(requestCount > 0 ? (double)allocationCount / requestCount : 0) forKey:@"_allocationsPerRequest"];
+    [result setValue:@(requestCount > 0 ? MAX(clientCPUTime, 0) / requestCount : 0) forKey:@"_cpuTimePerRequest"];
+    [result setValue:@(failureCount) forKey:@"_failureCount"];
+    free(latencies);
+    
+    return result;
+}
+
++ (BOOL)writeResults:(NSArray<YGBenchmarkResult *> *)results toFile:(NSString *)path error:(NSError *__autoreleasing *)error {
+    struct utsname systemInfo;
+    uname(&systemInfo);
+    
+    NSMutableArray *resultDictionaries = [NSMutableArray arrayWithCapacity:results.count];
+    for (YGBenchmarkResult *result in results) {
+        [resultDictionaries addObject:[result dictionaryRepresentation]];
+    }
+    NSDictionary *report = @{@"device": @(systemInfo.machine),
+                             @"system_version": [NSProcessInfo processInfo].operatingSystemVersionString,
+                             @"timestamp": @([[NSDate date] timeIntervalSince1970]),
+                             @"results": resultDictionaries};
+    
+    NSData *data = [NSJSONSerialization dataWithJSONObject:report options:NSJSONWritingPrettyPrinted error:error];
+    return data && [data writeToFile:path options:NSDataWritingAtomic error:error];
+}
+
+#pragma mark - Private Methods
+
+/**
+ 以固定并发数发送请求并等待全部完成，返回失败的请求数.
+
+ @param latencies 记录每个请求延迟的数组，为 `NULL` 时不记录.
+ */
+- (NSUInteger)yg_sendRequestCount:(NSUInteger)requestCount
+                      concurrency:(NSUInteger)concurrency
+                              URL:(NSURL *)URL
+                           client:(YGBenchmarkClient)client
+                        latencies:(NSTimeInterval *)latencies {
+    dispatch_semaphore_t slots = dispatch_semaphore_create(MAX(concurrency, 1));
+    dispatch_group_t group = dispatch_group_create();
+    _Atomic(NSUInteger) *failureCount = calloc(1, sizeof(_Atomic(NSUInteger)));
+    
+    for (NSUInteger i = 0; i < requestCount; i++) {
+        dispatch_semaphore_wait(slots, DISPATCH_TIME_FOREVER);
+        dispatch_group_enter(group);
+        NSTimeInterval startTimestamp = [NSProcessInfo processInfo].systemUptime;
+        [self yg_sendRequestWithURL:URL client:client completion:^(BOOL success) {
+            if (latencies) {
+                latencies[i] = [NSProcessInfo processInfo].systemUptime - startTimestamp;
+            }
+            if (!success) {
+                atomic_fetch_add(failureCount, 1);
+            }
+            dispatch_semaphore_signal(slots);
+            dispatch_group_leave(group);
+        }];
+    }
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    
+    NSUInteger count = atomic_load(failureCount);
+    free(failureCount);
+    return count;
+}
+
+- (void)yg_sendRequestWithURL:(NSURL *)URL client:(YGBenchmarkClient)client completion:(void (^)(BOOL success))completion {
+    switch (client) {
+        case kYGBenchmarkClientYGCenter: {
+            [YGCenter sendRequest:^(YGRequest *request) {
+                request.url = URL.absoluteString;
+                request.useGeneralServer = NO;
+                request.useGeneralHeaders = NO;
+                request.useGeneralParameters = NO;
+                request.responseSerializerType = kYGResponseSerializerRAW;
+            } onFinished:^(id responseObject, NSError *error) {
+                completion(error == nil);
+            }];
+            break;
+        }
+        case kYGBenchmarkClientAFURLSessionManager: {
+            NSURLSessionDataTask *task = [self.sessionManager dataTaskWithRequest:[NSURLRequest requestWithURL:URL]
+                                                                   uploadProgress:nil
+                                                                 downloadProgress:nil
+                                                                completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
+                completion(error == nil);
+            }];
+            [task resume];
+            break;
+        }
+        case kYGBenchmarkClientNSURLSession: {
+            NSURLSessionDataTask *task = [self.session dataTaskWithURL:URL completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+                completion(error == nil && [(NSHTTPURLResponse *)response statusCode] == 200);
+            }];
+            [task resume];
+            break;
+        }
+    }
+}
+
+@end
@@ -0,0 +1,201 @@
+//
+//  YGBenchmarkServer.h
+//  YGNetworking_Tests
+//
+//  Created by Sun on 2020/4/27.
+//  Copyright © 2020 oneofai. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `YGBenchmarkServer` 记录的一个请求.
+ */
+@interface YGBenchmarkServerRequest : NSObject
+
+/**
+ 请求的 HTTP 方法.
+ */
+@property (nonatomic, copy, readonly) NSString *method;
+
+/**
+ 请求的路径，不包含查询参数.
+ */
+@property (nonatomic, copy, readonly) NSString *path;
+
+/**
+ 请求头，key 为小写.
+ */
+@property (nonatomic, copy, readonly) NSDictionary<NSString *, NSString *> *headers;
+
+/**
+ 请求体的长度.
+ */
+@property (nonatomic, assign, readonly) NSUInteger bodyLength;
+
+/**
+ 服务器返回的状态码.
+ */
+@property (nonatomic, assign, readonly) NSInteger statusCode;
+
+@end
+
+/**
+ `YGBenchmarkServer` 是基准测试使用的本地 HTTP/1.1 服务器，监听 `127.0.0.1` 的随机端口，支持 keep-alive.
+
+ 没有设置文件资源和上传路径的请求都返回 `200` 和一个 JSON 响应体，响应体长度由查询参数 `length` 决定，例如 `GET /?length=16384`.
+ 文件资源 (`-setFileData:forPath:`) 支持 Range/If-Range，上传路径 (`-enableUploadsAtPath:`) 支持 tus 1.0 的可续传上传，
+ 它们的请求会被记录 (`requests`)，用于测试 YGEngine 的断点下载、分段下载和可续传上传.
+ NOTE: 服务器和被测客户端运行在同一个进程中，服务器处理请求的 CPU 时间单独统计 (`serverCPUTime`)，
+ 服务器线程上的内存分配不计入 `YGBenchmark` 的分配次数.
+ */
+@interface YGBenchmarkServer : NSObject
+
+/**
+ 启动服务器.
+
+ @param error 创建或绑定 socket 失败时返回的错误.
+ @return 启动成功时返回 `YES`.
+ */
+- (BOOL)start:(NSError * _Nullable __autoreleasing *)error;
+
+/**
+ 停止服务器并关闭所有连接.
+ */
+- (void)stop;
+
+/**
+ 服务器监听的端口，启动前为 `0`.
+ */
+@property (nonatomic, assign, readonly) uint16_t port;
+
+/**
+ 返回指定响应体长度的请求地址.
+ */
+- (NSURL *)URLWithPayloadLength:(NSUInteger)payloadLength;
+
+/**
+ 返回指定路径的请求地址.
+ */
+- (NSURL *)URLForPath:(NSString *)path;
+
+/**
+ 服务器线程处理请求累计消耗的 CPU 时间(秒).
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval serverCPUTime;
+
+/**
+ 服务器已经处理的请求数.
+ */
+@property (nonatomic, assign, readonly) NSUInteger handledRequestCount;
+
+///---------------------
+/// @name 文件资源
+///---------------------
+
+/**
+ 在 `path` 上提供文件资源，支持 GET 和 HEAD，响应带有 `ETag` 和 `Accept-Ranges: bytes`.
+ 请求带有单个字节范围的 `Range` (`bytes=a-b` 或 `bytes=a-`) 时返回 `206` 和对应的部分，`If-Range` 与 ETag 不一致时返回 `200` 和完整的文件.
+ NOTE: 每次设置都会生成新的 ETag，用于模拟服务器上的文件被修改.
+
+ @return 文件资源的地址.
+ */
+- (NSURL *)setFileData:(NSData *)data forPath:(NSString *)path;
+
+/**
+ 文件资源当前的 ETag，不存在时返回 `nil`.
+ */
+- (nullable NSString *)entityTagForPath:(NSString *)path;
+
+/**
+ 文件资源是否支持 Range 请求，默认为 `YES`. 为 `NO` 时不返回 `Accept-Ranges` 并忽略 `Range`，总是返回 `200` 和完整的文件.
+ */
+@property (atomic, assign) BOOL rangeRequestsEnabled;
+
+/**
+ 文件资源的响应体每发送 `responseChunkLength` 字节后暂停的时间(秒)，默认为 `0` (不限速)，用于在下载中途取消.
+ */
+@property (atomic, assign) NSTimeInterval responseChunkDelay;
+
+/**
+ 限速时每次发送的字节数，默认为 `64KB`.
+ */
+@property (atomic, assign) NSUInteger responseChunkLength;
+
+/**
+ 接下来的 `count` 个带有 `Range` 的文件资源请求返回 `statusCode` (例如 `503`) 和空的响应体.
+ */
+- (void)failNextRangeRequests:(NSUInteger)count statusCode:(NSInteger)statusCode;
+
+/**
+ 接下来的 `count` 个 `206` 响应只发送请求范围的前一半，`Content-Range` 不变，用于模拟不完整的分段.
+ */
+- (void)truncateNextRangeResponses:(NSUInteger)count;
+
+///---------------------
+/// @name 可续传上传
+///---------------------
+
+/**
+ 在 `path` 上提供 tus 1.0 的可续传上传.
+
+ - POST `path` (需要 `Upload-Length`): 创建上传，返回 `201` 和 `Location: <path>/<n>`.
+ - HEAD 上传地址: 返回 `200` 和服务器已经接收的 `Upload-Offset`.
+ - PATCH 上传地址: `Upload-Offset` 与服务器的偏移量不一致时返回 `409`，否则追加请求体并返回 `204` 和新的 `Upload-Offset`，
+   接收完整个文件的 PATCH 返回 `200` 和 JSON 响应体 `{"id": "<n>", "length": <Upload-Length>}`.
+
+ 不存在的上传返回 `404`，被 `-expireUploads` 标记过期的上传返回 `410`.
+
+ @return 创建上传的地址.
+ */
+- (NSURL *)enableUploadsAtPath:(NSString *)path;
+
+/**
+ 在服务器上直接创建一个已经接收了 `data` 的上传，模拟上次运行中断的上传. 需要先调用 `-enableUploadsAtPath:`.
+
+ @param length 上传文件的总长度.
+ @param data 服务器已经接收的内容.
+ @return 上传地址.
+ */
+- (NSURL *)createUploadWithLength:(long long)length data:(NSData *)data;
+
+/**
+ 上传地址已经接收的内容，不存在时返回 `nil`.
+ */
+- (nullable NSData *)uploadDataForURL:(NSURL *)URL;
+
+/**
+ 把当前所有的上传标记为过期，之后对它们的请求返回 `410`.
+ */
+- (void)expireUploads;
+
+/**
+ 接下来的 `count` 个 PATCH 请求返回 `409`，不接收请求体，用于模拟客户端和服务器的偏移量不一致.
+ */
+- (void)failNextUploadPatchesWithConflict:(NSUInteger)count;
+
+///---------------------
+/// @name 请求记录
+///---------------------
+
+/**
+ 文件资源和上传路径收到的请求，按收到的顺序排列.
+ */
+@property (nonatomic, copy, readonly) NSArray<YGBenchmarkServerRequest *> *requests;
+
+/**
+ 删除请求记录.
+ */
+- (void)removeAllRequests;
+
+@end
+
+/**
+ 当前线程是否是服务器的线程，`YGBenchmark` 通过它排除服务器的内存分配.
+ NOTE: 这个函数会在 malloc 中调用，不能分配内存.
+ */
+FOUNDATION_EXPORT BOOL YGBenchmarkServerIsCurrentThread(void);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,737 @@
+//
+//  YGBenchmarkServer.m
+//  YGNetworking_Tests
+//
+//  Created by Sun on 2020/4/27.
+//  Copyright © 2020 oneofai. All rights reserved.
+//
+
+#import "YGBenchmarkServer.h"
+#import <YGNetworking/YGNetworking.h>
+#import <arpa/inet.h>
+#import <mach/mach.h>
+#import <netinet/in.h>
+#import <netinet/tcp.h>
+#import <pthread.h>
+#import <stdatomic.h>
+#import <sys/socket.h>
+
+static const size_t YGBenchmarkRequestBufferLength = 16 * 1024;
+
+/// 测试请求的请求体可以超过初始的缓冲区，缓冲区最多扩大到这个长度.
+static const size_t YGBenchmarkRequestMaximumLength = 64 * 1024 * 1024;
+
+static pthread_key_t YGBenchmarkServerThreadKey;
+static BOOL YGBenchmarkServerThreadKeyCreated = NO;
+
+BOOL YGBenchmarkServerIsCurrentThread(void) {
+    return YGBenchmarkServerThreadKeyCreated && pthread_getspecific(YGBenchmarkServerThreadKey) != NULL;
+}
+
+static uint64_t YGCurrentThreadCPUTimeNanoseconds(void) {
+    mach_port_t thread = mach_thread_self();
+    thread_basic_info_data_t info;
+    mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+    kern_return_t result = thread_info(thread, THREAD_BASIC_INFO, (thread_info_t)&info, &count);
+    mach_port_deallocate(mach_task_self(), thread);
+    if (result != KERN_SUCCESS) return 0;
+    
+    uint64_t seconds = (uint64_t)info.user_time.seconds + (uint64_t)info.system_time.seconds;
+    uint64_t microseconds = (uint64_t)info.user_time.microseconds + (uint64_t)info.system_time.microseconds;
+    return seconds * NSEC_PER_SEC + microseconds * NSEC_PER_USEC;
+}
+
+static BOOL YGSendAll(int fd, const void *bytes, size_t length) {
+    const uint8_t *cursor = bytes;
+    while (length > 0) {
+        ssize_t sent = send(fd, cursor, length, 0);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return NO;
+        cursor += sent;
+        length -= (size_t)sent;
+    }
+    return YES;
+}
+
+/**
+ 从请求行中解析 `length` 查询参数，例如 `GET /?length=16384 HTTP/1.1`.
+ */
+static NSUInteger YGPayloadLengthFromRequestLine(const char *line, size_t lineLength) {
+    const char *key = "length=";
+    size_t keyLength = strlen(key);
+    const char *lineEnd = line + lineLength;
+    const char *target = memchr(line, ' ', lineLength);
+    const char *targetEnd = target ? memchr(target + 1, ' ', (size_t)(lineEnd - target - 1)) : NULL;
+    if (!target || !targetEnd) return 0;
+    
+    const char *query = memchr(target, '?', (size_t)(targetEnd - target));
+    for (const char *cursor = query; cursor && cursor + keyLength <= targetEnd; cursor++) {
+        if (memcmp(cursor, key, keyLength) == 0) {
+            return (NSUInteger)strtoull(cursor + keyLength, NULL, 10);
+        }
+    }
+    return 0;
+}
+
+/**
+ 从请求头中解析 `Content-Length`，请求体会被读取后丢弃.
+ */
+static size_t YGContentLengthFromHeader(const char *header, size_t headerLength) {
+    const char *key = "\r\ncontent-length:";
+    size_t keyLength = strlen(key);
+    for (size_t i = 0; i + keyLength <= headerLength; i++) {
+        if (strncasecmp(header + i, key, keyLength) == 0) {
+            return (size_t)strtoull(header + i + keyLength, NULL, 10);
+        }
+    }
+    return 0;
+}
+
+/**
+ 返回状态码对应的原因短语.
+ */
+static NSString * YGReasonPhraseForStatusCode(NSInteger statusCode) {
+    switch (statusCode) {
+        case 200: return @"OK";
+        case 201: return @"Created";
+        case 204: return @"No Content";
+        case 206: return @"Partial Content";
+        case 400: return @"Bad Request";
+        case 404: return @"Not Found";
+        case 405: return @"Method Not Allowed";
+        case 409: return @"Conflict";
+        case 410: return @"Gone";
+        case 416: return @"Range Not Satisfiable";
+        case 503: return @"Service Unavailable";
+        default: return @"Unknown";
+    }
+}
+
+/**
+ 解析单个字节范围 `bytes=a-b` 或 `bytes=a-`，`length` 为文件长度. 格式不支持时返回 `NO`.
+ */
+static BOOL YGByteRangeFromHeader(NSString *header, NSUInteger length, NSRange *range) {
+    NSScanner *scanner = [NSScanner scannerWithString:header];
+    long long start = 0;
+    long long end = (long long)length - 1;
+    if (![scanner scanString:@"bytes=" intoString:NULL] || ![scanner scanLongLong:&start] || ![scanner scanString:@"-" intoString:NULL]) {
+        return NO;
+    }
+    if (!scanner.isAtEnd && (![scanner scanLongLong:&end] || !scanner.isAtEnd)) {
+        return NO;
+    }
+    end = MIN(end, (long long)length - 1);
+    if (start < 0 || start > end) {
+        *range = NSMakeRange(NSNotFound, 0);
+    } else {
+        *range = NSMakeRange((NSUInteger)start, (NSUInteger)(end - start + 1));
+    }
+    return YES;
+}
+
+#pragma mark - YGBenchmarkServerRequest
+
+@interface YGBenchmarkServerRequest ()
+
+@property (nonatomic, copy, readwrite) NSString *method;
+@property (nonatomic, copy, readwrite) NSString *path;
+@property (nonatomic, copy, readwrite) NSDictionary<NSString *, NSString *> *headers;
+@property (nonatomic, assign, readwrite) NSUInteger bodyLength;
+@property (nonatomic, assign, readwrite) NSInteger statusCode;
+
+@end
+
+@implementation YGBenchmarkServerRequest
+
+/**
+ 解析请求行和请求头，请求头的 key 转为小写.
+ */
++ (instancetype)requestWithHeader:(const char *)header length:(size_t)headerLength {
+    NSString *string = [[NSString alloc] initWithBytes:header length:headerLength encoding:NSISOLatin1StringEncoding];
+    NSArray<NSString *> *lines = [string componentsSeparatedByString:@"\r\n"];
+    NSArray<NSString *> *requestLine = [lines.firstObject componentsSeparatedByString:@" "];
+    if (requestLine.count < 3) return nil;
+    
+    NSMutableDictionary<NSString *, NSString *> *headers = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 1; i < lines.count; i++) {
+        NSRange separator = [lines[i] rangeOfString:@":"];
+        if (separator.location == NSNotFound) continue;
+        NSString *field = [lines[i] substringToIndex:separator.location].lowercaseString;
+        NSString *value = [[lines[i] substringFromIndex:separator.location + 1] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+        headers[field] = value;
+    }
+    
+    YGBenchmarkServerRequest *request = [[self alloc] init];
+    request.method = requestLine[0];
+    request.path = [requestLine[1] componentsSeparatedByString:@"?"].firstObject;
+    request.headers = headers;
+    return request;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %p> %@ %@ %ld %@", [self class], self, self.method, self.path, (long)self.statusCode, self.headers];
+}
+
+@end
+
+#pragma mark - YGBenchmarkServerFile
+
+/**
+ 服务器提供的文件资源.
+ */
+@interface YGBenchmarkServerFile : NSObject
+
+@property (nonatomic, copy) NSData *data;
+@property (nonatomic, copy) NSString *entityTag;
+
+@end
+
+@implementation YGBenchmarkServerFile
+@end
+
+#pragma mark - YGBenchmarkServerUpload
+
+/**
+ 服务器上的一个 tus 上传.
+ */
+@interface YGBenchmarkServerUpload : NSObject
+
+@property (nonatomic, assign) long long length;
+@property (nonatomic, strong) NSMutableData *data;
+@property (nonatomic, assign, getter=isExpired) BOOL expired;
+
+@end
+
+@implementation YGBenchmarkServerUpload
+@end
+
+#pragma mark - YGBenchmarkServer
+
+@interface YGBenchmarkServer () {
+    pthread_mutex_t _lock;
+    int _listenSocket;
+    _Atomic(uint64_t) _serverCPUTimeNanoseconds;
+    _Atomic(NSUInteger) _handledRequestCount;
+    _Atomic(BOOL) _routesEnabled;
+}
+
+@property (nonatomic, assign, readwrite) uint16_t port;
+@property (nonatomic, strong) dispatch_source_t acceptSource;
+@property (nonatomic, strong) dispatch_queue_t connectionQueue;
+@property (nonatomic, strong) NSMutableSet<NSNumber *> *connectionSockets;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSData *> *responses;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, YGBenchmarkServerFile *> *files;
+@property (nonatomic, strong) NSMutableArray<YGBenchmarkServerRequest *> *requestLog;
+@property (nonatomic, assign) NSUInteger fileVersion;
+@property (nonatomic, assign) NSUInteger rangeFailureCount;
+@property (nonatomic, assign) NSInteger rangeFailureStatusCode;
+@property (nonatomic, assign) NSUInteger rangeTruncationCount;
+@property (nonatomic, copy) NSString *uploadPath;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, YGBenchmarkServerUpload *> *uploads;
+@property (nonatomic, assign) NSUInteger uploadCount;
+@property (nonatomic, assign) NSUInteger uploadConflictCount;
+
+@end
+
+@implementation YGBenchmarkServer
+
++ (void)initialize {
+    if (self == [YGBenchmarkServer class]) {
+        YGBenchmarkServerThreadKeyCreated = (pthread_key_create(&YGBenchmarkServerThreadKey, NULL) == 0);
+    }
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    YG_NETWORKING_LOCK_INIT();
+    _listenSocket = -1;
+    _connectionQueue = dispatch_queue_create("com.ygnetworking.benchmark.server.connection", DISPATCH_QUEUE_CONCURRENT);
+    _connectionSockets = [NSMutableSet set];
+    _responses = [NSMutableDictionary dictionary];
+    _files = [NSMutableDictionary dictionary];
+    _requestLog = [NSMutableArray array];
+    _uploads = [NSMutableDictionary dictionary];
+    _rangeRequestsEnabled = YES;
+    _responseChunkLength = 64 * 1024;
+    
+    return self;
+}
+
+- (void)dealloc {
+    [self stop];
+    YG_NETWORKING_LOCK_DESTROY();
+}
+
+#pragma mark - Public Methods
+
+- (BOOL)start:(NSError *__autoreleasing *)error {
+    if (_listenSocket >= 0) return YES;
+    
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) {
+        if (error) *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        return NO;
+    }
+    
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_len = sizeof(address);
+    address.sin_family = AF_INET;
+    address.sin_port = 0;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addressLength = sizeof(address);
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(fd, SOMAXCONN) != 0 ||
+        getsockname(fd, (struct sockaddr *)&address, &addressLength) != 0) {
+        if (error) *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        close(fd);
+        return NO;
+    }
+    
+    _listenSocket = fd;
+    self.port = ntohs(address.sin_port);
+    
+    __weak __typeof(self)weakSelf = self;
+    dispatch_source_t acceptSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0));
+    dispatch_source_set_event_handler(acceptSource, ^{
+        [weakSelf yg_acceptConnection];
+    });
+    dispatch_source_set_cancel_handler(acceptSource, ^{
+        close(fd);
+    });
+    self.acceptSource = acceptSource;
+    dispatch_resume(acceptSource);
+    
+    return YES;
+}
+
+- (void)stop {
+    if (self.acceptSource) {
+        dispatch_source_cancel(self.acceptSource);
+        self.acceptSource = nil;
+    }
+    _listenSocket = -1;
+    
+    YG_NETWORKING_LOCK();
+    for (NSNumber *socket in self.connectionSockets) {
+        // unblocks the connection loops, they close their own sockets.
+        shutdown(socket.intValue, SHUT_RDWR);
+    }
+    [self.connectionSockets removeAllObjects];
+    YG_NETWORKING_UNLOCK();
+}
+
+- (NSURL *)URLWithPayloadLength:(NSUInteger)payloadLength {
+    return [NSURL URLWithString:[NSString stringWithFormat:@"http://127.0.0.1:%u/?length=%lu", self.port, (unsigned long)payloadLength]];
+}
+
+- (NSURL *)URLForPath:(NSString *)path {
+    return [NSURL URLWithString:[NSString stringWithFormat:@"http://127.0.0.1:%u%@", self.port, path]];
+}
+
+- (NSTimeInterval)serverCPUTime {
+    return (NSTimeInterval)atomic_load(&_serverCPUTimeNanoseconds) / NSEC_PER_SEC;
+}
+
+- (NSUInteger)handledRequestCount {
+    return atomic_load(&_handledRequestCount);
+}
+
+- (NSURL *)setFileData:(NSData *)data forPath:(NSString *)path {
+    YGBenchmarkServerFile *file = [[YGBenchmarkServerFile alloc] init];
+    file.data = data;
+    YG_NETWORKING_LOCK();
+    file.entityTag = [NSString stringWithFormat:@"\"%lu-%lu\"", (unsigned long)++self.fileVersion, (unsigned long)data.length];
+    self.files[path] = file;
+    YG_NETWORKING_UNLOCK();
+    atomic_store(&_routesEnabled, YES);
+    return [self URLForPath:path];
+}
+
+- (NSString *)entityTagForPath:(NSString *)path {
+    YG_NETWORKING_LOCK();
+    NSString *entityTag = self.files[path].entityTag;
+    YG_NETWORKING_UNLOCK();
+    return entityTag;
+}
+
+- (void)failNextRangeRequests:(NSUInteger)count statusCode:(NSInteger)statusCode {
+    YG_NETWORKING_LOCK();
+    self.rangeFailureCount = count;
+    self.rangeFailureStatusCode = statusCode;
+    YG_NETWORKING_UNLOCK();
+}
+
+- (void)truncateNextRangeResponses:(NSUInteger)count {
+    YG_NETWORKING_LOCK();
+    self.rangeTruncationCount = count;
+    YG_NETWORKING_UNLOCK();
+}
+
+- (NSURL *)enableUploadsAtPath:(NSString *)path {
+    YG_NETWORKING_LOCK();
+    self.uploadPath = path;
+    YG_NETWORKING_UNLOCK();
+    atomic_store(&_routesEnabled, YES);
+    return [self URLForPath:path];
+}
+
+- (NSURL *)createUploadWithLength:(long long)length data:(NSData *)data {
+    return [self URLForPath:[self yg_createUploadWithLength:length data:data]];
+}
+
+- (NSData *)uploadDataForURL:(NSURL *)URL {
+    YG_NETWORKING_LOCK();
+    NSData *data = [self.uploads[URL.lastPathComponent].data copy];
+    YG_NETWORKING_UNLOCK();
+    return data;
+}
+
+- (void)expireUploads {
+    YG_NETWORKING_LOCK();
+    for (YGBenchmarkServerUpload *upload in self.uploads.allValues) {
+        upload.expired = YES;
+    }
+    YG_NETWORKING_UNLOCK();
+}
+
+- (void)failNextUploadPatchesWithConflict:(NSUInteger)count {
+    YG_NETWORKING_LOCK();
+    self.uploadConflictCount = count;
+    YG_NETWORKING_UNLOCK();
+}
+
+- (NSArray<YGBenchmarkServerRequest *> *)requests {
+    YG_NETWORKING_LOCK();
+    NSArray<YGBenchmarkServerRequest *> *requests = [self.requestLog copy];
+    YG_NETWORKING_UNLOCK();
+    return requests;
+}
+
+- (void)removeAllRequests {
+    YG_NETWORKING_LOCK();
+    [self.requestLog removeAllObjects];
+    YG_NETWORKING_UNLOCK();
+}
+
+#pragma mark - Private Methods
+
+- (void)yg_acceptConnection {
+    int fd = accept(_listenSocket, NULL, NULL);
+    if (fd < 0) return;
+    
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &yes, sizeof(yes));
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    
+    YG_NETWORKING_LOCK();
+    [self.connectionSockets addObject:@(fd)];
+    YG_NETWORKING_UNLOCK();
+    
+    dispatch_async(self.connectionQueue, ^{
+        [self yg_serveConnection:fd];
+        
+        YG_NETWORKING_LOCK();
+        [self.connectionSockets removeObject:@(fd)];
+        YG_NETWORKING_UNLOCK();
+        close(fd);
+    });
+}
+
+/**
+ 在连接上循环处理请求直到客户端关闭连接，连接所在的线程在处理期间被标记为服务器线程.
+ */
+- (void)yg_serveConnection:(int)fd {
+    pthread_setspecific(YGBenchmarkServerThreadKey, (__bridge void *)self);
+    
+    size_t bufferLength = YGBenchmarkRequestBufferLength;
+    char *buffer = malloc(bufferLength);
+    size_t bufferedLength = 0;
+    while (YES) {
+        ssize_t received = recv(fd, buffer + bufferedLength, bufferLength - bufferedLength, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) break;
+        bufferedLength += (size_t)received;
+        
+        uint64_t startCPUTime = YGCurrentThreadCPUTimeNanoseconds();
+        BOOL keepAlive = YES;
+        // a pipelined read can hold more than one request.
+        while (keepAlive) {
+            char *headerEnd = memmem(buffer, bufferedLength, "\r\n\r\n", 4);
+            if (!headerEnd) {
+                if (bufferedLength == bufferLength) keepAlive = NO;
+                break;
+            }
+            size_t headerLength = (size_t)(headerEnd - buffer) + 4;
+            size_t bodyLength = YGContentLengthFromHeader(buffer, headerLength);
+            if (headerLength + bodyLength > bufferedLength) {
+                // the benchmark sends small bodies, only the test routes need a larger buffer.
+                if (headerLength + bodyLength > YGBenchmarkRequestMaximumLength) {
+                    keepAlive = NO;
+                } else if (headerLength + bodyLength > bufferLength) {
+                    bufferLength = headerLength + bodyLength;
+                    buffer = realloc(buffer, bufferLength);
+                }
+                break;
+            }
+            
+            BOOL handled = NO;
+            if (atomic_load(&_routesEnabled)) {
+                keepAlive = [self yg_handleRequestWithHeader:buffer length:headerLength body:buffer + headerLength length:bodyLength connection:fd handled:&handled];
+            }
+            if (!handled) {
+                char *lineEnd = memchr(buffer, '\r', headerLength);
+                NSUInteger payloadLength = YGPayloadLengthFromRequestLine(buffer, (size_t)(lineEnd - buffer));
+                NSData *response = [self yg_responseWithPayloadLength:payloadLength];
+                keepAlive = YGSendAll(fd, response.bytes, response.length);
+            }
+            atomic_fetch_add(&_handledRequestCount, 1);
+            
+            size_t consumedLength = headerLength + bodyLength;
+            memmove(buffer, buffer + consumedLength, bufferedLength - consumedLength);
+            bufferedLength -= consumedLength;
+        }
+        atomic_fetch_add(&_serverCPUTimeNanoseconds, YGCurrentThreadCPUTimeNanoseconds() - startCPUTime);
+        if (!keepAlive) break;
+    }
+    free(buffer);
+    
+    pthread_setspecific(YGBenchmarkServerThreadKey, NULL);
+}
+
+/**
+ 处理文件资源和上传路径的请求并记录，请求的路径不是它们时 `handled` 为 `NO`，由基准测试的响应处理.
+
+ @return 连接是否可以继续使用.
+ */
+- (BOOL)yg_handleRequestWithHeader:(const char *)header
+                            length:(size_t)headerLength
+                              body:(const char *)body
+                            length:(size_t)bodyLength
+                        connection:(int)fd
+                           handled:(BOOL *)handled {
+    YGBenchmarkServerRequest *request = [YGBenchmarkServerRequest requestWithHeader:header length:headerLength];
+    YG_NETWORKING_LOCK();
+    YGBenchmarkServerFile *file = request ? self.files[request.path] : nil;
+    NSString *uploadPath = self.uploadPath;
+    YG_NETWORKING_UNLOCK();
+    BOOL isUpload = request && uploadPath && ([request.path isEqualToString:uploadPath] || [request.path hasPrefix:[uploadPath stringByAppendingString:@"/"]]);
+    if (!file && !isUpload) {
+        *handled = NO;
+        return YES;
+    }
+    
+    *handled = YES;
+    request.bodyLength = bodyLength;
+    YG_NETWORKING_LOCK();
+    [self.requestLog addObject:request];
+    YG_NETWORKING_UNLOCK();
+    if (file) {
+        return [self yg_serveFile:file request:request connection:fd];
+    }
+    return [self yg_serveUploadRequest:request body:body uploadPath:uploadPath connection:fd];
+}
+
+/**
+ 返回文件资源，按 `Range` 和 `If-Range` 返回部分或完整的文件.
+ */
+- (BOOL)yg_serveFile:(YGBenchmarkServerFile *)file request:(YGBenchmarkServerRequest *)request connection:(int)fd {
+    if (![request.method isEqualToString:@"GET"] && ![request.method isEqualToString:@"HEAD"]) {
+        return [self yg_sendStatusCode:405 headers:nil body:nil request:request connection:fd];
+    }
+    
+    BOOL rangeRequestsEnabled = self.rangeRequestsEnabled;
+    NSString *rangeHeader = rangeRequestsEnabled ? request.headers[@"range"] : nil;
+    if (rangeHeader) {
+        YG_NETWORKING_LOCK();
+        NSInteger failureStatusCode = self.rangeFailureCount > 0 ? self.rangeFailureStatusCode : 0;
+        if (self.rangeFailureCount > 0) {
+            self.rangeFailureCount--;
+        }
+        YG_NETWORKING_UNLOCK();
+        if (failureStatusCode > 0) {
+            return [self yg_sendStatusCode:failureStatusCode headers:nil body:nil request:request connection:fd];
+        }
+    }
+    
+    NSData *data = file.data;
+    NSMutableDictionary<NSString *, NSString *> *headers = [NSMutableDictionary dictionary];
+    headers[@"ETag"] = file.entityTag;
+    headers[@"Content-Type"] = @"application/octet-stream";
+    if (rangeRequestsEnabled) {
+        headers[@"Accept-Ranges"] = @"bytes";
+    }
+    
+    NSString *ifRange = request.headers[@"if-range"];
+    NSRange range = NSMakeRange(0, data.length);
+    // a changed resource answers with the whole file, like a real server does for a stale If-Range.
+    if (rangeHeader && (!ifRange || [ifRange isEqualToString:file.entityTag]) && YGByteRangeFromHeader(rangeHeader, data.length, &range)) {
+        if (range.location == NSNotFound) {
+            headers[@"Content-Range"] = [NSString stringWithFormat:@"bytes */%lu", (unsigned long)data.length];
+            return [self yg_sendStatusCode:416 headers:headers body:nil request:request connection:fd];
+        }
+        headers[@"Content-Range"] = [NSString stringWithFormat:@"bytes %lu-%lu/%lu", (unsigned long)range.location, (unsigned long)NSMaxRange(range) - 1, (unsigned long)data.length];
+        YG_NETWORKING_LOCK();
+        BOOL truncated = (self.rangeTruncationCount > 0);
+        if (truncated) {
+            self.rangeTruncationCount--;
+        }
+        YG_NETWORKING_UNLOCK();
+        // the Content-Range still claims the whole range, only the body is cut short.
+        if (truncated) {
+            range.length /= 2;
+        }
+        data = [data subdataWithRange:range];
+        return [self yg_sendStatusCode:206 headers:headers body:data request:request connection:fd];
+    }
+    return [self yg_sendStatusCode:200 headers:headers body:data request:request connection:fd];
+}
+
+/**
+ 处理 tus 1.0 的 POST、HEAD 和 PATCH 请求.
+ */
+- (BOOL)yg_serveUploadRequest:(YGBenchmarkServerRequest *)request body:(const char *)body uploadPath:(NSString *)uploadPath connection:(int)fd {
+    NSMutableDictionary<NSString *, NSString *> *headers = [NSMutableDictionary dictionaryWithObject:@"1.0.0" forKey:@"Tus-Resumable"];
+    if ([request.path isEqualToString:uploadPath]) {
+        NSString *uploadLength = request.headers[@"upload-length"];
+        if (![request.method isEqualToString:@"POST"]) {
+            return [self yg_sendStatusCode:405 headers:headers body:nil request:request connection:fd];
+        }
+        if (uploadLength.length == 0) {
+            return [self yg_sendStatusCode:400 headers:headers body:nil request:request connection:fd];
+        }
+        headers[@"Location"] = [self yg_createUploadWithLength:uploadLength.longLongValue data:nil];
+        return [self yg_sendStatusCode:201 headers:headers body:nil request:request connection:fd];
+    }
+    
+    BOOL isHead = [request.method isEqualToString:@"HEAD"];
+    BOOL isPatch = [request.method isEqualToString:@"PATCH"];
+    if (!isHead && !isPatch) {
+        return [self yg_sendStatusCode:405 headers:headers body:nil request:request connection:fd];
+    }
+    
+    NSString *identifier = request.path.lastPathComponent;
+    NSString *offsetString = request.headers[@"upload-offset"];
+    NSInteger statusCode = 200;
+    YG_NETWORKING_LOCK();
+    YGBenchmarkServerUpload *upload = self.uploads[identifier];
+    if (!upload) {
+        statusCode = 404;
+    } else if (upload.isExpired) {
+        statusCode = 410;
+    } else if (isPatch && self.uploadConflictCount > 0) {
+        self.uploadConflictCount--;
+        statusCode = 409;
+    } else if (isPatch && (!offsetString || offsetString.longLongValue != (long long)upload.data.length)) {
+        statusCode = 409;
+    } else if (isPatch) {
+        NSUInteger length = (NSUInteger)MIN((long long)request.bodyLength, upload.length - (long long)upload.data.length);
+        [upload.data appendBytes:body length:length];
+        statusCode = ((long long)upload.data.length >= upload.length) ? 200 : 204;
+    }
+    long long offset = upload.data.length;
+    long long length = upload.length;
+    YG_NETWORKING_UNLOCK();
+    
+    if (statusCode != 200 && statusCode != 204) {
+        return [self yg_sendStatusCode:statusCode headers:headers body:nil request:request connection:fd];
+    }
+    headers[@"Upload-Offset"] = [NSString stringWithFormat:@"%lld", offset];
+    NSData *responseBody = nil;
+    if (isHead) {
+        headers[@"Upload-Length"] = [NSString stringWithFormat:@"%lld", length];
+    } else if (statusCode == 200) {
+        // the final PATCH answers with a body, so the client has a response object to deliver.
+        headers[@"Content-Type"] = @"application/json";
+        responseBody = [NSJSONSerialization dataWithJSONObject:@{@"id": identifier, @"length": @(length)} options:0 error:nil];
+    }
+    return [self yg_sendStatusCode:statusCode headers:headers body:responseBody request:request connection:fd];
+}
+
+/**
+ 创建上传并返回上传地址的路径.
+ */
+- (NSString *)yg_createUploadWithLength:(long long)length data:(NSData *)data {
+    YGBenchmarkServerUpload *upload = [[YGBenchmarkServerUpload alloc] init];
+    upload.length = length;
+    upload.data = data ? [data mutableCopy] : [NSMutableData data];
+    YG_NETWORKING_LOCK();
+    NSString *identifier = [NSString stringWithFormat:@"%lu", (unsigned long)++self.uploadCount];
+    self.uploads[identifier] = upload;
+    NSString *path = [self.uploadPath stringByAppendingPathComponent:identifier];
+    YG_NETWORKING_UNLOCK();
+    return path;
+}
+
+/**
+ 发送响应，HEAD 请求只发送响应头. 设置了 `responseChunkDelay` 时响应体分块限速发送.
+ */
+- (BOOL)yg_sendStatusCode:(NSInteger)statusCode
+                  headers:(NSDictionary<NSString *, NSString *> *)headers
+                     body:(NSData *)body
+                  request:(YGBenchmarkServerRequest *)request
+               connection:(int)fd {
+    request.statusCode = statusCode;
+    NSMutableString *header = [NSMutableString stringWithFormat:@"HTTP/1.1 %ld %@\r\n", (long)statusCode, YGReasonPhraseForStatusCode(statusCode)];
+    [headers enumerateKeysAndObjectsUsingBlock:^(NSString *field, NSString *value, BOOL *stop) {
+        [header appendFormat:@"%@: %@\r\n", field, value];
+    }];
+    [header appendFormat:@"Content-Length: %lu\r\nCache-Control: no-store\r\nConnection: keep-alive\r\n\r\n", (unsigned long)body.length];
+    NSData *headerData = [header dataUsingEncoding:NSUTF8StringEncoding];
+    if (!YGSendAll(fd, headerData.bytes, headerData.length)) {
+        return NO;
+    }
+    if ([request.method isEqualToString:@"HEAD"] || body.length == 0) {
+        return YES;
+    }
+    
+    NSTimeInterval chunkDelay = self.responseChunkDelay;
+    size_t chunkLength = chunkDelay > 0 ? MAX(self.responseChunkLength, 1) : body.length;
+    for (size_t offset = 0; offset < body.length; offset += chunkLength) {
+        if (offset > 0) {
+            usleep((useconds_t)(chunkDelay * USEC_PER_SEC));
+        }
+        if (!YGSendAll(fd, (const uint8_t *)body.bytes + offset, MIN(chunkLength, body.length - offset))) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+/**
+ 返回完整的 HTTP 响应，同一个长度的响应只生成一次.
+ */
+- (NSData *)yg_responseWithPayloadLength:(NSUInteger)payloadLength {
+    YG_NETWORKING_LOCK();
+    NSData *response = self.responses[@(payloadLength)];
+    YG_NETWORKING_UNLOCK();
+    if (response) return response;
+    
+    // {"data":"xxxx"} padded to the requested length.
+    static const NSUInteger envelopeLength = 11;
+    NSUInteger fillLength = payloadLength > envelopeLength ? payloadLength - envelopeLength : 0;
+    NSMutableData *body = [NSMutableData dataWithCapacity:fillLength + envelopeLength];
+    [body appendBytes:"{\"data\":\"" length:9];
+    NSMutableData *fill = [NSMutableData dataWithLength:fillLength];
+    memset(fill.mutableBytes, 'x', fillLength);
+    [body appendData:fill];
+    [body appendBytes:"\"}" length:2];
+    
+    NSString *header = [NSString stringWithFormat:@"HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %lu\r\nCache-Control: no-store\r\nConnection: keep-alive\r\n\r\n", (unsigned long)body.length];
+    NSMutableData *mutableResponse = [[header dataUsingEncoding:NSUTF8StringEncoding] mutableCopy];
+    [mutableResponse appendData:body];
+    
+    YG_NETWORKING_LOCK();
+    self.responses[@(payloadLength)] = mutableResponse;
+    YG_NETWORKING_UNLOCK();
+    return mutableResponse;
+}
+
+@end
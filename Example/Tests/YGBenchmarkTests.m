@@ -0,0 +1,225 @@
+//
+//  YGBenchmarkTests.m
+//  YGNetworking_Tests
+//
+//  Created by Sun on 2020/4/27.
+//  Copyright © 2020 oneofai. All rights reserved.
+//
+
+@import XCTest;
+
+#import <YGNetworking/YGNetworking.h>
+
+#import "YGBenchmark.h"
+#import "YGBenchmarkServer.h"
+
+@interface YGCenter (YGBenchmarkTests)
+
+- (NSURL *)yg_baseURLForServer:(NSString *)server;
+
+@end
+
+/**
+ 基准测试只在设置了环境变量 `YG_BENCHMARK=1` 时运行 (在 scheme 的 Test > Arguments 中设置)，可选的环境变量:
+ 
+ - `YG_BENCHMARK_CONCURRENCY`: 逗号分隔的并发数，默认为 `1,8,32`.
+ - `YG_BENCHMARK_PAYLOADS`: 逗号分隔的响应体长度(字节)，默认为 `128,16384,1048576`.
+ - `YG_BENCHMARK_REQUESTS`: 每组测量的请求数，默认为 `2000`.
+ - `YG_BENCHMARK_OUTPUT`: JSON 结果的文件路径，默认为临时目录下的 `YGNetworkingBenchmark.json`.
+ 
+ NOTE: 使用 Release 配置在真机上运行才有参考意义，对比时使用相同的设备和参数.
+ */
+@interface YGBenchmarkTests : XCTestCase
+
+@end
+
+@implementation YGBenchmarkTests
+
+- (void)testBenchmark
+{
+    NSDictionary<NSString *, NSString *> *environment = [NSProcessInfo processInfo].environment;
+    if (![environment[@"YG_BENCHMARK"] boolValue]) {
+        NSLog(@"[YGBenchmark] skipped, set YG_BENCHMARK=1 to run the benchmark.");
+        return;
+    }
+    
+    NSArray<NSNumber *> *concurrencies = [self yg_numbersFromString:environment[@"YG_BENCHMARK_CONCURRENCY"] defaultValue:@[@1, @8, @32]];
+    NSArray<NSNumber *> *payloadLengths = [self yg_numbersFromString:environment[@"YG_BENCHMARK_PAYLOADS"] defaultValue:@[@128, @16384, @1048576]];
+    NSUInteger requestCount = environment[@"YG_BENCHMARK_REQUESTS"].integerValue ?: 2000;
+    NSString *outputPath = environment[@"YG_BENCHMARK_OUTPUT"] ?: [NSTemporaryDirectory() stringByAppendingPathComponent:@"YGNetworkingBenchmark.json"];
+    
+    YGBenchmarkServer *server = [[YGBenchmarkServer alloc] init];
+    NSError *error = nil;
+    XCTAssertTrue([server start:&error], @"%@", error);
+    
+    YGBenchmark *benchmark = [[YGBenchmark alloc] initWithServer:server];
+    NSMutableArray<YGBenchmarkResult *> *results = [NSMutableArray array];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"benchmark"];
+    // YGCenter may call back on the main queue, the benchmark blocks a background thread instead.
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        for (NSNumber *payloadLength in payloadLengths) {
+            for (NSNumber *concurrency in concurrencies) {
+                for (YGBenchmarkClient client = kYGBenchmarkClientYGCenter; client <= kYGBenchmarkClientNSURLSession; client++) {
+                    YGBenchmarkConfiguration *configuration = [[YGBenchmarkConfiguration alloc] init];
+                    configuration.client = client;
+                    configuration.concurrency = concurrency.unsignedIntegerValue;
+                    configuration.payloadLength = payloadLength.unsignedIntegerValue;
+                    configuration.requestCount = requestCount;
+                    
+                    YGBenchmarkResult *result = [benchmark runWithConfiguration:configuration];
+                    NSLog(@"[YGBenchmark] %@", result);
+                    [results addObject:result];
+                }
+            }
+        }
+        [expectation fulfill];
+    });
+    [self waitForExpectationsWithTimeout:3600 handler:nil];
+    [server stop];
+    
+    for (YGBenchmarkResult *result in results) {
+        XCTAssertEqual(result.failureCount, 0, @"%@", result);
+    }
+    XCTAssertTrue([YGBenchmark writeResults:results toFile:outputPath error:&error], @"%@", error);
+    NSLog(@"[YGBenchmark] results written to %@", outputPath);
+}
+
+/**
+ 对比每个请求都解析 server 和 url 字符串与使用缓存的 server 地址、把 NSURL 交给 YGEngine 时的 URL 处理开销，不需要网络.
+ */
+- (void)testURLBuildingWithoutCache
+{
+    NSString *server = @"https://api.example.com/v1";
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 100000; i++) {
+            @autoreleasepool {
+                // what YGCenter and YGEngine did for every request before the base URL was cached.
+                NSURL *baseURL = [NSURL URLWithString:server];
+                if ([[baseURL path] length] > 0 && ![[baseURL absoluteString] hasSuffix:@"/"]) {
+                    baseURL = [baseURL URLByAppendingPathComponent:@""];
+                }
+                NSString *url = [[NSURL URLWithString:@"user/profile" relativeToURL:baseURL] absoluteString];
+                NSURL *URL = [NSURL URLWithString:url];
+                XCTAssertNotNil(URL.host);
+            }
+        }
+    }];
+}
+
+- (void)testURLBuildingWithCache
+{
+    NSString *server = @"https://api.example.com/v1";
+    YGCenter *center = [YGCenter center];
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 100000; i++) {
+            @autoreleasepool {
+                NSURL *URL = [NSURL URLWithString:@"user/profile" relativeToURL:[center yg_baseURLForServer:server]].absoluteURL;
+                NSString *url = URL.absoluteString;
+                XCTAssertNotNil(url);
+                XCTAssertNotNil(URL.host);
+            }
+        }
+    }];
+}
+
+/**
+ 多线程压力测试，比较单个锁和分片锁的竞争次数，并统计 YGCenter 在多线程发送、查询和取消请求时的竞争次数.
+ 和 `testBenchmark` 一样只在设置了 `YG_BENCHMARK=1` 时运行，可选的环境变量 `YG_BENCHMARK_THREADS` 为线程数，默认为 `16`.
+ */
+- (void)testLockContention
+{
+    NSDictionary<NSString *, NSString *> *environment = [NSProcessInfo processInfo].environment;
+    if (![environment[@"YG_BENCHMARK"] boolValue]) {
+        NSLog(@"[YGBenchmark] skipped, set YG_BENCHMARK=1 to run the lock contention benchmark.");
+        return;
+    }
+    
+    NSUInteger threadCount = environment[@"YG_BENCHMARK_THREADS"].integerValue ?: 16;
+    
+    // a single shard is the old layout: one lock in front of one dictionary.
+    for (NSNumber *shardCount in @[@1, @0]) {
+        YGShardedDictionary<NSString *, NSNumber *> *dictionary = shardCount.unsignedIntegerValue > 0 ? [[YGShardedDictionary alloc] initWithShardCount:shardCount.unsignedIntegerValue] : [[YGShardedDictionary alloc] init];
+        NSUInteger operationCount = 50000;
+        YGNetworkingResetLockContentionCount();
+        NSTimeInterval startTimestamp = [NSProcessInfo processInfo].systemUptime;
+        dispatch_apply(threadCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t thread) {
+            for (NSUInteger i = 0; i < operationCount; i++) {
+                @autoreleasepool {
+                    NSString *key = [NSString stringWithFormat:@"+%lu", (unsigned long)(thread * operationCount + i)];
+                    dictionary[key] = @(i);
+                    [dictionary objectForKey:key];
+                    [dictionary removeObjectForKey:key];
+                }
+            }
+        });
+        NSTimeInterval duration = [NSProcessInfo processInfo].systemUptime - startTimestamp;
+        uint64_t contentionCount = YGNetworkingLockContentionCount();
+        NSLog(@"[YGBenchmark] dictionary shards: %@, threads: %lu, duration: %.3fs, contentions: %llu (%.4f per operation)",
+              shardCount.unsignedIntegerValue > 0 ? shardCount : @"default", (unsigned long)threadCount, duration,
+              contentionCount, (double)contentionCount / (threadCount * operationCount * 3));
+        XCTAssertEqual(dictionary.count, 0);
+    }
+    
+    YGBenchmarkServer *server = [[YGBenchmarkServer alloc] init];
+    NSError *error = nil;
+    XCTAssertTrue([server start:&error], @"%@", error);
+    NSURL *URL = [server URLWithPayloadLength:128];
+    
+    YGCenter *center = [YGCenter center];
+    NSUInteger requestCount = 200;
+    dispatch_group_t group = dispatch_group_create();
+    __block NSUInteger finishedCount = 0;
+    NSLock *finishedLock = [[NSLock alloc] init];
+    YGNetworkingResetLockContentionCount();
+    NSTimeInterval startTimestamp = [NSProcessInfo processInfo].systemUptime;
+    dispatch_apply(threadCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t thread) {
+        for (NSUInteger i = 0; i < requestCount; i++) {
+            dispatch_group_enter(group);
+            NSString *identifier = [center sendRequest:^(YGRequest *request) {
+                request.url = URL.absoluteString;
+                request.useGeneralServer = NO;
+                request.useGeneralHeaders = NO;
+                request.useGeneralParameters = NO;
+                request.responseSerializerType = kYGResponseSerializerRAW;
+            } onFinished:^(id responseObject, NSError *error) {
+                [finishedLock lock];
+                finishedCount++;
+                [finishedLock unlock];
+                dispatch_group_leave(group);
+            }];
+            [center getRequest:identifier];
+            if (i % 4 == 0) {
+                [center cancelRequest:identifier];
+            }
+        }
+    });
+    XCTestExpectation *expectation = [self expectationWithDescription:@"stress"];
+    dispatch_group_notify(group, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        [expectation fulfill];
+    });
+    [self waitForExpectationsWithTimeout:600 handler:nil];
+    NSTimeInterval duration = [NSProcessInfo processInfo].systemUptime - startTimestamp;
+    uint64_t contentionCount = YGNetworkingLockContentionCount();
+    [server stop];
+    
+    NSLog(@"[YGBenchmark] YGCenter threads: %lu, requests: %lu, duration: %.3fs, contentions: %llu (%.4f per request)",
+          (unsigned long)threadCount, (unsigned long)(threadCount * requestCount), duration,
+          contentionCount, (double)contentionCount / (threadCount * requestCount));
+    XCTAssertEqual(finishedCount, threadCount * requestCount);
+}
+
+#pragma mark - Private Methods
+
+- (NSArray<NSNumber *> *)yg_numbersFromString:(NSString *)string defaultValue:(NSArray<NSNumber *> *)defaultValue
+{
+    NSMutableArray<NSNumber *> *numbers = [NSMutableArray array];
+    for (NSString *component in [string componentsSeparatedByString:@","]) {
+        NSInteger value = [component stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]].integerValue;
+        if (value > 0) {
+            [numbers addObject:@(value)];
+        }
+    }
+    return numbers.count > 0 ? numbers : defaultValue;
+}
+
+@end
@@ -0,0 +1,216 @@
+//
+//  YGDownloadResumeTests.m
+//  YGNetworking_Tests
+//
+//  Created by Sun on 2020/5/8.
+//  Copyright © 2020 oneofai. All rights reserved.
+//
+
+@import XCTest;
+
+#import <YGNetworking/YGNetworking.h>
+
+#import "YGBenchmarkServer.h"
+
+/**
+ 断点下载的测试，文件资源由本地的 `YGBenchmarkServer` 提供，每个测试使用新的 YGEngine 和断点存储目录.
+ */
+@interface YGDownloadResumeTests : XCTestCase
+
+@property (nonatomic, strong) YGBenchmarkServer *server;
+@property (nonatomic, strong) YGCenter *center;
+@property (nonatomic, strong) YGDownloadResumeStore *store;
+@property (nonatomic, copy) NSString *directory;
+@property (nonatomic, strong) NSData *fileData;
+@property (nonatomic, strong) NSURL *URL;
+@property (nonatomic, copy) NSString *savePath;
+
+@end
+
+@implementation YGDownloadResumeTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    self.server = [[YGBenchmarkServer alloc] init];
+    NSError *error = nil;
+    XCTAssertTrue([self.server start:&error], @"%@", error);
+
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.directory withIntermediateDirectories:YES attributes:nil error:nil];
+
+    self.store = [YGDownloadResumeStore storeWithPath:[self.directory stringByAppendingPathComponent:@"resume"]];
+    self.center = [YGCenter center];
+    self.center.engine = [YGEngine engine];
+    self.center.engine.downloadResumeStore = self.store;
+
+    NSMutableData *fileData = [NSMutableData dataWithLength:4 * 1024 * 1024];
+    uint8_t *bytes = fileData.mutableBytes;
+    for (NSUInteger i = 0; i < fileData.length; i++) {
+        bytes[i] = (uint8_t)((i * 31 + i / 251) % 251);
+    }
+    self.fileData = fileData;
+    self.URL = [self.server setFileData:fileData forPath:@"/download.bin"];
+    self.savePath = [self.directory stringByAppendingPathComponent:@"download.bin"];
+}
+
+- (void)tearDown
+{
+    [self.server stop];
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+/**
+ 下载中途取消时保存断点数据，重新发送相同的请求时从断点继续下载，而不是重新下载整个文件.
+ */
+- (void)testResumeFromResumeData
+{
+    // slow enough to cancel in the middle of the body.
+    self.server.responseChunkDelay = 0.02;
+
+    __block BOOL cancelled = NO;
+    __block NSString *identifier = nil;
+    XCTestExpectation *cancelExpectation = [self expectationWithDescription:@"cancel"];
+    identifier = [self.center sendRequest:^(YGRequest *request) {
+        [self yg_setupRequest:request];
+    } onProgress:^(NSProgress *progress) {
+        if (progress.completedUnitCount < 256 * 1024) return;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (cancelled) return;
+            cancelled = YES;
+            [self.center cancelRequest:identifier];
+        });
+    } onSuccess:nil onFailure:nil onFinished:^(id responseObject, NSError *error) {
+        XCTAssertEqualObjects(error.domain, NSURLErrorDomain);
+        XCTAssertEqual(error.code, NSURLErrorCancelled);
+        [cancelExpectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:30 handler:nil];
+
+    // the resume data is produced asynchronously after the cancellation.
+    XCTAssertTrue([self yg_waitForCondition:^BOOL{
+        return [self.store resumeDataForURL:self.URL.absoluteString savePath:self.savePath] != nil;
+    }]);
+
+    self.server.responseChunkDelay = 0;
+    [self.server removeAllRequests];
+    XCTAssertEqualObjects([self yg_download], self.fileData);
+
+    NSArray<YGBenchmarkServerRequest *> *requests = self.server.requests;
+    XCTAssertEqual(requests.count, 1);
+    NSString *range = requests.firstObject.headers[@"range"];
+    XCTAssertTrue([range hasPrefix:@"bytes="], @"%@", range);
+    XCTAssertGreaterThan([range substringFromIndex:6].longLongValue, 0);
+    XCTAssertEqual(requests.firstObject.statusCode, 206);
+    XCTAssertNil([self.store partialFilePathForURL:self.URL.absoluteString savePath:self.savePath]);
+}
+
+/**
+ 断点数据失效、只剩下已下载部分和校验值时，发送 Range/If-Range 请求，206 的内容追加到已下载部分.
+ */
+- (void)testRangeRequestFallback
+{
+    NSUInteger partialLength = 1024 * 1024;
+    [self yg_seedPartialData:[self.fileData subdataWithRange:NSMakeRange(0, partialLength)] validator:[self.server entityTagForPath:@"/download.bin"]];
+
+    XCTAssertEqualObjects([self yg_download], self.fileData);
+
+    NSArray<YGBenchmarkServerRequest *> *requests = self.server.requests;
+    XCTAssertEqual(requests.count, 1);
+    XCTAssertEqualObjects(requests.firstObject.headers[@"range"], @"bytes=1048576-");
+    XCTAssertEqualObjects(requests.firstObject.headers[@"if-range"], [self.server entityTagForPath:@"/download.bin"]);
+    XCTAssertEqual(requests.firstObject.statusCode, 206);
+    XCTAssertNil([self.store partialFilePathForURL:self.URL.absoluteString savePath:self.savePath]);
+    XCTAssertNil([self.store validatorForURL:self.URL.absoluteString savePath:self.savePath]);
+}
+
+/**
+ 服务器上的文件已经被修改时 If-Range 不匹配，服务器返回 200 和完整的文件，完整的文件替换已下载部分，不会把两个版本拼在一起.
+ */
+- (void)testChangedResourceReplacesPartialFile
+{
+    NSString *staleEntityTag = [self.server entityTagForPath:@"/download.bin"];
+    NSMutableData *staleData = [NSMutableData dataWithLength:1024 * 1024];
+    memset(staleData.mutableBytes, 'x', staleData.length);
+    [self yg_seedPartialData:staleData validator:staleEntityTag];
+    // a new version of the file gets a new ETag.
+    [self.server setFileData:self.fileData forPath:@"/download.bin"];
+
+    XCTAssertEqualObjects([self yg_download], self.fileData);
+
+    NSArray<YGBenchmarkServerRequest *> *requests = self.server.requests;
+    XCTAssertEqual(requests.count, 1);
+    XCTAssertEqualObjects(requests.firstObject.headers[@"if-range"], staleEntityTag);
+    XCTAssertEqual(requests.firstObject.statusCode, 200);
+    XCTAssertNil([self.store partialFilePathForURL:self.URL.absoluteString savePath:self.savePath]);
+}
+
+#pragma mark - Private Methods
+
+- (void)yg_setupRequest:(YGRequest *)request
+{
+    request.url = self.URL.absoluteString;
+    request.useGeneralServer = NO;
+    request.useGeneralHeaders = NO;
+    request.useGeneralParameters = NO;
+    request.requestType = kYGRequestDownload;
+    request.downloadSavePath = self.savePath;
+}
+
+/**
+ 下载文件并返回下载后的文件内容.
+ */
+- (NSData *)yg_download
+{
+    __block NSURL *fileURL = nil;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"download"];
+    [self.center sendRequest:^(YGRequest *request) {
+        [self yg_setupRequest:request];
+    } onFinished:^(id responseObject, NSError *error) {
+        XCTAssertNil(error);
+        fileURL = responseObject;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:30 handler:nil];
+
+    XCTAssertEqualObjects(fileURL.path, self.savePath);
+    return fileURL ? [NSData dataWithContentsOfURL:fileURL] : nil;
+}
+
+/**
+ 保存已下载部分和校验值，断点数据随后被删除，和系统拒绝了断点数据之后的状态一致.
+ */
+- (void)yg_seedPartialData:(NSData *)partialData validator:(NSString *)validator
+{
+    NSString *tempFileName = [NSUUID UUID].UUIDString;
+    NSString *tempFilePath = [NSTemporaryDirectory() stringByAppendingPathComponent:tempFileName];
+    XCTAssertTrue([partialData writeToFile:tempFilePath atomically:YES]);
+    NSData *resumeData = [NSPropertyListSerialization dataWithPropertyList:@{@"NSURLSessionResumeInfoTempFileName": tempFileName}
+                                                                    format:NSPropertyListXMLFormat_v1_0
+                                                                   options:0
+                                                                     error:nil];
+
+    [self.store setResumeData:resumeData validator:validator forURL:self.URL.absoluteString savePath:self.savePath];
+    [self.store invalidateResumeDataForURL:self.URL.absoluteString savePath:self.savePath];
+    // the store keeps a hard link, the temporary file itself can go away.
+    [[NSFileManager defaultManager] removeItemAtPath:tempFilePath error:nil];
+
+    XCTAssertNil([self.store resumeDataForURL:self.URL.absoluteString savePath:self.savePath]);
+    XCTAssertNotNil([self.store partialFilePathForURL:self.URL.absoluteString savePath:self.savePath]);
+}
+
+- (BOOL)yg_waitForCondition:(BOOL (^)(void))condition
+{
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:10];
+    while (!condition()) {
+        if ([deadline timeIntervalSinceNow] < 0) {
+            return NO;
+        }
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    }
+    return YES;
+}
+
+@end
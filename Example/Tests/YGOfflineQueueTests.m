@@ -0,0 +1,243 @@
+//
+//  YGOfflineQueueTests.m
+//  YGNetworking_Tests
+//
+//  Created by Sun on 2020/5/8.
+//  Copyright © 2020 oneofai. All rights reserved.
+//
+
+@import XCTest;
+
+#import <YGNetworking/YGNetworking.h>
+
+/**
+ `YGOfflineQueue` 的测试，每个测试使用新的日志目录，重新创建队列模拟应用重启.
+ */
+@interface YGOfflineQueueTests : XCTestCase
+
+@property (nonatomic, copy) NSString *directory;
+
+@end
+
+@implementation YGOfflineQueueTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+/**
+ 应用重启后按入队顺序恢复队列中的请求配置，已经出队的请求不会恢复.
+ */
+- (void)testRestoreAfterRelaunch
+{
+    NSString *firstIdentifier = nil;
+    NSString *thirdIdentifier = nil;
+    @autoreleasepool {
+        YGOfflineQueue *queue = [YGOfflineQueue queueWithPath:self.directory];
+        YGRequest *request = [self yg_requestWithPath:@"/v1/orders"];
+        request.httpMethod = kYGHTTPMethodPOST;
+        request.requestSerializerType = kYGRequestSerializerJSON;
+        request.priority = kYGRequestPriorityHigh;
+        request.parameters = @{@"amount": @12, @"items": @[@"a", @"b"]};
+        request.headers = @{@"X-Trace": @"1"};
+        request.idempotencyKey = @"order-1";
+        request.userInfo = @{@"source": @"cart"};
+        firstIdentifier = [queue enqueueRequest:request];
+        XCTAssertNotNil(firstIdentifier);
+        XCTAssertEqualObjects(request.offlineEntryIdentifier, firstIdentifier);
+
+        [queue enqueueRequest:[self yg_requestWithPath:@"/v1/finished"]];
+        thirdIdentifier = [queue enqueueRequest:[self yg_requestWithPath:@"/v1/feed"]];
+        XCTAssertEqual(queue.count, 3);
+
+        // the second request finishes before the relaunch.
+        queue.maxConcurrentReplayCount = 2;
+        XCTAssertEqualObjects([queue dequeueRequest].offlineEntryIdentifier, firstIdentifier);
+        YGRequest *finishedRequest = [queue dequeueRequest];
+        XCTAssertEqualObjects(finishedRequest.url, [self yg_URLWithPath:@"/v1/finished"]);
+        [queue finishRequest:finishedRequest];
+        XCTAssertEqual(queue.count, 2);
+    }
+
+    YGOfflineQueue *queue = [YGOfflineQueue queueWithPath:self.directory];
+    XCTAssertEqual(queue.count, 2);
+    XCTAssertGreaterThanOrEqual(queue.oldestRequestAge, 0);
+    XCTAssertFalse(queue.isReplayPaused);
+
+    queue.maxConcurrentReplayCount = 2;
+    YGRequest *request = [queue dequeueRequest];
+    XCTAssertEqualObjects(request.offlineEntryIdentifier, firstIdentifier);
+    XCTAssertEqualObjects(request.identifier, firstIdentifier);
+    XCTAssertEqualObjects(request.url, [self yg_URLWithPath:@"/v1/orders"]);
+    XCTAssertEqual(request.httpMethod, kYGHTTPMethodPOST);
+    XCTAssertEqual(request.requestSerializerType, kYGRequestSerializerJSON);
+    XCTAssertEqual(request.priority, kYGRequestPriorityHigh);
+    XCTAssertEqualObjects(request.parameters, (@{@"amount": @12, @"items": @[@"a", @"b"]}));
+    XCTAssertEqualObjects(request.headers, @{@"X-Trace": @"1"});
+    XCTAssertEqualObjects(request.idempotencyKey, @"order-1");
+    XCTAssertEqualObjects(request.userInfo, @{@"source": @"cart"});
+    XCTAssertTrue(request.durable);
+
+    XCTAssertEqualObjects([queue dequeueRequest].offlineEntryIdentifier, thirdIdentifier);
+    XCTAssertNil([queue dequeueRequest]);
+}
+
+/**
+ 应用在写入时退出留下的不完整的最后一行被忽略，之后的记录不会接在这一行后面.
+ */
+- (void)testTornTrailingLineOnLoad
+{
+    @autoreleasepool {
+        YGOfflineQueue *queue = [YGOfflineQueue queueWithPath:self.directory];
+        [queue enqueueRequest:[self yg_requestWithPath:@"/v1/a"]];
+        [queue enqueueRequest:[self yg_requestWithPath:@"/v1/b"]];
+    }
+
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:[self yg_logPath]];
+    [fileHandle seekToEndOfFile];
+    [fileHandle writeData:[@"{\"op\":\"add\",\"id\":\"Qtorn\",\"time\":1,\"request\":{\"url\":" dataUsingEncoding:NSUTF8StringEncoding]];
+    [fileHandle closeFile];
+
+    @autoreleasepool {
+        YGOfflineQueue *queue = [YGOfflineQueue queueWithPath:self.directory];
+        XCTAssertEqual(queue.count, 2);
+        XCTAssertNotNil([queue enqueueRequest:[self yg_requestWithPath:@"/v1/c"]]);
+        XCTAssertEqual(queue.count, 3);
+    }
+
+    NSString *log = [NSString stringWithContentsOfFile:[self yg_logPath] encoding:NSUTF8StringEncoding error:nil];
+    XCTAssertFalse([log containsString:@"Qtorn"]);
+    XCTAssertEqual([self yg_logLineCount], 3);
+
+    YGOfflineQueue *queue = [YGOfflineQueue queueWithPath:self.directory];
+    XCTAssertEqual(queue.count, 3);
+    NSMutableArray<NSString *> *URLs = [NSMutableArray array];
+    queue.maxConcurrentReplayCount = 3;
+    for (YGRequest *request = [queue dequeueRequest]; request; request = [queue dequeueRequest]) {
+        [URLs addObject:request.url];
+    }
+    XCTAssertEqualObjects(URLs, (@[[self yg_URLWithPath:@"/v1/a"], [self yg_URLWithPath:@"/v1/b"], [self yg_URLWithPath:@"/v1/c"]]));
+}
+
+/**
+ 已出队的记录达到 64 条并且多于队列中的请求时压缩日志，日志只保留队列中的请求.
+ */
+- (void)testCompactionThreshold
+{
+    YGOfflineQueue *queue = [YGOfflineQueue queueWithPath:self.directory];
+    queue.maxConcurrentReplayCount = 1;
+    for (NSUInteger i = 0; i < 70; i++) {
+        XCTAssertNotNil([queue enqueueRequest:[self yg_requestWithPath:[NSString stringWithFormat:@"/v1/items/%lu", (unsigned long)i]]]);
+    }
+    XCTAssertEqual([self yg_logLineCount], 70);
+
+    for (NSUInteger i = 0; i < 63; i++) {
+        [queue finishRequest:[queue dequeueRequest]];
+    }
+    XCTAssertEqual(queue.count, 7);
+    XCTAssertEqual([self yg_logLineCount], 70 + 63);
+
+    [queue finishRequest:[queue dequeueRequest]];
+    XCTAssertEqual(queue.count, 6);
+    XCTAssertEqual([self yg_logLineCount], 6);
+
+    // the compacted log keeps the queue and its order.
+    YGRequest *nextRequest = [queue dequeueRequest];
+    XCTAssertEqualObjects(nextRequest.url, [self yg_URLWithPath:@"/v1/items/64"]);
+    queue = nil;
+    queue = [YGOfflineQueue queueWithPath:self.directory];
+    XCTAssertEqual(queue.count, 6);
+    XCTAssertEqualObjects([queue dequeueRequest].url, [self yg_URLWithPath:@"/v1/items/64"]);
+}
+
+/**
+ 队列已满时新的请求不会入队，也不会写入日志.
+ */
+- (void)testMaxRequestCountOverflow
+{
+    YGOfflineQueue *queue = [YGOfflineQueue queueWithPath:self.directory];
+    queue.maxRequestCount = 2;
+    XCTAssertNotNil([queue enqueueRequest:[self yg_requestWithPath:@"/v1/a"]]);
+    XCTAssertNotNil([queue enqueueRequest:[self yg_requestWithPath:@"/v1/b"]]);
+
+    YGRequest *overflowRequest = [self yg_requestWithPath:@"/v1/c"];
+    XCTAssertNil([queue enqueueRequest:overflowRequest]);
+    XCTAssertNil(overflowRequest.offlineEntryIdentifier);
+    XCTAssertEqual(queue.count, 2);
+    XCTAssertEqual([self yg_logLineCount], 2);
+
+    // a finished request makes room again.
+    [queue finishRequest:[queue dequeueRequest]];
+    XCTAssertNotNil([queue enqueueRequest:overflowRequest]);
+    XCTAssertEqual(queue.count, 2);
+}
+
+/**
+ 重放失败的请求放回原来的位置并暂停重放，恢复重放后最先发送的仍然是这个请求.
+ */
+- (void)testRequeuePausesReplay
+{
+    YGOfflineQueue *queue = [YGOfflineQueue queueWithPath:self.directory];
+    queue.maxConcurrentReplayCount = 2;
+    [queue enqueueRequest:[self yg_requestWithPath:@"/v1/a"]];
+    [queue enqueueRequest:[self yg_requestWithPath:@"/v1/b"]];
+
+    YGRequest *request = [queue dequeueRequest];
+    XCTAssertEqualObjects(request.url, [self yg_URLWithPath:@"/v1/a"]);
+    XCTAssertTrue([queue requeueRequest:request]);
+    XCTAssertTrue(queue.isReplayPaused);
+    XCTAssertNil([queue dequeueRequest]);
+    XCTAssertEqual(queue.count, 2);
+
+    [queue resumeReplay];
+    XCTAssertFalse(queue.isReplayPaused);
+    XCTAssertEqual([queue dequeueRequest], request);
+    XCTAssertEqualObjects([queue dequeueRequest].url, [self yg_URLWithPath:@"/v1/b"]);
+
+    // a request removed while it was replaying is not put back.
+    [queue removeAllRequests];
+    XCTAssertFalse([queue requeueRequest:request]);
+    XCTAssertFalse(queue.isReplayPaused);
+    XCTAssertEqual(queue.count, 0);
+}
+
+#pragma mark - Private Methods
+
+- (NSString *)yg_URLWithPath:(NSString *)path
+{
+    return [@"https://api.example.com" stringByAppendingString:path];
+}
+
+- (YGRequest *)yg_requestWithPath:(NSString *)path
+{
+    YGRequest *request = [YGRequest request];
+    request.url = [self yg_URLWithPath:path];
+    request.httpMethod = kYGHTTPMethodPUT;
+    request.durable = YES;
+    return request;
+}
+
+- (NSString *)yg_logPath
+{
+    return [self.directory stringByAppendingPathComponent:@"queue.log"];
+}
+
+/**
+ 日志中完整的记录数.
+ */
+- (NSUInteger)yg_logLineCount
+{
+    NSString *log = [NSString stringWithContentsOfFile:[self yg_logPath] encoding:NSUTF8StringEncoding error:nil];
+    return [log componentsSeparatedByString:@"\n"].count - 1;
+}
+
+@end
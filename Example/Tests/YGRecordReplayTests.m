@@ -0,0 +1,1134 @@
+//
+//  YGRecordReplayTests.m
+//  YGNetworking_Tests
+//
+//  Created by Sun on 2020/5/8.
+//  Copyright © 2020 oneofai. All rights reserved.
+//
+
+@import XCTest;
+
+#import <YGNetworking/YGNetworking.h>
+#import <AFNetworking/AFNetworkReachabilityManager.h>
+
+/// 回放存档中请求的服务器地址.
+static NSString * const YGRecordReplayTestsServer = @"https://api.example.com";
+
+/// 标记 `callbackQueue` 的 key.
+static void *YGRecordReplayTestsCallbackQueueKey = &YGRecordReplayTestsCallbackQueueKey;
+
+/**
+ 映射测试使用的模型.
+ */
+@interface YGRecordReplayTestsUser : NSObject <YGModel>
+
+@property (nonatomic, copy) NSString *userId;
+@property (nonatomic, copy) NSString *name;
+
+@end
+
+@implementation YGRecordReplayTestsUser
+
++ (NSDictionary<NSString *, NSString *> *)modelCustomPropertyMapper
+{
+    return @{@"userId": @"id"};
+}
+
+@end
+
+/**
+ 用 `YGRecordReplayTransport` 回放存档测试 YGCenter 和 YGEngine 的行为，不需要网络.
+ 每个测试使用新的 YGCenter、YGEngine 和缓存目录，请求经过完整的处理流程，只有网络被替换.
+ */
+@interface YGRecordReplayTests : XCTestCase
+
+@property (nonatomic, strong) YGCenter *center;
+@property (nonatomic, copy) NSString *directory;
+
+@end
+
+@implementation YGRecordReplayTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.directory withIntermediateDirectories:YES attributes:nil error:nil];
+
+    self.center = [YGCenter center];
+    self.center.engine = [YGEngine engine];
+    self.center.cache = [YGCache cacheWithPath:[self.directory stringByAppendingPathComponent:@"cache"]];
+}
+
+- (void)tearDown
+{
+    self.center.engine.recordReplayTransport = nil;
+    [self.center.cache removeAllObjects];
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+/**
+ 用存档回放 YGCenter 的请求，不需要网络: 匹配的请求经过完整的处理流程得到存档中的响应体，没有匹配的请求以 `kYGErrorReplayMissing` 结束.
+ */
+- (void)testRecordReplay
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"YGRecordReplayTests.json"];
+    NSData *body = [@"{\"name\":\"ygnetworking\"}" dataUsingEncoding:NSUTF8StringEncoding];
+    NSDictionary *archive = @{@"version": @1,
+                              @"entries": @[@{@"method": @"GET",
+                                              @"url": @"https://api.example.com/v1/user/profile",
+                                              @"statusCode": @200,
+                                              @"headers": @{@"Content-Type": @"application/json"},
+                                              @"body": [body base64EncodedStringWithOptions:0],
+                                              @"responseDelay": @0.2,
+                                              @"duration": @0.3}]};
+    XCTAssertTrue([[NSJSONSerialization dataWithJSONObject:archive options:0 error:nil] writeToFile:path atomically:YES]);
+
+    NSError *error = nil;
+    YGRecordReplayTransport *transport = [YGRecordReplayTransport replayerWithArchivePath:path error:&error];
+    XCTAssertNotNil(transport, @"%@", error);
+    XCTAssertEqual(transport.entryCount, 1);
+    transport.latencyScale = 0;
+
+    YGCenter *center = [YGCenter center];
+    center.engine.recordReplayTransport = transport;
+
+    XCTestExpectation *hitExpectation = [self expectationWithDescription:@"hit"];
+    [center sendRequest:^(YGRequest *request) {
+        request.url = @"https://api.example.com/v1/user/profile";
+        request.httpMethod = kYGHTTPMethodGET;
+        request.useGeneralServer = NO;
+        request.useGeneralHeaders = NO;
+        request.useGeneralParameters = NO;
+        request.responseSerializerType = kYGResponseSerializerRAW;
+    } onFinished:^(id responseObject, NSError *error) {
+        XCTAssertNil(error);
+        XCTAssertEqualObjects(responseObject, body);
+        [hitExpectation fulfill];
+    }];
+
+    XCTestExpectation *missExpectation = [self expectationWithDescription:@"miss"];
+    [center sendRequest:^(YGRequest *request) {
+        request.url = @"https://api.example.com/v1/user/settings";
+        request.httpMethod = kYGHTTPMethodGET;
+        request.useGeneralServer = NO;
+        request.useGeneralHeaders = NO;
+        request.useGeneralParameters = NO;
+        request.responseSerializerType = kYGResponseSerializerRAW;
+    } onFinished:^(id responseObject, NSError *error) {
+        XCTAssertEqualObjects(error.domain, YGErrorDomain);
+        XCTAssertEqual(error.code, kYGErrorReplayMissing);
+        [missExpectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+    center.engine.recordReplayTransport = nil;
+}
+
+#pragma mark - Cache
+
+/**
+ 带有 Authorization 的请求默认不读写缓存 (`cacheKey` 为 `nil`)，每次都从网络获取数据.
+ */
+- (void)testAuthorizedResponseIsNotCachedByDefault
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/user/profile" JSON:@{@"name": @"A"} statusCode:200 delay:0],
+                             [self yg_entryWithPath:@"/v1/user/profile" JSON:@{@"name": @"B"} statusCode:200 delay:0]]];
+
+    YGRequestConfigBlock configBlock = ^(YGRequest *request) {
+        request.headers = @{@"Authorization": @"Bearer alice"};
+        request.cachePolicy = kYGRequestCachePolicyCacheElseNetwork;
+        request.cacheTimeInterval = 60;
+    };
+
+    YGRequest *request = nil;
+    NSError *error = nil;
+    XCTAssertEqualObjects([self yg_resultOfPath:@"/v1/user/profile" config:configBlock request:&request error:&error], @{@"name": @"A"});
+    XCTAssertNil(error);
+    XCTAssertNil(request.cacheKey);
+
+    XCTAssertEqualObjects([self yg_resultOfPath:@"/v1/user/profile" config:configBlock request:&request error:&error], @{@"name": @"B"});
+    XCTAssertNil(error);
+    XCTAssertFalse(request.responseFromCache);
+}
+
+/**
+ 开启 `cachesAuthorizedResponse` 后缓存 key 包含身份的摘要 (不包含明文) 和 vary 请求头:
+ 相同的身份命中缓存，不同的身份或者不同的 Accept-Language 从网络获取数据.
+ */
+- (void)testAuthorizedResponseCacheIsKeyedByIdentity
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/user/profile" JSON:@{@"name": @"A"} statusCode:200 delay:0],
+                             [self yg_entryWithPath:@"/v1/user/profile" JSON:@{@"name": @"B"} statusCode:200 delay:0],
+                             [self yg_entryWithPath:@"/v1/user/profile" JSON:@{@"name": @"C"} statusCode:200 delay:0]]];
+
+    YGRequestConfigBlock (^configBlock)(NSDictionary *) = ^YGRequestConfigBlock(NSDictionary *headers) {
+        return ^(YGRequest *request) {
+            request.headers = headers;
+            request.cachePolicy = kYGRequestCachePolicyCacheElseNetwork;
+            request.cacheTimeInterval = 60;
+            request.cachesAuthorizedResponse = YES;
+        };
+    };
+    NSDictionary *alice = @{@"Authorization": @"Bearer alice"};
+
+    YGRequest *request = nil;
+    NSError *error = nil;
+    XCTAssertEqualObjects([self yg_resultOfPath:@"/v1/user/profile" config:configBlock(alice) request:&request error:&error], @{@"name": @"A"});
+    XCTAssertFalse(request.responseFromCache);
+    XCTAssertNotNil(request.cacheKey);
+    XCTAssertFalse([request.cacheKey containsString:@"alice"], @"%@", request.cacheKey);
+    NSString *aliceCacheKey = request.cacheKey;
+
+    XCTAssertEqualObjects([self yg_resultOfPath:@"/v1/user/profile" config:configBlock(alice) request:&request error:&error], @{@"name": @"A"});
+    XCTAssertTrue(request.responseFromCache);
+    XCTAssertEqualObjects(request.cacheKey, aliceCacheKey);
+
+    XCTAssertEqualObjects([self yg_resultOfPath:@"/v1/user/profile" config:configBlock(@{@"Authorization": @"Bearer bob"}) request:&request error:&error], @{@"name": @"B"});
+    XCTAssertFalse(request.responseFromCache);
+    XCTAssertNotEqualObjects(request.cacheKey, aliceCacheKey);
+
+    NSDictionary *french = @{@"Authorization": @"Bearer alice", @"Accept-Language": @"fr"};
+    XCTAssertEqualObjects([self yg_resultOfPath:@"/v1/user/profile" config:configBlock(french) request:&request error:&error], @{@"name": @"C"});
+    XCTAssertFalse(request.responseFromCache);
+    XCTAssertNil(error);
+}
+
+/**
+ 清理磁盘层时移除过期的文件，总大小超过 `diskCostLimit` 时先淘汰最早过期的文件.
+ */
+- (void)testCacheDiskTrim
+{
+    NSString *path = [self.directory stringByAppendingPathComponent:@"disk"];
+    YGCache *cache = [YGCache cacheWithPath:path];
+    NSString *value = [@"" stringByPaddingToLength:1024 withString:@"x" startingAtIndex:0];
+    [cache setObject:value forKey:@"short" timeToLive:1];
+    [cache setObject:value forKey:@"a" timeToLive:100];
+    [cache setObject:value forKey:@"b" timeToLive:200];
+    [cache setObject:value forKey:@"c" timeToLive:300];
+    [self yg_trimDiskOfCache:cache];
+    XCTAssertEqual([self yg_fileCountAtPath:path], 4);
+
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:1.1]];
+    [self yg_trimDiskOfCache:cache];
+    XCTAssertEqual([self yg_fileCountAtPath:path], 3);
+
+    // room for two files: the one which expires first goes.
+    NSUInteger fileLength = [[[NSFileManager defaultManager] attributesOfItemAtPath:[path stringByAppendingPathComponent:[self yg_contentsOfDirectoryAtPath:path].firstObject] error:nil] fileSize];
+    cache.diskCostLimit = fileLength * 2 + fileLength / 2;
+    [self yg_trimDiskOfCache:cache];
+    XCTAssertEqual([self yg_fileCountAtPath:path], 2);
+
+    // a new cache has no memory tier, it only sees the disk.
+    YGCache *reopenedCache = [YGCache cacheWithPath:path];
+    XCTAssertNil([reopenedCache objectForKey:@"short"]);
+    XCTAssertNil([reopenedCache objectForKey:@"a"]);
+    XCTAssertEqualObjects([reopenedCache objectForKey:@"b"], value);
+    XCTAssertEqualObjects([reopenedCache objectForKey:@"c"], value);
+}
+
+#pragma mark - Scheduler
+
+/**
+ 并发名额用完时请求按优先级排队，高优先级的请求先启动.
+ */
+- (void)testPriorityOrdering
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/blocker" JSON:@{} statusCode:200 delay:0.5],
+                             [self yg_entryWithPath:@"/v1/low" JSON:@{} statusCode:200 delay:0.2],
+                             [self yg_entryWithPath:@"/v1/high" JSON:@{} statusCode:200 delay:0]]];
+    YGEngine *engine = self.center.engine;
+    engine.maxConcurrentRequestCount = 1;
+
+    NSMutableArray<NSString *> *finishedPaths = [NSMutableArray array];
+    [self yg_sendPath:@"/v1/blocker" priority:kYGRequestPriorityNormal finishedPaths:finishedPaths];
+    [self yg_sendPath:@"/v1/low" priority:kYGRequestPriorityLow finishedPaths:finishedPaths];
+    [self yg_sendPath:@"/v1/high" priority:kYGRequestPriorityHigh finishedPaths:finishedPaths];
+
+    XCTAssertEqual(engine.runningRequestCount, 1);
+    XCTAssertEqual([engine pendingRequestCountForPriority:kYGRequestPriorityLow], 1);
+    XCTAssertEqual([engine pendingRequestCountForPriority:kYGRequestPriorityHigh], 1);
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+    XCTAssertEqualObjects(finishedPaths, (@[@"/v1/blocker", @"/v1/high", @"/v1/low"]));
+}
+
+/**
+ `kYGRequestPriorityCritical` 的请求不受并发数限制，不等待正在运行的请求.
+ */
+- (void)testCriticalBypassesConcurrencyLimit
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/blocker" JSON:@{} statusCode:200 delay:0.5],
+                             [self yg_entryWithPath:@"/v1/critical" JSON:@{} statusCode:200 delay:0]]];
+    YGEngine *engine = self.center.engine;
+    engine.maxConcurrentRequestCount = 1;
+
+    NSMutableArray<NSString *> *finishedPaths = [NSMutableArray array];
+    [self yg_sendPath:@"/v1/blocker" priority:kYGRequestPriorityNormal finishedPaths:finishedPaths];
+    [self yg_sendPath:@"/v1/critical" priority:kYGRequestPriorityCritical finishedPaths:finishedPaths];
+
+    XCTAssertEqual([engine pendingRequestCountForPriority:kYGRequestPriorityCritical], 0);
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+    XCTAssertEqualObjects(finishedPaths, (@[@"/v1/critical", @"/v1/blocker"]));
+}
+
+/**
+ 相同的 GET 请求被合并为一个网络任务，更高优先级的请求加入时排队的任务移到更高优先级的队列，先于普通优先级的请求启动.
+ */
+- (void)testCoalescingPromotesPriority
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/blocker" JSON:@{} statusCode:200 delay:0.5],
+                             [self yg_entryWithPath:@"/v1/feed" JSON:@{@"name": @"A"} statusCode:200 delay:0],
+                             [self yg_entryWithPath:@"/v1/feed" JSON:@{@"name": @"B"} statusCode:200 delay:0],
+                             [self yg_entryWithPath:@"/v1/normal" JSON:@{} statusCode:200 delay:0.2]]];
+    YGEngine *engine = self.center.engine;
+    engine.maxConcurrentRequestCount = 1;
+    self.center.coalescingEnabled = YES;
+
+    NSMutableArray<NSString *> *finishedPaths = [NSMutableArray array];
+    NSMutableArray *feedObjects = [NSMutableArray array];
+    [self yg_sendPath:@"/v1/blocker" priority:kYGRequestPriorityNormal finishedPaths:finishedPaths];
+    for (NSNumber *priority in @[@(kYGRequestPriorityLow), @(kYGRequestPriorityHigh)]) {
+        XCTestExpectation *expectation = [self expectationWithDescription:@"feed"];
+        [self yg_sendPath:@"/v1/feed" config:^(YGRequest *request) {
+            request.priority = priority.integerValue;
+        } onFinished:^(id responseObject, NSError *error) {
+            XCTAssertNil(error);
+            @synchronized (finishedPaths) {
+                [finishedPaths addObject:@"/v1/feed"];
+                [feedObjects addObject:responseObject ?: [NSNull null]];
+            }
+            [expectation fulfill];
+        }];
+    }
+    [self yg_sendPath:@"/v1/normal" priority:kYGRequestPriorityNormal finishedPaths:finishedPaths];
+
+    XCTAssertEqual([engine pendingRequestCountForPriority:kYGRequestPriorityLow], 0);
+    XCTAssertEqual([engine pendingRequestCountForPriority:kYGRequestPriorityHigh], 1);
+    XCTAssertEqual([engine pendingRequestCountForPriority:kYGRequestPriorityNormal], 1);
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+    XCTAssertEqualObjects(finishedPaths, (@[@"/v1/blocker", @"/v1/feed", @"/v1/feed", @"/v1/normal"]));
+    // one network task, both waiters get the first replayed response.
+    XCTAssertEqualObjects(feedObjects, (@[@{@"name": @"A"}, @{@"name": @"A"}]));
+}
+
+#pragma mark - Retry
+
+/**
+ 5xx 响应按重试策略重试，重试成功时回调重试的响应.
+ */
+- (void)testRetryAfterServerError
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/feed" JSON:@{} statusCode:503 delay:0],
+                             [self yg_entryWithPath:@"/v1/feed" JSON:@{@"name": @"A"} statusCode:200 delay:0]]];
+    YGExponentialBackoffRetryPolicy *retryPolicy = [YGExponentialBackoffRetryPolicy policy];
+    retryPolicy.baseDelay = 0.05;
+    self.center.retryPolicy = retryPolicy;
+
+    YGRequest *sentRequest = nil;
+    NSError *error = nil;
+    id responseObject = [self yg_resultOfPath:@"/v1/feed" config:^(YGRequest *request) {
+        request.retryCount = 1;
+    } request:&sentRequest error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(responseObject, @{@"name": @"A"});
+    XCTAssertEqual(sentRequest.retriedCount, 1);
+}
+
+#pragma mark - Hedging
+
+/**
+ 原始请求在对冲延迟内没有完成时发送对冲请求，先完成的对冲请求胜出，原始请求被取消.
+ */
+- (void)testHedgeWinsAfterDelay
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/feed" JSON:@{@"name": @"primary"} statusCode:200 delay:1],
+                             [self yg_entryWithPath:@"/v1/feed" JSON:@{@"name": @"hedge"} statusCode:200 delay:0]]];
+    YGHedgingPolicy *hedgingPolicy = [YGHedgingPolicy policy];
+    hedgingPolicy.delay = 0.2;
+    self.center.engine.hedgingPolicy = hedgingPolicy;
+
+    NSTimeInterval startTimestamp = [NSProcessInfo processInfo].systemUptime;
+    YGRequest *sentRequest = nil;
+    NSError *error = nil;
+    id responseObject = [self yg_resultOfPath:@"/v1/feed" config:^(YGRequest *request) {
+        request.hedgingEnabled = YES;
+    } request:&sentRequest error:&error];
+    NSTimeInterval duration = [NSProcessInfo processInfo].systemUptime - startTimestamp;
+
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(responseObject, @{@"name": @"hedge"});
+    XCTAssertGreaterThanOrEqual(duration, 0.15);
+    XCTAssertLessThan(duration, 0.8);
+    XCTAssertTrue(sentRequest.metrics.hedged);
+    XCTAssertTrue(sentRequest.metrics.hedgeWon);
+
+    // the original task is cancelled instead of running to the end of its response.
+    [self yg_waitUntil:startTimestamp + 0.6];
+    XCTAssertEqual(self.center.engine.runningRequestCount, 0);
+}
+
+/**
+ 原始请求在对冲请求之前完成时原始请求胜出，对冲请求被取消.
+ */
+- (void)testPrimaryWinsOverHedge
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/feed" JSON:@{@"name": @"primary"} statusCode:200 delay:0.3],
+                             [self yg_entryWithPath:@"/v1/feed" JSON:@{@"name": @"hedge"} statusCode:200 delay:1]]];
+    YGHedgingPolicy *hedgingPolicy = [YGHedgingPolicy policy];
+    hedgingPolicy.delay = 0.1;
+    self.center.engine.hedgingPolicy = hedgingPolicy;
+
+    NSTimeInterval startTimestamp = [NSProcessInfo processInfo].systemUptime;
+    YGRequest *sentRequest = nil;
+    NSError *error = nil;
+    id responseObject = [self yg_resultOfPath:@"/v1/feed" config:^(YGRequest *request) {
+        request.hedgingEnabled = YES;
+    } request:&sentRequest error:&error];
+
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(responseObject, @{@"name": @"primary"});
+    XCTAssertTrue(sentRequest.metrics.hedged);
+    XCTAssertFalse(sentRequest.metrics.hedgeWon);
+
+    [self yg_waitUntil:startTimestamp + 0.7];
+    XCTAssertEqual(self.center.engine.runningRequestCount, 0);
+}
+
+/**
+ 对冲预算用完时不发送对冲请求，请求等待原始请求完成.
+ */
+- (void)testEmptyBudgetSuppressesHedge
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/feed" JSON:@{@"name": @"primary"} statusCode:200 delay:0.5],
+                             [self yg_entryWithPath:@"/v1/feed" JSON:@{@"name": @"hedge"} statusCode:200 delay:0]]];
+    YGHedgingPolicy *hedgingPolicy = [YGHedgingPolicy policy];
+    hedgingPolicy.delay = 0.1;
+    hedgingPolicy.budget = [YGRetryBudget budgetWithRatio:0 maxTokens:1];
+    XCTAssertTrue([hedgingPolicy.budget tryWithdraw]);
+    self.center.engine.hedgingPolicy = hedgingPolicy;
+
+    NSTimeInterval startTimestamp = [NSProcessInfo processInfo].systemUptime;
+    YGRequest *sentRequest = nil;
+    NSError *error = nil;
+    id responseObject = [self yg_resultOfPath:@"/v1/feed" config:^(YGRequest *request) {
+        request.hedgingEnabled = YES;
+    } request:&sentRequest error:&error];
+
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(responseObject, @{@"name": @"primary"});
+    XCTAssertGreaterThanOrEqual([NSProcessInfo processInfo].systemUptime - startTimestamp, 0.45);
+    XCTAssertFalse(sentRequest.metrics.hedged);
+    XCTAssertFalse(sentRequest.metrics.hedgeWon);
+}
+
+#pragma mark - Circuit Breaker
+
+/**
+ 连续的 5xx 响应让主机熔断，冷却结束后只放行一个探测请求，探测期间的其它请求直接失败，探测成功后恢复正常.
+ */
+- (void)testCircuitBreakerHalfOpenProbe
+{
+    NSMutableArray *entries = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 4; i++) {
+        [entries addObject:[self yg_entryWithPath:@"/v1/feed" JSON:@{} statusCode:503 delay:0]];
+    }
+    [entries addObject:[self yg_entryWithPath:@"/v1/feed" JSON:@{@"name": @"A"} statusCode:200 delay:0.3]];
+    [self yg_replayEntries:entries];
+
+    YGCircuitBreaker *circuitBreaker = [YGCircuitBreaker breaker];
+    circuitBreaker.minimumRequestCount = 4;
+    circuitBreaker.cooldownInterval = 0.5;
+    self.center.engine.circuitBreaker = circuitBreaker;
+
+    NSError *error = nil;
+    for (NSUInteger i = 0; i < 4; i++) {
+        [self yg_resultOfPath:@"/v1/feed" config:nil request:NULL error:&error];
+        XCTAssertNotNil(error);
+    }
+    XCTAssertEqual([self.center circuitBreakerStateForHost:@"api.example.com"], kYGCircuitBreakerStateOpen);
+
+    // open: fails fast without consuming a replayed response.
+    [self yg_resultOfPath:@"/v1/feed" config:nil request:NULL error:&error];
+    XCTAssertEqualObjects(error.domain, YGErrorDomain);
+    XCTAssertEqual(error.code, kYGErrorCircuitOpen);
+
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.6]];
+
+    XCTestExpectation *probeExpectation = [self expectationWithDescription:@"probe"];
+    [self yg_sendPath:@"/v1/feed" config:nil onFinished:^(id responseObject, NSError *error) {
+        XCTAssertNil(error);
+        XCTAssertEqualObjects(responseObject, @{@"name": @"A"});
+        [probeExpectation fulfill];
+    }];
+    XCTAssertEqual([self.center circuitBreakerStateForHost:@"api.example.com"], kYGCircuitBreakerStateHalfOpen);
+
+    XCTestExpectation *rejectedExpectation = [self expectationWithDescription:@"rejected"];
+    [self yg_sendPath:@"/v1/feed" config:nil onFinished:^(id responseObject, NSError *error) {
+        XCTAssertEqualObjects(error.domain, YGErrorDomain);
+        XCTAssertEqual(error.code, kYGErrorCircuitOpen);
+        [rejectedExpectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+
+    XCTAssertEqual([self.center circuitBreakerStateForHost:@"api.example.com"], kYGCircuitBreakerStateClosed);
+}
+
+/**
+ 半开状态下只有携带探测令牌的结果改变主机的状态，取消探测会释放探测名额.
+ */
+- (void)testCircuitBreakerProbeToken
+{
+    YGCircuitBreaker *circuitBreaker = [YGCircuitBreaker breaker];
+    circuitBreaker.minimumRequestCount = 2;
+    circuitBreaker.cooldownInterval = 0.1;
+    NSString *host = @"api.example.com";
+    [circuitBreaker recordFailureForHost:host latency:0.1];
+    [circuitBreaker recordFailureForHost:host latency:0.1];
+    XCTAssertEqual([circuitBreaker stateForHost:host], kYGCircuitBreakerStateOpen);
+
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+
+    NSUInteger probeToken = 0;
+    XCTAssertTrue([circuitBreaker allowRequestForHost:host probeToken:&probeToken]);
+    XCTAssertNotEqual(probeToken, 0);
+    XCTAssertEqual([circuitBreaker stateForHost:host], kYGCircuitBreakerStateHalfOpen);
+
+    NSUInteger otherToken = 0;
+    XCTAssertFalse([circuitBreaker allowRequestForHost:host probeToken:&otherToken]);
+    XCTAssertEqual(otherToken, 0);
+
+    // a request admitted before the breaker opened does not decide the probe.
+    [circuitBreaker recordSuccessForHost:host latency:0.1 probeToken:0];
+    XCTAssertEqual([circuitBreaker stateForHost:host], kYGCircuitBreakerStateHalfOpen);
+
+    [circuitBreaker recordCancellationForHost:host probeToken:probeToken];
+    XCTAssertTrue([circuitBreaker allowRequestForHost:host probeToken:&probeToken]);
+    XCTAssertNotEqual(probeToken, 0);
+
+    [circuitBreaker recordSuccessForHost:host latency:0.1 probeToken:probeToken];
+    XCTAssertEqual([circuitBreaker stateForHost:host], kYGCircuitBreakerStateClosed);
+}
+
+/**
+ 探测请求在创建任务之前失败 (eg. 参数序列化失败) 时释放探测名额，下一个请求可以立即作为探测请求发送.
+ */
+- (void)testEarlyFailureReleasesCircuitProbe
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/feed" JSON:@{@"name": @"A"} statusCode:200 delay:0]]];
+
+    YGCircuitBreaker *circuitBreaker = [YGCircuitBreaker breaker];
+    circuitBreaker.minimumRequestCount = 2;
+    circuitBreaker.cooldownInterval = 0.1;
+    self.center.engine.circuitBreaker = circuitBreaker;
+    [circuitBreaker recordFailureForHost:@"api.example.com" latency:0.1];
+    [circuitBreaker recordFailureForHost:@"api.example.com" latency:0.1];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+
+    // a date is not a JSON object, the request fails before it gets a task.
+    NSError *error = nil;
+    [self yg_resultOfPath:@"/v1/feed" config:^(YGRequest *request) {
+        request.httpMethod = kYGHTTPMethodPOST;
+        request.requestSerializerType = kYGRequestSerializerJSON;
+        request.parameters = @{@"date": [NSDate date]};
+    } request:NULL error:&error];
+    XCTAssertNotNil(error);
+    XCTAssertNotEqualObjects(error.domain, YGErrorDomain);
+    XCTAssertEqual([circuitBreaker stateForHost:@"api.example.com"], kYGCircuitBreakerStateHalfOpen);
+
+    id responseObject = [self yg_resultOfPath:@"/v1/feed" config:nil request:NULL error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(responseObject, @{@"name": @"A"});
+    XCTAssertEqual([circuitBreaker stateForHost:@"api.example.com"], kYGCircuitBreakerStateClosed);
+}
+
+/**
+ 设备离线导致的错误不计入熔断器，主机不会因为设备离线而熔断; 服务端故障 (超时) 仍然计入失败.
+ */
+- (void)testOfflineErrorsDoNotOpenCircuitBreaker
+{
+    NSMutableArray *entries = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 4; i++) {
+        [entries addObject:[self yg_entryWithPath:@"/v1/feed" errorCode:NSURLErrorNotConnectedToInternet]];
+    }
+    for (NSUInteger i = 0; i < 4; i++) {
+        [entries addObject:[self yg_entryWithPath:@"/v1/feed" errorCode:NSURLErrorTimedOut]];
+    }
+    [self yg_replayEntries:entries];
+
+    YGCircuitBreaker *circuitBreaker = [YGCircuitBreaker breaker];
+    circuitBreaker.minimumRequestCount = 4;
+    self.center.engine.circuitBreaker = circuitBreaker;
+
+    NSError *error = nil;
+    for (NSUInteger i = 0; i < 4; i++) {
+        [self yg_resultOfPath:@"/v1/feed" config:nil request:NULL error:&error];
+        XCTAssertEqual(error.code, NSURLErrorNotConnectedToInternet);
+    }
+    XCTAssertEqual([self.center circuitBreakerStateForHost:@"api.example.com"], kYGCircuitBreakerStateClosed);
+
+    for (NSUInteger i = 0; i < 4; i++) {
+        [self yg_resultOfPath:@"/v1/feed" config:nil request:NULL error:&error];
+        XCTAssertEqual(error.code, NSURLErrorTimedOut);
+    }
+    XCTAssertEqual([self.center circuitBreakerStateForHost:@"api.example.com"], kYGCircuitBreakerStateOpen);
+}
+
+/**
+ 网络状态变化时熔断器被重置，上一个网络上的失败不影响新的网络.
+ */
+- (void)testReachabilityChangeResetsCircuitBreaker
+{
+    YGCircuitBreaker *circuitBreaker = [YGCircuitBreaker breaker];
+    circuitBreaker.minimumRequestCount = 2;
+    self.center.engine.circuitBreaker = circuitBreaker;
+    [circuitBreaker recordFailureForHost:@"api.example.com" latency:0.1];
+    [circuitBreaker recordFailureForHost:@"api.example.com" latency:0.1];
+    XCTAssertEqual([circuitBreaker stateForHost:@"api.example.com"], kYGCircuitBreakerStateOpen);
+
+    [[NSNotificationCenter defaultCenter] postNotificationName:AFNetworkingReachabilityDidChangeNotification
+                                                        object:nil
+                                                      userInfo:@{AFNetworkingReachabilityNotificationStatusItem: @(AFNetworkReachabilityStatusReachableViaWiFi)}];
+    XCTAssertEqual([circuitBreaker stateForHost:@"api.example.com"], kYGCircuitBreakerStateClosed);
+}
+
+#pragma mark - Offline Queue
+
+/**
+ 持久请求遇到熔断 (`kYGErrorCircuitOpen`) 时进入离线队列而不是结束; 重放时再次遇到熔断的请求放回队列并暂停重放，
+ 经过冷却时间后重放成功，请求不会从队列中丢失.
+ */
+- (void)testOfflineReplayThroughOpenCircuitBreaker
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/probe" JSON:@{} statusCode:200 delay:1.0],
+                             [self yg_entryWithPath:@"/v1/report" JSON:@{@"name": @"A"} statusCode:200 delay:0]]];
+    YGOfflineQueue *offlineQueue = [YGOfflineQueue queueWithPath:[self.directory stringByAppendingPathComponent:@"offline"]];
+    self.center.offlineQueue = offlineQueue;
+
+    YGCircuitBreaker *circuitBreaker = [YGCircuitBreaker breaker];
+    circuitBreaker.minimumRequestCount = 2;
+    circuitBreaker.cooldownInterval = 0.5;
+    self.center.engine.circuitBreaker = circuitBreaker;
+    [circuitBreaker recordFailureForHost:@"api.example.com" latency:0.1];
+    [circuitBreaker recordFailureForHost:@"api.example.com" latency:0.1];
+    NSTimeInterval openedTimestamp = [NSProcessInfo processInfo].systemUptime;
+
+    // t = 0.3: the durable request is rejected by the open breaker and waits in the queue.
+    [self yg_waitUntil:openedTimestamp + 0.3];
+    __block NSUInteger finishedCount = 0;
+    XCTestExpectation *reportExpectation = [self expectationWithDescription:@"report"];
+    [self yg_sendPath:@"/v1/report" config:^(YGRequest *request) {
+        request.durable = YES;
+    } onFinished:^(id responseObject, NSError *error) {
+        finishedCount++;
+        XCTAssertNil(error);
+        XCTAssertEqualObjects(responseObject, @{@"name": @"A"});
+        [reportExpectation fulfill];
+    }];
+    [self yg_waitUntil:openedTimestamp + 0.4];
+    XCTAssertEqual(offlineQueue.count, 1);
+    XCTAssertEqual(finishedCount, 0);
+
+    // t = 0.6: another request becomes the half-open probe, the replay at t = 0.8 is rejected and requeued.
+    [self yg_waitUntil:openedTimestamp + 0.6];
+    XCTestExpectation *probeExpectation = [self expectationWithDescription:@"probe"];
+    [self yg_sendPath:@"/v1/probe" config:nil onFinished:^(id responseObject, NSError *error) {
+        XCTAssertNil(error);
+        [probeExpectation fulfill];
+    }];
+    XCTAssertEqual([circuitBreaker stateForHost:@"api.example.com"], kYGCircuitBreakerStateHalfOpen);
+
+    [self yg_waitUntil:openedTimestamp + 1.0];
+    XCTAssertEqual(offlineQueue.count, 1);
+    XCTAssertTrue(offlineQueue.isReplayPaused);
+    XCTAssertEqual(finishedCount, 0);
+
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+    XCTAssertEqual(finishedCount, 1);
+    XCTAssertEqual(offlineQueue.count, 0);
+}
+
+#pragma mark - Graph Request
+
+/**
+ 依赖不存在、依赖自身、形成环或者节点重名的图请求不能通过检查.
+ */
+- (void)testGraphRequestValidation
+{
+    YGGraphNodeConfigBlock configBlock = ^(YGRequest *request, NSDictionary<NSString *, id> *dependencyResponses) {};
+
+    YGGraphRequest *graphRequest = [[YGGraphRequest alloc] init];
+    [graphRequest addNode:@"user" dependencies:nil config:configBlock];
+    [graphRequest addNode:@"orders" dependencies:@[@"user"] config:configBlock];
+    [graphRequest addNode:@"profile" dependencies:@[@"user"] config:configBlock];
+    [graphRequest addNode:@"summary" dependencies:@[@"orders", @"profile"] config:configBlock];
+    XCTAssertTrue([graphRequest validateDependencies]);
+
+    graphRequest = [[YGGraphRequest alloc] init];
+    [graphRequest addNode:@"orders" dependencies:@[@"user"] config:configBlock];
+    XCTAssertFalse([graphRequest validateDependencies]);
+
+    graphRequest = [[YGGraphRequest alloc] init];
+    [graphRequest addNode:@"user" dependencies:@[@"user"] config:configBlock];
+    XCTAssertFalse([graphRequest validateDependencies]);
+
+    graphRequest = [[YGGraphRequest alloc] init];
+    [graphRequest addNode:@"root" dependencies:nil config:configBlock];
+    [graphRequest addNode:@"a" dependencies:@[@"root", @"c"] config:configBlock];
+    [graphRequest addNode:@"b" dependencies:@[@"a"] config:configBlock];
+    [graphRequest addNode:@"c" dependencies:@[@"b"] config:configBlock];
+    XCTAssertFalse([graphRequest validateDependencies]);
+
+    graphRequest = [[YGGraphRequest alloc] init];
+    [graphRequest addNode:@"user" dependencies:nil config:configBlock];
+    BOOL raised = NO;
+    @try {
+        [graphRequest addNode:@"user" dependencies:nil config:configBlock];
+    } @catch (NSException *exception) {
+        raised = YES;
+    }
+    // builds without assertions reject the graph when it is checked.
+    XCTAssertTrue(raised || ![graphRequest validateDependencies]);
+}
+
+/**
+ 节点在依赖的节点都成功后运行并收到它们的结果，所有节点成功时回调成功 block.
+ */
+- (void)testGraphRequestDependencies
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/user" JSON:@{@"id": @"1"} statusCode:200 delay:0],
+                             [self yg_entryWithPath:@"/v1/users/1/orders" JSON:@[@"o1"] statusCode:200 delay:0.1],
+                             [self yg_entryWithPath:@"/v1/users/1/profile" JSON:@{@"name": @"alice"} statusCode:200 delay:0],
+                             [self yg_entryWithPath:@"/v1/summary" JSON:@{@"ok": @YES} statusCode:200 delay:0]]];
+
+    __block NSDictionary *summaryDependencies = nil;
+    NSDictionary *errors = nil;
+    NSDictionary *responseObjects = [self yg_resultOfGraphRequest:^(YGGraphRequest *graphRequest) {
+        [graphRequest addNode:@"user" dependencies:nil config:^(YGRequest *request, NSDictionary<NSString *, id> *dependencyResponses) {
+            [self yg_setupRequest:request path:@"/v1/user"];
+        }];
+        for (NSString *name in @[@"orders", @"profile"]) {
+            [graphRequest addNode:name dependencies:@[@"user"] config:^(YGRequest *request, NSDictionary<NSString *, id> *dependencyResponses) {
+                NSString *path = [NSString stringWithFormat:@"/v1/users/%@/%@", dependencyResponses[@"user"][@"id"], name];
+                [self yg_setupRequest:request path:path];
+            }];
+        }
+        [graphRequest addNode:@"summary" dependencies:@[@"orders", @"profile"] config:^(YGRequest *request, NSDictionary<NSString *, id> *dependencyResponses) {
+            summaryDependencies = dependencyResponses;
+            [self yg_setupRequest:request path:@"/v1/summary"];
+        }];
+    } errors:&errors];
+
+    XCTAssertNil(errors);
+    XCTAssertEqualObjects(summaryDependencies, (@{@"orders": @[@"o1"], @"profile": @{@"name": @"alice"}}));
+    XCTAssertEqualObjects(responseObjects, (@{@"user": @{@"id": @"1"},
+                                              @"orders": @[@"o1"],
+                                              @"profile": @{@"name": @"alice"},
+                                              @"summary": @{@"ok": @YES}}));
+}
+
+/**
+ `kYGGraphNodeFailureFailFast` 的节点失败时取消正在运行和还未运行的节点，不等待正在运行的节点结束.
+ */
+- (void)testGraphRequestFailFast
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/user" JSON:@{} statusCode:404 delay:0],
+                             [self yg_entryWithPath:@"/v1/feed" JSON:@{} statusCode:200 delay:2]]];
+
+    NSTimeInterval startTimestamp = [NSProcessInfo processInfo].systemUptime;
+    NSDictionary *errors = nil;
+    NSDictionary *responseObjects = [self yg_resultOfGraphRequest:^(YGGraphRequest *graphRequest) {
+        [self yg_addNode:@"user" path:@"/v1/user" dependencies:nil toGraphRequest:graphRequest];
+        [self yg_addNode:@"feed" path:@"/v1/feed" dependencies:nil toGraphRequest:graphRequest];
+        [self yg_addNode:@"orders" path:@"/v1/orders" dependencies:@[@"user"] toGraphRequest:graphRequest];
+    } errors:&errors];
+
+    XCTAssertNil(responseObjects);
+    XCTAssertLessThan([NSProcessInfo processInfo].systemUptime - startTimestamp, 1.5);
+    XCTAssertEqual(errors.count, 3);
+    XCTAssertTrue([errors[@"user"] isKindOfClass:[NSError class]]);
+    XCTAssertNotEqual([errors[@"user"] code], NSURLErrorCancelled);
+    XCTAssertEqual([errors[@"feed"] code], NSURLErrorCancelled);
+    XCTAssertEqual([errors[@"orders"] code], NSURLErrorCancelled);
+}
+
+/**
+ `kYGGraphNodeFailureContinue` 的节点失败时直接和间接依赖它的节点以 `kYGErrorGraphDependencyFailed` 跳过，其它节点继续运行.
+ */
+- (void)testGraphRequestContinue
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/user" JSON:@{} statusCode:404 delay:0],
+                             [self yg_entryWithPath:@"/v1/feed" JSON:@{@"name": @"A"} statusCode:200 delay:0.2]]];
+
+    NSDictionary *errors = nil;
+    NSDictionary *responseObjects = [self yg_resultOfGraphRequest:^(YGGraphRequest *graphRequest) {
+        [self yg_addNode:@"user" path:@"/v1/user" dependencies:nil toGraphRequest:graphRequest].failurePolicy = kYGGraphNodeFailureContinue;
+        [self yg_addNode:@"feed" path:@"/v1/feed" dependencies:nil toGraphRequest:graphRequest];
+        [self yg_addNode:@"orders" path:@"/v1/orders" dependencies:@[@"user"] toGraphRequest:graphRequest];
+        [self yg_addNode:@"invoices" path:@"/v1/invoices" dependencies:@[@"orders"] toGraphRequest:graphRequest];
+    } errors:&errors];
+
+    XCTAssertNil(responseObjects);
+    XCTAssertTrue([errors[@"user"] isKindOfClass:[NSError class]]);
+    XCTAssertEqualObjects(errors[@"feed"], @{@"name": @"A"});
+    for (NSString *name in @[@"orders", @"invoices"]) {
+        XCTAssertEqualObjects([errors[name] domain], YGErrorDomain);
+        XCTAssertEqual([errors[name] code], kYGErrorGraphDependencyFailed);
+    }
+}
+
+/**
+ `kYGGraphNodeFailureFallback` 的节点失败时使用 `fallbackResponseObject` 作为结果，依赖它的节点正常运行.
+ */
+- (void)testGraphRequestFallback
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/settings" JSON:@{} statusCode:404 delay:0],
+                             [self yg_entryWithPath:@"/v1/feed/en" JSON:@{@"name": @"A"} statusCode:200 delay:0]]];
+
+    NSDictionary *errors = nil;
+    NSDictionary *responseObjects = [self yg_resultOfGraphRequest:^(YGGraphRequest *graphRequest) {
+        YGGraphNode *settingsNode = [self yg_addNode:@"settings" path:@"/v1/settings" dependencies:nil toGraphRequest:graphRequest];
+        settingsNode.failurePolicy = kYGGraphNodeFailureFallback;
+        settingsNode.fallbackResponseObject = @{@"lang": @"en"};
+        [graphRequest addNode:@"feed" dependencies:@[@"settings"] config:^(YGRequest *request, NSDictionary<NSString *, id> *dependencyResponses) {
+            [self yg_setupRequest:request path:[@"/v1/feed/" stringByAppendingString:dependencyResponses[@"settings"][@"lang"]]];
+        }];
+    } errors:&errors];
+
+    XCTAssertNil(errors);
+    XCTAssertEqualObjects(responseObjects, (@{@"settings": @{@"lang": @"en"}, @"feed": @{@"name": @"A"}}));
+}
+
+/**
+ 同时运行的节点数不超过 `maxConcurrent`，后面的节点在有节点结束后才开始运行.
+ */
+- (void)testGraphRequestMaxConcurrent
+{
+    NSMutableArray *entries = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 4; i++) {
+        [entries addObject:[self yg_entryWithPath:[NSString stringWithFormat:@"/v1/items/%lu", (unsigned long)i] JSON:@{} statusCode:200 delay:0.3]];
+    }
+    [self yg_replayEntries:entries];
+
+    NSMutableDictionary<NSString *, NSNumber *> *startTimestamps = [NSMutableDictionary dictionary];
+    NSTimeInterval startTimestamp = [NSProcessInfo processInfo].systemUptime;
+    NSDictionary *errors = nil;
+    NSDictionary *responseObjects = [self yg_resultOfGraphRequest:^(YGGraphRequest *graphRequest) {
+        graphRequest.maxConcurrent = 2;
+        for (NSUInteger i = 0; i < 4; i++) {
+            NSString *name = [NSString stringWithFormat:@"%lu", (unsigned long)i];
+            [graphRequest addNode:name dependencies:nil config:^(YGRequest *request, NSDictionary<NSString *, id> *dependencyResponses) {
+                @synchronized (startTimestamps) {
+                    startTimestamps[name] = @([NSProcessInfo processInfo].systemUptime - startTimestamp);
+                }
+                [self yg_setupRequest:request path:[@"/v1/items/" stringByAppendingString:name]];
+            }];
+        }
+    } errors:&errors];
+
+    XCTAssertNil(errors);
+    XCTAssertEqual(responseObjects.count, 4);
+    XCTAssertLessThan(startTimestamps[@"0"].doubleValue, 0.2);
+    XCTAssertLessThan(startTimestamps[@"1"].doubleValue, 0.2);
+    XCTAssertGreaterThanOrEqual(startTimestamps[@"2"].doubleValue, 0.25);
+    XCTAssertGreaterThanOrEqual(startTimestamps[@"3"].doubleValue, 0.25);
+    XCTAssertGreaterThanOrEqual([NSProcessInfo processInfo].systemUptime - startTimestamp, 0.55);
+}
+
+#pragma mark - Response Processing
+
+/**
+ 开启 `responseStreamingEnabled` 后增量解析的结果和一次性解析的结果一致.
+ */
+- (void)testStreamingResponse
+{
+    NSArray *JSON = @[@{@"id": @"1", @"name": @"alice"}, @{@"id": @"2", @"name": @"bob"}, @{@"id": @"3", @"name": @"carol"}];
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/users" JSON:JSON statusCode:200 delay:0]]];
+
+    NSError *error = nil;
+    id responseObject = [self yg_resultOfPath:@"/v1/users" config:^(YGRequest *request) {
+        request.responseStreamingEnabled = YES;
+    } request:NULL error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(responseObject, JSON);
+
+    // the same body delivered one byte at a time.
+    NSData *body = [NSJSONSerialization dataWithJSONObject:JSON options:0 error:nil];
+    YGJSONStreamParser *parser = [YGJSONStreamParser parserWithReadingOptions:0];
+    for (NSUInteger i = 0; i < body.length; i++) {
+        XCTAssertTrue([parser appendData:[body subdataWithRange:NSMakeRange(i, 1)] error:&error], @"%@", error);
+    }
+    XCTAssertEqualObjects([parser finishWithError:&error], JSON);
+    XCTAssertNil(error);
+}
+
+/**
+ 列表包在字典中时，设置 `responseStreamingKeyPath` 后列表元素在到达时就被解析，不会等到根字典结束.
+ */
+- (void)testStreamingEnvelopeResponse
+{
+    NSMutableArray *list = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 100; i++) {
+        [list addObject:@{@"id": @(i), @"name": [NSString stringWithFormat:@"user \"%lu\", {%lu}", (unsigned long)i, (unsigned long)i]}];
+    }
+    NSDictionary *JSON = @{@"code": @0, @"message": @"ok", @"data": list};
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/users" JSON:JSON statusCode:200 delay:0]]];
+
+    NSError *error = nil;
+    id responseObject = [self yg_resultOfPath:@"/v1/users" config:^(YGRequest *request) {
+        request.responseStreamingEnabled = YES;
+        request.responseStreamingKeyPath = @"data";
+    } request:NULL error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(responseObject, JSON);
+
+    // without the key path the whole `data` member waits for its last byte.
+    NSData *body = [NSJSONSerialization dataWithJSONObject:JSON options:0 error:nil];
+    NSUInteger half = body.length / 2;
+    YGJSONStreamParser *parser = [YGJSONStreamParser parserWithReadingOptions:0];
+    XCTAssertTrue([parser appendData:[body subdataWithRange:NSMakeRange(0, half)] error:&error]);
+    XCTAssertLessThan(parser.parsedByteCount, half / 2);
+
+    parser = [YGJSONStreamParser parserWithReadingOptions:0 streamingKeyPath:@"data"];
+    for (NSUInteger i = 0; i < half; i += 7) {
+        XCTAssertTrue([parser appendData:[body subdataWithRange:NSMakeRange(i, MIN(7, half - i))] error:&error], @"%@", error);
+    }
+    XCTAssertGreaterThan(parser.parsedByteCount, half / 2);
+    XCTAssertLessThan(parser.bufferedByteCount, (NSUInteger)64);
+    XCTAssertTrue([parser appendData:[body subdataWithRange:NSMakeRange(half, body.length - half)] error:&error]);
+    NSDictionary *result = [parser finishWithError:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(result, JSON);
+    XCTAssertFalse([result[@"data"] isKindOfClass:[NSMutableArray class]]);
+
+    // a nested key path, with mutable containers.
+    NSDictionary *nested = @{@"code": @0, @"data": @{@"total": @2, @"list": @[@1, @[@2, @3]]}, @"tail": @[]};
+    body = [NSJSONSerialization dataWithJSONObject:nested options:0 error:nil];
+    parser = [YGJSONStreamParser parserWithReadingOptions:NSJSONReadingMutableContainers streamingKeyPath:@"data.list"];
+    for (NSUInteger i = 0; i < body.length; i++) {
+        XCTAssertTrue([parser appendData:[body subdataWithRange:NSMakeRange(i, 1)] error:&error], @"%@", error);
+    }
+    result = [parser finishWithError:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(result, nested);
+    XCTAssertTrue([result[@"data"][@"list"] isKindOfClass:[NSMutableArray class]]);
+
+    // a member after a streamed container must be separated by a comma.
+    parser = [YGJSONStreamParser parserWithReadingOptions:0 streamingKeyPath:@"data"];
+    [parser appendData:[@"{\"data\": [1, 2] \"code\": 0}" dataUsingEncoding:NSUTF8StringEncoding] error:NULL];
+    XCTAssertNil([parser finishWithError:&error]);
+    XCTAssertNotNil(error);
+}
+
+/**
+ 设置 `responseModelClass` 后成功回调在 `callbackQueue` 中执行，收到映射后的模型对象.
+ */
+- (void)testModelMappingOnCallbackQueue
+{
+    [self yg_replayEntries:@[[self yg_entryWithPath:@"/v1/user/profile" JSON:@{@"id": @"1", @"name": @"alice"} statusCode:200 delay:0]]];
+    dispatch_queue_t callbackQueue = dispatch_queue_create("com.ygnetworking.tests.callback", DISPATCH_QUEUE_SERIAL);
+    dispatch_queue_set_specific(callbackQueue, YGRecordReplayTestsCallbackQueueKey, YGRecordReplayTestsCallbackQueueKey, NULL);
+    self.center.callbackQueue = callbackQueue;
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"mapping"];
+    [self.center sendRequest:^(YGRequest *request) {
+        [self yg_setupRequest:request path:@"/v1/user/profile"];
+        request.responseModelClass = [YGRecordReplayTestsUser class];
+    } onProgress:nil onSuccess:^(id responseObject) {
+        XCTAssertTrue(dispatch_get_specific(YGRecordReplayTestsCallbackQueueKey) == YGRecordReplayTestsCallbackQueueKey);
+        XCTAssertTrue([responseObject isKindOfClass:[YGRecordReplayTestsUser class]]);
+        XCTAssertEqualObjects([responseObject userId], @"1");
+        XCTAssertEqualObjects([responseObject name], @"alice");
+    } onFailure:^(NSError *error) {
+        XCTFail(@"%@", error);
+    } onFinished:^(id responseObject, NSError *error) {
+        XCTAssertTrue(dispatch_get_specific(YGRecordReplayTestsCallbackQueueKey) == YGRecordReplayTestsCallbackQueueKey);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+#pragma mark - Private Methods
+
+/**
+ 清理缓存的磁盘层，等到清理结束才返回.
+ */
+- (void)yg_trimDiskOfCache:(YGCache *)cache
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"trim"];
+    [cache trimDiskWithBlock:^{
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+- (NSArray<NSString *> *)yg_contentsOfDirectoryAtPath:(NSString *)path
+{
+    return [[NSFileManager defaultManager] contentsOfDirectoryAtPath:path error:nil];
+}
+
+- (NSUInteger)yg_fileCountAtPath:(NSString *)path
+{
+    return [self yg_contentsOfDirectoryAtPath:path].count;
+}
+
+/**
+ 存档中的一个条目，响应体为 JSON，`delay` 为收到响应头的耗时.
+ */
+- (NSDictionary *)yg_entryWithPath:(NSString *)path JSON:(id)JSON statusCode:(NSInteger)statusCode delay:(NSTimeInterval)delay
+{
+    NSData *body = [NSJSONSerialization dataWithJSONObject:JSON options:0 error:nil];
+    return @{@"method": @"GET",
+             @"url": [YGRecordReplayTestsServer stringByAppendingString:path],
+             @"statusCode": @(statusCode),
+             @"headers": @{@"Content-Type": @"application/json"},
+             @"body": [body base64EncodedStringWithOptions:0],
+             @"responseDelay": @(delay),
+             @"duration": @(delay)};
+}
+
+/**
+ 存档中一个以 NSURLErrorDomain 错误结束的条目.
+ */
+- (NSDictionary *)yg_entryWithPath:(NSString *)path errorCode:(NSInteger)errorCode
+{
+    return @{@"method": @"GET",
+             @"url": [YGRecordReplayTestsServer stringByAppendingString:path],
+             @"statusCode": @0,
+             @"headers": @{},
+             @"body": @"",
+             @"responseDelay": @0,
+             @"duration": @0,
+             @"error": @{@"domain": NSURLErrorDomain, @"code": @(errorCode)}};
+}
+
+/**
+ 写入存档并让 YGEngine 按存档中的耗时回放.
+ */
+- (void)yg_replayEntries:(NSArray<NSDictionary *> *)entries
+{
+    NSString *path = [self.directory stringByAppendingPathComponent:@"archive.json"];
+    NSDictionary *archive = @{@"version": @1, @"entries": entries};
+    XCTAssertTrue([[NSJSONSerialization dataWithJSONObject:archive options:0 error:nil] writeToFile:path atomically:YES]);
+
+    NSError *error = nil;
+    YGRecordReplayTransport *transport = [YGRecordReplayTransport replayerWithArchivePath:path error:&error];
+    XCTAssertNotNil(transport, @"%@", error);
+    XCTAssertEqual(transport.entryCount, entries.count);
+    transport.latencyScale = 1;
+    self.center.engine.recordReplayTransport = transport;
+}
+
+/**
+ 运行 run loop 直到系统启动时间 `timestamp`.
+ */
+- (void)yg_waitUntil:(NSTimeInterval)timestamp
+{
+    NSTimeInterval interval = timestamp - [NSProcessInfo processInfo].systemUptime;
+    if (interval > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:interval]];
+    }
+}
+
+- (void)yg_setupRequest:(YGRequest *)request path:(NSString *)path
+{
+    request.url = [YGRecordReplayTestsServer stringByAppendingString:path];
+    request.httpMethod = kYGHTTPMethodGET;
+    request.useGeneralServer = NO;
+    request.useGeneralHeaders = NO;
+    request.useGeneralParameters = NO;
+}
+
+- (void)yg_sendPath:(NSString *)path config:(YGRequestConfigBlock)configBlock onFinished:(YGFinishedBlock)finishedBlock
+{
+    [self.center sendRequest:^(YGRequest *request) {
+        [self yg_setupRequest:request path:path];
+        YG_NETWORKING_SAFE_BLOCK(configBlock, request);
+    } onFinished:finishedBlock];
+}
+
+/**
+ 发送请求，结束时把路径按结束的顺序加入 `finishedPaths`.
+ */
+- (void)yg_sendPath:(NSString *)path priority:(YGRequestPriority)priority finishedPaths:(NSMutableArray<NSString *> *)finishedPaths
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:path];
+    [self yg_sendPath:path config:^(YGRequest *request) {
+        request.priority = priority;
+    } onFinished:^(id responseObject, NSError *error) {
+        XCTAssertNil(error);
+        @synchronized (finishedPaths) {
+            [finishedPaths addObject:path];
+        }
+        [expectation fulfill];
+    }];
+}
+
+/**
+ 添加一个请求 `path` 的图节点.
+ */
+- (YGGraphNode *)yg_addNode:(NSString *)name path:(NSString *)path dependencies:(NSArray<NSString *> *)dependencies toGraphRequest:(YGGraphRequest *)graphRequest
+{
+    return [graphRequest addNode:name dependencies:dependencies config:^(YGRequest *request, NSDictionary<NSString *, id> *dependencyResponses) {
+        [self yg_setupRequest:request path:path];
+    }];
+}
+
+/**
+ 发送图请求并等待结束，成功时返回所有节点的结果，失败时返回 `nil` 并通过 `errors` 返回所有节点的结果和错误.
+ */
+- (NSDictionary *)yg_resultOfGraphRequest:(YGGraphRequestConfigBlock)configBlock errors:(NSDictionary * __autoreleasing *)errors
+{
+    __block NSDictionary *resultObjects = nil;
+    __block NSDictionary *resultErrors = nil;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"graph"];
+    NSString *identifier = [self.center sendGraphRequest:configBlock onSuccess:nil onFailure:nil onFinished:^(NSDictionary *responseObjects, NSDictionary *errors) {
+        resultObjects = responseObjects;
+        resultErrors = errors;
+        [expectation fulfill];
+    }];
+    XCTAssertNotNil(identifier);
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+
+    if (errors) {
+        *errors = resultErrors;
+    }
+    return resultObjects;
+}
+
+/**
+ 发送请求并等待结束，返回响应对象.
+ */
+- (id)yg_resultOfPath:(NSString *)path
+               config:(YGRequestConfigBlock)configBlock
+              request:(YGRequest * __autoreleasing *)sentRequest
+                error:(NSError * __autoreleasing *)error
+{
+    __block YGRequest *resultRequest = nil;
+    __block id resultObject = nil;
+    __block NSError *resultError = nil;
+    XCTestExpectation *expectation = [self expectationWithDescription:path];
+    [self yg_sendPath:path config:^(YGRequest *request) {
+        YG_NETWORKING_SAFE_BLOCK(configBlock, request);
+        resultRequest = request;
+    } onFinished:^(id responseObject, NSError *error) {
+        resultObject = responseObject;
+        resultError = error;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+
+    if (sentRequest) {
+        *sentRequest = resultRequest;
+    }
+    if (error) {
+        *error = resultError;
+    }
+    return resultObject;
+}
+
+@end
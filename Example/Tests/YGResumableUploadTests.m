@@ -0,0 +1,226 @@
+//
+//  YGResumableUploadTests.m
+//  YGNetworking_Tests
+//
+//  Created by Sun on 2020/5/8.
+//  Copyright © 2020 oneofai. All rights reserved.
+//
+
+@import XCTest;
+
+#import <YGNetworking/YGNetworking.h>
+
+#import "YGBenchmarkServer.h"
+
+/// 测试使用的分块长度，上传文件被分成 3 块.
+static const NSUInteger YGResumableUploadTestsChunkSize = 128 * 1024;
+
+/**
+ 可续传上传 (tus 1.0) 的测试，上传路径由本地的 `YGBenchmarkServer` 提供，每个测试使用新的 YGEngine 和上传记录目录.
+ */
+@interface YGResumableUploadTests : XCTestCase
+
+@property (nonatomic, strong) YGBenchmarkServer *server;
+@property (nonatomic, strong) NSURL *creationURL;
+@property (nonatomic, copy) NSString *directory;
+@property (nonatomic, strong) NSURL *fileURL;
+@property (nonatomic, strong) NSData *fileData;
+
+@end
+
+@implementation YGResumableUploadTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    self.server = [[YGBenchmarkServer alloc] init];
+    NSError *error = nil;
+    XCTAssertTrue([self.server start:&error], @"%@", error);
+    self.creationURL = [self.server enableUploadsAtPath:@"/files"];
+
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.directory withIntermediateDirectories:YES attributes:nil error:nil];
+
+    NSMutableData *fileData = [NSMutableData dataWithLength:300 * 1024];
+    uint8_t *bytes = fileData.mutableBytes;
+    for (NSUInteger i = 0; i < fileData.length; i++) {
+        bytes[i] = (uint8_t)((i * 31 + i / 251) % 251);
+    }
+    self.fileData = fileData;
+    self.fileURL = [NSURL fileURLWithPath:[self.directory stringByAppendingPathComponent:@"upload.bin"] isDirectory:NO];
+    XCTAssertTrue([fileData writeToURL:self.fileURL atomically:YES]);
+}
+
+- (void)tearDown
+{
+    [self.server stop];
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+/**
+ 没有上传记录时 POST 创建上传，再按块 PATCH，成功回调得到最后一个 PATCH 响应解析后的对象，完成后删除上传记录.
+ */
+- (void)testCreateAndUpload
+{
+    YGUploadResumeStore *store = [self yg_store];
+    YGRequest *request = nil;
+    NSError *error = nil;
+    id responseObject = [self yg_uploadWithStore:store request:&request error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(responseObject, (@{@"id": @"1", @"length": @(self.fileData.length)}));
+
+    NSURL *uploadURL = [self.server URLForPath:@"/files/1"];
+    XCTAssertEqualObjects(request.resumableUploadURL, uploadURL);
+    XCTAssertEqualObjects([self.server uploadDataForURL:uploadURL], self.fileData);
+    XCTAssertNil([store uploadURLForURL:self.creationURL.absoluteString fileURL:self.fileURL]);
+
+    NSArray<YGBenchmarkServerRequest *> *requests = self.server.requests;
+    XCTAssertEqualObjects([requests valueForKey:@"method"], (@[@"POST", @"PATCH", @"PATCH", @"PATCH"]));
+    XCTAssertEqualObjects(requests[0].headers[@"upload-length"], @"307200");
+    XCTAssertEqualObjects(requests[0].headers[@"tus-resumable"], @"1.0.0");
+    XCTAssertEqualObjects([[requests subarrayWithRange:NSMakeRange(1, 3)] valueForKeyPath:@"headers.upload-offset"], (@[@"0", @"131072", @"262144"]));
+    XCTAssertEqualObjects([requests valueForKey:@"statusCode"], (@[@201, @204, @204, @200]));
+}
+
+/**
+ 应用重启后 (新的 YGEngine 和上传记录对象) 通过 HEAD 协商偏移量，从服务器已经接收的位置继续上传，不重新创建上传.
+ */
+- (void)testResumeAfterRelaunch
+{
+    NSUInteger receivedLength = 100 * 1024;
+    NSURL *uploadURL = [self.server createUploadWithLength:(long long)self.fileData.length data:[self.fileData subdataWithRange:NSMakeRange(0, receivedLength)]];
+    [[self yg_store] setUploadURL:uploadURL forURL:self.creationURL.absoluteString fileURL:self.fileURL];
+
+    YGRequest *request = nil;
+    NSError *error = nil;
+    [self yg_uploadWithStore:[self yg_store] request:&request error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(request.resumableUploadURL, uploadURL);
+    XCTAssertEqualObjects([self.server uploadDataForURL:uploadURL], self.fileData);
+
+    NSArray<YGBenchmarkServerRequest *> *requests = self.server.requests;
+    XCTAssertEqualObjects([requests valueForKey:@"method"], (@[@"HEAD", @"PATCH", @"PATCH"]));
+    XCTAssertEqualObjects(requests[1].headers[@"upload-offset"], @"102400");
+    XCTAssertEqualObjects(requests[2].headers[@"upload-offset"], @"233472");
+}
+
+/**
+ 服务器上的上传已经过期 (410) 时删除上传记录并重新创建上传.
+ */
+- (void)testExpiredUploadRestarts
+{
+    NSURL *expiredURL = [self.server createUploadWithLength:(long long)self.fileData.length data:[self.fileData subdataWithRange:NSMakeRange(0, 1024)]];
+    [self.server expireUploads];
+    [self yg_assertUploadRestartsFromURL:expiredURL statusCode:410];
+}
+
+/**
+ 服务器上的上传不存在 (404) 时删除上传记录并重新创建上传.
+ */
+- (void)testMissingUploadRestarts
+{
+    [self yg_assertUploadRestartsFromURL:[self.server URLForPath:@"/files/404"] statusCode:404];
+}
+
+/**
+ PATCH 的偏移量和服务器不一致 (409) 时重新通过 HEAD 协商偏移量，从服务器的偏移量继续上传.
+ */
+- (void)testConflictRenegotiatesOffset
+{
+    [self.server failNextUploadPatchesWithConflict:1];
+
+    YGRequest *request = nil;
+    NSError *error = nil;
+    id responseObject = [self yg_uploadWithStore:[self yg_store] request:&request error:&error];
+    XCTAssertNil(error);
+    XCTAssertNotNil(responseObject);
+    XCTAssertEqualObjects([self.server uploadDataForURL:request.resumableUploadURL], self.fileData);
+
+    NSArray<YGBenchmarkServerRequest *> *requests = self.server.requests;
+    XCTAssertEqualObjects([requests valueForKey:@"method"], (@[@"POST", @"PATCH", @"HEAD", @"PATCH", @"PATCH", @"PATCH"]));
+    XCTAssertEqual(requests[1].statusCode, 409);
+    XCTAssertEqualObjects(requests[3].headers[@"upload-offset"], @"0");
+}
+
+/**
+ 服务器已经接收了整个文件时不再 PATCH，响应对象为 `nil`.
+ */
+- (void)testCompletedUploadSkipsPatch
+{
+    NSURL *uploadURL = [self.server createUploadWithLength:(long long)self.fileData.length data:self.fileData];
+    YGUploadResumeStore *store = [self yg_store];
+    [store setUploadURL:uploadURL forURL:self.creationURL.absoluteString fileURL:self.fileURL];
+
+    YGRequest *request = nil;
+    NSError *error = nil;
+    id responseObject = [self yg_uploadWithStore:store request:&request error:&error];
+    XCTAssertNil(error);
+    XCTAssertNil(responseObject);
+    XCTAssertEqualObjects([self.server.requests valueForKey:@"method"], (@[@"HEAD"]));
+    XCTAssertNil([store uploadURLForURL:self.creationURL.absoluteString fileURL:self.fileURL]);
+}
+
+#pragma mark - Private Methods
+
+/**
+ 每次返回一个新的上传记录对象，目录相同，模拟应用重启后读取持久化的上传记录.
+ */
+- (YGUploadResumeStore *)yg_store
+{
+    return [YGUploadResumeStore storeWithPath:[self.directory stringByAppendingPathComponent:@"uploads"]];
+}
+
+- (void)yg_assertUploadRestartsFromURL:(NSURL *)staleURL statusCode:(NSInteger)statusCode
+{
+    YGUploadResumeStore *store = [self yg_store];
+    [store setUploadURL:staleURL forURL:self.creationURL.absoluteString fileURL:self.fileURL];
+
+    YGRequest *request = nil;
+    NSError *error = nil;
+    [self yg_uploadWithStore:store request:&request error:&error];
+    XCTAssertNil(error);
+    XCTAssertNotEqualObjects(request.resumableUploadURL, staleURL);
+    XCTAssertEqualObjects([self.server uploadDataForURL:request.resumableUploadURL], self.fileData);
+
+    NSArray<YGBenchmarkServerRequest *> *requests = self.server.requests;
+    XCTAssertEqualObjects([[requests subarrayWithRange:NSMakeRange(0, 3)] valueForKey:@"method"], (@[@"HEAD", @"POST", @"PATCH"]));
+    XCTAssertEqual(requests[0].statusCode, statusCode);
+    XCTAssertEqualObjects(requests[2].headers[@"upload-offset"], @"0");
+}
+
+- (id)yg_uploadWithStore:(YGUploadResumeStore *)store request:(YGRequest * __autoreleasing *)sentRequest error:(NSError * __autoreleasing *)error
+{
+    YGCenter *center = [YGCenter center];
+    center.engine = [YGEngine engine];
+    center.engine.uploadResumeStore = store;
+
+    __block YGRequest *uploadRequest = nil;
+    __block id uploadResponseObject = nil;
+    __block NSError *uploadError = nil;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"upload"];
+    [center sendRequest:^(YGRequest *request) {
+        request.url = self.creationURL.absoluteString;
+        request.useGeneralServer = NO;
+        request.useGeneralHeaders = NO;
+        request.useGeneralParameters = NO;
+        request.requestType = kYGRequestUpload;
+        request.uploadFileURL = self.fileURL;
+        request.resumableUploadEnabled = YES;
+        request.uploadChunkSize = YGResumableUploadTestsChunkSize;
+        request.responseSerializerType = kYGResponseSerializerJSON;
+        uploadRequest = request;
+    } onFinished:^(id responseObject, NSError *error) {
+        uploadResponseObject = responseObject;
+        uploadError = error;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:30 handler:nil];
+
+    *sentRequest = uploadRequest;
+    *error = uploadError;
+    return uploadResponseObject;
+}
+
+@end
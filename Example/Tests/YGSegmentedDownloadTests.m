@@ -0,0 +1,247 @@
+//
+//  YGSegmentedDownloadTests.m
+//  YGNetworking_Tests
+//
+//  Created by Sun on 2020/5/8.
+//  Copyright © 2020 oneofai. All rights reserved.
+//
+
+@import XCTest;
+
+#import <YGNetworking/YGNetworking.h>
+
+#import "YGBenchmarkServer.h"
+
+/**
+ 分段下载的测试，文件资源由本地的 `YGBenchmarkServer` 提供，每个测试使用新的 YGEngine.
+ */
+@interface YGSegmentedDownloadTests : XCTestCase
+
+@property (nonatomic, strong) YGBenchmarkServer *server;
+@property (nonatomic, strong) YGCenter *center;
+@property (nonatomic, copy) NSString *directory;
+
+@end
+
+@implementation YGSegmentedDownloadTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    self.server = [[YGBenchmarkServer alloc] init];
+    NSError *error = nil;
+    XCTAssertTrue([self.server start:&error], @"%@", error);
+
+    self.center = [YGCenter center];
+    self.center.engine = [YGEngine engine];
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.directory withIntermediateDirectories:YES attributes:nil error:nil];
+}
+
+- (void)tearDown
+{
+    [self.server stop];
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+/**
+ HEAD 探测到文件长度和 Range 支持后按字节范围同时下载，每个分段带有 If-Range，合并后的文件和服务器上的一致.
+ */
+- (void)testSegmentedDownload
+{
+    NSData *data = [self yg_fileDataWithLength:4 * 1024 * 1024];
+    NSURL *URL = [self.server setFileData:data forPath:@"/segmented.bin"];
+    NSString *entityTag = [self.server entityTagForPath:@"/segmented.bin"];
+
+    __block int64_t completedUnitCount = 0;
+    NSURL *fileURL = [self yg_downloadURL:URL segmentCount:4 progress:^(NSProgress *progress) {
+        completedUnitCount = progress.completedUnitCount;
+    }];
+    XCTAssertEqualObjects([NSData dataWithContentsOfURL:fileURL], data);
+    XCTAssertEqual(completedUnitCount, (int64_t)data.length);
+
+    NSArray<YGBenchmarkServerRequest *> *requests = self.server.requests;
+    NSArray<YGBenchmarkServerRequest *> *probes = [requests filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"method == 'HEAD'"]];
+    NSArray<YGBenchmarkServerRequest *> *segments = [requests filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"method == 'GET'"]];
+    XCTAssertEqual(probes.count, 1);
+    XCTAssertEqual(segments.count, 4);
+
+    NSSet<NSString *> *ranges = [NSSet setWithArray:[segments valueForKeyPath:@"headers.range"]];
+    NSSet<NSString *> *expectedRanges = [NSSet setWithObjects:@"bytes=0-1048575", @"bytes=1048576-2097151", @"bytes=2097152-3145727", @"bytes=3145728-4194303", nil];
+    XCTAssertEqualObjects(ranges, expectedRanges);
+    for (YGBenchmarkServerRequest *segment in segments) {
+        XCTAssertEqualObjects(segment.headers[@"if-range"], entityTag);
+        XCTAssertEqual(segment.statusCode, 206);
+    }
+}
+
+/**
+ 失败的分段单独重试，其它分段不重新下载.
+ */
+- (void)testSegmentRetry
+{
+    NSData *data = [self yg_fileDataWithLength:2 * 1024 * 1024];
+    NSURL *URL = [self.server setFileData:data forPath:@"/retry.bin"];
+    [self.server failNextRangeRequests:1 statusCode:503];
+
+    NSURL *fileURL = [self yg_downloadURL:URL segmentCount:2 progress:nil];
+    XCTAssertEqualObjects([NSData dataWithContentsOfURL:fileURL], data);
+
+    NSArray<YGBenchmarkServerRequest *> *segments = [self.server.requests filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"method == 'GET'"]];
+    NSArray<YGBenchmarkServerRequest *> *failedSegments = [segments filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"statusCode == 503"]];
+    XCTAssertEqual(segments.count, 3);
+    XCTAssertEqual(failedSegments.count, 1);
+
+    // the retried segment asks for the same range as the one that failed.
+    NSString *failedRange = failedSegments.firstObject.headers[@"range"];
+    NSArray<YGBenchmarkServerRequest *> *retriedSegments = [segments filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"headers.range == %@ AND statusCode == 206", failedRange]];
+    XCTAssertEqual(retriedSegments.count, 1);
+}
+
+/**
+ 分段重试次数用完时整个下载失败，不留下预分配的文件.
+ */
+- (void)testSegmentRetryExhausted
+{
+    NSData *data = [self yg_fileDataWithLength:2 * 1024 * 1024];
+    NSURL *URL = [self.server setFileData:data forPath:@"/exhausted.bin"];
+    [self.server failNextRangeRequests:NSUIntegerMax statusCode:503];
+
+    NSString *savePath = [self.directory stringByAppendingPathComponent:@"exhausted.bin"];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"download"];
+    [self.center sendRequest:^(YGRequest *request) {
+        [self yg_setupRequest:request URL:URL savePath:savePath segmentCount:2];
+        request.downloadSegmentRetryCount = 1;
+    } onFinished:^(id responseObject, NSError *error) {
+        XCTAssertNil(responseObject);
+        XCTAssertEqualObjects(error.domain, NSURLErrorDomain);
+        XCTAssertEqual(error.code, NSURLErrorBadServerResponse);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:30 handler:nil];
+
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:savePath]);
+}
+
+/**
+ 分段的响应体比请求的字节范围短时分段失败并重试，不会在文件中留下空洞.
+ */
+- (void)testShortSegmentRetry
+{
+    NSData *data = [self yg_fileDataWithLength:2 * 1024 * 1024];
+    NSURL *URL = [self.server setFileData:data forPath:@"/short.bin"];
+    [self.server truncateNextRangeResponses:1];
+
+    NSURL *fileURL = [self yg_downloadURL:URL segmentCount:2 progress:nil];
+    XCTAssertEqualObjects([NSData dataWithContentsOfURL:fileURL], data);
+
+    NSArray<YGBenchmarkServerRequest *> *segments = [self.server.requests filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"method == 'GET'"]];
+    XCTAssertEqual(segments.count, 3);
+}
+
+/**
+ 分段的响应体一直不完整时整个下载失败，不把不完整的文件移动到保存路径.
+ */
+- (void)testShortSegmentRetryExhausted
+{
+    NSData *data = [self yg_fileDataWithLength:2 * 1024 * 1024];
+    NSURL *URL = [self.server setFileData:data forPath:@"/truncated.bin"];
+    [self.server truncateNextRangeResponses:NSUIntegerMax];
+
+    NSString *savePath = [self.directory stringByAppendingPathComponent:@"truncated.bin"];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"download"];
+    [self.center sendRequest:^(YGRequest *request) {
+        [self yg_setupRequest:request URL:URL savePath:savePath segmentCount:2];
+        request.downloadSegmentRetryCount = 1;
+    } onFinished:^(id responseObject, NSError *error) {
+        XCTAssertNil(responseObject);
+        XCTAssertEqualObjects(error.domain, NSURLErrorDomain);
+        XCTAssertEqual(error.code, NSURLErrorNetworkConnectionLost);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:30 handler:nil];
+
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:savePath]);
+}
+
+/**
+ 服务器不支持 Range 时退化为单个连接下载，不发送 Range 请求.
+ */
+- (void)testSingleConnectionFallback
+{
+    NSData *data = [self yg_fileDataWithLength:4 * 1024 * 1024];
+    NSURL *URL = [self.server setFileData:data forPath:@"/fallback.bin"];
+    self.server.rangeRequestsEnabled = NO;
+
+    NSURL *fileURL = [self yg_downloadURL:URL segmentCount:4 progress:nil];
+    XCTAssertEqualObjects([NSData dataWithContentsOfURL:fileURL], data);
+
+    NSArray<YGBenchmarkServerRequest *> *segments = [self.server.requests filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"method == 'GET'"]];
+    XCTAssertEqual(segments.count, 1);
+    XCTAssertNil(segments.firstObject.headers[@"range"]);
+    XCTAssertEqual(segments.firstObject.statusCode, 200);
+}
+
+/**
+ 文件小于两个最小分段时不分段.
+ */
+- (void)testSmallFileFallback
+{
+    NSData *data = [self yg_fileDataWithLength:512 * 1024];
+    NSURL *URL = [self.server setFileData:data forPath:@"/small.bin"];
+
+    NSURL *fileURL = [self yg_downloadURL:URL segmentCount:4 progress:nil];
+    XCTAssertEqualObjects([NSData dataWithContentsOfURL:fileURL], data);
+
+    NSArray<YGBenchmarkServerRequest *> *segments = [self.server.requests filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"method == 'GET'"]];
+    XCTAssertEqual(segments.count, 1);
+    XCTAssertNil(segments.firstObject.headers[@"range"]);
+}
+
+#pragma mark - Private Methods
+
+/**
+ 不重复的文件内容，分段写错位置时内容一定不一致.
+ */
+- (NSData *)yg_fileDataWithLength:(NSUInteger)length
+{
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    uint8_t *bytes = data.mutableBytes;
+    for (NSUInteger i = 0; i < length; i++) {
+        bytes[i] = (uint8_t)((i * 31 + i / 251) % 251);
+    }
+    return data;
+}
+
+- (void)yg_setupRequest:(YGRequest *)request URL:(NSURL *)URL savePath:(NSString *)savePath segmentCount:(NSUInteger)segmentCount
+{
+    request.url = URL.absoluteString;
+    request.useGeneralServer = NO;
+    request.useGeneralHeaders = NO;
+    request.useGeneralParameters = NO;
+    request.requestType = kYGRequestDownload;
+    request.downloadSavePath = savePath;
+    request.downloadSegmentCount = segmentCount;
+}
+
+- (NSURL *)yg_downloadURL:(NSURL *)URL segmentCount:(NSUInteger)segmentCount progress:(YGProgressBlock)progressBlock
+{
+    NSString *savePath = [self.directory stringByAppendingPathComponent:URL.lastPathComponent];
+    __block NSURL *fileURL = nil;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"download"];
+    [self.center sendRequest:^(YGRequest *request) {
+        [self yg_setupRequest:request URL:URL savePath:savePath segmentCount:segmentCount];
+    } onProgress:progressBlock onSuccess:nil onFailure:nil onFinished:^(id responseObject, NSError *error) {
+        XCTAssertNil(error);
+        fileURL = responseObject;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:30 handler:nil];
+
+    XCTAssertEqualObjects(fileURL.path, savePath);
+    return fileURL;
+}
+
+@end
@@ -7,10 +7,11 @@
 //
 
 #import <Foundation/Foundation.h>
+#import <YGNetworking/YGNetworking.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
-@interface YGGithubTrendingRepo : NSObject
+@interface YGGithubTrendingRepo : NSObject <YGModel>
 
 /*
  {
@@ -10,6 +10,10 @@
 
 @implementation YGGithubTrendingRepo
 
++ (NSDictionary<NSString *,NSString *> *)modelCustomPropertyMapper {
+    return @{@"desc": @"description"};
+}
+
 // ignore unused keys
 - (void)setValue:(id)value forUndefinedKey:(NSString *)key {}
 
@@ -117,6 +117,14 @@ static NSError * YGNetworkingErrorGenerator(NSInteger code, NSString *msg) {
         // 比如对不同的错误码统一错误提示等
         
     }];
+    
+    // 请求耗时统一上报
+    [YGCenter setMetricsObserverBlock:^(YGRequest *request, YGRequestMetrics *metrics) {
+        // 在这里上报请求各阶段的耗时，如 DNS、建连、首字节和解码耗时等
+#ifdef DEBUG
+        NSLog(@"%@ %@", request.url, metrics);
+#endif
+    }];
 }
 
 @end
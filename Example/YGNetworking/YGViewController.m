@@ -62,15 +62,11 @@
     [YGCenter sendRequest:^(YGRequest * _Nonnull request) {
         request.api = @"/repositories";
         request.httpMethod = kYGHTTPMethodGET;
+        request.responseModelClass = [YGGithubTrendingRepo class];
     } onSuccess:^(id  _Nullable responseObject) {
         
         if ([responseObject isKindOfClass:[NSArray class]] && [responseObject count] > 0) {
-            [responseObject enumerateObjectsUsingBlock:^(id _Nonnull obj, NSUInteger idx, BOOL * _Nonnull stop) {
-                YGGithubTrendingRepo *repo = [[YGGithubTrendingRepo alloc] initWithDictionary:obj];
-                if (repo) {
-                    [self.dataList addObject:repo];
-                }
-            }];
+            [self.dataList addObjectsFromArray:responseObject];
         }
         [self.tableView reloadData];
     } onFailure:^(NSError * _Nullable error) {
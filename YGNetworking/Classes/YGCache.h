@@ -0,0 +1,128 @@
+//
+//  YGCache.h
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `YGCache` 是 YGCenter 持有的响应缓存，由一个按开销限制的内存 LRU 层和一个磁盘层组成.
+
+ 缓存的对象为经过 YGCenter 响应处理后的对象，写入磁盘时会通过 `NSKeyedArchiver` 归档，
+ 不遵循 `NSCoding` 协议的对象只会保存在内存层.
+ 磁盘层在创建时和应用进入后台时清理一次，移除过期的文件，并把总大小限制在 `diskCostLimit` 以内.
+ */
+@interface YGCache : NSObject
+
+///---------------------
+/// @name 初始化
+///---------------------
+
+/**
+ 创建并返回一个 `YGCache` 对象，磁盘层位于 `Library/Caches/com.ygnetworking.cache`.
+ */
++ (instancetype)cache;
+
+/**
+ 创建并返回一个 `YGCache` 对象.
+
+ @param path 磁盘层的目录路径.
+ */
++ (instancetype)cacheWithPath:(NSString *)path;
+
+- (instancetype)initWithPath:(NSString *)path NS_DESIGNATED_INITIALIZER;
+
+///---------------------
+/// @name 属性
+///---------------------
+
+/**
+ 磁盘层的目录路径.
+ */
+@property (nonatomic, copy, readonly) NSString *path;
+
+/**
+ 内存层的最大开销(字节)，超出后按最近最少使用的顺序淘汰，默认为 `10MB`.
+ NOTE: 对象的开销为其归档后的数据长度，不能归档的对象按 `NSData`/`NSString` 的长度估算，其他对象按 `4KB` 估算.
+ */
+@property (nonatomic, assign) NSUInteger memoryCostLimit;
+
+/**
+ 内存层的最大对象数，超出后按最近最少使用的顺序淘汰，默认为 `1000`.
+ */
+@property (nonatomic, assign) NSUInteger memoryCountLimit;
+
+/**
+ 内存层当前的总开销(字节).
+ */
+@property (nonatomic, assign, readonly) NSUInteger memoryTotalCost;
+
+/**
+ 磁盘层的最大开销(字节)，默认为 `50MB`，为 `0` 时不限制. 清理磁盘层时超出的部分按过期时间从早到晚淘汰.
+ NOTE: 文件的开销为文件的长度，修改后会立即清理一次磁盘层.
+ */
+@property (nonatomic, assign) NSUInteger diskCostLimit;
+
+///---------------------
+/// @name 读写
+///---------------------
+
+/**
+ 获取 `key` 对应的未过期缓存对象，先查找内存层，再查找磁盘层.
+ NOTE: 内存层未命中时会在当前线程读取并解档磁盘文件，不要在主线程或者请求发送的路径上调用，使用 `-objectForKey:withBlock:`.
+
+ @param key 缓存 key.
+ @return 缓存对象，不存在或已过期时返回 `nil`.
+ */
+- (nullable id)objectForKey:(NSString *)key;
+
+/**
+ 只在内存层中获取 `key` 对应的未过期缓存对象，不访问磁盘.
+
+ @param key 缓存 key.
+ @return 缓存对象，内存层中不存在或已过期时返回 `nil`.
+ */
+- (nullable id)memoryObjectForKey:(NSString *)key;
+
+/**
+ 异步获取 `key` 对应的未过期缓存对象，磁盘层在缓存的 I/O 队列中读取，读到的对象会回填内存层.
+
+ @param key 缓存 key.
+ @param block 在全局并发队列中执行的回调，缓存对象不存在或已过期时 `object` 为 `nil`.
+ */
+- (void)objectForKey:(NSString *)key withBlock:(void (^)(NSString *key, id _Nullable object))block;
+
+/**
+ 写入缓存对象，内存层同步写入，磁盘层异步写入.
+
+ @param object 缓存对象.
+ @param key 缓存 key.
+ @param timeToLive 缓存的有效时间(秒)，小于等于 `0` 时不写入.
+ */
+- (void)setObject:(id)object forKey:(NSString *)key timeToLive:(NSTimeInterval)timeToLive;
+
+/**
+ 移除 `key` 对应的缓存对象.
+ */
+- (void)removeObjectForKey:(NSString *)key;
+
+/**
+ 移除内存层和磁盘层的所有缓存对象.
+ */
+- (void)removeAllObjects;
+
+/**
+ 在缓存的 I/O 队列中清理磁盘层，移除过期的文件，总大小超过 `diskCostLimit` 时按过期时间从早到晚淘汰.
+
+ @param block 清理结束后在全局并发队列中执行的回调.
+ */
+- (void)trimDiskWithBlock:(nullable void (^)(void))block;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,427 @@
+//
+//  YGCache.m
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import "YGCache.h"
+#import "YGConst.h"
+#import <UIKit/UIKit.h>
+#import <CommonCrypto/CommonDigest.h>
+
+static NSString * const YGCacheArchiveObjectKey = @"object";
+static NSString * const YGCacheArchiveExpirationKey = @"expiration";
+
+/// 不能归档的对象在内存层中的估算开销.
+static const NSUInteger YGCacheDefaultObjectCost = 4 * 1024;
+
+static NSUInteger YGCacheEstimatedCostForObject(id object) {
+    if ([object isKindOfClass:[NSData class]]) {
+        return MAX([(NSData *)object length], 1);
+    }
+    if ([object isKindOfClass:[NSString class]]) {
+        return MAX([(NSString *)object lengthOfBytesUsingEncoding:NSUTF8StringEncoding], 1);
+    }
+    return YGCacheDefaultObjectCost;
+}
+
+static NSString * YGCacheFileNameForKey(NSString *key) {
+    const char *str = key.UTF8String;
+    unsigned char digest[CC_MD5_DIGEST_LENGTH];
+    CC_MD5(str, (CC_LONG)strlen(str), digest);
+    NSMutableString *fileName = [NSMutableString stringWithCapacity:CC_MD5_DIGEST_LENGTH * 2];
+    for (int i = 0; i < CC_MD5_DIGEST_LENGTH; i++) {
+        [fileName appendFormat:@"%02x", digest[i]];
+    }
+    return fileName;
+}
+
+#pragma mark - YGCacheNode
+
+/**
+ 内存层 LRU 双向链表的节点, 链表由 `YGCache` 持有的字典强引用.
+ */
+@interface YGCacheNode : NSObject {
+    @package
+    __unsafe_unretained YGCacheNode *_prev;
+    __unsafe_unretained YGCacheNode *_next;
+    NSString *_key;
+    id _object;
+    NSUInteger _cost;
+    NSTimeInterval _expiration;
+}
+@end
+
+@implementation YGCacheNode
+@end
+
+#pragma mark - YGCache
+
+@interface YGCache () {
+    pthread_mutex_t _lock;
+    dispatch_queue_t _ioQueue;
+    
+    NSMutableDictionary<NSString *, YGCacheNode *> *_nodeMap;
+    YGCacheNode *_head; // 最近使用
+    YGCacheNode *_tail; // 最久未使用
+    NSUInteger _totalCost;
+}
+
+@end
+
+@implementation YGCache
+
++ (instancetype)cache {
+    return [[[self class] alloc] init];
+}
+
++ (instancetype)cacheWithPath:(NSString *)path {
+    return [[[self class] alloc] initWithPath:path];
+}
+
+- (instancetype)init {
+    NSString *cachesPath = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES).firstObject;
+    return [self initWithPath:[cachesPath stringByAppendingPathComponent:@"com.ygnetworking.cache"]];
+}
+
+- (instancetype)initWithPath:(NSString *)path {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _path = [path copy];
+    _memoryCostLimit = 10 * 1024 * 1024;
+    _memoryCountLimit = 1000;
+    _diskCostLimit = 50 * 1024 * 1024;
+    YG_NETWORKING_LOCK_INIT();
+    _ioQueue = dispatch_queue_create("com.ygnetworking.cache.io.queue", DISPATCH_QUEUE_SERIAL);
+    _nodeMap = [NSMutableDictionary dictionary];
+    
+    [[NSFileManager defaultManager] createDirectoryAtPath:_path withIntermediateDirectories:YES attributes:nil error:nil];
+    
+    // files left by the previous launches are only ever removed by a sweep.
+    [self trimDiskWithBlock:nil];
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(yg_applicationDidEnterBackground:)
+                                                 name:UIApplicationDidEnterBackgroundNotification
+                                               object:nil];
+    
+    return self;
+}
+
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    YG_NETWORKING_LOCK_DESTROY();
+}
+
+#pragma mark - Public Methods
+
+- (NSUInteger)memoryTotalCost {
+    YG_NETWORKING_LOCK();
+    NSUInteger totalCost = _totalCost;
+    YG_NETWORKING_UNLOCK();
+    return totalCost;
+}
+
+- (void)setMemoryCostLimit:(NSUInteger)memoryCostLimit {
+    YG_NETWORKING_LOCK();
+    _memoryCostLimit = memoryCostLimit;
+    [self yg_trimToLimit];
+    YG_NETWORKING_UNLOCK();
+}
+
+- (void)setMemoryCountLimit:(NSUInteger)memoryCountLimit {
+    YG_NETWORKING_LOCK();
+    _memoryCountLimit = memoryCountLimit;
+    [self yg_trimToLimit];
+    YG_NETWORKING_UNLOCK();
+}
+
+- (void)setDiskCostLimit:(NSUInteger)diskCostLimit {
+    YG_NETWORKING_LOCK();
+    _diskCostLimit = diskCostLimit;
+    YG_NETWORKING_UNLOCK();
+    [self trimDiskWithBlock:nil];
+}
+
+- (id)objectForKey:(NSString *)key {
+    if (key.length == 0) return nil;
+    
+    id object = [self memoryObjectForKey:key];
+    if (object) {
+        return object;
+    }
+    
+    // 内存层未命中, 查找磁盘层并回填内存层.
+    return [self yg_diskObjectForKey:key];
+}
+
+- (id)memoryObjectForKey:(NSString *)key {
+    if (key.length == 0) return nil;
+    
+    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+    
+    YG_NETWORKING_LOCK();
+    YGCacheNode *node = _nodeMap[key];
+    id object = nil;
+    if (node) {
+        if (node->_expiration > now) {
+            object = node->_object;
+            [self yg_bringNodeToHead:node];
+        } else {
+            [self yg_removeNode:node];
+        }
+    }
+    YG_NETWORKING_UNLOCK();
+    
+    return object;
+}
+
+- (void)objectForKey:(NSString *)key withBlock:(void (^)(NSString *key, id object))block {
+    if (!block) return;
+    
+    id object = [self memoryObjectForKey:key];
+    if (object || key.length == 0) {
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            block(key, object);
+        });
+        return;
+    }
+    
+    // the disk tier is read on the serial io queue, after the writes that were already scheduled.
+    dispatch_async(_ioQueue, ^{
+        id diskObject = [self yg_diskObjectForKey:key];
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            block(key, diskObject);
+        });
+    });
+}
+
+- (void)setObject:(id)object forKey:(NSString *)key timeToLive:(NSTimeInterval)timeToLive {
+    if (!object || key.length == 0 || timeToLive <= 0) return;
+    
+    NSTimeInterval expiration = [[NSDate date] timeIntervalSince1970] + timeToLive;
+    NSData *data = nil;
+    if ([object conformsToProtocol:@protocol(NSCoding)]) {
+        @try {
+            data = [NSKeyedArchiver archivedDataWithRootObject:@{YGCacheArchiveObjectKey: object,
+                                                                 YGCacheArchiveExpirationKey: @(expiration)}];
+        } @catch (NSException *exception) {
+            data = nil;
+        }
+    }
+    
+    YG_NETWORKING_LOCK();
+    [self yg_setObject:object forKey:key cost:(data.length > 0 ? data.length : YGCacheEstimatedCostForObject(object)) expiration:expiration];
+    YG_NETWORKING_UNLOCK();
+    
+    if (data) {
+        NSString *filePath = [self yg_filePathForKey:key];
+        dispatch_async(_ioQueue, ^{
+            // the modification date carries the expiration, the sweep reads it without unarchiving the file.
+            if ([data writeToFile:filePath atomically:YES]) {
+                [[NSFileManager defaultManager] setAttributes:@{NSFileModificationDate: [NSDate dateWithTimeIntervalSince1970:expiration]}
+                                                 ofItemAtPath:filePath
+                                                        error:nil];
+            }
+        });
+    }
+}
+
+- (void)removeObjectForKey:(NSString *)key {
+    if (key.length == 0) return;
+    
+    YG_NETWORKING_LOCK();
+    YGCacheNode *node = _nodeMap[key];
+    if (node) {
+        [self yg_removeNode:node];
+    }
+    YG_NETWORKING_UNLOCK();
+    
+    NSString *filePath = [self yg_filePathForKey:key];
+    dispatch_async(_ioQueue, ^{
+        [[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
+    });
+}
+
+- (void)removeAllObjects {
+    YG_NETWORKING_LOCK();
+    [_nodeMap removeAllObjects];
+    _head = nil;
+    _tail = nil;
+    _totalCost = 0;
+    YG_NETWORKING_UNLOCK();
+    
+    NSString *path = self.path;
+    dispatch_async(_ioQueue, ^{
+        NSFileManager *fileManager = [NSFileManager defaultManager];
+        [fileManager removeItemAtPath:path error:nil];
+        [fileManager createDirectoryAtPath:path withIntermediateDirectories:YES attributes:nil error:nil];
+    });
+}
+
+- (void)trimDiskWithBlock:(void (^)(void))block {
+    dispatch_async(_ioQueue, ^{
+        [self yg_trimDisk];
+        if (block) {
+            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), block);
+        }
+    });
+}
+
+#pragma mark - Private Methods
+
+- (void)yg_applicationDidEnterBackground:(NSNotification *)notification {
+    [self trimDiskWithBlock:nil];
+}
+
+/**
+ 移除过期的文件，总大小超过 `diskCostLimit` 时再按过期时间从早到晚淘汰，需要在 `_ioQueue` 中调用.
+ */
+- (void)yg_trimDisk {
+    NSArray<NSURLResourceKey> *resourceKeys = @[NSURLContentModificationDateKey, NSURLFileSizeKey, NSURLIsRegularFileKey];
+    NSDirectoryEnumerator<NSURL *> *enumerator = [[NSFileManager defaultManager] enumeratorAtURL:[NSURL fileURLWithPath:self.path isDirectory:YES]
+                                                                      includingPropertiesForKeys:resourceKeys
+                                                                                         options:NSDirectoryEnumerationSkipsHiddenFiles
+                                                                                    errorHandler:nil];
+    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+    NSMutableDictionary<NSURL *, NSDictionary<NSURLResourceKey, id> *> *files = [NSMutableDictionary dictionary];
+    NSUInteger totalCost = 0;
+    for (NSURL *fileURL in enumerator) {
+        NSDictionary<NSURLResourceKey, id> *resourceValues = [fileURL resourceValuesForKeys:resourceKeys error:nil];
+        if (![resourceValues[NSURLIsRegularFileKey] boolValue]) {
+            continue;
+        }
+        
+        NSDate *expirationDate = resourceValues[NSURLContentModificationDateKey];
+        if (expirationDate.timeIntervalSince1970 <= now) {
+            [[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil];
+            continue;
+        }
+        totalCost += [resourceValues[NSURLFileSizeKey] unsignedIntegerValue];
+        files[fileURL] = resourceValues;
+    }
+    
+    YG_NETWORKING_LOCK();
+    NSUInteger diskCostLimit = _diskCostLimit;
+    YG_NETWORKING_UNLOCK();
+    if (diskCostLimit == 0 || totalCost <= diskCostLimit) {
+        return;
+    }
+    
+    NSArray<NSURL *> *sortedFileURLs = [files keysSortedByValueUsingComparator:^NSComparisonResult(NSDictionary *resourceValues1, NSDictionary *resourceValues2) {
+        return [resourceValues1[NSURLContentModificationDateKey] compare:resourceValues2[NSURLContentModificationDateKey]];
+    }];
+    for (NSURL *fileURL in sortedFileURLs) {
+        if (totalCost <= diskCostLimit) break;
+        if ([[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil]) {
+            totalCost -= [files[fileURL][NSURLFileSizeKey] unsignedIntegerValue];
+        }
+    }
+}
+
+- (id)yg_diskObjectForKey:(NSString *)key {
+    NSString *filePath = [self yg_filePathForKey:key];
+    NSData *data = [NSData dataWithContentsOfFile:filePath];
+    if (data.length == 0) {
+        return nil;
+    }
+    
+    NSDictionary *archive = nil;
+    @try {
+        archive = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+    } @catch (NSException *exception) {
+        archive = nil;
+    }
+    
+    NSTimeInterval expiration = [archive[YGCacheArchiveExpirationKey] doubleValue];
+    id object = archive[YGCacheArchiveObjectKey];
+    if (!object || expiration <= [[NSDate date] timeIntervalSince1970]) {
+        dispatch_async(_ioQueue, ^{
+            [[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
+        });
+        return nil;
+    }
+    
+    YG_NETWORKING_LOCK();
+    [self yg_setObject:object forKey:key cost:data.length expiration:expiration];
+    YG_NETWORKING_UNLOCK();
+    
+    return object;
+}
+
+// NOTE: 以下 LRU 链表操作都需要在持有 `_lock` 的情况下调用.
+
+- (void)yg_setObject:(id)object forKey:(NSString *)key cost:(NSUInteger)cost expiration:(NSTimeInterval)expiration {
+    YGCacheNode *node = _nodeMap[key];
+    if (node) {
+        _totalCost -= node->_cost;
+        node->_object = object;
+        node->_cost = cost;
+        node->_expiration = expiration;
+        _totalCost += cost;
+        [self yg_bringNodeToHead:node];
+    } else {
+        node = [[YGCacheNode alloc] init];
+        node->_key = key;
+        node->_object = object;
+        node->_cost = cost;
+        node->_expiration = expiration;
+        _nodeMap[key] = node;
+        _totalCost += cost;
+        [self yg_insertNodeAtHead:node];
+    }
+    [self yg_trimToLimit];
+}
+
+- (void)yg_insertNodeAtHead:(YGCacheNode *)node {
+    if (_head) {
+        node->_next = _head;
+        _head->_prev = node;
+        _head = node;
+    } else {
+        _head = _tail = node;
+    }
+}
+
+- (void)yg_bringNodeToHead:(YGCacheNode *)node {
+    if (_head == node) return;
+    
+    if (_tail == node) {
+        _tail = node->_prev;
+        _tail->_next = nil;
+    } else {
+        node->_next->_prev = node->_prev;
+        node->_prev->_next = node->_next;
+    }
+    node->_next = _head;
+    node->_prev = nil;
+    _head->_prev = node;
+    _head = node;
+}
+
+- (void)yg_removeNode:(YGCacheNode *)node {
+    // 节点由 `_nodeMap` 持有, 先取出 key 再从字典中移除.
+    NSString *key = node->_key;
+    if (node->_next) node->_next->_prev = node->_prev;
+    if (node->_prev) node->_prev->_next = node->_next;
+    if (_head == node) _head = node->_next;
+    if (_tail == node) _tail = node->_prev;
+    _totalCost -= node->_cost;
+    [_nodeMap removeObjectForKey:key];
+}
+
+- (void)yg_trimToLimit {
+    while ((_totalCost > _memoryCostLimit || _nodeMap.count > _memoryCountLimit) && _tail) {
+        [self yg_removeNode:_tail];
+    }
+}
+
+- (NSString *)yg_filePathForKey:(NSString *)key {
+    return [self.path stringByAppendingPathComponent:YGCacheFileNameForKey(key)];
+}
+
+@end
@@ -11,7 +11,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class YGConfig, YGEngine;
+@class YGConfig, YGEngine, YGCache, YGRetryBudget, YGOfflineQueue;
+@protocol YGRetryPolicy;
 
 /**
  `YGCenter` 是一个全局的放置发送和管理所有网络请求的中心.
@@ -81,14 +82,16 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, copy, nullable) NSString *generalServer;
 
 /**
- YGCenter 的通用参数，如果 YGRequest.useGeneralParameters 为 `YES` 并且当前属性不为空，将会把此属性的值追加到 YGRequest.parameters 里.
+ YGCenter 的通用参数，如果 YGRequest.useGeneralParameters 为 `YES` 并且当前属性不为空，请求序列化时会和 YGRequest.parameters 合并.
+ NOTE: 返回的是不可变的快照，修改通过 `-setGeneralParameterValue:forKey:` 或 `-setupConfig:` 进行，已经发送的请求不受影响.
  */
-@property (nonatomic, strong, nullable, readonly) NSMutableDictionary<NSString *, id> *generalParameters;
+@property (nonatomic, strong, nullable, readonly) NSDictionary<NSString *, id> *generalParameters;
 
 /**
- YGCenter 的通用头，如果 YGRequest.useGeneralHeaders 为 `YES` 并且当前属性不为空，将会把此属性的值追加到 YGRequest.headers 里.
+ YGCenter 的通用头，如果 YGRequest.useGeneralHeaders 为 `YES` 并且当前属性不为空，请求序列化时会和 YGRequest.headers 合并.
+ NOTE: 返回的是不可变的快照，修改通过 `-setGeneralHeaderValue:forField:` 或 `-setupConfig:` 进行，已经发送的请求不受影响.
  */
-@property (nonatomic, strong, nullable, readonly) NSMutableDictionary<NSString *, NSString *> *generalHeaders;
+@property (nonatomic, strong, nullable, readonly) NSDictionary<NSString *, NSString *> *generalHeaders;
 
 /**
  YGCenter 的通用用户信息，如果 YGRequest.userInfo 为 `nil` 并且此属性不为 `nil`，将会把次属性设置成 YGRequest.userInfo.
@@ -105,6 +108,44 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, strong) YGEngine *engine;
 
+/**
+ YGCenter 的响应缓存，`cachePolicy` 不为 `kYGRequestCachePolicyNetworkOnly` 的请求会通过它读写缓存，默认为 `[YGCache cache]`.
+ */
+@property (nonatomic, strong) YGCache *cache;
+
+/**
+ 通过 `-sendRequest:...` 方法创建的 YGRequest 的 `coalescingEnabled` 默认值，默认为 `NO`.
+ 开启后，正在运行的相同 GET/HEAD 请求会被合并为一个网络任务，具体查看 `YGRequest.coalescingEnabled`.
+ */
+@property (nonatomic, assign) BOOL coalescingEnabled;
+
+/**
+ 通过 `-sendRequest:...` 方法创建的 YGRequest 的 `requestCompressionType` 默认值，默认为 `kYGRequestCompressionNone`.
+ */
+@property (nonatomic, assign) YGRequestCompressionType requestCompressionType;
+
+/**
+ 通过 `-sendRequest:...` 方法创建的 YGRequest 的 `requestCompressionThreshold` 默认值，默认为 `1024` 字节.
+ */
+@property (nonatomic, assign) NSUInteger requestCompressionThreshold;
+
+/**
+ YGCenter 的重试策略，决定失败的请求是否重试以及重试的间隔，默认为 `[YGExponentialBackoffRetryPolicy policy]`.
+ */
+@property (nonatomic, strong) id<YGRetryPolicy> retryPolicy;
+
+/**
+ YGCenter 的重试预算，限制重试请求占总请求量的比例，避免服务端故障时重试放大流量，默认比例为 `0.1`，容量为 `10`.
+ 设置为 `nil` 时不限制重试.
+ */
+@property (nonatomic, strong, nullable) YGRetryBudget *retryBudget;
+
+/**
+ YGCenter 的离线请求队列，`durable` 为 `YES` 的请求在网络不可用时进入这个队列，网络恢复后按顺序重放，默认为 `nil` (不使用离线队列).
+ NOTE: 设置后立即重放上次运行时留在队列中的请求，具体查看 `YGOfflineQueue`.
+ */
+@property (nonatomic, strong, nullable) YGOfflineQueue *offlineQueue;
+
 /**
  控制台是否打印请求和响应信息，默认为 `NO`.
  */
@@ -144,6 +185,21 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)setErrorProcessBlock:(YGCenterErrorProcessBlock)block;
 
+/**
+ 对 YGCenter 请求耗时观察的 block，请求结束时在成功/失败回调之前调用，可以用来上报请求各阶段的耗时.
+ NOTE: 重试的请求只在最后一次结束时调用，`CacheThenNetwork` 缓存命中的回调不会调用.
+ 
+ @param block 耗时观察 block (`YGCenterMetricsObserverBlock`).
+ */
+- (void)setMetricsObserverBlock:(nullable YGCenterMetricsObserverBlock)block;
+
+/**
+ 对 YGCenter 离线队列中的请求重放结束的 block，请求再次因为网络错误失败并放回队列时不会调用.
+ 
+ @param block 重放结束 block (`YGCenterOfflineReplayBlock`).
+ */
+- (void)setOfflineReplayBlock:(nullable YGCenterOfflineReplayBlock)block;
+
 /**
  对 YGCenter 设置通用的 HTTP 头，如果设为 `nil`，将会移除现有已设置的头.
  
@@ -279,6 +335,9 @@ NS_ASSUME_NONNULL_BEGIN
 /**
  Creates and runs batch requests
 
+ NOTE: When `maxConcurrent` of the YGBatchRequest is set, at most `maxConcurrent` requests run at the same time,
+ the next request is sent when a running one finishes.
+
  @param configBlock The config block to setup batch requests context info for the new created YGBatchRequest object.
  @param successBlock Success callback block called when all batch requests finished successfully.
  @param failureBlock Failure callback block called once a request error occured.
@@ -304,6 +363,22 @@ NS_ASSUME_NONNULL_BEGIN
                               onFailure:(nullable YGBCFailureBlock)failureBlock
                              onFinished:(nullable YGBCFinishedBlock)finishedBlock;
 
+/**
+ Creates and runs graph requests, a node runs when all of its dependencies finished successfully.
+
+ NOTE: The callback blocks receive dictionaries keyed by node name, the value of a failed or skipped node is an NSError.
+
+ @param configBlock The config block to add nodes to the new created YGGraphRequest object.
+ @param successBlock Success callback block called when all nodes finished successfully.
+ @param failureBlock Failure callback block called when all nodes finished and some of them failed or were skipped.
+ @param finishedBlock Finished callback block for the new created YGGraphRequest object.
+ @return Unique identifier for the new running YGGraphRequest object,`nil` for fail or an invalid graph.
+ */
+- (nullable NSString *)sendGraphRequest:(YGGraphRequestConfigBlock)configBlock
+                              onSuccess:(nullable YGGraphSuccessBlock)successBlock
+                              onFailure:(nullable YGGraphFailureBlock)failureBlock
+                             onFinished:(nullable YGGraphFinishedBlock)finishedBlock;
+
 ///------------------------------------------
 /// @name Instance Method to Operate Requests
 ///------------------------------------------
@@ -328,11 +403,20 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)cancelRequest:(NSString *)identifier
              onCancel:(nullable YGCancelBlock)cancelBlock;
 
+/**
+ Method to cancel all running requests in a group in one pass, see `group` of YGRequest/YGBatchRequest/YGChainRequest/YGGraphRequest.
+ 
+ NOTE: Requests bound to an `owner` are cancelled automatically when the owner deallocates.
+ 
+ @param group The group name of the running requests.
+ */
+- (void)cancelRequestsInGroup:(NSString *)group;
+
 /**
  Method to get a runnig request object matching to identifier.
  
  @param identifier The unique identifier of a running request.
- @return return The runing YGRequest/YGBatchRequest/YGChainRequest object (if exist) matching to identifier.
+ @return return The runing YGRequest/YGBatchRequest/YGChainRequest/YGGraphRequest object (if exist) matching to identifier.
  */
 - (nullable id)getRequest:(NSString *)identifier;
 
@@ -350,6 +434,14 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (YGNetworkConnectionType)networkConnectionType;
 
+/**
+ 获取主机当前的熔断器状态，可用于在主机熔断时降级，状态变化时会发送 `YGCircuitBreakerStateDidChangeNotification` 通知.
+ 
+ @param host 主机，eg. `api.example.com`.
+ @return 熔断器状态，YGEngine 没有熔断器时总是返回 `kYGCircuitBreakerStateClosed`.
+ */
+- (YGCircuitBreakerState)circuitBreakerStateForHost:(NSString *)host;
+
 ///--------------------------------
 /// @name Class Method for YGCenter
 ///--------------------------------
@@ -362,6 +454,8 @@ NS_ASSUME_NONNULL_BEGIN
 + (void)setRequestProcessBlock:(YGCenterRequestProcessBlock)block;
 + (void)setResponseProcessBlock:(YGCenterResponseProcessBlock)block;
 + (void)setErrorProcessBlock:(YGCenterErrorProcessBlock)block;
++ (void)setMetricsObserverBlock:(nullable YGCenterMetricsObserverBlock)block;
++ (void)setOfflineReplayBlock:(nullable YGCenterOfflineReplayBlock)block;
 + (void)setGeneralHeaderValue:(nullable NSString *)value forField:(NSString *)field;
 + (void)setGeneralParameterValue:(nullable id)value forKey:(NSString *)key;
 
@@ -408,6 +502,11 @@ NS_ASSUME_NONNULL_BEGIN
                               onFailure:(nullable YGBCFailureBlock)failureBlock
                              onFinished:(nullable YGBCFinishedBlock)finishedBlock;
 
++ (nullable NSString *)sendGraphRequest:(YGGraphRequestConfigBlock)configBlock
+                              onSuccess:(nullable YGGraphSuccessBlock)successBlock
+                              onFailure:(nullable YGGraphFailureBlock)failureBlock
+                             onFinished:(nullable YGGraphFinishedBlock)finishedBlock;
+
 #pragma mark -
 
 + (void)cancelRequest:(NSString *)identifier;
@@ -415,12 +514,16 @@ NS_ASSUME_NONNULL_BEGIN
 + (void)cancelRequest:(NSString *)identifier
              onCancel:(nullable YGCancelBlock)cancelBlock;
 
++ (void)cancelRequestsInGroup:(NSString *)group;
+
 + (nullable id)getRequest:(NSString *)identifier;
 
 + (BOOL)isNetworkReachable;
 
 + (YGNetworkConnectionType)networkConnectionType;
 
++ (YGCircuitBreakerState)circuitBreakerStateForHost:(NSString *)host;
+
 #pragma mark -
 
 + (void)addSSLPinningURL:(NSString *)url;
@@ -470,6 +573,41 @@ The general server address to assign for YGCenter.
  */
 @property (nonatomic, strong, nullable) YGEngine *engine;
 
+/**
+ The response cache to assign for YGCenter.
+ */
+@property (nonatomic, strong, nullable) YGCache *cache;
+
+/**
+ The default coalescing BOOL value to assign for YGCenter.
+ */
+@property (nonatomic, assign) BOOL coalescingEnabled;
+
+/**
+ The default request body compression type to assign for YGCenter.
+ */
+@property (nonatomic, assign) YGRequestCompressionType requestCompressionType;
+
+/**
+ The default request body compression threshold to assign for YGCenter.
+ */
+@property (nonatomic, assign) NSUInteger requestCompressionThreshold;
+
+/**
+ The retry policy to assign for YGCenter.
+ */
+@property (nonatomic, strong, nullable) id<YGRetryPolicy> retryPolicy;
+
+/**
+ The retry budget to assign for YGCenter.
+ */
+@property (nonatomic, strong, nullable) YGRetryBudget *retryBudget;
+
+/**
+ The offline request queue to assign for YGCenter.
+ */
+@property (nonatomic, strong, nullable) YGOfflineQueue *offlineQueue;
+
 /**
  The console log BOOL value to assign for YGCenter.
  */
@@ -9,23 +9,208 @@
 #import "YGCenter.h"
 #import "YGRequest.h"
 #import "YGEngine.h"
+#import "YGCache.h"
+#import "YGRetryPolicy.h"
+#import "YGCircuitBreaker.h"
+#import "YGModelMapper.h"
+#import "YGRequestMetrics.h"
+#import "YGOfflineQueue.h"
+#import <stdatomic.h>
+#import <objc/runtime.h>
+#import <CommonCrypto/CommonDigest.h>
+
+#if __has_include(<AFNetworking/AFNetworking.h>)
+#import <AFNetworking/AFURLRequestSerialization.h>
+#import <AFNetworking/AFNetworkReachabilityManager.h>
+#else
+#import "AFURLRequestSerialization.h"
+#import "AFNetworkReachabilityManager.h"
+#endif
+
+NSString * const YGErrorDomain = @"com.ygnetworking.error";
 
 #ifndef YGLog(...)
     #define YGLog(...) printf("%s", [[NSString stringWithFormat:__VA_ARGS__] UTF8String])
 #endif
 
+#pragma mark - YGGeneralConfig
+
+/**
+ YGCenter 通用配置的快照，发布后不再修改，修改时复制一份新的快照并整体替换 (copy-on-write).
+ 请求在处理时只引用快照中的字典，不需要在每个请求中复制通用参数和通用头.
+ */
+@interface YGGeneralConfig : NSObject <NSCopying>
+
+@property (nonatomic, copy, nullable) NSString *server;
+@property (nonatomic, copy, nullable) NSDictionary<NSString *, id> *parameters;
+@property (nonatomic, copy, nullable) NSDictionary<NSString *, NSString *> *headers;
+@property (nonatomic, strong, nullable) NSDictionary *userInfo;
+
+@end
+
+@implementation YGGeneralConfig
+
+- (id)copyWithZone:(NSZone *)zone {
+    YGGeneralConfig *config = [[[self class] allocWithZone:zone] init];
+    config.server = self.server;
+    config.parameters = self.parameters;
+    config.headers = self.headers;
+    config.userInfo = self.userInfo;
+    return config;
+}
+
+@end
+
+static NSDictionary * YGDictionaryBySettingValue(NSDictionary *dictionary, id value, NSString *key) {
+    NSMutableDictionary *mutableDictionary = dictionary ? [dictionary mutableCopy] : [NSMutableDictionary dictionary];
+    [mutableDictionary setValue:value forKey:key];
+    return mutableDictionary.count > 0 ? [mutableDictionary copy] : nil;
+}
+
+/**
+ 是否是网络不可用导致的错误，持久请求遇到这些错误时进入离线队列.
+ */
+static BOOL YGIsConnectivityError(NSError *error) {
+    if (![error.domain isEqualToString:NSURLErrorDomain]) return NO;
+    
+    switch (error.code) {
+        case NSURLErrorNotConnectedToInternet:
+        case NSURLErrorNetworkConnectionLost:
+        case NSURLErrorCannotConnectToHost:
+        case NSURLErrorCannotFindHost:
+        case NSURLErrorDNSLookupFailed:
+        case NSURLErrorTimedOut:
+        case NSURLErrorInternationalRoamingOff:
+        case NSURLErrorDataNotAllowed:
+        case NSURLErrorCallIsActive:
+            return YES;
+        default:
+            return NO;
+    }
+}
+
+/**
+ 字符串的 SHA-256 摘要，用于在缓存 key 中区分请求的身份信息.
+ */
+static NSString * YGCenterDigestString(NSString *string) {
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(data.bytes, (CC_LONG)data.length, digest);
+    NSMutableString *hexString = [NSMutableString stringWithCapacity:CC_SHA256_DIGEST_LENGTH * 2];
+    for (int i = 0; i < CC_SHA256_DIGEST_LENGTH; i++) {
+        [hexString appendFormat:@"%02x", digest[i]];
+    }
+    return hexString;
+}
+
+#pragma mark - YGRequestGroup
+
+/**
+ 分组中的请求，弱引用 YGRequest/YGBatchRequest/YGChainRequest/YGGraphRequest 对象，请求结束并释放后自动移除.
+ 分组被取消时关闭，之后加入的请求由新的分组记录.
+ */
+@interface YGRequestGroup : NSObject {
+    pthread_mutex_t _lock;
+    NSHashTable *_requests;
+    BOOL _closed;
+}
+
+/**
+ 加入请求，分组已经关闭时返回 `NO`.
+ */
+- (BOOL)addRequest:(id)request;
+
+/**
+ 关闭分组并返回其中还存在的请求.
+ */
+- (NSArray *)close;
+
+@end
+
+@implementation YGRequestGroup
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    YG_NETWORKING_LOCK_INIT();
+    _requests = [NSHashTable weakObjectsHashTable];
+    
+    return self;
+}
+
+- (void)dealloc {
+    YG_NETWORKING_LOCK_DESTROY();
+}
+
+- (BOOL)addRequest:(id)request {
+    YG_NETWORKING_LOCK();
+    BOOL added = !_closed;
+    if (added) {
+        [_requests addObject:request];
+    }
+    YG_NETWORKING_UNLOCK();
+    return added;
+}
+
+- (NSArray *)close {
+    YG_NETWORKING_LOCK();
+    _closed = YES;
+    NSArray *requests = _requests.allObjects;
+    [_requests removeAllObjects];
+    YG_NETWORKING_UNLOCK();
+    return requests;
+}
+
+@end
+
+#pragma mark - YGRequestOwnerToken
+
+/**
+ 关联在请求的所有者上，所有者释放时取消它的分组中的请求.
+ */
+@interface YGRequestOwnerToken : NSObject
+
+@property (nonatomic, weak) YGCenter *center;
+@property (nonatomic, copy) NSString *group;
+
+@end
+
+@implementation YGRequestOwnerToken
+
+- (void)dealloc {
+    [_center cancelRequestsInGroup:_group];
+}
+
+@end
+
+#pragma mark - YGCenter
+
 @interface YGCenter () {
-    dispatch_semaphore_t _lock;
+    pthread_mutex_t _lock;
+    atomic_ulong _autoIncrement;
 }
 
-@property (nonatomic, assign) NSUInteger autoIncrement;
-@property (nonatomic, strong) NSMutableDictionary<NSString *, id> *runningBatchAndChainPool;
-@property (nonatomic, strong, readwrite) NSMutableDictionary<NSString *, id> *generalParameters;
-@property (nonatomic, strong, readwrite) NSMutableDictionary<NSString *, NSString *> *generalHeaders;
+/// 正在运行的批量、链式和图请求，按 identifier 分片加锁，不占用 `_lock`.
+@property (nonatomic, strong) YGShardedDictionary<NSString *, id> *runningBatchAndChainPool;
+/// 请求分组，key 为分组名，所有者的分组名由 `-yg_groupForOwner:` 生成.
+@property (nonatomic, strong) YGShardedDictionary<NSString *, YGRequestGroup *> *requestGroups;
+/// 当前发布的通用配置快照，读取不加锁，替换在 `_lock` 中进行.
+@property (atomic, strong) YGGeneralConfig *generalConfig;
+/// 解析后的 server 地址，key 为 server 字符串.
+@property (nonatomic, strong) NSCache<NSString *, NSURL *> *baseURLCache;
+/// 正在读取磁盘缓存的请求，key 为读取缓存时分配的 `C` 开头的 identifier，在 `_lock` 中访问.
+@property (nonatomic, strong) NSMutableDictionary<NSString *, YGRequest *> *cacheLookupRequests;
+/// 缓存未命中后发往网络的请求，key 同上，不持有请求，在 `_lock` 中访问.
+@property (nonatomic, strong) NSMapTable<NSString *, YGRequest *> *cacheMissRequests;
 
 @property (nonatomic, copy) YGCenterResponseProcessBlock responseProcessHandler;
 @property (nonatomic, copy) YGCenterRequestProcessBlock requestProcessHandler;
 @property (nonatomic, copy) YGCenterErrorProcessBlock errorProcessHandler;
+@property (nonatomic, copy) YGCenterMetricsObserverBlock metricsObserverHandler;
+@property (nonatomic, copy) YGCenterOfflineReplayBlock offlineReplayHandler;
 
 @end
 
@@ -49,37 +234,83 @@
     if (!self) {
         return nil;
     }
-    _autoIncrement = 0;
-    _lock = dispatch_semaphore_create(1);
+    atomic_init(&_autoIncrement, 0);
+    YG_NETWORKING_LOCK_INIT();
+    _runningBatchAndChainPool = [[YGShardedDictionary alloc] init];
+    _requestGroups = [[YGShardedDictionary alloc] init];
+    _generalConfig = [[YGGeneralConfig alloc] init];
+    _baseURLCache = [[NSCache alloc] init];
+    _baseURLCache.countLimit = 64;
+    _cacheLookupRequests = [NSMutableDictionary dictionary];
+    _cacheMissRequests = [NSMapTable strongToWeakObjectsMapTable];
     _engine = [YGEngine sharedEngine];
+    _cache = [YGCache cache];
+    _retryPolicy = [YGExponentialBackoffRetryPolicy policy];
+    _retryBudget = [YGRetryBudget budgetWithRatio:0.1 maxTokens:10];
+    _requestCompressionType = kYGRequestCompressionNone;
+    _requestCompressionThreshold = 1024;
+    
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(yg_reachabilityDidChange:)
+                                                 name:AFNetworkingReachabilityDidChangeNotification
+                                               object:nil];
     return self;
 }
 
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    YG_NETWORKING_LOCK_DESTROY();
+}
+
 #pragma mark - Public Instance Methods for YGCenter
 
 - (void)setupConfig:(void(^)(YGConfig *config))block {
     YGConfig *config = [[YGConfig alloc] init];
     config.consoleLog = NO;
+    config.coalescingEnabled = self.coalescingEnabled;
+    config.requestCompressionType = self.requestCompressionType;
+    config.requestCompressionThreshold = self.requestCompressionThreshold;
     YG_NETWORKING_SAFE_BLOCK(block, config);
     
-    if (config.generalServer) {
-        self.generalServer = config.generalServer;
-    }
-    if (config.generalParameters.count > 0) {
-        [self.generalParameters addEntriesFromDictionary:config.generalParameters];
-    }
-    if (config.generalHeaders.count > 0) {
-        [self.generalHeaders addEntriesFromDictionary:config.generalHeaders];
-    }
+    [self yg_updateGeneralConfig:^(YGGeneralConfig *generalConfig) {
+        if (config.generalServer) {
+            generalConfig.server = config.generalServer;
+        }
+        if (config.generalParameters.count > 0) {
+            NSMutableDictionary *parameters = [NSMutableDictionary dictionaryWithDictionary:generalConfig.parameters];
+            [parameters addEntriesFromDictionary:config.generalParameters];
+            generalConfig.parameters = parameters;
+        }
+        if (config.generalHeaders.count > 0) {
+            NSMutableDictionary *headers = [NSMutableDictionary dictionaryWithDictionary:generalConfig.headers];
+            [headers addEntriesFromDictionary:config.generalHeaders];
+            generalConfig.headers = headers;
+        }
+        if (config.generalUserInfo) {
+            generalConfig.userInfo = config.generalUserInfo;
+        }
+    }];
     if (config.callbackQueue != NULL) {
         self.callbackQueue = config.callbackQueue;
     }
-    if (config.generalUserInfo) {
-        self.generalUserInfo = config.generalUserInfo;
-    }
     if (config.engine) {
         self.engine = config.engine;
     }
+    if (config.cache) {
+        self.cache = config.cache;
+    }
+    if (config.retryPolicy) {
+        self.retryPolicy = config.retryPolicy;
+    }
+    if (config.retryBudget) {
+        self.retryBudget = config.retryBudget;
+    }
+    if (config.offlineQueue) {
+        self.offlineQueue = config.offlineQueue;
+    }
+    self.coalescingEnabled = config.coalescingEnabled;
+    self.requestCompressionType = config.requestCompressionType;
+    self.requestCompressionThreshold = config.requestCompressionThreshold;
     self.consoleLog = config.consoleLog;
 }
 
@@ -95,12 +326,24 @@
     self.errorProcessHandler = block;
 }
 
+- (void)setMetricsObserverBlock:(YGCenterMetricsObserverBlock)block {
+    self.metricsObserverHandler = block;
+}
+
+- (void)setOfflineReplayBlock:(YGCenterOfflineReplayBlock)block {
+    self.offlineReplayHandler = block;
+}
+
 - (void)setGeneralHeaderValue:(NSString *)value forField:(NSString *)field {
-    [self.generalHeaders setValue:value forKey:field];
+    [self yg_updateGeneralConfig:^(YGGeneralConfig *generalConfig) {
+        generalConfig.headers = YGDictionaryBySettingValue(generalConfig.headers, value, field);
+    }];
 }
 
 - (void)setGeneralParameterValue:(id)value forKey:(NSString *)key {
-    [self.generalParameters setValue:value forKey:key];
+    [self yg_updateGeneralConfig:^(YGGeneralConfig *generalConfig) {
+        generalConfig.parameters = YGDictionaryBySettingValue(generalConfig.parameters, value, key);
+    }];
 }
 
 #pragma mark -
@@ -150,7 +393,13 @@
                 onFailure:(nullable YGFailureBlock)failureBlock
                onFinished:(nullable YGFinishedBlock)finishedBlock {
     YGRequest *request = [YGRequest request];
+    request.coalescingEnabled = self.coalescingEnabled;
+    request.requestCompressionType = self.requestCompressionType;
+    request.requestCompressionThreshold = self.requestCompressionThreshold;
+    [request setValue:[[YGRequestMetrics alloc] init] forKey:@"_metrics"];
+    NSTimeInterval configTimestamp = [NSProcessInfo processInfo].systemUptime;
     YG_NETWORKING_SAFE_BLOCK(configBlock, request);
+    [request.metrics setValue:@([NSProcessInfo processInfo].systemUptime - configTimestamp) forKey:@"_configDuration"];
     
     [self yg_processRequest:request onProgress:progressBlock onSuccess:successBlock onFailure:failureBlock onFinished:finishedBlock];
     [self yg_sendRequest:request];
@@ -177,29 +426,25 @@
         }
         
         [batchRequest.responseArray removeAllObjects];
-        for (YGRequest *request in batchRequest.requestArray) {
+        for (NSUInteger i = 0; i < batchRequest.requestArray.count; i++) {
             [batchRequest.responseArray addObject:[NSNull null]];
-            __weak __typeof(self)weakSelf = self;
-            [self yg_processRequest:request
-                         onProgress:nil
-                          onSuccess:nil
-                          onFailure:nil
-                         onFinished:^(id responseObject, NSError *error) {
-                             if ([batchRequest onFinishedOneRequest:request response:responseObject error:error]) {
-                                 __strong __typeof(weakSelf)strongSelf = weakSelf;
-                                 dispatch_semaphore_wait(strongSelf->_lock, DISPATCH_TIME_FOREVER);
-                                 [strongSelf.runningBatchAndChainPool removeObjectForKey:batchRequest.identifier];
-                                 dispatch_semaphore_signal(strongSelf->_lock);
-                             }
-                         }];
-            [self yg_sendRequest:request];
         }
         
+        // register before sending, the window refills from the pool entry's callbacks.
         NSString *identifier = [self yg_identifierForBatchAndChainRequest];
         [batchRequest setValue:identifier forKey:@"_identifier"];
-        YG_NETWORKING_LOCK();
-        [self.runningBatchAndChainPool setValue:batchRequest forKey:identifier];
-        YG_NETWORKING_UNLOCK();
+        [self.runningBatchAndChainPool setObject:batchRequest forKey:identifier];
+        [self yg_addRequest:batchRequest toGroup:batchRequest.group owner:batchRequest.owner];
+        
+        NSUInteger windowSize = batchRequest.requestArray.count;
+        if (batchRequest.maxConcurrent > 0) {
+            windowSize = MIN(batchRequest.maxConcurrent, windowSize);
+        }
+        for (NSUInteger i = 0; i < windowSize; i++) {
+            NSUInteger index = [batchRequest nextPendingRequestIndex];
+            if (index == NSNotFound) break;
+            [self yg_sendBatchRequest:batchRequest requestAtIndex:index];
+        }
         
         return identifier;
     } else {
@@ -229,9 +474,43 @@
         
         NSString *identifier = [self yg_identifierForBatchAndChainRequest];
         [chainRequest setValue:identifier forKey:@"_identifier"];
-        YG_NETWORKING_LOCK();
-        [self.runningBatchAndChainPool setValue:chainRequest forKey:identifier];
-        YG_NETWORKING_UNLOCK();
+        [self.runningBatchAndChainPool setObject:chainRequest forKey:identifier];
+        [self yg_addRequest:chainRequest toGroup:chainRequest.group owner:chainRequest.owner];
+        
+        return identifier;
+    } else {
+        return nil;
+    }
+}
+
+- (NSString *)sendGraphRequest:(YGGraphRequestConfigBlock)configBlock
+                     onSuccess:(nullable YGGraphSuccessBlock)successBlock
+                     onFailure:(nullable YGGraphFailureBlock)failureBlock
+                    onFinished:(nullable YGGraphFinishedBlock)finishedBlock {
+    YGGraphRequest *graphRequest = [[YGGraphRequest alloc] init];
+    YG_NETWORKING_SAFE_BLOCK(configBlock, graphRequest);
+    
+    if (graphRequest.nodes.count > 0) {
+        if (![graphRequest validateDependencies]) {
+            NSAssert(NO, @"The graph request has unknown dependencies or a dependency cycle.");
+            return nil;
+        }
+        if (successBlock) {
+            [graphRequest setValue:successBlock forKey:@"_graphSuccessBlock"];
+        }
+        if (failureBlock) {
+            [graphRequest setValue:failureBlock forKey:@"_graphFailureBlock"];
+        }
+        if (finishedBlock) {
+            [graphRequest setValue:finishedBlock forKey:@"_graphFinishedBlock"];
+        }
+        
+        NSString *identifier = [self yg_identifierForBatchAndChainRequest];
+        [graphRequest setValue:identifier forKey:@"_identifier"];
+        [self.runningBatchAndChainPool setObject:graphRequest forKey:identifier];
+        [self yg_addRequest:graphRequest toGroup:graphRequest.group owner:graphRequest.owner];
+        
+        [self yg_sendReadyNodesOfGraphRequest:graphRequest];
         
         return identifier;
     } else {
@@ -249,23 +528,70 @@
              onCancel:(nullable YGCancelBlock)cancelBlock {
     id request = nil;
     if ([identifier hasPrefix:@"BC"]) {
-        YG_NETWORKING_LOCK();
-        request = [self.runningBatchAndChainPool objectForKey:identifier];
-        [self.runningBatchAndChainPool removeObjectForKey:identifier];
-        YG_NETWORKING_UNLOCK();
+        request = [self.runningBatchAndChainPool removeAndReturnObjectForKey:identifier];
         if ([request isKindOfClass:[YGBatchRequest class]]) {
             YGBatchRequest *batchRequest = request;
+            // stop the window first, so cancelled requests do not start the pending ones.
+            NSRange pendingRange = [batchRequest cancelPendingRequests];
             if (batchRequest.requestArray.count > 0) {
                 for (YGRequest *rq in batchRequest.requestArray) {
                     if (rq.identifier.length > 0) {
-                        [self.engine cancelRequestByIdentifier:rq.identifier];
+                        [self cancelRequest:rq.identifier onCancel:nil];
                     }
                 }
             }
+            if (pendingRange.length > 0) {
+                NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil];
+                for (NSUInteger i = pendingRange.location; i < NSMaxRange(pendingRange); i++) {
+                    [batchRequest onFinishedRequestAtIndex:i response:nil error:error];
+                }
+            }
         } else if ([request isKindOfClass:[YGChainRequest class]]) {
             YGChainRequest *chainRequest = request;
             if (chainRequest.runningRequest && chainRequest.runningRequest.identifier.length > 0) {
-                [self.engine cancelRequestByIdentifier:chainRequest.runningRequest.identifier];
+                [self cancelRequest:chainRequest.runningRequest.identifier onCancel:nil];
+            }
+        } else if ([request isKindOfClass:[YGGraphRequest class]]) {
+            YGGraphRequest *graphRequest = request;
+            // finish the pending nodes first, so cancelled nodes do not start their dependents.
+            if (![graphRequest cancel]) {
+                [self yg_cancelRunningNodesOfGraphRequest:graphRequest];
+            }
+        }
+    } else if ([identifier hasPrefix:@"Q"]) {
+        request = [self.offlineQueue removeRequestWithIdentifier:identifier];
+        if (request) {
+            // the request never reached YGEngine, finish it the way a cancelled task does.
+            NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil];
+            dispatch_async(self.callbackQueue ?: dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                [self yg_execureFailureBlockWithError:error forRequest:request];
+            });
+        } else {
+            // the request is being replayed under the identifier assigned by YGEngine.
+            request = [self.offlineQueue requestWithIdentifier:identifier];
+            NSString *runningIdentifier = [request identifier];
+            if (runningIdentifier.length > 0 && ![runningIdentifier isEqualToString:identifier]) {
+                [self.engine cancelRequestByIdentifier:runningIdentifier];
+            }
+        }
+    } else if ([identifier hasPrefix:@"C"]) {
+        YG_NETWORKING_LOCK();
+        YGRequest *lookupRequest = self.cacheLookupRequests[identifier];
+        [self.cacheLookupRequests removeObjectForKey:identifier];
+        YGRequest *missRequest = [self.cacheMissRequests objectForKey:identifier];
+        YG_NETWORKING_UNLOCK();
+        if (lookupRequest) {
+            // the request is still reading the disk cache, it never reached YGEngine.
+            request = lookupRequest;
+            NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil];
+            dispatch_async(self.callbackQueue ?: dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                [self yg_execureFailureBlockWithError:error forRequest:lookupRequest];
+            });
+        } else if (missRequest) {
+            // the cache missed, the request is running under the identifier assigned by YGEngine.
+            NSString *runningIdentifier = missRequest.identifier;
+            if (runningIdentifier.length > 0 && ![runningIdentifier isEqualToString:identifier]) {
+                request = [self.engine cancelRequestByIdentifier:runningIdentifier];
             }
         }
     } else if (identifier.length > 0) {
@@ -274,12 +600,29 @@
     YG_NETWORKING_SAFE_BLOCK(cancelBlock, request);
 }
 
+- (void)cancelRequestsInGroup:(NSString *)group {
+    if (group.length == 0) return;
+    
+    // closing the group makes requests added from now on start a new group.
+    NSArray *requests = [[self.requestGroups removeAndReturnObjectForKey:group] close];
+    for (id request in requests) {
+        NSString *identifier = [request identifier];
+        if (identifier.length > 0) {
+            [self cancelRequest:identifier onCancel:nil];
+        }
+    }
+}
+
 - (id)getRequest:(NSString *)identifier {
     if (identifier == nil) {
         return nil;
     } else if ([identifier hasPrefix:@"BC"]) {
+        return [self.runningBatchAndChainPool objectForKey:identifier];
+    } else if ([identifier hasPrefix:@"Q"]) {
+        return [self.offlineQueue requestWithIdentifier:identifier];
+    } else if ([identifier hasPrefix:@"C"]) {
         YG_NETWORKING_LOCK();
-        id request = [self.runningBatchAndChainPool objectForKey:identifier];
+        YGRequest *request = self.cacheLookupRequests[identifier] ?: [self.cacheMissRequests objectForKey:identifier];
         YG_NETWORKING_UNLOCK();
         return request;
     } else {
@@ -295,6 +638,11 @@
     return self.engine.reachabilityStatus;
 }
 
+- (YGCircuitBreakerState)circuitBreakerStateForHost:(NSString *)host {
+    YGCircuitBreaker *circuitBreaker = self.engine.circuitBreaker;
+    return circuitBreaker ? [circuitBreaker stateForHost:host] : kYGCircuitBreakerStateClosed;
+}
+
 #pragma mark - Public Class Methods for YGCenter
 
 + (void)setupConfig:(void(^)(YGConfig *config))block {
@@ -313,12 +661,20 @@
     [[YGCenter defaultCenter] setErrorProcessBlock:block];
 }
 
++ (void)setMetricsObserverBlock:(YGCenterMetricsObserverBlock)block {
+    [[YGCenter defaultCenter] setMetricsObserverBlock:block];
+}
+
++ (void)setOfflineReplayBlock:(YGCenterOfflineReplayBlock)block {
+    [[YGCenter defaultCenter] setOfflineReplayBlock:block];
+}
+
 + (void)setGeneralHeaderValue:(NSString *)value forField:(NSString *)field {
-    [[YGCenter defaultCenter].generalHeaders setValue:value forKey:field];
+    [[YGCenter defaultCenter] setGeneralHeaderValue:value forField:field];
 }
 
 + (void)setGeneralParameterValue:(id)value forKey:(NSString *)key {
-    [[YGCenter defaultCenter].generalParameters setValue:value forKey:key];
+    [[YGCenter defaultCenter] setGeneralParameterValue:value forKey:key];
 }
 
 #pragma mark -
@@ -384,6 +740,13 @@
     return [[YGCenter defaultCenter] sendChainRequest:configBlock onSuccess:successBlock onFailure:failureBlock onFinished:finishedBlock];
 }
 
++ (NSString *)sendGraphRequest:(YGGraphRequestConfigBlock)configBlock
+                     onSuccess:(nullable YGGraphSuccessBlock)successBlock
+                     onFailure:(nullable YGGraphFailureBlock)failureBlock
+                    onFinished:(nullable YGGraphFinishedBlock)finishedBlock {
+    return [[YGCenter defaultCenter] sendGraphRequest:configBlock onSuccess:successBlock onFailure:failureBlock onFinished:finishedBlock];
+}
+
 #pragma mark -
 
 + (void)cancelRequest:(NSString *)identifier {
@@ -395,6 +758,10 @@
     [[YGCenter defaultCenter] cancelRequest:identifier onCancel:cancelBlock];
 }
 
++ (void)cancelRequestsInGroup:(NSString *)group {
+    [[YGCenter defaultCenter] cancelRequestsInGroup:group];
+}
+
 + (nullable id)getRequest:(NSString *)identifier {
     return [[YGCenter defaultCenter] getRequest:identifier];
 }
@@ -407,6 +774,10 @@
     return [[YGCenter defaultCenter] networkConnectionType];
 }
 
++ (YGCircuitBreakerState)circuitBreakerStateForHost:(NSString *)host {
+    return [[YGCenter defaultCenter] circuitBreakerStateForHost:host];
+}
+
 #pragma mark -
 
 + (void)addSSLPinningURL:(NSString *)url {
@@ -423,6 +794,63 @@
 
 #pragma mark - Private Methods for YGCenter
 
+/**
+ 发送图请求中可以开始运行的节点，节点结束后记录结果并发送新的可以运行的节点.
+ */
+- (void)yg_sendReadyNodesOfGraphRequest:(YGGraphRequest *)graphRequest {
+    for (YGGraphNode *node in [graphRequest dequeueReadyNodes]) {
+        __weak __typeof(self)weakSelf = self;
+        [self yg_processRequest:node.request
+                     onProgress:nil
+                      onSuccess:nil
+                      onFailure:nil
+                     onFinished:^(id responseObject, NSError *error) {
+                         __strong __typeof(weakSelf)strongSelf = weakSelf;
+                         if ([graphRequest onFinishedNode:node response:responseObject error:error]) {
+                             [strongSelf.runningBatchAndChainPool removeObjectForKey:graphRequest.identifier];
+                         } else if (!responseObject && node.failurePolicy == kYGGraphNodeFailureFailFast) {
+                             // the pending nodes have been cancelled, stop the running ones too.
+                             [strongSelf yg_cancelRunningNodesOfGraphRequest:graphRequest];
+                         } else {
+                             [strongSelf yg_sendReadyNodesOfGraphRequest:graphRequest];
+                         }
+                     }];
+        [self yg_sendRequest:node.request];
+    }
+}
+
+- (void)yg_cancelRunningNodesOfGraphRequest:(YGGraphRequest *)graphRequest {
+    for (YGRequest *request in graphRequest.runningRequests) {
+        if (request.identifier.length > 0) {
+            [self cancelRequest:request.identifier onCancel:nil];
+        }
+    }
+}
+
+/**
+ 发送批量请求中指定位置的请求，请求结束时按位置记录结果，并从滑动窗口中发送下一个待发送的请求.
+ */
+- (void)yg_sendBatchRequest:(YGBatchRequest *)batchRequest requestAtIndex:(NSUInteger)index {
+    YGRequest *request = batchRequest.requestArray[index];
+    __weak __typeof(self)weakSelf = self;
+    [self yg_processRequest:request
+                 onProgress:nil
+                  onSuccess:nil
+                  onFailure:nil
+                 onFinished:^(id responseObject, NSError *error) {
+                     __strong __typeof(weakSelf)strongSelf = weakSelf;
+                     if ([batchRequest onFinishedRequestAtIndex:index response:responseObject error:error]) {
+                         [strongSelf.runningBatchAndChainPool removeObjectForKey:batchRequest.identifier];
+                     } else {
+                         NSUInteger nextIndex = [batchRequest nextPendingRequestIndex];
+                         if (nextIndex != NSNotFound) {
+                             [strongSelf yg_sendBatchRequest:batchRequest requestAtIndex:nextIndex];
+                         }
+                     }
+                 }];
+    [self yg_sendRequest:request];
+}
+
 - (void)yg_sendChainRequest:(YGChainRequest *)chainRequest {
     if (chainRequest.runningRequest != nil) {
         __weak __typeof(self)weakSelf = self;
@@ -433,9 +861,7 @@
                      onFinished:^(id responseObject, NSError *error) {
                          __strong __typeof(weakSelf)strongSelf = weakSelf;
                          if ([chainRequest onFinishedOneRequest:chainRequest.runningRequest response:responseObject error:error]) {
-                             dispatch_semaphore_wait(strongSelf->_lock, DISPATCH_TIME_FOREVER);
                              [strongSelf.runningBatchAndChainPool removeObjectForKey:chainRequest.identifier];
-                             dispatch_semaphore_signal(strongSelf->_lock);
                          } else {
                              if (chainRequest.runningRequest != nil) {
                                  [strongSelf yg_sendChainRequest:chainRequest];
@@ -452,6 +878,10 @@
                 onSuccess:(YGSuccessBlock)successBlock
                 onFailure:(YGFailureBlock)failureBlock
                onFinished:(YGFinishedBlock)finishedBlock {
+    NSTimeInterval processTimestamp = [NSProcessInfo processInfo].systemUptime;
+    if (!request.metrics) {
+        [request setValue:[[YGRequestMetrics alloc] init] forKey:@"_metrics"];
+    }
     
     // set callback blocks for the request object.
     if (successBlock) {
@@ -466,44 +896,34 @@
     if (progressBlock && request.requestType != kYGRequestNormal) {
         [request setValue:progressBlock forKey:@"_progressBlock"];
     }
+    [self yg_addRequest:request toGroup:request.group owner:request.owner];
+    
+    YGGeneralConfig *generalConfig = self.generalConfig;
     
     // add general user info to the request object.
-    if (!request.userInfo && self.generalUserInfo) {
-        request.userInfo = self.generalUserInfo;
+    if (!request.userInfo && generalConfig.userInfo) {
+        request.userInfo = generalConfig.userInfo;
     }
     
-    // add general parameters to the request object.
-    if (request.useGeneralParameters && self.generalParameters.count > 0) {
-        NSMutableDictionary *parameters = [NSMutableDictionary dictionary];
-        [parameters addEntriesFromDictionary:self.generalParameters];
-        if (request.parameters.count > 0) {
-            [parameters addEntriesFromDictionary:request.parameters];
-        }
-        request.parameters = parameters;
-    }
+    // reference the immutable general parameters and headers, they are merged when the request is serialized.
+    [request setValue:(request.useGeneralParameters ? generalConfig.parameters : nil) forKey:@"_generalParameters"];
+    [request setValue:(request.useGeneralHeaders ? generalConfig.headers : nil) forKey:@"_generalHeaders"];
     
-    // add general headers to the request object.
-    if (request.useGeneralHeaders && self.generalHeaders.count > 0) {
-        NSMutableDictionary *headers = [NSMutableDictionary dictionary];
-        [headers addEntriesFromDictionary:self.generalHeaders];
-        if (request.headers) {
-            [headers addEntriesFromDictionary:request.headers];
-        }
-        request.headers = headers;
+    // send the idempotency key, so the server can recognize a replayed request.
+    if (request.idempotencyKey.length > 0 && !request.headers[@"Idempotency-Key"]) {
+        request.headers = YGDictionaryBySettingValue(request.headers, request.idempotencyKey, @"Idempotency-Key");
     }
     
     // process url for the request object.
     if (request.url.length == 0) {
-        if (request.server.length == 0 && request.useGeneralServer && self.generalServer.length > 0) {
-            request.server = self.generalServer;
+        if (request.server.length == 0 && request.useGeneralServer && generalConfig.server.length > 0) {
+            request.server = generalConfig.server;
         }
         if (request.api.length > 0) {
-            NSURL *baseURL = [NSURL URLWithString:request.server];
-            // ensure terminal slash for baseURL path, so that NSURL +URLWithString:relativeToURL: works as expected.
-            if ([[baseURL path] length] > 0 && ![[baseURL absoluteString] hasSuffix:@"/"]) {
-                baseURL = [baseURL URLByAppendingPathComponent:@""];
-            }
-            request.url = [[NSURL URLWithString:request.api relativeToURL:baseURL] absoluteString];
+            NSURL *URL = [NSURL URLWithString:request.api relativeToURL:[self yg_baseURLForServer:request.server]].absoluteURL;
+            request.url = URL.absoluteString;
+            // hand the parsed URL to YGEngine, so it does not parse `url` again.
+            [request setValue:URL forKey:@"_resolvedURL"];
         } else {
             request.url = request.server;
         }
@@ -511,18 +931,47 @@
     
     YG_NETWORKING_SAFE_BLOCK(self.requestProcessHandler, request);
     NSAssert(request.url.length > 0, @"The request url can't be null.");
+    
+    [request.metrics setValue:@([NSProcessInfo processInfo].systemUptime - processTimestamp) forKey:@"_processDuration"];
 }
 
 - (void)yg_sendRequest:(YGRequest *)request {
     
+    if (request.requestType == kYGRequestNormal && request.cachePolicy != kYGRequestCachePolicyNetworkOnly) {
+        [request setValue:[self yg_cacheKeyForRequest:request] forKey:@"_cacheKey"];
+        if ([self yg_loadCacheForRequest:request]) {
+            return;
+        }
+    }
+    
+    [self yg_sendNetworkRequest:request];
+}
+
+- (void)yg_sendNetworkRequest:(YGRequest *)request {
+    
+    // the network is known to be down, wait in the offline queue instead of failing right away.
+    if (!self.isNetworkReachable && [self yg_enqueueOfflineRequest:request]) {
+        return;
+    }
+    
+    [self yg_startRequest:request];
+}
+
+- (void)yg_startRequest:(YGRequest *)request {
+    
     if (self.consoleLog) {
         if (request.requestType == kYGRequestDownload) {
-            YGLog(@"\n============ [YGRequest Info] ============\nrequest download url: %@\nrequest save path: %@ \nrequest headers: \n%@ \nrequest parameters: \n%@ \n==========================================\n", request.url, request.downloadSavePath, request.headers, request.parameters);
+            YGLog(@"\n============ [YGRequest Info] ============\nrequest download url: %@\nrequest save path: %@ \nrequest headers: \n%@ \nrequest parameters: \n%@ \n==========================================\n", request.url, request.downloadSavePath, request.mergedHeaders, request.mergedParameters);
         } else {
-            YGLog(@"\n============ [YGRequest Info] ============\nrequest url: %@ \nrequest headers: \n%@ \nrequest parameters: \n%@ \n==========================================\n", request.url, request.headers, request.parameters);
+            YGLog(@"\n============ [YGRequest Info] ============\nrequest url: %@ \nrequest headers: \n%@ \nrequest parameters: \n%@ \n==========================================\n", request.url, request.mergedHeaders, request.mergedParameters);
         }
     }
     
+    // only the first attempt earns retry tokens, retries are paid out of the budget.
+    if (request.retriedCount == 0) {
+        [self.retryBudget deposit];
+    }
+    
     // send the request through YGEngine.
     [self.engine sendRequest:request completionHandler:^(id responseObject, NSError *error) {
         // the completionHandler will be execured in a private concurrent dispatch queue.
@@ -534,6 +983,131 @@
     }];
 }
 
+/**
+ 根据缓存策略读取缓存，返回 `YES` 表示请求已经结束，或者正在读取磁盘缓存，由读取完成后决定是否从网络获取数据.
+ NOTE: 内存缓存在当前线程中查找，磁盘缓存在 YGCache 的 I/O 队列中异步读取，不阻塞发送请求的线程.
+ */
+- (BOOL)yg_loadCacheForRequest:(YGRequest *)request {
+    NSString *cacheKey = request.cacheKey;
+    YGCache *cache = self.cache;
+    id cachedObject = [cache memoryObjectForKey:cacheKey];
+    if (cachedObject || !cacheKey || !cache) {
+        return [self yg_finishCacheLookupForRequest:request cachedObject:cachedObject];
+    }
+    
+    // the request waits for the disk cache under a cache identifier, so it can be cancelled meanwhile.
+    NSString *identifier = [self yg_identifierWithPrefix:@"C"];
+    [request setValue:identifier forKey:@"_identifier"];
+    YG_NETWORKING_LOCK();
+    self.cacheLookupRequests[identifier] = request;
+    YG_NETWORKING_UNLOCK();
+    
+    [cache objectForKey:cacheKey withBlock:^(NSString *key, id object) {
+        YG_NETWORKING_LOCK();
+        BOOL isCancelled = (self.cacheLookupRequests[identifier] == nil);
+        [self.cacheLookupRequests removeObjectForKey:identifier];
+        if (!isCancelled && (!object || request.cachePolicy == kYGRequestCachePolicyCacheThenNetwork)) {
+            [self.cacheMissRequests setObject:request forKey:identifier];
+        }
+        YG_NETWORKING_UNLOCK();
+        if (isCancelled) {
+            return;
+        }
+        if (![self yg_finishCacheLookupForRequest:request cachedObject:object]) {
+            [self yg_sendNetworkRequest:request];
+        }
+    }];
+    return YES;
+}
+
+/**
+ 回调缓存查找的结果，返回 `YES` 表示请求已经结束，不需要再从网络获取数据.
+ */
+- (BOOL)yg_finishCacheLookupForRequest:(YGRequest *)request cachedObject:(id)cachedObject {
+    BOOL hasCacheIdentifier = [request.identifier hasPrefix:@"C"];
+    if (!cachedObject) {
+        if (request.cachePolicy == kYGRequestCachePolicyCacheOnly) {
+            if (!hasCacheIdentifier) {
+                [request setValue:[self yg_identifierWithPrefix:@"C"] forKey:@"_identifier"];
+            }
+            NSError *error = [NSError errorWithDomain:YGErrorDomain
+                                                 code:kYGErrorCacheMiss
+                                             userInfo:@{NSLocalizedDescriptionKey: @"No valid cached response for the request."}];
+            [self yg_performCallbackForRequest:request block:^{
+                [self yg_execureFailureBlockWithError:error forRequest:request];
+            }];
+            return YES;
+        }
+        return NO;
+    }
+    
+    if (self.consoleLog) {
+        YGLog(@"\n============ [YGResponse Cache] ==========\nrequest url: %@ \nresponse data: \n%@\n==========================================\n", request.url, cachedObject);
+    }
+    
+    BOOL isFinished = (request.cachePolicy != kYGRequestCachePolicyCacheThenNetwork);
+    if (isFinished && !hasCacheIdentifier) {
+        [request setValue:[self yg_identifierWithPrefix:@"C"] forKey:@"_identifier"];
+    }
+    BOOL willMap = [self yg_shouldMapResponse:cachedObject forRequest:request];
+    [self yg_mapResponse:cachedObject forRequest:request completion:^(id mappedObject, NSError *mappingError) {
+        dispatch_block_t callbackBlock = ^{
+            if (!mappingError) {
+                [self yg_execureSuccessBlockWithResponse:mappedObject forRequest:request fromCache:YES];
+            } else if (isFinished) {
+                [self yg_execureFailureBlockWithError:mappingError forRequest:request];
+            }
+        };
+        // the mapped response is already on the callback queue.
+        if (willMap) {
+            callbackBlock();
+        } else {
+            [self yg_performCallbackForRequest:request block:callbackBlock];
+        }
+    }];
+    return isFinished;
+}
+
+/**
+ 生成请求的缓存 key，带有身份信息且没有开启 `cachesAuthorizedResponse` 的请求返回 `nil`，不读写缓存.
+ */
+- (NSString *)yg_cacheKeyForRequest:(YGRequest *)request {
+    NSMutableDictionary<NSString *, NSString *> *headers = [NSMutableDictionary dictionary];
+    [request.mergedHeaders enumerateKeysAndObjectsUsingBlock:^(NSString *field, NSString *value, BOOL *stop) {
+        headers[field.lowercaseString] = [value description];
+    }];
+    NSString *authorization = headers[@"authorization"];
+    NSString *cookie = headers[@"cookie"];
+    BOOL isAuthorized = (authorization.length > 0 || cookie.length > 0);
+    if (isAuthorized && !request.cachesAuthorizedResponse) {
+        return nil;
+    }
+    
+    NSDictionary *parameters = request.mergedParameters;
+    NSString *query = parameters.count > 0 ? AFQueryStringFromParameters(parameters) : @"";
+    NSMutableString *cacheKey = [NSMutableString stringWithFormat:@"%ld %@ %@ %ld", (long)request.httpMethod, request.url, query, (long)request.responseSerializerType];
+    
+    NSMutableOrderedSet<NSString *> *varyHeaders = [NSMutableOrderedSet orderedSet];
+    for (NSString *field in (request.cacheVaryHeaders ?: @[@"Accept", @"Accept-Language"])) {
+        [varyHeaders addObject:field.lowercaseString];
+    }
+    // the identity only enters the key as a digest, never in plain text.
+    [varyHeaders removeObject:@"authorization"];
+    [varyHeaders removeObject:@"cookie"];
+    [varyHeaders sortUsingSelector:@selector(compare:)];
+    for (NSString *field in varyHeaders) {
+        NSString *value = headers[field];
+        if (value) {
+            [cacheKey appendFormat:@" %@:%@", field, value];
+        }
+    }
+    if (isAuthorized) {
+        NSString *identity = [NSString stringWithFormat:@"%@\n%@", authorization ?: @"", cookie ?: @""];
+        [cacheKey appendFormat:@" identity:%@", YGCenterDigestString(identity)];
+    }
+    return cacheKey;
+}
+
 - (void)yg_successWithResponse:(id)responseObject forRequest:(YGRequest *)request {
     
     NSError *processError = nil;
@@ -547,6 +1121,11 @@
         return;
     }
     
+    // write the processed response object to the cache.
+    if (request.cacheKey && request.cachePolicy != kYGRequestCachePolicyNetworkOnly) {
+        [self.cache setObject:responseObject forKey:request.cacheKey timeToLive:request.cacheTimeInterval];
+    }
+    
     if (self.consoleLog) {
         if (request.requestType == kYGRequestDownload) {
             YGLog(@"\n============ [YGResponse Data] ===========\nrequest download url: %@\nresponse data: %@\n==========================================\n", request.url, responseObject);
@@ -559,20 +1138,89 @@
         }
     }
     
-    if (self.callbackQueue) {
-        __weak __typeof(self)weakSelf = self;
-        dispatch_async(self.callbackQueue, ^{
-            __strong __typeof(weakSelf)strongSelf = weakSelf;
-            [strongSelf yg_execureSuccessBlockWithResponse:responseObject forRequest:request];
-        });
+    BOOL willMap = [self yg_shouldMapResponse:responseObject forRequest:request];
+    [self yg_mapResponse:responseObject forRequest:request completion:^(id mappedObject, NSError *mappingError) {
+        if (mappingError) {
+            [self yg_failureWithError:mappingError forRequest:request];
+            return;
+        }
+        if (self.callbackQueue && !willMap) {
+            __weak __typeof(self)weakSelf = self;
+            NSTimeInterval dispatchTimestamp = [NSProcessInfo processInfo].systemUptime;
+            dispatch_async(self.callbackQueue, ^{
+                __strong __typeof(weakSelf)strongSelf = weakSelf;
+                [request.metrics setValue:@([NSProcessInfo processInfo].systemUptime - dispatchTimestamp) forKey:@"_callbackDispatchDuration"];
+                [strongSelf yg_execureSuccessBlockWithResponse:mappedObject forRequest:request fromCache:NO];
+            });
+        } else {
+            // execure success block on a private concurrent dispatch queue, or on `callbackQueue` after mapping.
+            [self yg_execureSuccessBlockWithResponse:mappedObject forRequest:request fromCache:NO];
+        }
+    }];
+}
+
+- (BOOL)yg_shouldMapResponse:(id)responseObject forRequest:(YGRequest *)request {
+    return request.responseModelClass != nil && responseObject != nil;
+}
+
+/**
+ 将响应对象映射为 `responseModelClass` 的实例, 映射在 YGEngine 的解码队列中执行,
+ 完成后在 `callbackQueue` 中回调, 没有设置 `callbackQueue` 时在请求优先级对应的回调队列中回调.
+ 没有设置 `responseModelClass` 时在当前线程直接回调.
+ */
+- (void)yg_mapResponse:(id)responseObject forRequest:(YGRequest *)request completion:(void (^)(id mappedObject, NSError *error))completion {
+    if (![self yg_shouldMapResponse:responseObject forRequest:request]) {
+        completion(responseObject, nil);
+        return;
+    }
+    
+    Class modelClass = request.responseModelClass;
+    YGRequestMetrics *metrics = request.metrics;
+    [self.engine performDecodeForRequest:request block:^{
+        NSTimeInterval startTimestamp = [NSProcessInfo processInfo].systemUptime;
+        id model = [YGModelMapper modelWithJSON:responseObject modelClass:modelClass];
+        [metrics setValue:@([NSProcessInfo processInfo].systemUptime - startTimestamp) forKey:@"_mappingDuration"];
+        
+        NSError *error = nil;
+        if (!model) {
+            error = [NSError errorWithDomain:YGErrorDomain
+                                        code:kYGErrorModelMapping
+                                    userInfo:@{NSLocalizedDescriptionKey: [NSString stringWithFormat:@"The response object can not be mapped to %@.", NSStringFromClass(modelClass)]}];
+        }
+        NSTimeInterval dispatchTimestamp = [NSProcessInfo processInfo].systemUptime;
+        [self yg_performCallbackForRequest:request block:^{
+            [metrics setValue:@([NSProcessInfo processInfo].systemUptime - dispatchTimestamp) forKey:@"_callbackDispatchDuration"];
+            completion(model, error);
+        }];
+    }];
+}
+
+/**
+ 在 `callbackQueue` 中异步执行 block, 没有设置 `callbackQueue` 时在 YGEngine 中请求优先级对应的回调队列中执行.
+ */
+- (void)yg_performCallbackForRequest:(YGRequest *)request block:(dispatch_block_t)block {
+    dispatch_queue_t callbackQueue = self.callbackQueue;
+    if (callbackQueue) {
+        dispatch_async(callbackQueue, block);
     } else {
-        // execure success block on a private concurrent dispatch queue.
-        [self yg_execureSuccessBlockWithResponse:responseObject forRequest:request];
+        [self.engine performCallbackForRequest:request block:block];
     }
 }
 
-- (void)yg_execureSuccessBlockWithResponse:(id)responseObject forRequest:(YGRequest *)request {
+- (void)yg_execureSuccessBlockWithResponse:(id)responseObject forRequest:(YGRequest *)request fromCache:(BOOL)fromCache {
+    [request setValue:@(fromCache) forKey:@"_responseFromCache"];
+    // the request is still running, the finished block will be called with the network response.
+    BOOL isFinished = !(fromCache && request.cachePolicy == kYGRequestCachePolicyCacheThenNetwork);
+    if (isFinished && request.metrics) {
+        YG_NETWORKING_SAFE_BLOCK(self.metricsObserverHandler, request, request.metrics);
+    }
+    if (isFinished && request.offlineEntryIdentifier) {
+        [self yg_finishOfflineRequest:request responseObject:responseObject error:nil];
+    }
     YG_NETWORKING_SAFE_BLOCK(request.successBlock, responseObject);
+    if (!isFinished) {
+        return;
+    }
     YG_NETWORKING_SAFE_BLOCK(request.finishedBlock, responseObject, nil);
     [request cleanCallbackBlocks];
 }
@@ -586,18 +1234,32 @@
     YG_NETWORKING_SAFE_BLOCK(self.errorProcessHandler, request, &error);
     
     if (request.retryCount > 0) {
-        request.retryCount --;
-        // retry current request after 2 seconds.
-        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(2.0 * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-            [self yg_sendRequest:request];
-        });
+        NSUInteger attempt = request.retriedCount + 1;
+        NSTimeInterval delay = [self.retryPolicy retryDelayForRequest:request error:error attempt:attempt];
+        // a negative delay means the error is not retryable, an exhausted budget means the server is likely overloaded.
+        if (delay >= 0 && (!self.retryBudget || [self.retryBudget tryWithdraw])) {
+            request.retryCount --;
+            [request setValue:@(attempt) forKey:@"_retriedCount"];
+            if (self.consoleLog) {
+                YGLog(@"\n============ [YGRequest Retry] ===========\nrequest url: %@ \nretry attempt: %lu \nretry delay: %.3fs\n==========================================\n", request.url, (unsigned long)attempt, delay);
+            }
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                [self yg_startRequest:request];
+            });
+            return;
+        }
+    }
+    
+    if ([self yg_deferOfflineRequest:request error:error]) {
         return;
     }
     
     if (self.callbackQueue) {
         __weak __typeof(self)weakSelf = self;
+        NSTimeInterval dispatchTimestamp = [NSProcessInfo processInfo].systemUptime;
         dispatch_async(self.callbackQueue, ^{
             __strong __typeof(weakSelf)strongSelf = weakSelf;
+            [request.metrics setValue:@([NSProcessInfo processInfo].systemUptime - dispatchTimestamp) forKey:@"_callbackDispatchDuration"];
             [strongSelf yg_execureFailureBlockWithError:error forRequest:request];
         });
     } else {
@@ -607,41 +1269,237 @@
 }
 
 - (void)yg_execureFailureBlockWithError:(NSError *)error forRequest:(YGRequest *)request {
+    if (request.metrics) {
+        YG_NETWORKING_SAFE_BLOCK(self.metricsObserverHandler, request, request.metrics);
+    }
+    if (request.offlineEntryIdentifier) {
+        [self yg_finishOfflineRequest:request responseObject:nil error:error];
+    }
     YG_NETWORKING_SAFE_BLOCK(request.failureBlock, error);
     YG_NETWORKING_SAFE_BLOCK(request.finishedBlock, nil, error);
     [request cleanCallbackBlocks];
 }
 
-- (NSString *)yg_identifierForBatchAndChainRequest {
-    NSString *identifier = nil;
+#pragma mark - Offline Queue
+
+/**
+ 持久请求进入离线队列，返回 `YES` 表示请求已经入队，回调在重放结束后调用.
+ 只有 Normal 类型、HTTP 方法幂等或者设置了 `idempotencyKey` 的请求可以入队，重放不会产生重复的副作用.
+ */
+- (BOOL)yg_enqueueOfflineRequest:(YGRequest *)request {
+    YGOfflineQueue *offlineQueue = self.offlineQueue;
+    if (!offlineQueue || !request.durable || request.requestType != kYGRequestNormal) return NO;
+    
+    YGHTTPMethodType httpMethod = request.httpMethod;
+    BOOL idempotent = (httpMethod == kYGHTTPMethodGET || httpMethod == kYGHTTPMethodHEAD ||
+                       httpMethod == kYGHTTPMethodPUT || httpMethod == kYGHTTPMethodDELETE);
+    if (!idempotent && request.idempotencyKey.length == 0) return NO;
+    
+    NSString *identifier = [offlineQueue enqueueRequest:request];
+    if (!identifier) return NO;
+    
+    [request setValue:identifier forKey:@"_identifier"];
+    if (self.consoleLog) {
+        YGLog(@"\n============ [YGRequest Offline] =========\nrequest url: %@ \noffline queue depth: %lu\n==========================================\n", request.url, (unsigned long)offlineQueue.count);
+    }
+    return YES;
+}
+
+/**
+ 持久请求因为网络错误或者主机熔断失败时进入离线队列，重放的请求放回原来的位置，返回 `YES` 表示请求还没有结束.
+ NOTE: 熔断时网络仍然可用，不会有网络恢复的通知，经过熔断器的冷却时间后恢复重放.
+ */
+- (BOOL)yg_deferOfflineRequest:(YGRequest *)request error:(NSError *)error {
+    BOOL isCircuitOpen = ([error.domain isEqualToString:YGErrorDomain] && error.code == kYGErrorCircuitOpen);
+    if (!isCircuitOpen && !YGIsConnectivityError(error)) return NO;
+    
+    BOOL deferred = NO;
+    if (request.offlineEntryIdentifier) {
+        deferred = [self.offlineQueue requeueRequest:request];
+        if (deferred) {
+            // YGEngine assigned a new identifier when the request was replayed.
+            [request setValue:request.offlineEntryIdentifier forKey:@"_identifier"];
+        }
+    } else {
+        deferred = [self yg_enqueueOfflineRequest:request];
+    }
+    if (deferred && isCircuitOpen) {
+        [self yg_resumeOfflineReplayAfterDelay:self.engine.circuitBreaker.cooldownInterval];
+    }
+    return deferred;
+}
+
+/**
+ 经过 `delay` 秒后恢复离线队列的重放.
+ */
+- (void)yg_resumeOfflineReplayAfterDelay:(NSTimeInterval)delay {
+    __weak __typeof(self)weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        [strongSelf.offlineQueue resumeReplay];
+        [strongSelf yg_replayOfflineRequests];
+    });
+}
+
+/**
+ 重放的请求结束，从离线队列中删除并发送下一个等待重放的请求.
+ */
+- (void)yg_finishOfflineRequest:(YGRequest *)request responseObject:(id)responseObject error:(NSError *)error {
+    [self.offlineQueue finishRequest:request];
+    YG_NETWORKING_SAFE_BLOCK(self.offlineReplayHandler, request, responseObject, error);
+    // the callback queue may be the main queue, replaying serializes requests and writes the queue log.
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [self yg_replayOfflineRequests];
+    });
+}
+
+/**
+ 按入队顺序重放离线队列中的请求，同时重放的请求数由 `maxConcurrentReplayCount` 限制，请求结束时继续重放下一个.
+ */
+- (void)yg_replayOfflineRequests {
+    YGOfflineQueue *offlineQueue = self.offlineQueue;
+    if (!offlineQueue || !self.isNetworkReachable) return;
+    
+    YGRequest *request = nil;
+    while ((request = [offlineQueue dequeueRequest])) {
+        // requests restored from the queue log have not been processed in this run.
+        if (!request.metrics) {
+            [self yg_processRequest:request onProgress:nil onSuccess:nil onFailure:nil onFinished:nil];
+        }
+        // the cache was already consulted when the request was sent the first time.
+        [self yg_startRequest:request];
+    }
+}
+
+- (void)yg_reachabilityDidChange:(NSNotification *)notification {
+    if (!self.offlineQueue || !self.isNetworkReachable) return;
+    
+    [self.offlineQueue resumeReplay];
+    // the notification is posted on the main queue, replaying serializes requests and writes the queue log.
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [self yg_replayOfflineRequests];
+    });
+}
+
+#pragma mark -
+
+/**
+ 解析 server 地址并缓存，多数请求使用相同的 server，不需要每次都重新解析.
+ */
+- (NSURL *)yg_baseURLForServer:(NSString *)server {
+    if (server.length == 0) return nil;
+    
+    NSURL *baseURL = [self.baseURLCache objectForKey:server];
+    if (!baseURL) {
+        baseURL = [NSURL URLWithString:server];
+        // ensure terminal slash for baseURL path, so that NSURL +URLWithString:relativeToURL: works as expected.
+        if ([[baseURL path] length] > 0 && ![[baseURL absoluteString] hasSuffix:@"/"]) {
+            baseURL = [baseURL URLByAppendingPathComponent:@""];
+        }
+        if (baseURL) {
+            [self.baseURLCache setObject:baseURL forKey:server];
+        }
+    }
+    return baseURL;
+}
+
+/**
+ 复制当前的通用配置快照，修改后整体替换，已经引用旧快照的请求不受影响.
+ */
+- (void)yg_updateGeneralConfig:(void (^)(YGGeneralConfig *generalConfig))block {
     YG_NETWORKING_LOCK();
-    self.autoIncrement++;
-    identifier = [NSString stringWithFormat:@"BC%lu", (unsigned long)self.autoIncrement];
+    YGGeneralConfig *generalConfig = [self.generalConfig copy];
+    block(generalConfig);
+    self.generalConfig = generalConfig;
     YG_NETWORKING_UNLOCK();
-    return identifier;
 }
 
-#pragma mark - Accessor
-
-- (NSMutableDictionary<NSString *, id> *)runningBatchAndChainPool {
-    if (!_runningBatchAndChainPool) {
-        _runningBatchAndChainPool = [NSMutableDictionary dictionary];
+/**
+ 将请求加入分组和所有者的分组，请求可以是 YGRequest/YGBatchRequest/YGChainRequest/YGGraphRequest 对象.
+ */
+- (void)yg_addRequest:(id)request toGroup:(NSString *)group owner:(id)owner {
+    if (group.length > 0) {
+        [self yg_addRequest:request toGroup:group];
+    }
+    if (owner) {
+        [self yg_addRequest:request toGroup:[self yg_groupForOwner:owner]];
     }
-    return _runningBatchAndChainPool;
 }
 
-- (NSMutableDictionary<NSString *, id> *)generalParameters {
-    if (!_generalParameters) {
-        _generalParameters = [NSMutableDictionary dictionary];
+- (void)yg_addRequest:(id)request toGroup:(NSString *)group {
+    while (YES) {
+        YGRequestGroup *requestGroup = [self.requestGroups objectForKey:group insertingIfAbsent:^id{
+            return [[YGRequestGroup alloc] init];
+        }];
+        if ([requestGroup addRequest:request]) {
+            return;
+        }
+        // the group was cancelled and removed concurrently, retry with a new one.
     }
-    return _generalParameters;
 }
 
-- (NSMutableDictionary<NSString *, NSString *> *)generalHeaders {
-    if (!_generalHeaders) {
-        _generalHeaders = [NSMutableDictionary dictionary];
+/**
+ 返回所有者的分组名，第一次调用时在所有者上关联一个 YGRequestOwnerToken，所有者释放时取消这个分组.
+ */
+- (NSString *)yg_groupForOwner:(id)owner {
+    YG_NETWORKING_LOCK();
+    YGRequestOwnerToken *token = objc_getAssociatedObject(owner, (__bridge const void *)self);
+    if (!token) {
+        token = [[YGRequestOwnerToken alloc] init];
+        token.center = self;
+        token.group = [NSString stringWithFormat:@"com.ygnetworking.owner.%p", token];
+        objc_setAssociatedObject(owner, (__bridge const void *)self, token, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
     }
-    return _generalHeaders;
+    NSString *group = token.group;
+    YG_NETWORKING_UNLOCK();
+    return group;
+}
+
+- (NSString *)yg_identifierForBatchAndChainRequest {
+    return [self yg_identifierWithPrefix:@"BC"];
+}
+
+- (NSString *)yg_identifierWithPrefix:(NSString *)prefix {
+    unsigned long autoIncrement = atomic_fetch_add_explicit(&_autoIncrement, 1, memory_order_relaxed) + 1;
+    return [NSString stringWithFormat:@"%@%lu", prefix, autoIncrement];
+}
+
+#pragma mark - Accessor
+
+- (void)setOfflineQueue:(YGOfflineQueue *)offlineQueue {
+    _offlineQueue = offlineQueue;
+    // replay the requests left in the queue by the previous run.
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [self yg_replayOfflineRequests];
+    });
+}
+
+- (NSString *)generalServer {
+    return self.generalConfig.server;
+}
+
+- (void)setGeneralServer:(NSString *)generalServer {
+    [self yg_updateGeneralConfig:^(YGGeneralConfig *generalConfig) {
+        generalConfig.server = generalServer;
+    }];
+}
+
+- (NSDictionary<NSString *, id> *)generalParameters {
+    return self.generalConfig.parameters;
+}
+
+- (NSDictionary<NSString *, NSString *> *)generalHeaders {
+    return self.generalConfig.headers;
+}
+
+- (NSDictionary *)generalUserInfo {
+    return self.generalConfig.userInfo;
+}
+
+- (void)setGeneralUserInfo:(NSDictionary *)generalUserInfo {
+    [self yg_updateGeneralConfig:^(YGGeneralConfig *generalConfig) {
+        generalConfig.userInfo = generalUserInfo;
+    }];
 }
 
 @end
@@ -0,0 +1,172 @@
+//
+//  YGCircuitBreaker.h
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "YGConst.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ 主机的熔断器状态发生变化时发送的通知，在记录结果或检查请求的线程中发送.
+ userInfo 中包含 `YGCircuitBreakerHostKey` 和 `YGCircuitBreakerStateKey`.
+ */
+FOUNDATION_EXPORT NSString * const YGCircuitBreakerStateDidChangeNotification;
+
+/**
+ 通知 userInfo 中状态发生变化的主机 (NSString).
+ */
+FOUNDATION_EXPORT NSString * const YGCircuitBreakerHostKey;
+
+/**
+ 通知 userInfo 中变化后的状态 (NSNumber，`YGCircuitBreakerState`).
+ */
+FOUNDATION_EXPORT NSString * const YGCircuitBreakerStateKey;
+
+/**
+ `YGCircuitBreaker` 是 YGEngine 按主机统计的熔断器.
+ 
+ 在 `windowInterval` 的滚动窗口内统计每个主机的请求结果，服务端故障导致的传输错误和 5xx 响应记为失败 (设备离线导致的错误不统计)，
+ 耗时超过 `slowCallDurationThreshold` 的请求记为慢请求. 窗口内请求数达到 `minimumRequestCount` 且失败率或慢请求率超过阈值时，
+ 主机进入熔断状态，之后的请求直接失败; 经过 `cooldownInterval` 后进入半开状态，放行探测请求，
+ 探测成功后恢复正常，失败后重新熔断.
+ 
+ NOTE: 半开状态下只有放行时分配了探测令牌的请求的结果会改变主机的状态，熔断前已经发出的请求的结果被忽略.
+ */
+@interface YGCircuitBreaker : NSObject
+
+/**
+ 创建并返回一个默认配置的 `YGCircuitBreaker` 对象.
+ */
++ (instancetype)breaker;
+
+///---------------------
+/// @name 配置
+///---------------------
+
+/**
+ 统计请求结果的滚动窗口长度，默认为 `30` 秒.
+ */
+@property (nonatomic, assign) NSTimeInterval windowInterval;
+
+/**
+ 窗口内触发熔断所需的最少请求数，默认为 `10`.
+ */
+@property (nonatomic, assign) NSUInteger minimumRequestCount;
+
+/**
+ 触发熔断的失败率，默认为 `0.5`.
+ */
+@property (nonatomic, assign) double failureRateThreshold;
+
+/**
+ 请求被记为慢请求的耗时，默认为 `10` 秒.
+ */
+@property (nonatomic, assign) NSTimeInterval slowCallDurationThreshold;
+
+/**
+ 触发熔断的慢请求率，默认为 `0.8`.
+ */
+@property (nonatomic, assign) double slowCallRateThreshold;
+
+/**
+ 熔断后进入半开状态前的冷却时间，也是半开状态下探测请求的最长等待时间，默认为 `15` 秒.
+ */
+@property (nonatomic, assign) NSTimeInterval cooldownInterval;
+
+///---------------------
+/// @name 检查和记录
+///---------------------
+
+/**
+ 判断是否允许向主机发送请求，冷却结束时会将主机切换到半开状态并放行一个探测请求.
+ NOTE: 这个方法不返回探测令牌，放行的探测请求的结果不能结束半开状态，只能等待探测超时，需要记录结果时使用 `-allowRequestForHost:probeToken:`.
+
+ @param host 请求的主机.
+ @return 主机未熔断或请求作为探测请求被放行时返回 `YES`.
+ */
+- (BOOL)allowRequestForHost:(NSString *)host;
+
+/**
+ 判断是否允许向主机发送请求，冷却结束时会将主机切换到半开状态并放行一个探测请求.
+
+ @param host 请求的主机.
+ @param probeToken 请求作为探测请求被放行时返回非 `0` 的探测令牌，记录这个请求的结果时传入，其他情况返回 `0`.
+ @return 主机未熔断或请求作为探测请求被放行时返回 `YES`.
+ */
+- (BOOL)allowRequestForHost:(NSString *)host probeToken:(nullable NSUInteger *)probeToken;
+
+/**
+ 记录一个成功的请求.
+
+ @param host 请求的主机.
+ @param latency 请求的耗时(秒).
+ */
+- (void)recordSuccessForHost:(NSString *)host latency:(NSTimeInterval)latency;
+
+/**
+ 记录一个成功的请求.
+
+ @param host 请求的主机.
+ @param latency 请求的耗时(秒).
+ @param probeToken 放行请求时返回的探测令牌，只有当前探测请求的令牌能让主机从半开状态恢复正常.
+ */
+- (void)recordSuccessForHost:(NSString *)host latency:(NSTimeInterval)latency probeToken:(NSUInteger)probeToken;
+
+/**
+ 记录一个失败的请求.
+
+ @param host 请求的主机.
+ @param latency 请求的耗时(秒).
+ */
+- (void)recordFailureForHost:(NSString *)host latency:(NSTimeInterval)latency;
+
+/**
+ 记录一个失败的请求.
+
+ @param host 请求的主机.
+ @param latency 请求的耗时(秒).
+ @param probeToken 放行请求时返回的探测令牌，只有当前探测请求的令牌能让主机从半开状态重新熔断.
+ */
+- (void)recordFailureForHost:(NSString *)host latency:(NSTimeInterval)latency probeToken:(NSUInteger)probeToken;
+
+/**
+ 记录一个被取消的请求，取消不计入统计.
+
+ @param host 请求的主机.
+ */
+- (void)recordCancellationForHost:(NSString *)host;
+
+/**
+ 记录一个被取消的请求，取消不计入统计，当前探测请求被取消时释放半开状态下的探测名额.
+
+ @param host 请求的主机.
+ @param probeToken 放行请求时返回的探测令牌.
+ */
+- (void)recordCancellationForHost:(NSString *)host probeToken:(NSUInteger)probeToken;
+
+/**
+ 获取主机当前的熔断器状态.
+
+ @param host 主机.
+ @return 熔断器状态，没有记录的主机为 `kYGCircuitBreakerStateClosed`.
+ */
+- (YGCircuitBreakerState)stateForHost:(NSString *)host;
+
+/**
+ 清除主机的统计数据并恢复正常状态.
+ */
+- (void)resetHost:(NSString *)host;
+
+/**
+ 清除所有主机的统计数据.
+ */
+- (void)reset;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,293 @@
+//
+//  YGCircuitBreaker.m
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import "YGCircuitBreaker.h"
+
+NSString * const YGCircuitBreakerStateDidChangeNotification = @"com.ygnetworking.circuitbreaker.statechange";
+NSString * const YGCircuitBreakerHostKey = @"host";
+NSString * const YGCircuitBreakerStateKey = @"state";
+
+#define YGCircuitBreakerBucketCount 10
+
+typedef NS_ENUM(NSInteger, YGCircuitBreakerOutcome) {
+    YGCircuitBreakerOutcomeSuccess,
+    YGCircuitBreakerOutcomeFailure,
+    YGCircuitBreakerOutcomeCancellation,
+};
+
+#pragma mark - YGCircuitBreakerHost
+
+/**
+ 单个主机的熔断状态和滚动窗口, 窗口被分为 `YGCircuitBreakerBucketCount` 个桶, 桶的 epoch 过期时重新计数.
+ */
+@interface YGCircuitBreakerHost : NSObject {
+    @package
+    YGCircuitBreakerState _state;
+    NSTimeInterval _openedAt;
+    NSTimeInterval _probeDeadline;
+    NSUInteger _probeToken;
+    long long _epochs[YGCircuitBreakerBucketCount];
+    NSUInteger _totals[YGCircuitBreakerBucketCount];
+    NSUInteger _failures[YGCircuitBreakerBucketCount];
+    NSUInteger _slows[YGCircuitBreakerBucketCount];
+}
+@end
+
+@implementation YGCircuitBreakerHost
+@end
+
+#pragma mark - YGCircuitBreaker
+
+@interface YGCircuitBreaker () {
+    pthread_mutex_t _lock;
+    NSUInteger _probeSequence;
+}
+
+@property (nonatomic, strong) NSMutableDictionary<NSString *, YGCircuitBreakerHost *> *hosts;
+
+@end
+
+@implementation YGCircuitBreaker
+
++ (instancetype)breaker {
+    return [[[self class] alloc] init];
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    YG_NETWORKING_LOCK_INIT();
+    _hosts = [NSMutableDictionary dictionary];
+    _windowInterval = 30.0;
+    _minimumRequestCount = 10;
+    _failureRateThreshold = 0.5;
+    _slowCallDurationThreshold = 10.0;
+    _slowCallRateThreshold = 0.8;
+    _cooldownInterval = 15.0;
+    
+    return self;
+}
+
+- (void)dealloc {
+    YG_NETWORKING_LOCK_DESTROY();
+}
+
+#pragma mark - Public Methods
+
+- (BOOL)allowRequestForHost:(NSString *)host {
+    return [self allowRequestForHost:host probeToken:NULL];
+}
+
+- (BOOL)allowRequestForHost:(NSString *)host probeToken:(NSUInteger *)probeToken {
+    if (probeToken) *probeToken = 0;
+    if (host.length == 0) return YES;
+    
+    NSTimeInterval now = [NSProcessInfo processInfo].systemUptime;
+    BOOL allowed = YES;
+    BOOL stateChanged = NO;
+    
+    YG_NETWORKING_LOCK();
+    YGCircuitBreakerHost *record = self.hosts[host.lowercaseString];
+    if (record && record->_state == kYGCircuitBreakerStateOpen) {
+        if (now - record->_openedAt >= self.cooldownInterval) {
+            record->_state = kYGCircuitBreakerStateHalfOpen;
+            [self yg_admitProbeForHost:record now:now probeToken:probeToken];
+            stateChanged = YES;
+        } else {
+            allowed = NO;
+        }
+    } else if (record && record->_state == kYGCircuitBreakerStateHalfOpen) {
+        // only one probe at a time, a probe that never reports back releases its slot at the deadline.
+        if (now >= record->_probeDeadline) {
+            [self yg_admitProbeForHost:record now:now probeToken:probeToken];
+        } else {
+            allowed = NO;
+        }
+    }
+    YG_NETWORKING_UNLOCK();
+    
+    if (stateChanged) {
+        [self yg_postStateChange:kYGCircuitBreakerStateHalfOpen forHost:host];
+    }
+    return allowed;
+}
+
+- (void)recordSuccessForHost:(NSString *)host latency:(NSTimeInterval)latency {
+    [self recordSuccessForHost:host latency:latency probeToken:0];
+}
+
+- (void)recordSuccessForHost:(NSString *)host latency:(NSTimeInterval)latency probeToken:(NSUInteger)probeToken {
+    [self yg_recordOutcome:YGCircuitBreakerOutcomeSuccess forHost:host latency:latency probeToken:probeToken];
+}
+
+- (void)recordFailureForHost:(NSString *)host latency:(NSTimeInterval)latency {
+    [self recordFailureForHost:host latency:latency probeToken:0];
+}
+
+- (void)recordFailureForHost:(NSString *)host latency:(NSTimeInterval)latency probeToken:(NSUInteger)probeToken {
+    [self yg_recordOutcome:YGCircuitBreakerOutcomeFailure forHost:host latency:latency probeToken:probeToken];
+}
+
+- (void)recordCancellationForHost:(NSString *)host {
+    [self recordCancellationForHost:host probeToken:0];
+}
+
+- (void)recordCancellationForHost:(NSString *)host probeToken:(NSUInteger)probeToken {
+    [self yg_recordOutcome:YGCircuitBreakerOutcomeCancellation forHost:host latency:0 probeToken:probeToken];
+}
+
+- (YGCircuitBreakerState)stateForHost:(NSString *)host {
+    if (host.length == 0) return kYGCircuitBreakerStateClosed;
+    
+    YG_NETWORKING_LOCK();
+    YGCircuitBreakerHost *record = self.hosts[host.lowercaseString];
+    YGCircuitBreakerState state = record ? record->_state : kYGCircuitBreakerStateClosed;
+    YG_NETWORKING_UNLOCK();
+    return state;
+}
+
+- (void)resetHost:(NSString *)host {
+    if (host.length == 0) return;
+    
+    YG_NETWORKING_LOCK();
+    YGCircuitBreakerHost *record = self.hosts[host.lowercaseString];
+    BOOL stateChanged = record && record->_state != kYGCircuitBreakerStateClosed;
+    [self.hosts removeObjectForKey:host.lowercaseString];
+    YG_NETWORKING_UNLOCK();
+    
+    if (stateChanged) {
+        [self yg_postStateChange:kYGCircuitBreakerStateClosed forHost:host];
+    }
+}
+
+- (void)reset {
+    NSMutableArray<NSString *> *closedHosts = [NSMutableArray array];
+    YG_NETWORKING_LOCK();
+    [self.hosts enumerateKeysAndObjectsUsingBlock:^(NSString *key, YGCircuitBreakerHost *record, BOOL *stop) {
+        if (record->_state != kYGCircuitBreakerStateClosed) {
+            [closedHosts addObject:key];
+        }
+    }];
+    [self.hosts removeAllObjects];
+    YG_NETWORKING_UNLOCK();
+    
+    for (NSString *host in closedHosts) {
+        [self yg_postStateChange:kYGCircuitBreakerStateClosed forHost:host];
+    }
+}
+
+#pragma mark - Private Methods
+
+/**
+ 放行一个探测请求, 需要在持有 `_lock` 的情况下调用. 新的令牌让之前超时的探测请求的结果失效.
+ */
+- (void)yg_admitProbeForHost:(YGCircuitBreakerHost *)record now:(NSTimeInterval)now probeToken:(NSUInteger *)probeToken {
+    record->_probeDeadline = now + self.cooldownInterval;
+    record->_probeToken = ++_probeSequence;
+    if (probeToken) *probeToken = record->_probeToken;
+}
+
+- (void)yg_recordOutcome:(YGCircuitBreakerOutcome)outcome forHost:(NSString *)host latency:(NSTimeInterval)latency probeToken:(NSUInteger)probeToken {
+    if (host.length == 0) return;
+    
+    NSString *key = host.lowercaseString;
+    NSTimeInterval now = [NSProcessInfo processInfo].systemUptime;
+    YGCircuitBreakerState newState = kYGCircuitBreakerStateClosed;
+    BOOL stateChanged = NO;
+    
+    YG_NETWORKING_LOCK();
+    YGCircuitBreakerHost *record = self.hosts[key];
+    if (!record) {
+        if (outcome == YGCircuitBreakerOutcomeCancellation) {
+            YG_NETWORKING_UNLOCK();
+            return;
+        }
+        record = [[YGCircuitBreakerHost alloc] init];
+        self.hosts[key] = record;
+    }
+    
+    if (record->_state == kYGCircuitBreakerStateHalfOpen) {
+        // only the admitted probe decides the state of the host, requests sent before the breaker opened do not.
+        BOOL isProbe = (probeToken != 0 && probeToken == record->_probeToken);
+        if (isProbe && outcome == YGCircuitBreakerOutcomeSuccess) {
+            [self yg_resetBucketsForHost:record];
+            record->_state = kYGCircuitBreakerStateClosed;
+            record->_probeToken = 0;
+            stateChanged = YES;
+        } else if (isProbe && outcome == YGCircuitBreakerOutcomeFailure) {
+            record->_state = kYGCircuitBreakerStateOpen;
+            record->_openedAt = now;
+            record->_probeToken = 0;
+            stateChanged = YES;
+        } else if (isProbe) {
+            record->_probeDeadline = 0;
+            record->_probeToken = 0;
+        }
+    } else if (record->_state == kYGCircuitBreakerStateClosed && outcome != YGCircuitBreakerOutcomeCancellation) {
+        NSTimeInterval bucketInterval = MAX(self.windowInterval / YGCircuitBreakerBucketCount, 0.001);
+        long long epoch = (long long)(now / bucketInterval);
+        NSUInteger index = (NSUInteger)(epoch % YGCircuitBreakerBucketCount);
+        if (record->_epochs[index] != epoch) {
+            record->_epochs[index] = epoch;
+            record->_totals[index] = 0;
+            record->_failures[index] = 0;
+            record->_slows[index] = 0;
+        }
+        record->_totals[index]++;
+        if (outcome == YGCircuitBreakerOutcomeFailure) {
+            record->_failures[index]++;
+        }
+        if (latency >= self.slowCallDurationThreshold) {
+            record->_slows[index]++;
+        }
+        
+        NSUInteger total = 0, failures = 0, slows = 0;
+        for (NSUInteger i = 0; i < YGCircuitBreakerBucketCount; i++) {
+            if (epoch - record->_epochs[i] < YGCircuitBreakerBucketCount) {
+                total += record->_totals[i];
+                failures += record->_failures[i];
+                slows += record->_slows[i];
+            }
+        }
+        if (total > 0 && total >= self.minimumRequestCount &&
+            ((double)failures / total >= self.failureRateThreshold || (double)slows / total >= self.slowCallRateThreshold)) {
+            [self yg_resetBucketsForHost:record];
+            record->_state = kYGCircuitBreakerStateOpen;
+            record->_openedAt = now;
+            stateChanged = YES;
+        }
+    }
+    // results that arrive late for an open host are ignored.
+    newState = record->_state;
+    YG_NETWORKING_UNLOCK();
+    
+    if (stateChanged) {
+        [self yg_postStateChange:newState forHost:key];
+    }
+}
+
+- (void)yg_resetBucketsForHost:(YGCircuitBreakerHost *)record {
+    for (NSUInteger i = 0; i < YGCircuitBreakerBucketCount; i++) {
+        record->_epochs[i] = 0;
+        record->_totals[i] = 0;
+        record->_failures[i] = 0;
+        record->_slows[i] = 0;
+    }
+}
+
+- (void)yg_postStateChange:(YGCircuitBreakerState)state forHost:(NSString *)host {
+    [[NSNotificationCenter defaultCenter] postNotificationName:YGCircuitBreakerStateDidChangeNotification
+                                                        object:self
+                                                      userInfo:@{YGCircuitBreakerHostKey: host.lowercaseString,
+                                                                 YGCircuitBreakerStateKey: @(state)}];
+}
+
+@end
@@ -0,0 +1,169 @@
+//
+//  YGConcurrencyLimiter.h
+//  YGNetworking
+//
+//  Created by Sun on 2020/5/2.
+//  Copyright © 2020 YGNetworking. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "YGConst.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ 主机的并发上限发生变化时发送的通知，在记录结果或重置的线程中发送.
+ userInfo 中包含 `YGConcurrencyLimiterHostKey`、`YGConcurrencyLimiterLimitKey`、`YGConcurrencyLimiterPreviousLimitKey`、
+ `YGConcurrencyLimiterDecisionKey` 和 `YGConcurrencyLimiterLatencyKey`.
+ */
+FOUNDATION_EXPORT NSString * const YGConcurrencyLimitDidChangeNotification;
+
+/**
+ 通知 userInfo 中并发上限发生变化的主机 (NSString).
+ */
+FOUNDATION_EXPORT NSString * const YGConcurrencyLimiterHostKey;
+
+/**
+ 通知 userInfo 中变化后的并发上限 (NSNumber).
+ */
+FOUNDATION_EXPORT NSString * const YGConcurrencyLimiterLimitKey;
+
+/**
+ 通知 userInfo 中变化前的并发上限 (NSNumber).
+ */
+FOUNDATION_EXPORT NSString * const YGConcurrencyLimiterPreviousLimitKey;
+
+/**
+ 通知 userInfo 中调整的原因 (NSNumber，`YGConcurrencyLimitDecision`).
+ */
+FOUNDATION_EXPORT NSString * const YGConcurrencyLimiterDecisionKey;
+
+/**
+ 通知 userInfo 中主机的平滑延迟(秒) (NSNumber)，重置时为 `0`.
+ */
+FOUNDATION_EXPORT NSString * const YGConcurrencyLimiterLatencyKey;
+
+/**
+ `YGConcurrencyLimiter` 是 YGEngine 按主机自适应调整并发上限的限流器 (TCP Vegas 风格的延迟判断 + AIMD).
+ 
+ 每个主机记录最小延迟和平滑延迟，按 `limit × (1 - 最小延迟 / 平滑延迟)` 估计在网络或服务端排队的请求数:
+ 排队数低于 `lowQueueThreshold` 并且并发名额被充分使用时上限每轮增加 `1` (每个请求增加 `1 / limit`);
+ 排队数高于 `highQueueThreshold` 时上限减少 `1`，在超时堆积之前降低并发;
+ 超时、连接失败或过载响应 (429/503/504) 时上限乘以 `backoffRatio`.
+ 两次减少至少间隔一个平滑延迟，同一批请求一起失败时只减少一次.
+ 
+ 初始上限由网络连接类型决定，网络连接类型变化时 YGEngine 调用 `-resetWithConnectionType:` 重新开始估计.
+ NOTE: 每次 `-tryAcquireForHost:` 成功后必须调用一次 `-recordSuccessForHost:latency:`、`-recordDropForHost:` 或 `-releaseForHost:`.
+ */
+@interface YGConcurrencyLimiter : NSObject
+
+/**
+ 创建并返回一个默认配置的 `YGConcurrencyLimiter` 对象.
+ */
++ (instancetype)limiter;
+
+///---------------------
+/// @name 配置
+///---------------------
+
+/**
+ Wi-Fi 下主机的初始并发上限，默认为 `6`.
+ */
+@property (nonatomic, assign) NSUInteger initialLimitViaWiFi;
+
+/**
+ 移动网络和未知网络下主机的初始并发上限，默认为 `3`.
+ */
+@property (nonatomic, assign) NSUInteger initialLimitViaWWAN;
+
+/**
+ 主机的最小并发上限，默认为 `1`.
+ */
+@property (nonatomic, assign) NSUInteger minLimit;
+
+/**
+ 主机的最大并发上限，默认为 `32`. 所有主机的总并发数仍然受 YGEngine 的 `maxConcurrentRequestCount` 限制.
+ */
+@property (nonatomic, assign) NSUInteger maxLimit;
+
+/**
+ 估计的排队请求数低于这个值时增加上限，默认为 `2`.
+ */
+@property (nonatomic, assign) double lowQueueThreshold;
+
+/**
+ 估计的排队请求数高于这个值时减少上限，默认为 `4`.
+ */
+@property (nonatomic, assign) double highQueueThreshold;
+
+/**
+ 超时、连接失败或过载响应时上限的乘数，默认为 `0.7`.
+ */
+@property (nonatomic, assign) double backoffRatio;
+
+/**
+ 当前的网络连接类型，由 `-resetWithConnectionType:` 设置，默认为 `kYGNetworkConnectionTypeUnknown`.
+ */
+@property (nonatomic, assign, readonly) YGNetworkConnectionType connectionType;
+
+///---------------------
+/// @name 获取和释放名额
+///---------------------
+
+/**
+ 为发往主机的请求获取一个并发名额.
+
+ @param host 请求的主机，为空时不限制.
+ @return 主机正在运行的请求数小于并发上限时返回 `YES`.
+ */
+- (BOOL)tryAcquireForHost:(nullable NSString *)host;
+
+/**
+ 释放名额并记录一个成功的请求，用延迟调整上限.
+
+ @param host 请求的主机.
+ @param latency 请求的耗时(秒).
+ */
+- (void)recordSuccessForHost:(nullable NSString *)host latency:(NSTimeInterval)latency;
+
+/**
+ 释放名额并记录一个超时、连接失败或过载响应的请求，乘性减少上限.
+
+ @param host 请求的主机.
+ */
+- (void)recordDropForHost:(nullable NSString *)host;
+
+/**
+ 释放名额，不调整上限，用于取消的请求和与服务端负载无关的错误.
+
+ @param host 请求的主机.
+ */
+- (void)releaseForHost:(nullable NSString *)host;
+
+///---------------------
+/// @name 状态
+///---------------------
+
+/**
+ 获取主机当前的并发上限.
+
+ @param host 主机.
+ @return 并发上限，没有记录的主机为当前网络连接类型的初始上限.
+ */
+- (NSUInteger)limitForHost:(NSString *)host;
+
+/**
+ 获取发往主机正在运行的请求数.
+ */
+- (NSUInteger)inflightCountForHost:(NSString *)host;
+
+/**
+ 按新的网络连接类型重新开始估计，所有主机的上限恢复为初始值，正在运行的请求数保持不变.
+
+ @param connectionType 网络连接类型.
+ */
+- (void)resetWithConnectionType:(YGNetworkConnectionType)connectionType;
+
+@end
+
+NS_ASSUME_NONNULL_END
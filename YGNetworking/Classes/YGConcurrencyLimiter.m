@@ -0,0 +1,266 @@
+//
+//  YGConcurrencyLimiter.m
+//  YGNetworking
+//
+//  Created by Sun on 2020/5/2.
+//  Copyright © 2020 YGNetworking. All rights reserved.
+//
+
+#import "YGConcurrencyLimiter.h"
+
+NSString * const YGConcurrencyLimitDidChangeNotification = @"com.ygnetworking.concurrencylimiter.limitchange";
+NSString * const YGConcurrencyLimiterHostKey = @"host";
+NSString * const YGConcurrencyLimiterLimitKey = @"limit";
+NSString * const YGConcurrencyLimiterPreviousLimitKey = @"previousLimit";
+NSString * const YGConcurrencyLimiterDecisionKey = @"decision";
+NSString * const YGConcurrencyLimiterLatencyKey = @"latency";
+
+/// 每记录这么多个样本，用平滑延迟替换最小延迟，路由或服务端变化后最小延迟不会一直停留在旧值.
+#define YGConcurrencyLimiterMinLatencyWindow 100
+
+/// 平滑延迟中新样本的权重.
+#define YGConcurrencyLimiterSmoothingFactor 0.2
+
+#pragma mark - YGConcurrencyLimiterHost
+
+/**
+ 单个主机的并发上限和延迟估计.
+ */
+@interface YGConcurrencyLimiterHost : NSObject {
+    @package
+    double _limit;
+    NSUInteger _inflight;
+    NSTimeInterval _minLatency;
+    NSTimeInterval _smoothedLatency;
+    NSUInteger _sampleCount;
+    NSTimeInterval _lastDecreasedAt;
+}
+@end
+
+@implementation YGConcurrencyLimiterHost
+@end
+
+#pragma mark - YGConcurrencyLimiter
+
+@interface YGConcurrencyLimiter () {
+    pthread_mutex_t _lock;
+}
+
+@property (nonatomic, strong) NSMutableDictionary<NSString *, YGConcurrencyLimiterHost *> *hosts;
+
+@end
+
+@implementation YGConcurrencyLimiter
+
++ (instancetype)limiter {
+    return [[[self class] alloc] init];
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    YG_NETWORKING_LOCK_INIT();
+    _hosts = [NSMutableDictionary dictionary];
+    _initialLimitViaWiFi = 6;
+    _initialLimitViaWWAN = 3;
+    _minLimit = 1;
+    _maxLimit = 32;
+    _lowQueueThreshold = 2.0;
+    _highQueueThreshold = 4.0;
+    _backoffRatio = 0.7;
+    _connectionType = kYGNetworkConnectionTypeUnknown;
+    
+    return self;
+}
+
+- (void)dealloc {
+    YG_NETWORKING_LOCK_DESTROY();
+}
+
+#pragma mark - Public Methods
+
+- (BOOL)tryAcquireForHost:(NSString *)host {
+    if (host.length == 0) return YES;
+    
+    YG_NETWORKING_LOCK();
+    YGConcurrencyLimiterHost *record = [self yg_recordForHost:host];
+    BOOL acquired = record->_inflight < [self yg_integerLimit:record->_limit];
+    if (acquired) {
+        record->_inflight++;
+    }
+    YG_NETWORKING_UNLOCK();
+    return acquired;
+}
+
+- (void)recordSuccessForHost:(NSString *)host latency:(NSTimeInterval)latency {
+    if (host.length == 0) return;
+    
+    NSTimeInterval now = [NSProcessInfo processInfo].systemUptime;
+    YGConcurrencyLimitDecision decision = kYGConcurrencyLimitDecisionIncrease;
+    
+    YG_NETWORKING_LOCK();
+    YGConcurrencyLimiterHost *record = [self yg_recordForHost:host];
+    NSUInteger previousLimit = [self yg_integerLimit:record->_limit];
+    // the request still holds its slot here, so `_inflight` counts it.
+    NSUInteger inflight = record->_inflight;
+    [self yg_releaseSlotOfHost:record];
+    
+    if (latency > 0) {
+        record->_sampleCount++;
+        record->_smoothedLatency = record->_smoothedLatency > 0 ? record->_smoothedLatency * (1 - YGConcurrencyLimiterSmoothingFactor) + latency * YGConcurrencyLimiterSmoothingFactor : latency;
+        if (record->_minLatency <= 0 || latency < record->_minLatency) {
+            record->_minLatency = latency;
+        }
+        if (record->_sampleCount % YGConcurrencyLimiterMinLatencyWindow == 0) {
+            record->_minLatency = MIN(record->_smoothedLatency, latency);
+        }
+        
+        double queueSize = record->_limit * (1 - record->_minLatency / record->_smoothedLatency);
+        if (queueSize > self.highQueueThreshold) {
+            if ([self yg_canDecreaseHost:record now:now]) {
+                record->_limit -= 1;
+                record->_lastDecreasedAt = now;
+                decision = kYGConcurrencyLimitDecisionLatencyDecrease;
+            }
+        } else if (queueSize < self.lowQueueThreshold && inflight * 2 >= previousLimit) {
+            // only grow when the current limit is actually used, an idle host says nothing about the network.
+            record->_limit += 1 / MAX(record->_limit, 1);
+        }
+        record->_limit = MAX(MIN(record->_limit, (double)self.maxLimit), (double)MAX(self.minLimit, 1));
+    }
+    NSUInteger limit = [self yg_integerLimit:record->_limit];
+    NSTimeInterval smoothedLatency = record->_smoothedLatency;
+    YG_NETWORKING_UNLOCK();
+    
+    if (limit != previousLimit) {
+        [self yg_postLimitChange:limit previousLimit:previousLimit decision:decision latency:smoothedLatency forHost:host];
+    }
+}
+
+- (void)recordDropForHost:(NSString *)host {
+    if (host.length == 0) return;
+    
+    NSTimeInterval now = [NSProcessInfo processInfo].systemUptime;
+    
+    YG_NETWORKING_LOCK();
+    YGConcurrencyLimiterHost *record = [self yg_recordForHost:host];
+    NSUInteger previousLimit = [self yg_integerLimit:record->_limit];
+    [self yg_releaseSlotOfHost:record];
+    if ([self yg_canDecreaseHost:record now:now]) {
+        record->_limit = MAX(record->_limit * self.backoffRatio, (double)MAX(self.minLimit, 1));
+        record->_lastDecreasedAt = now;
+    }
+    NSUInteger limit = [self yg_integerLimit:record->_limit];
+    NSTimeInterval smoothedLatency = record->_smoothedLatency;
+    YG_NETWORKING_UNLOCK();
+    
+    if (limit != previousLimit) {
+        [self yg_postLimitChange:limit previousLimit:previousLimit decision:kYGConcurrencyLimitDecisionDropDecrease latency:smoothedLatency forHost:host];
+    }
+}
+
+- (void)releaseForHost:(NSString *)host {
+    if (host.length == 0) return;
+    
+    YG_NETWORKING_LOCK();
+    [self yg_releaseSlotOfHost:[self yg_recordForHost:host]];
+    YG_NETWORKING_UNLOCK();
+}
+
+- (NSUInteger)limitForHost:(NSString *)host {
+    YG_NETWORKING_LOCK();
+    YGConcurrencyLimiterHost *record = self.hosts[host.lowercaseString];
+    NSUInteger limit = [self yg_integerLimit:record ? record->_limit : [self yg_initialLimit]];
+    YG_NETWORKING_UNLOCK();
+    return limit;
+}
+
+- (NSUInteger)inflightCountForHost:(NSString *)host {
+    YG_NETWORKING_LOCK();
+    YGConcurrencyLimiterHost *record = self.hosts[host.lowercaseString];
+    NSUInteger inflight = record ? record->_inflight : 0;
+    YG_NETWORKING_UNLOCK();
+    return inflight;
+}
+
+- (void)resetWithConnectionType:(YGNetworkConnectionType)connectionType {
+    NSMutableDictionary<NSString *, NSNumber *> *previousLimits = [NSMutableDictionary dictionary];
+    YG_NETWORKING_LOCK();
+    _connectionType = connectionType;
+    double initialLimit = [self yg_initialLimit];
+    [self.hosts enumerateKeysAndObjectsUsingBlock:^(NSString *key, YGConcurrencyLimiterHost *record, BOOL *stop) {
+        NSUInteger previousLimit = [self yg_integerLimit:record->_limit];
+        if (previousLimit != [self yg_integerLimit:initialLimit]) {
+            previousLimits[key] = @(previousLimit);
+        }
+        // keep `_inflight`, the running requests still release their slots.
+        record->_limit = initialLimit;
+        record->_minLatency = 0;
+        record->_smoothedLatency = 0;
+        record->_sampleCount = 0;
+        record->_lastDecreasedAt = 0;
+    }];
+    NSUInteger limit = [self yg_integerLimit:initialLimit];
+    YG_NETWORKING_UNLOCK();
+    
+    [previousLimits enumerateKeysAndObjectsUsingBlock:^(NSString *host, NSNumber *previousLimit, BOOL *stop) {
+        [self yg_postLimitChange:limit previousLimit:previousLimit.unsignedIntegerValue decision:kYGConcurrencyLimitDecisionReset latency:0 forHost:host];
+    }];
+}
+
+#pragma mark - Private Methods
+
+/**
+ 获取主机的记录，不存在时按当前网络连接类型创建，必须在持有 `_lock` 时调用.
+ */
+- (YGConcurrencyLimiterHost *)yg_recordForHost:(NSString *)host {
+    NSString *key = host.lowercaseString;
+    YGConcurrencyLimiterHost *record = self.hosts[key];
+    if (!record) {
+        record = [[YGConcurrencyLimiterHost alloc] init];
+        record->_limit = [self yg_initialLimit];
+        self.hosts[key] = record;
+    }
+    return record;
+}
+
+- (void)yg_releaseSlotOfHost:(YGConcurrencyLimiterHost *)record {
+    if (record->_inflight > 0) {
+        record->_inflight--;
+    }
+}
+
+/**
+ 两次减少至少间隔一个平滑延迟，同一时间发出的请求一起超时或者一起变慢时只减少一次.
+ */
+- (BOOL)yg_canDecreaseHost:(YGConcurrencyLimiterHost *)record now:(NSTimeInterval)now {
+    return record->_lastDecreasedAt <= 0 || now - record->_lastDecreasedAt >= record->_smoothedLatency;
+}
+
+- (double)yg_initialLimit {
+    NSUInteger initialLimit = (self.connectionType == kYGNetworkConnectionTypeViaWiFi) ? self.initialLimitViaWiFi : self.initialLimitViaWWAN;
+    return MAX(MIN(initialLimit, self.maxLimit), MAX(self.minLimit, 1));
+}
+
+- (NSUInteger)yg_integerLimit:(double)limit {
+    return MAX((NSUInteger)limit, MAX(self.minLimit, 1));
+}
+
+- (void)yg_postLimitChange:(NSUInteger)limit
+             previousLimit:(NSUInteger)previousLimit
+                  decision:(YGConcurrencyLimitDecision)decision
+                   latency:(NSTimeInterval)latency
+                   forHost:(NSString *)host {
+    [[NSNotificationCenter defaultCenter] postNotificationName:YGConcurrencyLimitDidChangeNotification
+                                                        object:self
+                                                      userInfo:@{YGConcurrencyLimiterHostKey: host.lowercaseString,
+                                                                 YGConcurrencyLimiterLimitKey: @(limit),
+                                                                 YGConcurrencyLimiterPreviousLimitKey: @(previousLimit),
+                                                                 YGConcurrencyLimiterDecisionKey: @(decision),
+                                                                 YGConcurrencyLimiterLatencyKey: @(latency)}];
+}
+
+@end
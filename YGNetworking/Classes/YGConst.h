@@ -9,13 +9,17 @@
 #ifndef YGConst_h
 #define YGConst_h
 
+#import "YGLock.h"
+
 #define YG_NETWORKING_SAFE_BLOCK(BlockName, ...) ({ !BlockName ? nil : BlockName(__VA_ARGS__); })
-#define YG_NETWORKING_LOCK() dispatch_semaphore_wait(self->_lock, DISPATCH_TIME_FOREVER)
-#define YG_NETWORKING_UNLOCK() dispatch_semaphore_signal(self->_lock)
+#define YG_NETWORKING_LOCK_INIT() YGNetworkingLockInit(&self->_lock)
+#define YG_NETWORKING_LOCK_DESTROY() pthread_mutex_destroy(&self->_lock)
+#define YG_NETWORKING_LOCK() YGNetworkingLock(&self->_lock)
+#define YG_NETWORKING_UNLOCK() pthread_mutex_unlock(&self->_lock)
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class YGRequest, YGBatchRequest, YGChainRequest;
+@class YGRequest, YGBatchRequest, YGChainRequest, YGGraphRequest, YGRequestMetrics;
 
 /**
  YGRequest 请求类型枚举.
@@ -47,6 +51,14 @@ typedef NS_ENUM(NSInteger, YGRequestSerializerType) {
     kYGRequestSerializerPlist   = 2,    //!< 将参数通过 `NSPropertyListSerialization` 编码为 plist 形式，将编码后的请求 `Content-Type` 设置为 `application/x-plist`.
 };
 
+/**
+ YGRequest 请求体压缩类型枚举, 压缩后会设置对应的 `Content-Encoding` 请求头.
+ */
+typedef NS_ENUM(NSInteger, YGRequestCompressionType) {
+    kYGRequestCompressionNone   = 0,    //!< 不压缩.
+    kYGRequestCompressionGzip   = 1,    //!< 通过 zlib 压缩为 gzip 格式, `Content-Encoding: gzip`.
+};
+
 /**
  YGRequest 响应体序列化类型枚举, 具体查看 `AFURLResponseSerialization.h`.
  */
@@ -67,6 +79,83 @@ typedef NS_ENUM(NSInteger, YGNetworkConnectionType) {
     kYGNetworkConnectionTypeViaWiFi          = 2,  // Wi-Fi
 };
 
+/**
+ YGRequest 优先级枚举, 决定请求在 YGEngine 调度器中的排队顺序、`NSURLSessionTask.priority` 和回调队列的 QoS.
+ */
+typedef NS_ENUM(NSInteger, YGRequestPriority) {
+    kYGRequestPriorityCritical      = 0,    //!< 关键请求，如当前页面渲染依赖的数据，不受并发数限制. QoS: USER_INTERACTIVE
+    kYGRequestPriorityHigh          = 1,    //!< 高优先级. QoS: USER_INITIATED
+    kYGRequestPriorityNormal        = 2,    //!< 默认优先级. QoS: DEFAULT
+    kYGRequestPriorityLow           = 3,    //!< 低优先级，如预加载. QoS: UTILITY
+    kYGRequestPriorityBackground    = 4,    //!< 后台请求，如统计数据上报. QoS: BACKGROUND
+};
+
+/**
+ YGRequest 缓存策略枚举, 只对 `kYGRequestNormal` 类型的请求有效.
+ */
+typedef NS_ENUM(NSInteger, YGRequestCachePolicy) {
+    kYGRequestCachePolicyNetworkOnly        = 0,    //!< 只从网络获取数据，不读写缓存.
+    kYGRequestCachePolicyCacheOnly          = 1,    //!< 只从缓存读取数据，没有有效缓存时以 `kYGErrorCacheMiss` 错误结束.
+    kYGRequestCachePolicyCacheThenNetwork   = 2,    //!< 先回调缓存数据(如果有)，再从网络获取数据并更新缓存，成功回调可能被执行两次，结束回调只在网络请求结束时执行.
+    kYGRequestCachePolicyCacheElseNetwork   = 3,    //!< 有有效缓存时只回调缓存数据，否则从网络获取数据并写入缓存.
+};
+
+/**
+ 按主机统计的熔断器状态.
+ */
+typedef NS_ENUM(NSInteger, YGCircuitBreakerState) {
+    kYGCircuitBreakerStateClosed    = 0,    //!< 正常状态，请求正常发送并统计结果.
+    kYGCircuitBreakerStateOpen      = 1,    //!< 熔断状态，请求直接以 `kYGErrorCircuitOpen` 错误结束.
+    kYGCircuitBreakerStateHalfOpen  = 2,    //!< 冷却结束后的半开状态，只放行探测请求，探测成功后恢复正常，失败后重新熔断.
+};
+
+/**
+ YGGraphRequest 中节点请求失败时的处理策略.
+ */
+typedef NS_ENUM(NSInteger, YGGraphNodeFailurePolicy) {
+    kYGGraphNodeFailureFailFast     = 0,    //!< 取消整个图中正在运行和还未运行的节点，图请求以失败结束.
+    kYGGraphNodeFailureContinue     = 1,    //!< 记录错误，依赖它的节点以 `kYGErrorGraphDependencyFailed` 错误跳过，其它节点继续运行.
+    kYGGraphNodeFailureFallback     = 2,    //!< 使用节点的 `fallbackResponseObject` 作为结果，依赖它的节点正常运行.
+};
+
+/**
+ YGConcurrencyLimiter 调整主机并发上限的原因.
+ */
+typedef NS_ENUM(NSInteger, YGConcurrencyLimitDecision) {
+    kYGConcurrencyLimitDecisionIncrease         = 0,    //!< 延迟接近最小延迟并且并发名额被充分使用，加性增加.
+    kYGConcurrencyLimitDecisionLatencyDecrease  = 1,    //!< 延迟明显高于最小延迟，请求开始在网络或服务端排队，减少 `1`.
+    kYGConcurrencyLimitDecisionDropDecrease     = 2,    //!< 超时、连接失败或过载响应 (429/503/504)，乘性减少.
+    kYGConcurrencyLimitDecisionReset            = 3,    //!< 网络连接类型变化，按新的连接类型恢复初始值.
+};
+
+/**
+ YGRecordReplayTransport 的模式.
+ */
+typedef NS_ENUM(NSInteger, YGRecordReplayMode) {
+    kYGRecordReplayModeRecord   = 0,    //!< 请求照常发往服务端，记录请求和响应.
+    kYGRecordReplayModeReplay   = 1,    //!< 请求不发出，由存档中匹配的响应返回，没有匹配的响应时以 `kYGErrorReplayMissing` 错误结束.
+};
+
+///------------------------------
+/// @name 错误
+///------------------------------
+
+/**
+ YGNetworking 自身产生的错误的错误域.
+ */
+FOUNDATION_EXPORT NSString * const YGErrorDomain;
+
+/**
+ `YGErrorDomain` 下的错误码.
+ */
+typedef NS_ENUM(NSInteger, YGErrorCode) {
+    kYGErrorCacheMiss   = 1001,     //!< 缓存策略为 `kYGRequestCachePolicyCacheOnly` 时没有有效的缓存数据.
+    kYGErrorCircuitOpen = 1002,     //!< 请求的主机处于熔断状态，请求没有被发送.
+    kYGErrorModelMapping = 1003,    //!< 响应对象无法映射为 `responseModelClass` 的实例.
+    kYGErrorGraphDependencyFailed = 1004,   //!< YGGraphRequest 中节点依赖的节点失败或被跳过，节点没有被发送.
+    kYGErrorReplayMissing = 1005,   //!< YGRecordReplayTransport 回放时存档中没有匹配的响应.
+};
+
 ///------------------------------
 /// @name YGRequest 配置 Blocks
 ///------------------------------
@@ -74,6 +163,7 @@ typedef NS_ENUM(NSInteger, YGNetworkConnectionType) {
 typedef void (^YGRequestConfigBlock)(YGRequest *request);
 typedef void (^YGBatchRequestConfigBlock)(YGBatchRequest *batchRequest);
 typedef void (^YGChainRequestConfigBlock)(YGChainRequest *chainRequest);
+typedef void (^YGGraphRequestConfigBlock)(YGGraphRequest *graphRequest);
 
 ///--------------------------------
 /// @name YGRequest 回调 Blocks
@@ -83,7 +173,7 @@ typedef void (^YGProgressBlock)(NSProgress *progress);
 typedef void (^YGSuccessBlock)(id _Nullable responseObject);
 typedef void (^YGFailureBlock)(NSError * _Nullable error);
 typedef void (^YGFinishedBlock)(id _Nullable responseObject, NSError * _Nullable error);
-typedef void (^YGCancelBlock)(id _Nullable request); // `request` 可能是一个 YGRequest/YGBatchRequest/YGChainRequest 对象.
+typedef void (^YGCancelBlock)(id _Nullable request); // `request` 可能是一个 YGRequest/YGBatchRequest/YGChainRequest/YGGraphRequest 对象.
 
 ///-------------------------------------------------
 /// @name Batch 和 Chain 请求的回调 Blocks
@@ -94,6 +184,22 @@ typedef void (^YGBCFailureBlock)(NSArray *errors);
 typedef void (^YGBCFinishedBlock)(NSArray * _Nullable responseObjects, NSArray * _Nullable errors);
 typedef void (^YGBCNextBlock)(YGRequest *request, id _Nullable responseObject, BOOL *isSent);
 
+///-------------------------------------------------
+/// @name Graph 请求的回调 Blocks
+///-------------------------------------------------
+
+/**
+ 配置图中节点的请求，节点依赖的节点都结束后调用，`dependencyResponses` 的 key 为依赖节点的名字，value 为它们的响应对象.
+ */
+typedef void (^YGGraphNodeConfigBlock)(YGRequest *request, NSDictionary<NSString *, id> *dependencyResponses);
+
+/**
+ 图请求的回调，key 为节点的名字，value 为节点的响应对象，失败和被跳过的节点为 NSError.
+ */
+typedef void (^YGGraphSuccessBlock)(NSDictionary<NSString *, id> *responseObjects);
+typedef void (^YGGraphFailureBlock)(NSDictionary<NSString *, id> *errors);
+typedef void (^YGGraphFinishedBlock)(NSDictionary<NSString *, id> * _Nullable responseObjects, NSDictionary<NSString *, id> * _Nullable errors);
+
 ///------------------------------
 /// @name YGCenter 处理的 Blocks
 ///------------------------------
@@ -122,6 +228,24 @@ typedef id _Nullable (^YGCenterResponseProcessBlock)(YGRequest *request, id _Nul
  */
 typedef void (^YGCenterErrorProcessBlock)(YGRequest *request, NSError * _Nullable __autoreleasing *error);
 
+/**
+ 针对所有被 YGCenter 调用的 YGRequests 的耗时观察 block，在请求的成功/失败回调之前调用.
+ 
+ @param request 当前 YGRequest 对象.
+ @param metrics 请求各阶段的耗时，与 `request.metrics` 是同一个对象.
+ */
+typedef void (^YGCenterMetricsObserverBlock)(YGRequest *request, YGRequestMetrics *metrics);
+
+/**
+ 针对所有从 YGCenter 的 `offlineQueue` 重放的 YGRequests 的结束 block，在请求的成功/失败回调之前调用.
+ NOTE: 应用重启后恢复的请求没有自己的回调，只能通过这个 block 获取重放的结果.
+ 
+ @param request 当前 YGRequest 对象.
+ @param responseObject 从服务器返回的数据对象，失败时为 `nil`.
+ @param error 重放失败的错误，成功时为 `nil`.
+ */
+typedef void (^YGCenterOfflineReplayBlock)(YGRequest *request, id _Nullable responseObject, NSError * _Nullable error);
+
 NS_ASSUME_NONNULL_END
 
 #endif /* YGConst_h */
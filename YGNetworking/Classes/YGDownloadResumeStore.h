@@ -0,0 +1,116 @@
+//
+//  YGDownloadResumeStore.h
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `YGDownloadResumeStore` 是 YGEngine 持有的下载断点存储，按 `url` + `downloadSavePath` 保存下载任务取消或失败时的断点.
+ 
+ 每个下载保存三个文件: `NSURLSessionDownloadTaskResumeData`、已下载部分的文件 (临时文件的硬链接，系统清理临时目录后依然可用)
+ 和资源的校验值 (ETag 或 Last-Modified). 断点数据可用时通过 `downloadTaskWithResumeData:` 继续下载，
+ 断点数据失效时使用已下载部分和校验值发送 Range/If-Range 请求.
+ NOTE: 断点数据的内部格式没有公开，解析失败时只会退化为重新下载.
+ */
+@interface YGDownloadResumeStore : NSObject
+
+///---------------------
+/// @name 初始化
+///---------------------
+
+/**
+ 创建并返回一个 `YGDownloadResumeStore` 对象，目录位于 `Library/Caches/com.ygnetworking.download.resume`.
+ */
++ (instancetype)store;
+
+/**
+ 创建并返回一个 `YGDownloadResumeStore` 对象.
+
+ @param path 保存断点的目录路径.
+ */
++ (instancetype)storeWithPath:(NSString *)path;
+
+- (instancetype)initWithPath:(NSString *)path NS_DESIGNATED_INITIALIZER;
+
+/**
+ 保存断点的目录路径.
+ */
+@property (nonatomic, copy, readonly) NSString *path;
+
+///---------------------
+/// @name 读写
+///---------------------
+
+/**
+ 获取可以直接继续下载的断点数据.
+
+ @param url 下载地址.
+ @param savePath 下载文件的保存路径.
+ @return 断点数据，不存在或断点引用的临时文件已经被清理时返回 `nil`.
+ */
+- (nullable NSData *)resumeDataForURL:(NSString *)url savePath:(NSString *)savePath;
+
+/**
+ 保存断点数据，同时保留已下载部分的文件和资源的校验值.
+
+ @param resumeData `NSURLSessionDownloadTaskResumeData`.
+ @param validator 资源的校验值，作为 If-Range 的值，为 `nil` 时保留之前的校验值.
+ @param url 下载地址.
+ @param savePath 下载文件的保存路径.
+ */
+- (void)setResumeData:(NSData *)resumeData validator:(nullable NSString *)validator forURL:(NSString *)url savePath:(NSString *)savePath;
+
+/**
+ 将 Range 请求的断点数据合并到已下载部分，合并后删除断点数据，之后只能通过 Range 请求继续下载.
+
+ @param resumeData Range 请求的 `NSURLSessionDownloadTaskResumeData`.
+ @param url 下载地址.
+ @param savePath 下载文件的保存路径.
+ */
+- (void)mergeResumeData:(NSData *)resumeData forURL:(NSString *)url savePath:(NSString *)savePath;
+
+/**
+ 已下载部分的文件路径，不存在或为空时返回 `nil`.
+ */
+- (nullable NSString *)partialFilePathForURL:(NSString *)url savePath:(NSString *)savePath;
+
+/**
+ 资源的校验值 (ETag 或 Last-Modified)，不存在时返回 `nil`.
+ */
+- (nullable NSString *)validatorForURL:(NSString *)url savePath:(NSString *)savePath;
+
+/**
+ 将文件内容追加到已下载部分的末尾.
+
+ @param filePath 需要追加的文件路径.
+ @param url 下载地址.
+ @param savePath 下载文件的保存路径.
+ @param error 读写失败时返回的错误.
+ @return 追加成功时返回 `YES`.
+ */
+- (BOOL)appendFileAtPath:(NSString *)filePath toPartialFileForURL:(NSString *)url savePath:(NSString *)savePath error:(NSError * _Nullable __autoreleasing *)error;
+
+/**
+ 删除断点数据，保留已下载部分和校验值.
+ */
+- (void)invalidateResumeDataForURL:(NSString *)url savePath:(NSString *)savePath;
+
+/**
+ 删除下载的所有断点信息，下载完成时调用.
+ */
+- (void)removeResumeDataForURL:(NSString *)url savePath:(NSString *)savePath;
+
+/**
+ 删除所有下载的断点信息.
+ */
+- (void)removeAllResumeData;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,247 @@
+//
+//  YGDownloadResumeStore.m
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import "YGDownloadResumeStore.h"
+#import "YGConst.h"
+#import <CommonCrypto/CommonDigest.h>
+
+static NSString * const YGResumeDataPathExtension = @"resume";
+static NSString * const YGPartialFilePathExtension = @"partial";
+static NSString * const YGValidatorPathExtension = @"validator";
+
+static const NSUInteger YGFileCopyChunkLength = 1024 * 1024;
+
+static NSString * YGDownloadResumeFileNameForKey(NSString *key) {
+    const char *str = key.UTF8String;
+    unsigned char digest[CC_MD5_DIGEST_LENGTH];
+    CC_MD5(str, (CC_LONG)strlen(str), digest);
+    NSMutableString *fileName = [NSMutableString stringWithCapacity:CC_MD5_DIGEST_LENGTH * 2];
+    for (int i = 0; i < CC_MD5_DIGEST_LENGTH; i++) {
+        [fileName appendFormat:@"%02x", digest[i]];
+    }
+    return fileName;
+}
+
+@interface YGDownloadResumeStore () {
+    pthread_mutex_t _lock;
+}
+
+@end
+
+@implementation YGDownloadResumeStore
+
++ (instancetype)store {
+    return [[[self class] alloc] init];
+}
+
++ (instancetype)storeWithPath:(NSString *)path {
+    return [[[self class] alloc] initWithPath:path];
+}
+
+- (instancetype)init {
+    NSString *cachesPath = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES).firstObject;
+    return [self initWithPath:[cachesPath stringByAppendingPathComponent:@"com.ygnetworking.download.resume"]];
+}
+
+- (instancetype)initWithPath:(NSString *)path {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _path = [path copy];
+    YG_NETWORKING_LOCK_INIT();
+    
+    [[NSFileManager defaultManager] createDirectoryAtPath:_path withIntermediateDirectories:YES attributes:nil error:nil];
+    
+    return self;
+}
+
+- (void)dealloc {
+    YG_NETWORKING_LOCK_DESTROY();
+}
+
+#pragma mark - Public Methods
+
+- (NSData *)resumeDataForURL:(NSString *)url savePath:(NSString *)savePath {
+    NSString *basePath = [self yg_basePathForURL:url savePath:savePath];
+    if (!basePath) return nil;
+    
+    YG_NETWORKING_LOCK();
+    NSData *resumeData = [NSData dataWithContentsOfFile:[basePath stringByAppendingPathExtension:YGResumeDataPathExtension]];
+    YG_NETWORKING_UNLOCK();
+    
+    // the resume data is useless once the system purged the temporary file it refers to.
+    NSString *tempFilePath = [self yg_tempFilePathInResumeData:resumeData];
+    if (!tempFilePath || ![[NSFileManager defaultManager] fileExistsAtPath:tempFilePath]) {
+        return nil;
+    }
+    return resumeData;
+}
+
+- (void)setResumeData:(NSData *)resumeData validator:(NSString *)validator forURL:(NSString *)url savePath:(NSString *)savePath {
+    NSString *basePath = [self yg_basePathForURL:url savePath:savePath];
+    if (!basePath || resumeData.length == 0) return;
+    
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSString *partialFilePath = [basePath stringByAppendingPathExtension:YGPartialFilePathExtension];
+    NSString *tempFilePath = [self yg_tempFilePathInResumeData:resumeData];
+    
+    YG_NETWORKING_LOCK();
+    [resumeData writeToFile:[basePath stringByAppendingPathExtension:YGResumeDataPathExtension] atomically:YES];
+    if (validator.length > 0) {
+        [validator writeToFile:[basePath stringByAppendingPathExtension:YGValidatorPathExtension] atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    }
+    if (tempFilePath && [fileManager fileExistsAtPath:tempFilePath]) {
+        // a hard link keeps the downloaded bytes alive without copying them.
+        [fileManager removeItemAtPath:partialFilePath error:nil];
+        [fileManager linkItemAtPath:tempFilePath toPath:partialFilePath error:nil];
+    }
+    YG_NETWORKING_UNLOCK();
+}
+
+- (void)mergeResumeData:(NSData *)resumeData forURL:(NSString *)url savePath:(NSString *)savePath {
+    NSString *basePath = [self yg_basePathForURL:url savePath:savePath];
+    NSString *tempFilePath = [self yg_tempFilePathInResumeData:resumeData];
+    if (!basePath || !tempFilePath) return;
+    
+    if ([self appendFileAtPath:tempFilePath toPartialFileForURL:url savePath:savePath error:NULL]) {
+        [self invalidateResumeDataForURL:url savePath:savePath];
+    } else {
+        [self removeResumeDataForURL:url savePath:savePath];
+    }
+}
+
+- (NSString *)partialFilePathForURL:(NSString *)url savePath:(NSString *)savePath {
+    NSString *basePath = [self yg_basePathForURL:url savePath:savePath];
+    if (!basePath) return nil;
+    
+    NSString *partialFilePath = [basePath stringByAppendingPathExtension:YGPartialFilePathExtension];
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:partialFilePath error:nil];
+    return attributes.fileSize > 0 ? partialFilePath : nil;
+}
+
+- (NSString *)validatorForURL:(NSString *)url savePath:(NSString *)savePath {
+    NSString *basePath = [self yg_basePathForURL:url savePath:savePath];
+    if (!basePath) return nil;
+    
+    NSString *validator = [NSString stringWithContentsOfFile:[basePath stringByAppendingPathExtension:YGValidatorPathExtension]
+                                                    encoding:NSUTF8StringEncoding
+                                                       error:nil];
+    return validator.length > 0 ? validator : nil;
+}
+
+- (BOOL)appendFileAtPath:(NSString *)filePath toPartialFileForURL:(NSString *)url savePath:(NSString *)savePath error:(NSError *__autoreleasing *)error {
+    NSString *basePath = [self yg_basePathForURL:url savePath:savePath];
+    if (!basePath) return NO;
+    
+    NSString *partialFilePath = [basePath stringByAppendingPathExtension:YGPartialFilePathExtension];
+    
+    YG_NETWORKING_LOCK();
+    NSFileHandle *readingHandle = [NSFileHandle fileHandleForReadingFromURL:[NSURL fileURLWithPath:filePath] error:error];
+    NSFileHandle *writingHandle = readingHandle ? [NSFileHandle fileHandleForWritingToURL:[NSURL fileURLWithPath:partialFilePath] error:error] : nil;
+    BOOL success = (writingHandle != nil);
+    if (success) {
+        // copy in chunks, the partial file of a large download can be hundreds of megabytes.
+        @try {
+            [writingHandle seekToEndOfFile];
+            while (YES) {
+                @autoreleasepool {
+                    NSData *chunk = [readingHandle readDataOfLength:YGFileCopyChunkLength];
+                    if (chunk.length == 0) {
+                        break;
+                    }
+                    [writingHandle writeData:chunk];
+                }
+            }
+        } @catch (NSException *exception) {
+            success = NO;
+            if (error) {
+                *error = [NSError errorWithDomain:NSCocoaErrorDomain
+                                             code:NSFileWriteUnknownError
+                                         userInfo:@{NSLocalizedDescriptionKey: exception.reason ?: @"",
+                                                    NSFilePathErrorKey: partialFilePath}];
+            }
+        }
+    }
+    [readingHandle closeFile];
+    [writingHandle closeFile];
+    YG_NETWORKING_UNLOCK();
+    
+    return success;
+}
+
+- (void)invalidateResumeDataForURL:(NSString *)url savePath:(NSString *)savePath {
+    NSString *basePath = [self yg_basePathForURL:url savePath:savePath];
+    if (!basePath) return;
+    
+    YG_NETWORKING_LOCK();
+    [[NSFileManager defaultManager] removeItemAtPath:[basePath stringByAppendingPathExtension:YGResumeDataPathExtension] error:nil];
+    YG_NETWORKING_UNLOCK();
+}
+
+- (void)removeResumeDataForURL:(NSString *)url savePath:(NSString *)savePath {
+    NSString *basePath = [self yg_basePathForURL:url savePath:savePath];
+    if (!basePath) return;
+    
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    YG_NETWORKING_LOCK();
+    for (NSString *pathExtension in @[YGResumeDataPathExtension, YGPartialFilePathExtension, YGValidatorPathExtension]) {
+        [fileManager removeItemAtPath:[basePath stringByAppendingPathExtension:pathExtension] error:nil];
+    }
+    YG_NETWORKING_UNLOCK();
+}
+
+- (void)removeAllResumeData {
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    YG_NETWORKING_LOCK();
+    [fileManager removeItemAtPath:self.path error:nil];
+    [fileManager createDirectoryAtPath:self.path withIntermediateDirectories:YES attributes:nil error:nil];
+    YG_NETWORKING_UNLOCK();
+}
+
+#pragma mark - Private Methods
+
+- (NSString *)yg_basePathForURL:(NSString *)url savePath:(NSString *)savePath {
+    if (url.length == 0 || savePath.length == 0) return nil;
+    
+    NSString *key = [NSString stringWithFormat:@"%@\n%@", url, savePath];
+    return [self.path stringByAppendingPathComponent:YGDownloadResumeFileNameForKey(key)];
+}
+
+/**
+ 从断点数据中取出已下载部分的临时文件路径.
+ NOTE: 断点数据是一个 plist, iOS 12 之后为 `NSKeyedArchiver` 归档后的字典.
+ */
+- (NSString *)yg_tempFilePathInResumeData:(NSData *)resumeData {
+    if (resumeData.length == 0) return nil;
+    
+    id resumeInfo = [NSPropertyListSerialization propertyListWithData:resumeData options:NSPropertyListImmutable format:NULL error:nil];
+    if ([resumeInfo isKindOfClass:[NSDictionary class]] && resumeInfo[@"$archiver"]) {
+        @try {
+            resumeInfo = [NSKeyedUnarchiver unarchiveObjectWithData:resumeData];
+        } @catch (NSException *exception) {
+            resumeInfo = nil;
+        }
+    }
+    if (![resumeInfo isKindOfClass:[NSDictionary class]]) {
+        return nil;
+    }
+    
+    NSString *tempFileName = resumeInfo[@"NSURLSessionResumeInfoTempFileName"];
+    if ([tempFileName isKindOfClass:[NSString class]] && tempFileName.length > 0) {
+        return [NSTemporaryDirectory() stringByAppendingPathComponent:tempFileName];
+    }
+    NSString *localPath = resumeInfo[@"NSURLSessionResumeInfoLocalPath"];
+    if ([localPath isKindOfClass:[NSString class]] && localPath.length > 0) {
+        return localPath;
+    }
+    return nil;
+}
+
+@end
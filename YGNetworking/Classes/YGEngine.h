@@ -7,10 +7,11 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "YGConst.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class YGRequest;
+@class YGRequest, YGCircuitBreaker, YGConcurrencyLimiter, YGHedgingPolicy, YGDownloadResumeStore, YGUploadResumeStore, YGRecordReplayTransport;
 
 /**
  网络请求的完成回调.
@@ -68,12 +69,121 @@ typedef void (^YGCompletionHandler) (id _Nullable responseObject, NSError * _Nul
 - (nullable YGRequest *)getRequestByIdentifier:(NSString *)identifier;
 
 /**
- 设置并发操作个数.
+ 设置并发操作个数，等同于设置 `maxConcurrentRequestCount`.
  
  @param count 最大并发个数.
  */
 - (void)setConcurrentOperationCount:(NSInteger)count;
 
+///------------------------
+/// @name 请求调度
+///------------------------
+
+/**
+ 同时运行的最大请求数，超出的请求按 `YGRequest.priority` 分别排队，高优先级先启动，默认为 `6`.
+ NOTE: `kYGRequestPriorityCritical` 的请求不受此限制，总是立即启动.
+ */
+@property (nonatomic, assign) NSInteger maxConcurrentRequestCount;
+
+/**
+ 按主机自适应调整并发上限的限流器，默认为 `nil` (只使用 `maxConcurrentRequestCount`).
+ 设置后，请求除了受 `maxConcurrentRequestCount` 限制外，发往同一主机的并发数还受限流器按延迟和错误调整的上限限制，
+ 排队的请求按优先级启动，跳过已经达到上限的主机. 限流器的初始上限由当前网络连接类型决定，网络连接类型变化时重新开始估计.
+ NOTE: `kYGRequestPriorityCritical` 的请求不受限流器限制，也不计入主机的并发数. 上限的变化通过 `YGConcurrencyLimitDidChangeNotification` 通知.
+ */
+@property (nonatomic, strong, nullable) YGConcurrencyLimiter *concurrencyLimiter;
+
+/**
+ 获取指定优先级正在排队等待的请求个数.
+ 
+ @param priority 请求优先级.
+ @return 排队中的请求个数.
+ */
+- (NSUInteger)pendingRequestCountForPriority:(YGRequestPriority)priority;
+
+/**
+ 获取已经启动且还未结束的请求个数.
+ */
+- (NSUInteger)runningRequestCount;
+
+///------------------------
+/// @name 响应解码
+///------------------------
+
+/**
+ 同时解码响应数据的最大个数，默认为 `2`.
+ NOTE: 响应解码在独立的有界队列中执行，与网络回调和 YGCenter 的响应处理分开，突发的大响应不会占用过多线程.
+ */
+@property (nonatomic, assign) NSInteger maxConcurrentDecodeCount;
+
+/**
+ 响应解码队列的 QoS，默认为 `NSQualityOfServiceUtility`. 队列中的解码任务按 `YGRequest.priority` 排序.
+ */
+@property (nonatomic, assign) NSQualityOfService decodeQualityOfService;
+
+/**
+ 在响应解码队列中执行 block，按 `request.priority` 排序，用于解码之后的响应转换 (eg. 模型映射).
+ 
+ @param request block 所属的 YGRequest 对象.
+ @param block 需要执行的 block.
+ */
+- (void)performDecodeForRequest:(YGRequest *)request block:(dispatch_block_t)block;
+
+/**
+ 在请求优先级对应 QoS 的回调队列中异步执行 block，与请求的响应回调使用同一个队列，用于离开解码队列之后的回调.
+ 
+ @param request block 所属的 YGRequest 对象.
+ @param block 需要执行的 block.
+ */
+- (void)performCallbackForRequest:(YGRequest *)request block:(dispatch_block_t)block;
+
+///------------------------
+/// @name 熔断
+///------------------------
+
+/**
+ 按主机统计请求结果的熔断器，主机熔断时请求直接以 `kYGErrorCircuitOpen` 错误结束而不再等待超时，默认为 `[YGCircuitBreaker breaker]`.
+ 设置为 `nil` 时关闭熔断.
+ NOTE: 只有 5xx 响应和服务端故障 (超时、连接被拒绝或中断) 记为失败，设备离线导致的错误不统计，网络状态变化时熔断器被重置.
+ */
+@property (nonatomic, strong, nullable) YGCircuitBreaker *circuitBreaker;
+
+///------------------------
+/// @name 对冲请求
+///------------------------
+
+/**
+ 开启 `YGRequest.hedgingEnabled` 的请求使用的对冲策略，决定对冲延迟并用预算限制对冲请求的数量，默认为 `[YGHedgingPolicy policy]`.
+ 设置为 `nil` 时关闭对冲.
+ */
+@property (nonatomic, strong, nullable) YGHedgingPolicy *hedgingPolicy;
+
+///------------------------
+/// @name 断点续传
+///------------------------
+
+/**
+ 下载请求的断点存储，默认为 `[YGDownloadResumeStore store]`. 设置为 `nil` 时关闭断点续传.
+ NOTE: 下载任务取消或失败时按 `url` 和 `downloadSavePath` 保存断点，之后发送相同的下载请求时自动继续下载.
+ */
+@property (nonatomic, strong, nullable) YGDownloadResumeStore *downloadResumeStore;
+
+/**
+ 可续传上传的上传地址存储，默认为 `[YGUploadResumeStore store]`. 设置为 `nil` 时可续传上传每次都会重新创建上传.
+ */
+@property (nonatomic, strong, nullable) YGUploadResumeStore *uploadResumeStore;
+
+///--------------------------
+/// @name 录制和回放
+///--------------------------
+
+/**
+ 录制或回放请求的传输，默认为 `nil` (请求正常发送). 设置后读写的是 `YGRecordReplayTransport.activeTransport`，对所有 YGEngine 生效.
+ 回放模式下请求不会发出，响应来自存档，YGCenter 的全部处理流程可以在没有网络的环境中重复运行，具体查看 `YGRecordReplayTransport`.
+ NOTE: 录制模式下请求由传输自己的 session 转发，不经过 SSL pinning 和 HTTPS 两步验证.
+ */
+@property (nonatomic, strong, nullable) YGRecordReplayTransport *recordReplayTransport;
+
 ///--------------------------
 /// @name 网络质量监测
 ///--------------------------
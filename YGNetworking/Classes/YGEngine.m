@@ -8,7 +8,18 @@
 
 #import "YGEngine.h"
 #import "YGRequest.h"
+#import "YGCircuitBreaker.h"
+#import "YGConcurrencyLimiter.h"
+#import "YGHedgingPolicy.h"
+#import "YGRecordReplayTransport.h"
+#import "YGDownloadResumeStore.h"
+#import "YGUploadResumeStore.h"
+#import "YGJSONStreamParser.h"
+#import "YGRequestMetrics.h"
+#import "YGRetryPolicy.h"
 #import <objc/runtime.h>
+#import <zlib.h>
+#import <stdatomic.h>
 
 #if __has_include(<AFNetworking/AFNetworking.h>)
 #import <AFNetworking/AFNetworking.h>
@@ -18,6 +29,25 @@
 #import "AFNetworkActivityIndicatorManager.h"
 #endif
 
+/// 分段下载中每个分段的最小长度, 文件太小时分段只会增加请求开销.
+static const long long YGDownloadSegmentMinimumLength = 1024 * 1024;
+
+/// 按块读写文件时每次读写的长度.
+static const NSUInteger YGFileCopyChunkLength = 1024 * 1024;
+
+/**
+ 请求体压缩的私有串行队列, 压缩不在调用者线程中执行.
+ */
+static dispatch_queue_t yg_request_compression_queue() {
+    static dispatch_queue_t _YG_request_compression_queue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        dispatch_queue_attr_t attr = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0);
+        _YG_request_compression_queue = dispatch_queue_create("com.ygnetworking.request.compression.queue", attr);
+    });
+    return _YG_request_compression_queue;
+}
+
 static dispatch_queue_t yg_request_completion_callback_queue() {
     static dispatch_queue_t _YG_request_completion_callback_queue;
     static dispatch_once_t onceToken;
@@ -27,6 +57,206 @@ static dispatch_queue_t yg_request_completion_callback_queue() {
     return _YG_request_completion_callback_queue;
 }
 
+/**
+ 按请求优先级返回回调队列, `kYGRequestPriorityNormal` 直接使用 session 的 completion 队列, 其它优先级使用对应 QoS 的并发队列.
+ */
+static dispatch_queue_t yg_request_callback_queue_for_priority(YGRequestPriority priority) {
+    static dispatch_queue_t _YG_request_callback_queues[kYGRequestPriorityBackground + 1];
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        const qos_class_t qosClasses[] = {QOS_CLASS_USER_INTERACTIVE, QOS_CLASS_USER_INITIATED, QOS_CLASS_DEFAULT, QOS_CLASS_UTILITY, QOS_CLASS_BACKGROUND};
+        const char *labels[] = {"com.ygnetworking.request.callback.queue.critical",
+                                "com.ygnetworking.request.callback.queue.high",
+                                "com.ygnetworking.request.callback.queue.normal",
+                                "com.ygnetworking.request.callback.queue.low",
+                                "com.ygnetworking.request.callback.queue.background"};
+        for (NSInteger i = kYGRequestPriorityCritical; i <= kYGRequestPriorityBackground; i++) {
+            if (i == kYGRequestPriorityNormal) {
+                _YG_request_callback_queues[i] = yg_request_completion_callback_queue();
+            } else {
+                dispatch_queue_attr_t attr = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_CONCURRENT, qosClasses[i], 0);
+                _YG_request_callback_queues[i] = dispatch_queue_create(labels[i], attr);
+            }
+        }
+    });
+    if (priority < kYGRequestPriorityCritical || priority > kYGRequestPriorityBackground) {
+        priority = kYGRequestPriorityNormal;
+    }
+    return _YG_request_callback_queues[priority];
+}
+
+static float YGTaskPriorityFromRequestPriority(YGRequestPriority priority) {
+    switch (priority) {
+        case kYGRequestPriorityCritical:    return 1.0f;
+        case kYGRequestPriorityHigh:        return NSURLSessionTaskPriorityHigh;
+        case kYGRequestPriorityLow:         return NSURLSessionTaskPriorityLow;
+        case kYGRequestPriorityBackground:  return 0.0f;
+        default:                            return NSURLSessionTaskPriorityDefault;
+    }
+}
+
+static NSOperationQueuePriority YGOperationQueuePriorityFromRequestPriority(YGRequestPriority priority) {
+    switch (priority) {
+        case kYGRequestPriorityCritical:    return NSOperationQueuePriorityVeryHigh;
+        case kYGRequestPriorityHigh:        return NSOperationQueuePriorityHigh;
+        case kYGRequestPriorityLow:         return NSOperationQueuePriorityLow;
+        case kYGRequestPriorityBackground:  return NSOperationQueuePriorityVeryLow;
+        default:                            return NSOperationQueuePriorityNormal;
+    }
+}
+
+static NSString * YGHTTPHeaderValueFromResponse(NSURLResponse *response, NSString *field) {
+    if (![response isKindOfClass:[NSHTTPURLResponse class]]) return nil;
+    
+    __block NSString *value = nil;
+    [((NSHTTPURLResponse *)response).allHeaderFields enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSString *obj, BOOL *stop) {
+        if ([key caseInsensitiveCompare:field] == NSOrderedSame) {
+            value = obj;
+            *stop = YES;
+        }
+    }];
+    return value;
+}
+
+/**
+ 返回可以作为 If-Range 的校验值, 优先使用强 ETag, 其次使用 Last-Modified.
+ */
+static NSString * YGRangeValidatorFromResponse(NSURLResponse *response) {
+    NSString *entityTag = YGHTTPHeaderValueFromResponse(response, @"ETag");
+    if (entityTag.length > 0 && ![entityTag hasPrefix:@"W/"]) {
+        return entityTag;
+    }
+    return YGHTTPHeaderValueFromResponse(response, @"Last-Modified");
+}
+
+/**
+ 解析 206 响应 Content-Range (eg. `bytes 100-199/200`) 的起始和结束位置 (包含), 无法解析时返回 `NO`.
+ */
+static BOOL YGContentRangeFromResponse(NSURLResponse *response, long long *rangeStart, long long *rangeEnd) {
+    NSString *contentRange = YGHTTPHeaderValueFromResponse(response, @"Content-Range");
+    if (contentRange.length == 0) return NO;
+    
+    NSScanner *scanner = [NSScanner scannerWithString:contentRange];
+    long long start = -1;
+    long long end = -1;
+    if (![scanner scanString:@"bytes" intoString:NULL] || ![scanner scanLongLong:&start] ||
+        ![scanner scanString:@"-" intoString:NULL] || ![scanner scanLongLong:&end] || end < start) {
+        return NO;
+    }
+    if (rangeStart) *rangeStart = start;
+    if (rangeEnd) *rangeEnd = end;
+    return YES;
+}
+
+/**
+ 返回 206 响应 Content-Range 的起始位置, 无法解析时返回 `-1`.
+ */
+static long long YGRangeStartFromResponse(NSURLResponse *response) {
+    long long rangeStart = -1;
+    return YGContentRangeFromResponse(response, &rangeStart, NULL) ? rangeStart : -1;
+}
+
+/**
+ 文件的长度, 文件不存在时返回 `-1`.
+ */
+static long long YGFileLengthAtURL(NSURL *fileURL) {
+    NSDictionary<NSFileAttributeKey, id> *attributes = fileURL.path ? [[NSFileManager defaultManager] attributesOfItemAtPath:fileURL.path error:nil] : nil;
+    return attributes ? (long long)attributes.fileSize : -1;
+}
+
+/**
+ 通过 zlib 将数据压缩为 gzip 格式, 压缩失败时返回 `nil`.
+ */
+static NSData * YGGzipCompressData(NSData *data) {
+    if (data.length == 0 || data.length > UINT_MAX) return nil;
+    
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // windowBits 15 + 16 writes a gzip header and trailer instead of a zlib wrapper.
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return nil;
+    }
+    
+    NSMutableData *compressedData = [NSMutableData dataWithLength:deflateBound(&stream, (uLong)data.length)];
+    stream.next_in = (Bytef *)data.bytes;
+    stream.avail_in = (uInt)data.length;
+    stream.next_out = (Bytef *)compressedData.mutableBytes;
+    stream.avail_out = (uInt)compressedData.length;
+    int status = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if (status != Z_STREAM_END) {
+        return nil;
+    }
+    compressedData.length = stream.total_out;
+    return compressedData;
+}
+
+/**
+ 分段的响应体长度和请求的字节范围不一致 (连接中途断开或者服务器多发了数据), 按连接中断处理, 分段可以重试.
+ */
+static NSError * YGIncompleteSegmentError(NSString *url) {
+    return [NSError errorWithDomain:NSURLErrorDomain
+                               code:NSURLErrorNetworkConnectionLost
+                           userInfo:@{NSLocalizedDescriptionKey: @"The length of the segment does not match the requested range.",
+                                      NSURLErrorFailingURLStringErrorKey: url ?: @""}];
+}
+
+static NSError * YGBadServerResponseError(NSString *url) {
+    return [NSError errorWithDomain:NSURLErrorDomain
+                               code:NSURLErrorBadServerResponse
+                           userInfo:@{NSURLErrorFailingURLStringErrorKey: url ?: @""}];
+}
+
+/**
+ 下载任务不经过响应序列化, 错误的状态码由这里转为错误, 错误中带有响应, 重试策略可以按状态码 (例如 503) 判断是否重试.
+ */
+static NSError * YGUnacceptableResponseError(NSString *url, NSURLResponse *response) {
+    if (!response) {
+        return YGBadServerResponseError(url);
+    }
+    return [NSError errorWithDomain:NSURLErrorDomain
+                               code:NSURLErrorBadServerResponse
+                           userInfo:@{NSURLErrorFailingURLStringErrorKey: url ?: @"",
+                                      AFNetworkingOperationFailingURLResponseErrorKey: response}];
+}
+
+/**
+ 是否是设备离线 (没有网络、蜂窝数据被禁用、DNS 不可用等) 导致的错误, 这些错误和服务端的状态无关, 不计入熔断器.
+ */
+static BOOL YGIsOfflineError(NSError *error) {
+    if (![error.domain isEqualToString:NSURLErrorDomain]) return NO;
+    
+    switch (error.code) {
+        case NSURLErrorNotConnectedToInternet:
+        case NSURLErrorDataNotAllowed:
+        case NSURLErrorInternationalRoamingOff:
+        case NSURLErrorCallIsActive:
+        case NSURLErrorCannotFindHost:
+        case NSURLErrorDNSLookupFailed:
+            return YES;
+        default:
+            return NO;
+    }
+}
+
+/**
+ 是否是服务端故障导致的传输错误 (超时、连接被拒绝或者中断), 这些错误计入熔断器的失败.
+ */
+static BOOL YGIsServerFailureError(NSError *error) {
+    if (![error.domain isEqualToString:NSURLErrorDomain]) return NO;
+    
+    switch (error.code) {
+        case NSURLErrorTimedOut:
+        case NSURLErrorCannotConnectToHost:
+        case NSURLErrorNetworkConnectionLost:
+        case NSURLErrorBadServerResponse:
+        case NSURLErrorZeroByteResource:
+            return YES;
+        default:
+            return NO;
+    }
+}
+
 static OSStatus YGExtractIdentityAndTrustFromPKCS12(CFDataRef inPKCS12Data, CFStringRef keyPassword, SecIdentityRef *outIdentity, SecTrustRef *outTrust) {
     OSStatus securityError = errSecSuccess;
     
@@ -64,11 +294,191 @@ static OSStatus YGExtractIdentityAndTrustFromPKCS12(CFDataRef inPKCS12Data, CFSt
     return securityError;
 }
 
+#pragma mark - YGRequestFlight
+
+/**
+ 合并后正在运行的同一个请求, 所有相同的请求 (waiter) 共享一个 `NSURLSessionTask` 和同一个解析后的响应对象.
+ NOTE: 除 `key` 和 `task` 外, 其它属性都需要在持有 YGEngine `_lock` 的情况下访问.
+ */
+@interface YGRequestFlight : NSObject
+
+@property (nonatomic, copy) NSString *key;
+@property (nonatomic, strong) NSURLSessionTask *task;
+@property (nonatomic, assign) NSUInteger waiterCount;
+/// waiter 中最高的优先级, 任务在调度器中排队的优先级.
+@property (nonatomic, assign) YGRequestPriority priority;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, YGRequest *> *requests;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, YGCompletionHandler> *completionHandlers;
+
+@end
+
+@implementation YGRequestFlight
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    _requests = [NSMutableDictionary dictionary];
+    _completionHandlers = [NSMutableDictionary dictionary];
+    return self;
+}
+
+@end
+
+#pragma mark - YGRequestHedge
+
+/**
+ 开启对冲的请求, 原始任务启动后经过对冲延迟还没有完成时发送相同的对冲任务, 使用先成功完成的任务的响应.
+ NOTE: 创建任务前设置的属性 (`policy` 至 `primaryTask`) 之后不再修改, 其它属性都需要在持有 YGEngine `_lock` 的情况下访问.
+ */
+@interface YGRequestHedge : NSObject
+
+@property (nonatomic, strong) YGHedgingPolicy *policy;
+@property (nonatomic, strong) YGRequest *request;
+@property (nonatomic, copy) NSURLRequest *urlRequest;
+@property (nonatomic, strong) AFURLSessionManager *sessionManager;
+@property (nonatomic, copy) YGCompletionHandler completionHandler;
+@property (nonatomic, weak) NSURLSessionTask *primaryTask;
+@property (nonatomic, weak) NSURLSessionTask *hedgeTask;
+/// 原始任务启动的时间, 用于统计主机的请求耗时.
+@property (nonatomic, assign) NSTimeInterval primaryResumeTimestamp;
+/// 已经创建 (或者正在创建) 且还没有完成的任务个数.
+@property (nonatomic, assign) NSUInteger runningCount;
+/// 请求已经被取消, 不再发送对冲任务.
+@property (nonatomic, assign) BOOL cancelled;
+/// 已经选出使用响应的任务, 另一个任务的结果被丢弃.
+@property (nonatomic, assign) BOOL finished;
+@property (nonatomic, weak) NSURLSessionTask *winnerTask;
+
+@end
+
+@implementation YGRequestHedge
+@end
+
+#pragma mark - YGResponseStream
+
+/**
+ 流式解析中的响应, 数据块在私有串行队列中按到达顺序追加到解析器, 解析与下载并行进行.
+ */
+@interface YGResponseStream : NSObject
+
+@property (nonatomic, strong, readonly) YGJSONStreamParser *parser;
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+
+- (instancetype)initWithReadingOptions:(NSJSONReadingOptions)readingOptions
+                      streamingKeyPath:(nullable NSString *)streamingKeyPath
+                           targetQueue:(dispatch_queue_t)targetQueue;
+
+@end
+
+@implementation YGResponseStream
+
+- (instancetype)initWithReadingOptions:(NSJSONReadingOptions)readingOptions
+                      streamingKeyPath:(NSString *)streamingKeyPath
+                           targetQueue:(dispatch_queue_t)targetQueue {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    _parser = [YGJSONStreamParser parserWithReadingOptions:readingOptions streamingKeyPath:streamingKeyPath];
+    _queue = dispatch_queue_create("com.ygnetworking.response.stream.queue", DISPATCH_QUEUE_SERIAL);
+    dispatch_set_target_queue(_queue, targetQueue);
+    return self;
+}
+
+@end
+
+#pragma mark - YGSegmentedDownload
+
+/**
+ 分段下载中的一个字节范围, `length` 小于等于 `0` 时表示不带 Range 下载整个文件.
+ */
+@interface YGDownloadSegment : NSObject
+
+@property (nonatomic, assign) long long offset;
+@property (nonatomic, assign) long long length;
+@property (nonatomic, assign) int64_t receivedLength;
+@property (nonatomic, assign) NSUInteger retriedCount;
+@property (nonatomic, strong, nullable) NSURLSessionDownloadTask *task;
+
+@end
+
+@implementation YGDownloadSegment
+@end
+
+/**
+ 正在运行的分段下载, 由一个 HEAD 探测任务和多个 Range 下载任务组成, 所有分段写入预分配文件的对应位置.
+ NOTE: 除 `identifier`、`request` 和 `urlRequest` 外, 其它属性都需要在持有 YGEngine `_lock` 的情况下访问.
+ */
+@interface YGSegmentedDownload : NSObject
+
+@property (nonatomic, copy) NSString *identifier;
+@property (nonatomic, strong) YGRequest *request;
+@property (nonatomic, strong) NSURLRequest *urlRequest;
+@property (nonatomic, strong) NSURL *destination;
+@property (nonatomic, copy, nullable) NSString *validator;
+@property (nonatomic, assign) long long contentLength;
+@property (nonatomic, copy, nullable) YGCompletionHandler completionHandler;
+@property (nonatomic, strong, nullable) NSURLSessionTask *probeTask;
+@property (nonatomic, strong) NSArray<YGDownloadSegment *> *segments;
+@property (nonatomic, assign) NSUInteger finishedSegmentCount;
+@property (nonatomic, strong) NSProgress *progress;
+@property (nonatomic, assign, getter=isFinished) BOOL finished;
+
+/// 分段写入的预分配文件, 所有分段完成后移动到 `destination`.
+@property (nonatomic, readonly) NSURL *partialFileURL;
+
+@end
+
+@implementation YGSegmentedDownload
+
+- (NSURL *)partialFileURL {
+    return [self.destination URLByAppendingPathExtension:@"ygdownload"];
+}
+
+@end
+
+#pragma mark - YGResumableUpload
+
+/**
+ 正在运行的可续传上传, 按 tus 协议创建上传地址、协商偏移量并分块 PATCH 上传文件.
+ NOTE: 除 `identifier`、`request`、`fileURL` 和 `fileLength` 外, 其它属性都需要在持有 YGEngine `_lock` 的情况下访问.
+ */
+@interface YGResumableUpload : NSObject
+
+@property (nonatomic, copy) NSString *identifier;
+@property (nonatomic, strong) YGRequest *request;
+@property (nonatomic, strong) NSURL *fileURL;
+@property (nonatomic, assign) long long fileLength;
+@property (nonatomic, strong, nullable) NSURL *uploadURL;
+@property (nonatomic, assign) long long offset;
+@property (nonatomic, copy, nullable) YGCompletionHandler completionHandler;
+@property (nonatomic, strong, nullable) NSURLSessionTask *task;
+@property (nonatomic, strong) NSProgress *progress;
+@property (nonatomic, assign, getter=isFinished) BOOL finished;
+
+@end
+
+@implementation YGResumableUpload
+@end
+
 #pragma mark - YGRequest Binding
 
 @interface NSURLSessionTask (YGRequest)
 
 @property (nonatomic, strong) YGRequest *bindedRequest;
+@property (nonatomic, strong, nullable) YGRequestFlight *bindedFlight;
+@property (nonatomic, strong, nullable) YGRequestHedge *bindedHedge;
+@property (nonatomic, strong, nullable) YGResponseStream *bindedStream;
+@property (nonatomic, assign) NSTimeInterval scheduleTimestamp;
+@property (nonatomic, assign) NSTimeInterval resumeTimestamp;
+@property (nonatomic, assign) long long rangeOffset;
+@property (nonatomic, assign) BOOL resumeDataPersisted;
+/// 任务从中获取了主机并发名额的限流器, 任务结束时向它释放名额.
+@property (nonatomic, strong, nullable) YGConcurrencyLimiter *bindedLimiter;
+/// 任务作为熔断器半开状态的探测请求时的探测令牌, 任务结束时随结果一起记录.
+@property (nonatomic, assign) NSUInteger circuitProbeToken;
 
 @end
 
@@ -82,12 +492,106 @@ static OSStatus YGExtractIdentityAndTrustFromPKCS12(CFDataRef inPKCS12Data, CFSt
     objc_setAssociatedObject(self, @selector(bindedRequest), bindedRequest, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
 }
 
+- (YGRequestFlight *)bindedFlight {
+    return objc_getAssociatedObject(self, _cmd);
+}
+
+- (void)setBindedFlight:(YGRequestFlight *)bindedFlight {
+    objc_setAssociatedObject(self, @selector(bindedFlight), bindedFlight, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+- (YGRequestHedge *)bindedHedge {
+    return objc_getAssociatedObject(self, _cmd);
+}
+
+- (void)setBindedHedge:(YGRequestHedge *)bindedHedge {
+    objc_setAssociatedObject(self, @selector(bindedHedge), bindedHedge, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+- (YGResponseStream *)bindedStream {
+    return objc_getAssociatedObject(self, _cmd);
+}
+
+- (void)setBindedStream:(YGResponseStream *)bindedStream {
+    objc_setAssociatedObject(self, @selector(bindedStream), bindedStream, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+- (NSTimeInterval)scheduleTimestamp {
+    return [objc_getAssociatedObject(self, _cmd) doubleValue];
+}
+
+- (void)setScheduleTimestamp:(NSTimeInterval)scheduleTimestamp {
+    objc_setAssociatedObject(self, @selector(scheduleTimestamp), @(scheduleTimestamp), OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+- (NSTimeInterval)resumeTimestamp {
+    return [objc_getAssociatedObject(self, _cmd) doubleValue];
+}
+
+- (void)setResumeTimestamp:(NSTimeInterval)resumeTimestamp {
+    objc_setAssociatedObject(self, @selector(resumeTimestamp), @(resumeTimestamp), OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+- (long long)rangeOffset {
+    return [objc_getAssociatedObject(self, _cmd) longLongValue];
+}
+
+- (void)setRangeOffset:(long long)rangeOffset {
+    objc_setAssociatedObject(self, @selector(rangeOffset), @(rangeOffset), OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+- (BOOL)resumeDataPersisted {
+    return [objc_getAssociatedObject(self, _cmd) boolValue];
+}
+
+- (void)setResumeDataPersisted:(BOOL)resumeDataPersisted {
+    objc_setAssociatedObject(self, @selector(resumeDataPersisted), @(resumeDataPersisted), OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+- (YGConcurrencyLimiter *)bindedLimiter {
+    return objc_getAssociatedObject(self, _cmd);
+}
+
+- (void)setBindedLimiter:(YGConcurrencyLimiter *)bindedLimiter {
+    objc_setAssociatedObject(self, @selector(bindedLimiter), bindedLimiter, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+- (NSUInteger)circuitProbeToken {
+    return [objc_getAssociatedObject(self, _cmd) unsignedIntegerValue];
+}
+
+- (void)setCircuitProbeToken:(NSUInteger)circuitProbeToken {
+    objc_setAssociatedObject(self, @selector(circuitProbeToken), @(circuitProbeToken), OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+@end
+
+@interface YGRequest (YGCircuitBreaker)
+
+/// 熔断器放行请求时分配的探测令牌, 在第一个任务进入调度器时转移给该任务.
+@property (nonatomic, assign) NSUInteger circuitProbeToken;
+
+@end
+
+@implementation YGRequest (YGCircuitBreaker)
+
+- (NSUInteger)circuitProbeToken {
+    return [objc_getAssociatedObject(self, _cmd) unsignedIntegerValue];
+}
+
+- (void)setCircuitProbeToken:(NSUInteger)circuitProbeToken {
+    objc_setAssociatedObject(self, @selector(circuitProbeToken), @(circuitProbeToken), OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
 @end
 
 #pragma mark - YGEngine
 
 @interface YGEngine () {
-    dispatch_semaphore_t _lock;
+    pthread_mutex_t _lock;
+    atomic_ulong _segmentedDownloadCount;
+    atomic_ulong _resumableUploadCount;
+    atomic_ulong _compressingRequestCount;
 }
 
 @property (nonatomic, strong) AFURLSessionManager *sessionManager;
@@ -104,10 +608,40 @@ static OSStatus YGExtractIdentityAndTrustFromPKCS12(CFDataRef inPKCS12Data, CFSt
 
 @property (nonatomic, strong) NSMutableArray *sslPinningHosts;
 
+/// 正在运行的任务索引表, key 为 YGRequest 的 `identifier`, 在 `-yg_setIdentifierForReqeust:` 中写入, 任务结束时移除.
+/// NOTE: 按 identifier 分片加锁, 读写不需要持有 `_lock`; 同时持有两者时先获取 `_lock`.
+@property (nonatomic, strong) YGShardedDictionary<NSString *, NSURLSessionTask *> *runningTasks;
+
+/// 调度器中每个优先级等待运行的任务, 下标为 `YGRequestPriority`.
+@property (nonatomic, strong) NSArray<NSMutableOrderedSet<NSURLSessionTask *> *> *pendingLanes;
+
+/// 调度器中已经启动且还未结束的任务个数.
+@property (nonatomic, assign) NSUInteger runningTaskCount;
+
+/// 正在运行的合并请求, key 为 `-yg_flightKeyForURLRequest:request:` 生成的请求特征.
+@property (nonatomic, strong) NSMutableDictionary<NSString *, YGRequestFlight *> *runningFlights;
+
+/// 正在运行的分段下载, key 为分段下载的 identifier.
+@property (nonatomic, strong) NSMutableDictionary<NSString *, YGSegmentedDownload *> *runningDownloads;
+
+/// 正在运行的可续传上传, key 为可续传上传的 identifier.
+@property (nonatomic, strong) NSMutableDictionary<NSString *, YGResumableUpload *> *runningUploads;
+
+/// 正在压缩请求体的请求, key 为压缩前分配的 identifier, 压缩期间被取消的请求会从中移除.
+@property (nonatomic, strong) NSMutableDictionary<NSString *, YGRequest *> *compressingRequests;
+
+/// 分段下载中失败分段的重试策略.
+@property (nonatomic, strong) YGExponentialBackoffRetryPolicy *segmentRetryPolicy;
+
+/// 有界的响应解码队列.
+@property (nonatomic, strong) NSOperationQueue *decodeQueue;
+
 @end
 
 @implementation YGEngine
 
+@synthesize maxConcurrentRequestCount = _maxConcurrentRequestCount;
+
 + (instancetype)engine {
     return [[[self class] alloc] init];
 }
@@ -127,9 +661,34 @@ static OSStatus YGExtractIdentityAndTrustFromPKCS12(CFDataRef inPKCS12Data, CFSt
         return nil;
     }
     
-    _lock = dispatch_semaphore_create(1);
+    YG_NETWORKING_LOCK_INIT();
+    _runningTasks = [[YGShardedDictionary alloc] init];
+    _maxConcurrentRequestCount = 6;
+    
+    NSMutableArray *pendingLanes = [NSMutableArray array];
+    for (NSInteger i = kYGRequestPriorityCritical; i <= kYGRequestPriorityBackground; i++) {
+        [pendingLanes addObject:[NSMutableOrderedSet orderedSet]];
+    }
+    _pendingLanes = [pendingLanes copy];
+    
+    _circuitBreaker = [YGCircuitBreaker breaker];
+    _hedgingPolicy = [YGHedgingPolicy policy];
+    _downloadResumeStore = [YGDownloadResumeStore store];
+    _uploadResumeStore = [YGUploadResumeStore store];
+    _segmentRetryPolicy = [YGExponentialBackoffRetryPolicy policy];
+    
+    _decodeQueue = [[NSOperationQueue alloc] init];
+    _decodeQueue.name = @"com.ygnetworking.response.decode.queue";
+    self.maxConcurrentDecodeCount = 2;
+    self.decodeQualityOfService = NSQualityOfServiceUtility;
+    
     [AFNetworkActivityIndicatorManager sharedManager].enabled = YES;
     
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(yg_reachabilityDidChange:)
+                                                 name:AFNetworkingReachabilityDidChangeNotification
+                                               object:nil];
+    
     return self;
 }
 
@@ -138,6 +697,8 @@ static OSStatus YGExtractIdentityAndTrustFromPKCS12(CFDataRef inPKCS12Data, CFSt
 }
 
 - (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    YG_NETWORKING_LOCK_DESTROY();
     if (_sessionManager) {
         [_sessionManager invalidateSessionCancelingTasks:YES resetSession:YES];
     }
@@ -149,10 +710,44 @@ static OSStatus YGExtractIdentityAndTrustFromPKCS12(CFDataRef inPKCS12Data, CFSt
 #pragma mark - Public Methods
 
 - (void)sendRequest:(YGRequest *)request completionHandler:(YGCompletionHandler)completionHandler {
+    // every attempt gets new metrics, the phases in YGCenter only run once per request.
+    YGRequestMetrics *metrics = [[YGRequestMetrics alloc] init];
+    [metrics setValue:@(request.metrics.configDuration) forKey:@"_configDuration"];
+    [metrics setValue:@(request.metrics.processDuration) forKey:@"_processDuration"];
+    [request setValue:metrics forKey:@"_metrics"];
+    
+    YGCircuitBreaker *circuitBreaker = self.circuitBreaker;
+    request.circuitProbeToken = 0;
+    if (circuitBreaker) {
+        NSString *host = [self yg_URLForRequest:request].host;
+        NSUInteger probeToken = 0;
+        BOOL allowed = [circuitBreaker allowRequestForHost:host probeToken:&probeToken];
+        request.circuitProbeToken = probeToken;
+        if (!allowed) {
+            // fail fast instead of holding a concurrency slot until the timeout.
+            if (completionHandler) {
+                NSError *error = [NSError errorWithDomain:YGErrorDomain
+                                                     code:kYGErrorCircuitOpen
+                                                 userInfo:@{NSLocalizedDescriptionKey: [NSString stringWithFormat:@"The circuit breaker for host %@ is open.", host],
+                                                            NSURLErrorFailingURLStringErrorKey: request.url ?: @""}];
+                dispatch_async(yg_request_completion_callback_queue(), ^{
+                    completionHandler(nil, error);
+                });
+            }
+            return;
+        }
+    }
+    
     if (request.requestType == kYGRequestNormal) {
         [self yg_dataTaskWithRequest:request completionHandler:completionHandler];
+    } else if (request.requestType == kYGRequestUpload && request.uploadFileURL && request.resumableUploadEnabled) {
+        [self yg_resumableUploadTaskWithRequest:request completionHandler:completionHandler];
+    } else if (request.requestType == kYGRequestUpload && request.uploadFileURL) {
+        [self yg_fileUploadTaskWithRequest:request completionHandler:completionHandler];
     } else if (request.requestType == kYGRequestUpload) {
         [self yg_uploadTaskWithRequest:request completionHandler:completionHandler];
+    } else if (request.requestType == kYGRequestDownload && request.downloadSegmentCount > 1) {
+        [self yg_segmentedDownloadTaskWithRequest:request completionHandler:completionHandler];
     } else if (request.requestType == kYGRequestDownload) {
         [self yg_downloadTaskWithRequest:request completionHandler:completionHandler];
     } else {
@@ -164,339 +759,2034 @@ static OSStatus YGExtractIdentityAndTrustFromPKCS12(CFDataRef inPKCS12Data, CFSt
     if (identifier.length == 0) return nil;
     
     YG_NETWORKING_LOCK();
-    NSArray *tasks = nil;
-    if ([identifier hasPrefix:@"+"]) {
-        tasks = self.sessionManager.tasks;
-    } else if ([identifier hasPrefix:@"-"]) {
-        tasks = self.securitySessionManager.tasks;
+    YGSegmentedDownload *download = self.runningDownloads[identifier];
+    YGResumableUpload *upload = self.runningUploads[identifier];
+    YGRequest *compressingRequest = self.compressingRequests[identifier];
+    [self.compressingRequests removeObjectForKey:identifier];
+    YG_NETWORKING_UNLOCK();
+    if (compressingRequest) {
+        // the compression queue finishes the request with a cancellation error.
+        return compressingRequest;
     }
-    __block YGRequest *request = nil;
-    if (tasks.count > 0) {
-        [tasks enumerateObjectsUsingBlock:^(NSURLSessionTask *task, NSUInteger idx, BOOL *stop) {
-            if ([task.bindedRequest.identifier isEqualToString:identifier]) {
-                request = task.bindedRequest;
-                [task cancel];
-                *stop = YES;
-            }
-        }];
+    if (download) {
+        [self yg_finishSegmentedDownload:download filePath:nil error:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]];
+        return download.request;
+    }
+    if (upload) {
+        [self yg_finishResumableUpload:upload responseObject:nil error:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]];
+        return upload.request;
+    }
+    
+    NSURLSessionTask *task = [self.runningTasks removeAndReturnObjectForKey:identifier];
+    YG_NETWORKING_LOCK();
+    YGRequestFlight *flight = task.bindedFlight;
+    YGRequestHedge *hedge = task.bindedHedge;
+    YGRequest *request = nil;
+    YGCompletionHandler detachedHandler = nil;
+    NSURLSessionTask *hedgeTask = nil;
+    BOOL shouldCancelTask = YES;
+    if (flight) {
+        // detach the waiter only, the shared task is cancelled when no waiters remain.
+        request = flight.requests[identifier];
+        detachedHandler = flight.completionHandlers[identifier];
+        [flight.requests removeObjectForKey:identifier];
+        [flight.completionHandlers removeObjectForKey:identifier];
+        shouldCancelTask = (flight.completionHandlers.count == 0);
+        if (shouldCancelTask && self.runningFlights[flight.key] == flight) {
+            [self.runningFlights removeObjectForKey:flight.key];
+        }
+    } else {
+        request = task.bindedRequest;
+    }
+    if (hedge) {
+        // stop a pending hedge and cancel the one already sent.
+        hedge.cancelled = YES;
+        hedgeTask = hedge.hedgeTask;
     }
     YG_NETWORKING_UNLOCK();
+    
+    [hedgeTask cancel];
+    if (shouldCancelTask) {
+        if ([task isKindOfClass:[NSURLSessionDownloadTask class]] && self.downloadResumeStore) {
+            __weak __typeof(self)weakSelf = self;
+            [(NSURLSessionDownloadTask *)task cancelByProducingResumeData:^(NSData *resumeData) {
+                [weakSelf yg_persistResumeData:resumeData forTask:task];
+            }];
+        } else {
+            [task cancel];
+        }
+    }
+    if (detachedHandler) {
+        NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil];
+        dispatch_async(yg_request_completion_callback_queue(), ^{
+            detachedHandler(nil, error);
+        });
+    }
     return request;
 }
 
 - (YGRequest *)getRequestByIdentifier:(NSString *)identifier {
     if (identifier.length == 0) return nil;
     
+    NSURLSessionTask *task = self.runningTasks[identifier];
     YG_NETWORKING_LOCK();
-    NSArray *tasks = nil;
-    if ([identifier hasPrefix:@"+"]) {
-        tasks = self.sessionManager.tasks;
-    } else if ([identifier hasPrefix:@"-"]) {
-        tasks = self.securitySessionManager.tasks;
+    YGRequestFlight *flight = task.bindedFlight;
+    YGRequest *request = flight ? flight.requests[identifier] : task.bindedRequest;
+    if (!request) {
+        request = self.runningDownloads[identifier].request ?: self.runningUploads[identifier].request ?: self.compressingRequests[identifier];
     }
-    __block YGRequest *request = nil;
-    [tasks enumerateObjectsUsingBlock:^(NSURLSessionTask *task, NSUInteger idx, BOOL *stop) {
-        if ([task.bindedRequest.identifier isEqualToString:identifier]) {
-            request = task.bindedRequest;
-            *stop = YES;
-        }
-    }];
     YG_NETWORKING_UNLOCK();
     return request;
 }
 
 - (void)setConcurrentOperationCount:(NSInteger)count {
-    if (count < 1) {
-        count = 1;
+    self.maxConcurrentRequestCount = count;
+}
+
+- (void)setMaxConcurrentRequestCount:(NSInteger)maxConcurrentRequestCount {
+    if (maxConcurrentRequestCount < 1) {
+        maxConcurrentRequestCount = 1;
     }
-    self.sessionManager.operationQueue.maxConcurrentOperationCount = count;
-    self.securitySessionManager.operationQueue.maxConcurrentOperationCount = count;
+    
+    YG_NETWORKING_LOCK();
+    _maxConcurrentRequestCount = maxConcurrentRequestCount;
+    YG_NETWORKING_UNLOCK();
+    
+    [self yg_resumePendingTasks];
 }
 
-- (NSInteger)reachabilityStatus {
-    return [AFNetworkReachabilityManager sharedManager].networkReachabilityStatus;
+- (void)setConcurrencyLimiter:(YGConcurrencyLimiter *)concurrencyLimiter {
+    // seed the limits from the current connection type.
+    [concurrencyLimiter resetWithConnectionType:[self reachabilityStatus]];
+    
+    YG_NETWORKING_LOCK();
+    _concurrencyLimiter = concurrencyLimiter;
+    YG_NETWORKING_UNLOCK();
+    
+    // tasks waiting on a host limit of the old limiter may start now.
+    [self yg_resumePendingTasks];
 }
 
-- (void)addSSLPinningURL:(NSString *)url {
-    NSParameterAssert(url);
+- (void)setMaxConcurrentDecodeCount:(NSInteger)maxConcurrentDecodeCount {
+    _maxConcurrentDecodeCount = MAX(maxConcurrentDecodeCount, 1);
+    self.decodeQueue.maxConcurrentOperationCount = _maxConcurrentDecodeCount;
+}
+
+- (void)setDecodeQualityOfService:(NSQualityOfService)decodeQualityOfService {
+    _decodeQualityOfService = decodeQualityOfService;
+    self.decodeQueue.qualityOfService = decodeQualityOfService;
+}
+
+- (void)performDecodeForRequest:(YGRequest *)request block:(dispatch_block_t)block {
+    if (!block) return;
     
-    if ([url hasPrefix:@"https"]) {
-        NSString *rootDomainName = [self yg_rootDomainNameFromURL:url];
-        if (rootDomainName && ![self.sslPinningHosts containsObject:rootDomainName]) {
-            [self.sslPinningHosts addObject:rootDomainName];
+    NSBlockOperation *operation = [NSBlockOperation blockOperationWithBlock:block];
+    operation.queuePriority = YGOperationQueuePriorityFromRequestPriority(request.priority);
+    [self.decodeQueue addOperation:operation];
+}
+
+- (void)performCallbackForRequest:(YGRequest *)request block:(dispatch_block_t)block {
+    if (!block) return;
+    
+    dispatch_async(yg_request_callback_queue_for_priority(request.priority), block);
+}
+
+- (NSInteger)maxConcurrentRequestCount {
+    YG_NETWORKING_LOCK();
+    NSInteger maxConcurrentRequestCount = _maxConcurrentRequestCount;
+    YG_NETWORKING_UNLOCK();
+    return maxConcurrentRequestCount;
+}
+
+- (NSUInteger)pendingRequestCountForPriority:(YGRequestPriority)priority {
+    if (priority < kYGRequestPriorityCritical || priority > kYGRequestPriorityBackground) return 0;
+    
+    YG_NETWORKING_LOCK();
+    NSUInteger count = self.pendingLanes[priority].count;
+    YG_NETWORKING_UNLOCK();
+    return count;
+}
+
+- (NSUInteger)runningRequestCount {
+    YG_NETWORKING_LOCK();
+    NSUInteger count = self.runningTaskCount;
+    YG_NETWORKING_UNLOCK();
+    return count;
+}
+
+- (YGRecordReplayTransport *)recordReplayTransport {
+    return YGRecordReplayTransport.activeTransport;
+}
+
+- (void)setRecordReplayTransport:(YGRecordReplayTransport *)recordReplayTransport {
+    YGRecordReplayTransport.activeTransport = recordReplayTransport;
+}
+
+- (NSInteger)reachabilityStatus {
+    return [AFNetworkReachabilityManager sharedManager].networkReachabilityStatus;
+}
+
+- (void)addSSLPinningURL:(NSString *)url {
+    NSParameterAssert(url);
+    
+    if ([url hasPrefix:@"https"]) {
+        NSString *rootDomainName = [self yg_rootDomainNameFromHost:[NSURL URLWithString:url].host];
+        if (rootDomainName && ![self.sslPinningHosts containsObject:rootDomainName]) {
+            [self.sslPinningHosts addObject:rootDomainName];
+        }
+    }
+}
+
+- (void)addSSLPinningCert:(NSData *)cert {
+    NSParameterAssert(cert);
+    
+    NSMutableSet *certSet;
+    if (self.securitySessionManager.securityPolicy.pinnedCertificates.count > 0) {
+        certSet = [NSMutableSet setWithSet:self.securitySessionManager.securityPolicy.pinnedCertificates];
+    } else {
+        certSet = [NSMutableSet set];
+    }
+    [certSet addObject:cert];
+    [self.securitySessionManager.securityPolicy setPinnedCertificates:certSet];
+}
+
+- (void)addTwowayAuthenticationPKCS12:(NSData *)p12 keyPassword:(NSString *)password {
+    NSParameterAssert(p12);
+    NSParameterAssert(password);
+    
+    __weak __typeof(self)weakSelf = self;
+    [self.securitySessionManager setSessionDidReceiveAuthenticationChallengeBlock:^NSURLSessionAuthChallengeDisposition(NSURLSession * _Nonnull session, NSURLAuthenticationChallenge * _Nonnull challenge, NSURLCredential *__autoreleasing  _Nullable * _Nullable credential) {
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        NSURLSessionAuthChallengeDisposition disposition = NSURLSessionAuthChallengePerformDefaultHandling;
+        if ([challenge.protectionSpace.authenticationMethod isEqualToString:NSURLAuthenticationMethodServerTrust]) {
+            // Server Trust (SSL Pinning)
+            if ([strongSelf.securitySessionManager.securityPolicy evaluateServerTrust:challenge.protectionSpace.serverTrust forDomain:challenge.protectionSpace.host]) {
+                *credential = [NSURLCredential credentialForTrust:challenge.protectionSpace.serverTrust];
+                if (*credential) {
+                    disposition = NSURLSessionAuthChallengeUseCredential;
+                } else {
+                    disposition = NSURLSessionAuthChallengePerformDefaultHandling;
+                }
+            } else {
+                disposition = NSURLSessionAuthChallengeCancelAuthenticationChallenge;
+            }
+        } else if ([challenge.protectionSpace.authenticationMethod isEqualToString:NSURLAuthenticationMethodClientCertificate]) {
+            // Client Certificate (Two-way Authentication)
+            SecIdentityRef identity = NULL;
+            SecTrustRef trust = NULL;
+            
+            if (YGExtractIdentityAndTrustFromPKCS12((__bridge CFDataRef)p12, (__bridge CFStringRef)password, &identity, &trust) == 0) {
+                SecCertificateRef certificate = NULL;
+                SecIdentityCopyCertificate(identity, &certificate);
+                
+                const void *certs[] = { certificate };
+                CFArrayRef certArray = CFArrayCreate(kCFAllocatorDefault, certs, 1, NULL);
+                *credential = [NSURLCredential credentialWithIdentity:identity certificates:(__bridge NSArray *)certArray persistence:NSURLCredentialPersistencePermanent];
+                if (*credential) {
+                    disposition = NSURLSessionAuthChallengeUseCredential;
+                } else {
+                    disposition = NSURLSessionAuthChallengePerformDefaultHandling;
+                }
+                
+                if (certificate) {
+                    CFRelease(certificate);
+                }
+                if (certArray) {
+                    CFRelease(certArray);
+                }
+            }
+            
+            if (identity) {
+                CFRelease(identity);
+            }
+            if (trust) {
+                CFRelease(trust);
+            }
+        } else {
+            disposition = NSURLSessionAuthChallengePerformDefaultHandling;
+        }
+        
+        return disposition;
+    }];
+}
+
+#pragma mark - Private Methods
+
+- (void)yg_dataTaskWithRequest:(YGRequest *)request
+             completionHandler:(YGCompletionHandler)completionHandler {
+    NSString *httpMethod = [self yg_HTTPMethodForRequest:request];
+    
+    AFURLSessionManager *sessionManager = [self yg_getSessionManager:request];
+    AFHTTPRequestSerializer *requestSerializer = [self yg_getRequestSerializer:request];
+    
+    NSError *serializationError = nil;
+    NSTimeInterval serializationTimestamp = [NSProcessInfo processInfo].systemUptime;
+    // build the request from the parsed URL instead of `-requestWithMethod:URLString:...`, which parses the string again.
+    NSMutableURLRequest *urlRequest = [NSMutableURLRequest requestWithURL:[self yg_URLForRequest:request]];
+    urlRequest.HTTPMethod = httpMethod;
+    urlRequest = [[requestSerializer requestBySerializingRequest:urlRequest withParameters:request.mergedParameters error:&serializationError] mutableCopy];
+    [request.metrics setValue:@([NSProcessInfo processInfo].systemUptime - serializationTimestamp) forKey:@"_serializationDuration"];
+    
+    if (serializationError) {
+        [self yg_releaseCircuitProbeForRequest:request];
+        if (completionHandler) {
+            dispatch_async(yg_request_completion_callback_queue(), ^{
+                completionHandler(nil, serializationError);
+            });
+        }
+        return;
+    }
+    
+    [self yg_processURLRequest:urlRequest byYGRequest:request];
+    
+    if (request.coalescingEnabled && (request.httpMethod == kYGHTTPMethodGET || request.httpMethod == kYGHTTPMethodHEAD)) {
+        [self yg_coalescingDataTaskWithURLRequest:urlRequest request:request sessionManager:sessionManager completionHandler:completionHandler];
+        return;
+    }
+    
+    if (request.requestCompressionType != kYGRequestCompressionNone &&
+        urlRequest.HTTPBody.length > 0 &&
+        urlRequest.HTTPBody.length >= request.requestCompressionThreshold &&
+        ![urlRequest valueForHTTPHeaderField:@"Content-Encoding"]) {
+        [self yg_compressBodyOfURLRequest:urlRequest request:request sessionManager:sessionManager completionHandler:completionHandler];
+        return;
+    }
+    
+    [self yg_dataTaskWithURLRequest:urlRequest request:request identifier:nil sessionManager:sessionManager completionHandler:completionHandler];
+}
+
+/**
+ 创建并调度普通请求的 data task.
+ 
+ @param identifier 已经分配给请求的 identifier, 为 `nil` 时按任务生成.
+ */
+- (void)yg_dataTaskWithURLRequest:(NSURLRequest *)urlRequest
+                          request:(YGRequest *)request
+                       identifier:(NSString *)identifier
+                   sessionManager:(AFURLSessionManager *)sessionManager
+                completionHandler:(YGCompletionHandler)completionHandler {
+    YGResponseStream *stream = [self yg_responseStreamForRequest:request];
+    YGHedgingPolicy *hedgingPolicy = self.hedgingPolicy;
+    YGRequestHedge *hedge = nil;
+    if (request.hedgingEnabled && hedgingPolicy && !stream &&
+        (request.httpMethod == kYGHTTPMethodGET || request.httpMethod == kYGHTTPMethodHEAD)) {
+        hedge = [[YGRequestHedge alloc] init];
+        hedge.policy = hedgingPolicy;
+        hedge.request = request;
+        hedge.urlRequest = urlRequest;
+        hedge.sessionManager = sessionManager;
+        hedge.completionHandler = completionHandler;
+        hedge.runningCount = 1;
+        [hedgingPolicy.budget deposit];
+    }
+    
+    NSURLSessionDataTask *dataTask = [self yg_dataTaskWithURLRequest:urlRequest
+                                                              request:request
+                                                               stream:stream
+                                                                hedge:hedge
+                                                       sessionManager:sessionManager
+                                                    completionHandler:completionHandler];
+    hedge.primaryTask = dataTask;
+    if (identifier) {
+        self.runningTasks[identifier] = dataTask;
+    } else {
+        [self yg_setIdentifierForReqeust:request task:dataTask sessionManager:sessionManager];
+    }
+    [self yg_scheduleTask:dataTask priority:request.priority];
+}
+
+/**
+ 创建普通请求的 data task, 开启对冲的请求的原始任务和对冲任务都由这里创建.
+ */
+- (NSURLSessionDataTask *)yg_dataTaskWithURLRequest:(NSURLRequest *)urlRequest
+                                            request:(YGRequest *)request
+                                             stream:(YGResponseStream *)stream
+                                              hedge:(YGRequestHedge *)hedge
+                                     sessionManager:(AFURLSessionManager *)sessionManager
+                                  completionHandler:(YGCompletionHandler)completionHandler {
+    __block __weak NSURLSessionDataTask *weakDataTask = nil;
+    __weak __typeof(self)weakSelf = self;
+    NSURLSessionDataTask *dataTask = [sessionManager dataTaskWithRequest:urlRequest
+                                                          uploadProgress:nil
+                                                        downloadProgress:nil
+                                                       completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        if (hedge && ![strongSelf yg_resolveHedge:hedge withTask:weakDataTask error:error]) {
+            return;
+        }
+        [strongSelf yg_removeIdentifierForRequest:request];
+        if (stream) {
+            [strongSelf yg_processStreamingResponse:response
+                                               data:responseObject
+                                              error:error
+                                             stream:stream
+                                            metrics:request.metrics
+                                  completionHandler:completionHandler];
+        } else {
+            [strongSelf yg_processResponse:response
+                                    object:responseObject
+                                     error:error
+                                   request:request
+                         completionHandler:completionHandler];
+        }
+    }];
+    weakDataTask = dataTask;
+    
+    [dataTask setBindedRequest:request];
+    [dataTask setBindedStream:stream];
+    [dataTask setBindedHedge:hedge];
+    return dataTask;
+}
+
+/**
+ 在压缩队列中压缩请求体后再创建任务, 请求在压缩前就分配 `Z` 开头的 identifier, 压缩期间可以被取消.
+ NOTE: 压缩后的数据不比原始数据短时发送原始数据.
+ */
+- (void)yg_compressBodyOfURLRequest:(NSMutableURLRequest *)urlRequest
+                            request:(YGRequest *)request
+                     sessionManager:(AFURLSessionManager *)sessionManager
+                  completionHandler:(YGCompletionHandler)completionHandler {
+    NSString *identifier = [NSString stringWithFormat:@"Z%lu", atomic_fetch_add_explicit(&_compressingRequestCount, 1, memory_order_relaxed) + 1];
+    YG_NETWORKING_LOCK();
+    self.compressingRequests[identifier] = request;
+    YG_NETWORKING_UNLOCK();
+    [request setValue:identifier forKey:@"_identifier"];
+    
+    YGRequestMetrics *metrics = request.metrics;
+    dispatch_async(yg_request_compression_queue(), ^{
+        NSData *body = urlRequest.HTTPBody;
+        NSTimeInterval startTimestamp = [NSProcessInfo processInfo].systemUptime;
+        NSData *compressedBody = YGGzipCompressData(body);
+        [metrics setValue:@([NSProcessInfo processInfo].systemUptime - startTimestamp) forKey:@"_compressionDuration"];
+        [metrics setValue:@(body.length) forKey:@"_requestBodyLength"];
+        if (compressedBody && compressedBody.length < body.length) {
+            urlRequest.HTTPBody = compressedBody;
+            [urlRequest setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+            [metrics setValue:@(compressedBody.length) forKey:@"_compressedRequestBodyLength"];
+        }
+        
+        YG_NETWORKING_LOCK();
+        BOOL cancelled = (self.compressingRequests[identifier] == nil);
+        [self.compressingRequests removeObjectForKey:identifier];
+        YG_NETWORKING_UNLOCK();
+        
+        if (cancelled) {
+            [self yg_releaseCircuitProbeForRequest:request];
+            if (completionHandler) {
+                NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil];
+                dispatch_async(yg_request_completion_callback_queue(), ^{
+                    completionHandler(nil, error);
+                });
+            }
+            return;
+        }
+        [self yg_dataTaskWithURLRequest:urlRequest request:request identifier:identifier sessionManager:sessionManager completionHandler:completionHandler];
+    });
+}
+
+- (NSString *)yg_HTTPMethodForRequest:(YGRequest *)request {
+    NSString *httpMethod = nil;
+    static dispatch_once_t onceToken;
+    static NSArray *httpMethodArray = nil;
+    dispatch_once(&onceToken, ^{
+        httpMethodArray = @[@"GET", @"POST", @"HEAD", @"DELETE", @"PUT", @"PATCH"];
+    });
+    if (request.httpMethod >= 0 && request.httpMethod < httpMethodArray.count) {
+        httpMethod = httpMethodArray[request.httpMethod];
+    }
+    NSAssert(httpMethod.length > 0, @"The HTTP method not found.");
+    return httpMethod;
+}
+
+- (void)yg_coalescingDataTaskWithURLRequest:(NSURLRequest *)urlRequest
+                                    request:(YGRequest *)request
+                             sessionManager:(AFURLSessionManager *)sessionManager
+                          completionHandler:(YGCompletionHandler)completionHandler {
+    NSString *flightKey = [self yg_flightKeyForURLRequest:urlRequest request:request];
+    YGCompletionHandler handler = completionHandler ?: ^(id responseObject, NSError *error) {};
+    
+    // attach to the identical request already in flight.
+    if ([self yg_joinFlightForKey:flightKey request:request completionHandler:handler]) {
+        return;
+    }
+    
+    // the task is created outside `_lock`, creating it must not stall the other requests of the engine.
+    YGRequestFlight *flight = [[YGRequestFlight alloc] init];
+    flight.key = flightKey;
+    
+    YGResponseStream *stream = [self yg_responseStreamForRequest:request];
+    __weak __typeof(self)weakSelf = self;
+    NSURLSessionDataTask *dataTask = [sessionManager dataTaskWithRequest:urlRequest
+                                                          uploadProgress:nil
+                                                        downloadProgress:nil
+                                                       completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        NSArray<YGCompletionHandler> *completionHandlers = [strongSelf yg_finishFlight:flight];
+        if (completionHandlers.count == 0) {
+            return;
+        }
+        // decode the response once and deliver the same object to every waiter.
+        YGCompletionHandler fanOutHandler = ^(id decodedObject, NSError *decodeError) {
+            for (YGCompletionHandler completionHandler in completionHandlers) {
+                completionHandler(decodedObject, decodeError);
+            }
+        };
+        if (stream) {
+            [strongSelf yg_processStreamingResponse:response
+                                               data:responseObject
+                                              error:error
+                                             stream:stream
+                                            metrics:request.metrics
+                                  completionHandler:fanOutHandler];
+        } else {
+            [strongSelf yg_processResponse:response
+                                    object:responseObject
+                                     error:error
+                                   request:request
+                         completionHandler:fanOutHandler];
+        }
+    }];
+    
+    flight.task = dataTask;
+    [dataTask setBindedRequest:request];
+    [dataTask setBindedStream:stream];
+    [dataTask setBindedFlight:flight];
+    
+    YGRequestPriority priority = request.priority;
+    if (priority < kYGRequestPriorityCritical || priority > kYGRequestPriorityBackground) {
+        priority = kYGRequestPriorityNormal;
+    }
+    
+    YG_NETWORKING_LOCK();
+    // another identical request may have started a flight while the task was being created.
+    BOOL isDuplicate = (self.runningFlights[flightKey] != nil);
+    if (!isDuplicate) {
+        flight.priority = priority;
+        [self yg_setIdentifierForReqeust:request task:dataTask sessionManager:sessionManager];
+        flight.requests[request.identifier] = request;
+        flight.completionHandlers[request.identifier] = handler;
+        self.runningFlights[flightKey] = flight;
+    }
+    YG_NETWORKING_UNLOCK();
+    
+    if (isDuplicate) {
+        // the task never entered the scheduler, cancelling it only releases it from the session.
+        [dataTask setBindedFlight:nil];
+        [dataTask cancel];
+        if (![self yg_joinFlightForKey:flightKey request:request completionHandler:handler]) {
+            // the other flight finished in the meantime, run the request on its own.
+            [self yg_coalescingDataTaskWithURLRequest:urlRequest request:request sessionManager:sessionManager completionHandler:completionHandler];
+        }
+        return;
+    }
+    
+    [self yg_scheduleTask:dataTask priority:priority];
+    
+    // a waiter may have joined with a higher priority before the task reached the scheduler.
+    YG_NETWORKING_LOCK();
+    BOOL shouldResume = [self yg_promotePendingTask:dataTask toPriority:flight.priority];
+    YG_NETWORKING_UNLOCK();
+    if (shouldResume) {
+        [self yg_resumeTask:dataTask];
+    }
+}
+
+/**
+ 把请求作为 waiter 加入正在运行的相同请求, 没有正在运行的相同请求时返回 `NO`.
+ waiter 的优先级高于任务时提升任务的优先级, 任务还在排队时移到对应优先级的队列,
+ `kYGRequestPriorityCritical` 的 waiter 让排队的任务立即启动.
+ */
+- (BOOL)yg_joinFlightForKey:(NSString *)flightKey
+                    request:(YGRequest *)request
+          completionHandler:(YGCompletionHandler)completionHandler {
+    BOOL shouldResume = NO;
+    YG_NETWORKING_LOCK();
+    YGRequestFlight *flight = self.runningFlights[flightKey];
+    if (!flight) {
+        YG_NETWORKING_UNLOCK();
+        return NO;
+    }
+    
+    NSURLSessionTask *task = flight.task;
+    NSString *identifier = [NSString stringWithFormat:@"%@.%lu", task.bindedRequest.identifier, (unsigned long)++flight.waiterCount];
+    [request setValue:identifier forKey:@"_identifier"];
+    [request setValue:task.bindedRequest.metrics forKey:@"_metrics"];
+    flight.requests[identifier] = request;
+    flight.completionHandlers[identifier] = completionHandler;
+    self.runningTasks[identifier] = task;
+    
+    YGRequestPriority priority = request.priority;
+    if (priority >= kYGRequestPriorityCritical && priority < flight.priority) {
+        flight.priority = priority;
+        shouldResume = [self yg_promotePendingTask:task toPriority:priority];
+    }
+    YG_NETWORKING_UNLOCK();
+    
+    // the waiter never gets a task of its own, its probe must not hold the half-open host.
+    [self yg_releaseCircuitProbeForRequest:request];
+    if (shouldResume) {
+        [self yg_resumeTask:task];
+    }
+    return YES;
+}
+
+/**
+ 提升合并任务的优先级, 任务在更低优先级的队列中排队时移到 `priority` 的队列, 需要在持有 `_lock` 的情况下调用.
+ 
+ @return 提升到 `kYGRequestPriorityCritical` 的排队任务不受并发数限制, 已经占用并发名额, 需要立即启动时返回 `YES`.
+ */
+- (BOOL)yg_promotePendingTask:(NSURLSessionTask *)task toPriority:(YGRequestPriority)priority {
+    task.priority = MAX(task.priority, YGTaskPriorityFromRequestPriority(priority));
+    for (NSUInteger index = priority + 1; index < self.pendingLanes.count; index++) {
+        NSMutableOrderedSet<NSURLSessionTask *> *lane = self.pendingLanes[index];
+        if (![lane containsObject:task]) {
+            continue;
+        }
+        [lane removeObject:task];
+        if (priority == kYGRequestPriorityCritical) {
+            // critical requests bypass the concurrency limit, so does the task they wait for.
+            self.runningTaskCount++;
+            return YES;
+        }
+        [self.pendingLanes[priority] addObject:task];
+        return NO;
+    }
+    return NO;
+}
+
+/**
+ 结束合并请求, 移除所有 waiter 的索引并返回它们的回调.
+ */
+- (NSArray<YGCompletionHandler> *)yg_finishFlight:(YGRequestFlight *)flight {
+    YG_NETWORKING_LOCK();
+    if (self.runningFlights[flight.key] == flight) {
+        [self.runningFlights removeObjectForKey:flight.key];
+    }
+    [self.runningTasks removeObjectsForKeys:flight.completionHandlers.allKeys];
+    NSArray<YGCompletionHandler> *completionHandlers = flight.completionHandlers.allValues;
+    [flight.completionHandlers removeAllObjects];
+    [flight.requests removeAllObjects];
+    // break the retain cycle between the flight and its task.
+    [flight.task setBindedFlight:nil];
+    YG_NETWORKING_UNLOCK();
+    return completionHandlers;
+}
+
+- (NSString *)yg_flightKeyForURLRequest:(NSURLRequest *)urlRequest request:(YGRequest *)request {
+    NSDictionary<NSString *, NSString *> *headers = urlRequest.allHTTPHeaderFields;
+    NSMutableString *headerString = [NSMutableString string];
+    for (NSString *field in [headers.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        [headerString appendFormat:@"%@:%@\n", field, headers[field]];
+    }
+    return [NSString stringWithFormat:@"%@ %@ %ld\n%@", urlRequest.HTTPMethod, urlRequest.URL.absoluteString, (long)request.responseSerializerType, headerString];
+}
+
+- (void)yg_uploadTaskWithRequest:(YGRequest *)request
+               completionHandler:(YGCompletionHandler)completionHandler {
+    
+    AFURLSessionManager *sessionManager = [self yg_getSessionManager:request];
+    AFHTTPRequestSerializer *requestSerializer = [self yg_getRequestSerializer:request];
+    
+    __block NSError *serializationError = nil;
+    NSTimeInterval serializationTimestamp = [NSProcessInfo processInfo].systemUptime;
+    NSMutableURLRequest *urlRequest = [requestSerializer multipartFormRequestWithMethod:@"POST"
+                                                                              URLString:[self yg_URLForRequest:request].absoluteString
+                                                                             parameters:request.mergedParameters
+                                                              constructingBodyWithBlock:^(id<AFMultipartFormData> formData) {
+        [request.uploadFormDatas enumerateObjectsUsingBlock:^(YGUploadFormData *obj, NSUInteger idx, BOOL *stop) {
+            if (obj.fileData) {
+                if (obj.fileName && obj.mimeType) {
+                    [formData appendPartWithFileData:obj.fileData name:obj.name fileName:obj.fileName mimeType:obj.mimeType];
+                } else {
+                    [formData appendPartWithFormData:obj.fileData name:obj.name];
+                }
+            } else if (obj.fileURL) {
+                NSError *fileError = nil;
+                if (obj.fileName && obj.mimeType) {
+                    [formData appendPartWithFileURL:obj.fileURL name:obj.name fileName:obj.fileName mimeType:obj.mimeType error:&fileError];
+                } else {
+                    [formData appendPartWithFileURL:obj.fileURL name:obj.name error:&fileError];
+                }
+                if (fileError) {
+                    serializationError = fileError;
+                    *stop = YES;
+                }
+            }
+        }];
+    } error:&serializationError];
+    [request.metrics setValue:@([NSProcessInfo processInfo].systemUptime - serializationTimestamp) forKey:@"_serializationDuration"];
+    
+    if (serializationError) {
+        [self yg_releaseCircuitProbeForRequest:request];
+        if (completionHandler) {
+            dispatch_async(yg_request_completion_callback_queue(), ^{
+                completionHandler(nil, serializationError);
+            });
+        }
+        return;
+    }
+    
+    [self yg_processURLRequest:urlRequest byYGRequest:request];
+    
+    NSURLSessionUploadTask *uploadTask = nil;
+    __weak __typeof(self)weakSelf = self;
+    uploadTask = [sessionManager uploadTaskWithStreamedRequest:urlRequest
+                                                      progress:request.progressBlock
+                                             completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        [strongSelf yg_removeIdentifierForRequest:request];
+        [strongSelf yg_processResponse:response
+                                object:responseObject
+                                 error:error
+                               request:request
+                     completionHandler:completionHandler];
+    }];
+    
+    [uploadTask setBindedRequest:request];
+    [self yg_setIdentifierForReqeust:request task:uploadTask sessionManager:sessionManager];
+    [self yg_scheduleTask:uploadTask priority:request.priority];
+}
+
+- (void)yg_downloadTaskWithRequest:(YGRequest *)request
+                 completionHandler:(YGCompletionHandler)completionHandler {
+    NSMutableURLRequest *urlRequest = [NSMutableURLRequest requestWithURL:[self yg_URLForRequest:request]];
+    [self yg_processURLRequest:urlRequest byYGRequest:request];
+    
+    NSURL *downloadFileSavePath = [self yg_downloadFileURLForRequest:request URL:urlRequest.URL];
+    
+    YGDownloadResumeStore *resumeStore = self.downloadResumeStore;
+    NSString *url = request.url;
+    NSString *savePath = request.downloadSavePath;
+    __block BOOL resumedFromData = NO;
+    __block long long rangeOffset = 0;
+    
+    __weak __typeof(self)weakSelf = self;
+    __block __weak NSURLSessionDownloadTask *weakTask = nil;
+    NSURL * (^destination)(NSURL *, NSURLResponse *) = ^NSURL *(NSURL *targetPath, NSURLResponse *response) {
+        if (rangeOffset > 0 && [response isKindOfClass:[NSHTTPURLResponse class]] && ((NSHTTPURLResponse *)response).statusCode == 206) {
+            // the partial content is merged into the downloaded part when the task finishes.
+            return [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString] isDirectory:NO];
+        }
+        return downloadFileSavePath;
+    };
+    void (^downloadCompletionHandler)(NSURLResponse *, NSURL *, NSError *) = ^(NSURLResponse *response, NSURL *filePath, NSError *error) {
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        [strongSelf yg_removeIdentifierForRequest:request];
+        
+        if (rangeOffset > 0 && !error) {
+            filePath = [strongSelf yg_finishRangeDownloadForRequest:request
+                                                           response:response
+                                                           filePath:filePath
+                                                        destination:downloadFileSavePath
+                                                        rangeOffset:rangeOffset
+                                                              error:&error];
+        }
+        
+        NSData *resumeData = error.userInfo[NSURLSessionDownloadTaskResumeData];
+        BOOL cancelled = [error.domain isEqualToString:NSURLErrorDomain] && error.code == NSURLErrorCancelled;
+        if (!error) {
+            [resumeStore removeResumeDataForURL:url savePath:savePath];
+        } else if (resumeData) {
+            [strongSelf yg_persistResumeData:resumeData forTask:weakTask];
+        } else if (resumedFromData && !cancelled) {
+            // the resume data was rejected, later sends fall back to a range request.
+            [resumeStore invalidateResumeDataForURL:url savePath:savePath];
+        }
+        
+        if (completionHandler) {
+            [strongSelf yg_performCallbackForRequest:request block:^{
+                completionHandler(filePath, error);
+            }];
+        }
+    };
+    
+    NSURLSessionDownloadTask *downloadTask = nil;
+    AFURLSessionManager *sessionManager = [self yg_getSessionManager:request];
+    NSData *resumeData = [resumeStore resumeDataForURL:url savePath:savePath];
+    if (resumeData) {
+        downloadTask = [sessionManager downloadTaskWithResumeData:resumeData
+                                                         progress:request.progressBlock
+                                                      destination:destination
+                                                completionHandler:downloadCompletionHandler];
+        resumedFromData = (downloadTask != nil);
+        if (!downloadTask) {
+            [resumeStore invalidateResumeDataForURL:url savePath:savePath];
+        }
+    }
+    if (!downloadTask) {
+        rangeOffset = [self yg_prepareRangeRequest:urlRequest forRequest:request];
+        downloadTask = [sessionManager downloadTaskWithRequest:urlRequest
+                                                      progress:request.progressBlock
+                                                   destination:destination
+                                             completionHandler:downloadCompletionHandler];
+    }
+    weakTask = downloadTask;
+    
+    [downloadTask setBindedRequest:request];
+    [downloadTask setRangeOffset:rangeOffset];
+    [self yg_setIdentifierForReqeust:request task:downloadTask sessionManager:sessionManager];
+    [self yg_scheduleTask:downloadTask priority:request.priority];
+}
+
+/**
+ 下载文件的保存路径, `downloadSavePath` 为目录时使用 URL 中的文件名.
+ */
+- (NSURL *)yg_downloadFileURLForRequest:(YGRequest *)request URL:(NSURL *)URL {
+    BOOL isDirectory;
+    if(![[NSFileManager defaultManager] fileExistsAtPath:request.downloadSavePath isDirectory:&isDirectory]) {
+        isDirectory = NO;
+    }
+    if (isDirectory) {
+        NSString *fileName = [URL lastPathComponent];
+        return [NSURL fileURLWithPath:[NSString pathWithComponents:@[request.downloadSavePath, fileName]] isDirectory:NO];
+    } else {
+        return [NSURL fileURLWithPath:request.downloadSavePath isDirectory:NO];
+    }
+}
+
+#pragma mark - Download Resume
+
+/**
+ 断点数据不可用时使用已下载部分继续下载, 只有资源的校验值存在时才发送 Range/If-Range 请求, 否则删除已下载部分重新下载.
+ 
+ @return Range 请求的起始位置, 不发送 Range 请求时返回 `0`.
+ */
+- (long long)yg_prepareRangeRequest:(NSMutableURLRequest *)urlRequest forRequest:(YGRequest *)request {
+    YGDownloadResumeStore *resumeStore = self.downloadResumeStore;
+    NSString *partialFilePath = [resumeStore partialFilePathForURL:request.url savePath:request.downloadSavePath];
+    if (!partialFilePath) return 0;
+    
+    NSString *validator = [resumeStore validatorForURL:request.url savePath:request.downloadSavePath];
+    long long rangeOffset = (long long)[[NSFileManager defaultManager] attributesOfItemAtPath:partialFilePath error:nil].fileSize;
+    if (!validator || rangeOffset <= 0) {
+        // without a validator the server can not tell us whether the resource changed.
+        [resumeStore removeResumeDataForURL:request.url savePath:request.downloadSavePath];
+        return 0;
+    }
+    
+    [urlRequest setValue:[NSString stringWithFormat:@"bytes=%lld-", rangeOffset] forHTTPHeaderField:@"Range"];
+    [urlRequest setValue:validator forHTTPHeaderField:@"If-Range"];
+    return rangeOffset;
+}
+
+/**
+ 结束 Range 请求, 206 响应的内容追加到已下载部分后移动到保存路径, 其它响应 (If-Range 不匹配时为 200) 已经是完整的文件.
+ 
+ @return 下载文件的路径, 合并失败时返回 `nil`.
+ */
+- (NSURL *)yg_finishRangeDownloadForRequest:(YGRequest *)request
+                                   response:(NSURLResponse *)response
+                                   filePath:(NSURL *)filePath
+                                destination:(NSURL *)destination
+                                rangeOffset:(long long)rangeOffset
+                                      error:(NSError *__autoreleasing *)error {
+    if (![response isKindOfClass:[NSHTTPURLResponse class]] || ((NSHTTPURLResponse *)response).statusCode != 206) {
+        return filePath;
+    }
+    
+    YGDownloadResumeStore *resumeStore = self.downloadResumeStore;
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSString *partialFilePath = [resumeStore partialFilePathForURL:request.url savePath:request.downloadSavePath];
+    NSError *mergeError = nil;
+    BOOL merged = NO;
+    if (partialFilePath && filePath && YGRangeStartFromResponse(response) == rangeOffset) {
+        merged = [resumeStore appendFileAtPath:filePath.path toPartialFileForURL:request.url savePath:request.downloadSavePath error:&mergeError];
+    }
+    if (filePath) {
+        [fileManager removeItemAtURL:filePath error:nil];
+    }
+    if (merged) {
+        [fileManager removeItemAtURL:destination error:nil];
+        merged = [fileManager moveItemAtPath:partialFilePath toPath:destination.path error:&mergeError];
+    }
+    
+    if (!merged) {
+        [resumeStore removeResumeDataForURL:request.url savePath:request.downloadSavePath];
+        if (error) {
+            *error = mergeError ?: YGBadServerResponseError(request.url);
+        }
+        return nil;
+    }
+    return destination;
+}
+
+/**
+ 保存下载任务的断点数据, 任务取消和失败时都可能收到断点数据, 每个任务只保存一次.
+ NOTE: Range 请求的断点数据只包含请求的部分, 需要合并到已下载部分.
+ */
+- (void)yg_persistResumeData:(NSData *)resumeData forTask:(NSURLSessionTask *)task {
+    YGDownloadResumeStore *resumeStore = self.downloadResumeStore;
+    YGRequest *request = task.bindedRequest;
+    if (!resumeStore || resumeData.length == 0 || !request) return;
+    
+    YG_NETWORKING_LOCK();
+    BOOL persisted = task.resumeDataPersisted;
+    task.resumeDataPersisted = YES;
+    YG_NETWORKING_UNLOCK();
+    if (persisted) return;
+    
+    long long rangeOffset = task.rangeOffset;
+    NSURLResponse *response = task.response;
+    if (rangeOffset <= 0) {
+        [resumeStore setResumeData:resumeData validator:YGRangeValidatorFromResponse(response) forURL:request.url savePath:request.downloadSavePath];
+    } else if ([response isKindOfClass:[NSHTTPURLResponse class]] && ((NSHTTPURLResponse *)response).statusCode == 206) {
+        if (YGRangeStartFromResponse(response) == rangeOffset) {
+            [resumeStore mergeResumeData:resumeData forURL:request.url savePath:request.downloadSavePath];
+        } else {
+            [resumeStore removeResumeDataForURL:request.url savePath:request.downloadSavePath];
+        }
+    } else {
+        // the resource changed and the server sent it from the beginning.
+        [resumeStore setResumeData:resumeData validator:YGRangeValidatorFromResponse(response) forURL:request.url savePath:request.downloadSavePath];
+    }
+}
+
+- (void)yg_processURLRequest:(NSMutableURLRequest *)urlRequest byYGRequest:(YGRequest *)request {
+    // general headers first so the request's own headers win, without merging the dictionaries.
+    void (^setHeaders)(NSDictionary *) = ^(NSDictionary *headers) {
+        [headers enumerateKeysAndObjectsUsingBlock:^(id field, id value, BOOL * __unused stop) {
+            //if (![urlRequest valueForHTTPHeaderField:field]) {
+                [urlRequest setValue:value forHTTPHeaderField:field];
+            //}
+        }];
+    };
+    if (request.generalHeaders.count > 0) {
+        setHeaders(request.generalHeaders);
+    }
+    if (request.headers.count > 0) {
+        setHeaders(request.headers);
+    }
+    urlRequest.timeoutInterval = request.timeoutInterval;
+}
+
+- (void)yg_processResponse:(NSURLResponse *)response
+                    object:(id)responseObject
+                     error:(NSError *)error
+                   request:(YGRequest *)request
+         completionHandler:(YGCompletionHandler)completionHandler {
+    if (request.responseSerializerType == kYGResponseSerializerRAW) {
+        [self yg_performCallbackForRequest:request block:^{
+            if (completionHandler) {
+                completionHandler(responseObject, error);
+            }
+        }];
+        return;
+    }
+    
+    YGRequestMetrics *metrics = request.metrics;
+    NSTimeInterval enqueueTimestamp = [NSProcessInfo processInfo].systemUptime;
+    [self performDecodeForRequest:request block:^{
+        NSTimeInterval startTimestamp = [NSProcessInfo processInfo].systemUptime;
+        NSError *serializationError = nil;
+        AFHTTPResponseSerializer *responseSerializer = [self yg_getResponseSerializer:request];
+        id serializedObject = [responseSerializer responseObjectForResponse:response data:responseObject error:&serializationError];
+        [metrics setValue:@(startTimestamp - enqueueTimestamp) forKey:@"_decodeWaitDuration"];
+        [metrics setValue:@([NSProcessInfo processInfo].systemUptime - startTimestamp) forKey:@"_decodeDuration"];
+        
+        // hand the result back to the callback queue, the decode workers only decode.
+        dispatch_async(yg_request_callback_queue_for_priority(request.priority), ^{
+            if (completionHandler) {
+                if (serializationError) {
+                    completionHandler(nil, serializationError);
+                } else {
+                    completionHandler(serializedObject, error);
+                }
+            }
+        });
+    }];
+}
+
+/**
+ 创建请求的流式解析响应, 只有开启 `responseStreamingEnabled` 的 JSON 请求需要.
+ */
+- (YGResponseStream *)yg_responseStreamForRequest:(YGRequest *)request {
+    if (!request.responseStreamingEnabled ||
+        request.responseSerializerType != kYGResponseSerializerJSON ||
+        request.httpMethod == kYGHTTPMethodHEAD) {
+        return nil;
+    }
+    return [[YGResponseStream alloc] initWithReadingOptions:self.afJSONResponseSerializer.readingOptions
+                                           streamingKeyPath:request.responseStreamingKeyPath
+                                                targetQueue:yg_request_callback_queue_for_priority(request.priority)];
+}
+
+/**
+ 结束流式解析, 在所有已接收的数据块之后执行, 此时只剩下尾部数据需要解析.
+ NOTE: AFURLSessionManager 仍然会缓存完整的响应数据, 这里只用它来校验响应.
+ */
+- (void)yg_processStreamingResponse:(NSURLResponse *)response
+                               data:(NSData *)data
+                              error:(NSError *)error
+                             stream:(YGResponseStream *)stream
+                            metrics:(YGRequestMetrics *)metrics
+                  completionHandler:(YGCompletionHandler)completionHandler {
+    NSTimeInterval enqueueTimestamp = [NSProcessInfo processInfo].systemUptime;
+    dispatch_async(stream.queue, ^{
+        NSTimeInterval startTimestamp = [NSProcessInfo processInfo].systemUptime;
+        NSError *serializationError = nil;
+        id serializedObject = nil;
+        if (!error && [self.afJSONResponseSerializer validateResponse:(NSHTTPURLResponse *)response data:data error:&serializationError]) {
+            serializedObject = [stream.parser finishWithError:&serializationError];
+        }
+        [metrics setValue:@(startTimestamp - enqueueTimestamp) forKey:@"_decodeWaitDuration"];
+        [metrics setValue:@([NSProcessInfo processInfo].systemUptime - startTimestamp) forKey:@"_decodeDuration"];
+        
+        if (completionHandler) {
+            completionHandler(serializedObject, error ?: serializationError);
+        }
+    });
+}
+
+/**
+ 在请求优先级对应 QoS 的回调队列中执行 block, `kYGRequestPriorityNormal` 的请求已经在 session 的 completion 队列中, 直接执行.
+ */
+- (void)yg_performCallbackForRequest:(YGRequest *)request block:(dispatch_block_t)block {
+    dispatch_queue_t callbackQueue = yg_request_callback_queue_for_priority(request.priority);
+    if (callbackQueue == yg_request_completion_callback_queue()) {
+        block();
+    } else {
+        dispatch_async(callbackQueue, block);
+    }
+}
+
+#pragma mark - Segmented Download
+
+/**
+ 分段下载, 先发送 HEAD 请求探测文件长度和 Range 支持, 再按 `downloadSegmentCount` 分段同时下载.
+ NOTE: 分段下载使用 `S` 开头的固定 identifier, 取消时会取消所有分段任务.
+ */
+- (void)yg_segmentedDownloadTaskWithRequest:(YGRequest *)request
+                          completionHandler:(YGCompletionHandler)completionHandler {
+    NSMutableURLRequest *urlRequest = [NSMutableURLRequest requestWithURL:[self yg_URLForRequest:request]];
+    [self yg_processURLRequest:urlRequest byYGRequest:request];
+    
+    YGSegmentedDownload *download = [[YGSegmentedDownload alloc] init];
+    download.request = request;
+    download.urlRequest = urlRequest;
+    download.destination = [self yg_downloadFileURLForRequest:request URL:urlRequest.URL];
+    download.completionHandler = completionHandler;
+    
+    NSMutableURLRequest *probeRequest = [urlRequest mutableCopy];
+    probeRequest.HTTPMethod = @"HEAD";
+    
+    AFURLSessionManager *sessionManager = [self yg_getSessionManager:request];
+    __weak __typeof(self)weakSelf = self;
+    NSURLSessionDataTask *probeTask = [sessionManager dataTaskWithRequest:probeRequest
+                                                           uploadProgress:nil
+                                                         downloadProgress:nil
+                                                        completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        [strongSelf yg_segmentedDownload:download didProbeWithResponse:response error:error];
+    }];
+    [probeTask setBindedRequest:request];
+    
+    download.identifier = [NSString stringWithFormat:@"S%lu", atomic_fetch_add_explicit(&_segmentedDownloadCount, 1, memory_order_relaxed) + 1];
+    YG_NETWORKING_LOCK();
+    download.probeTask = probeTask;
+    self.runningDownloads[download.identifier] = download;
+    YG_NETWORKING_UNLOCK();
+    
+    [request setValue:download.identifier forKey:@"_identifier"];
+    [self yg_scheduleTask:probeTask priority:request.priority];
+}
+
+/**
+ 根据 HEAD 响应分段, 服务器返回文件长度且支持 Range 时预分配文件并启动所有分段, 否则退化为单个连接下载.
+ */
+- (void)yg_segmentedDownload:(YGSegmentedDownload *)download didProbeWithResponse:(NSURLResponse *)response error:(NSError *)error {
+    NSHTTPURLResponse *HTTPResponse = [response isKindOfClass:[NSHTTPURLResponse class]] ? (NSHTTPURLResponse *)response : nil;
+    if (!HTTPResponse && error) {
+        [self yg_finishSegmentedDownload:download filePath:nil error:error];
+        return;
+    }
+    
+    YGRequest *request = download.request;
+    long long contentLength = HTTPResponse.expectedContentLength;
+    BOOL acceptRanges = [YGHTTPHeaderValueFromResponse(HTTPResponse, @"Accept-Ranges") rangeOfString:@"bytes" options:NSCaseInsensitiveSearch].location != NSNotFound;
+    NSUInteger segmentCount = 1;
+    if (!error && HTTPResponse.statusCode == 200 && acceptRanges && contentLength > 0) {
+        segmentCount = (NSUInteger)MIN((long long)request.downloadSegmentCount, contentLength / YGDownloadSegmentMinimumLength);
+    }
+    
+    NSMutableArray<YGDownloadSegment *> *segments = [NSMutableArray array];
+    NSProgress *progress = nil;
+    if (segmentCount > 1) {
+        // preallocate the file so that every segment can be written at its own offset.
+        NSError *fileError = nil;
+        if (![self yg_preallocateFileAtURL:download.partialFileURL length:contentLength error:&fileError]) {
+            [self yg_finishSegmentedDownload:download filePath:nil error:fileError];
+            return;
+        }
+        long long segmentLength = contentLength / segmentCount;
+        for (NSUInteger i = 0; i < segmentCount; i++) {
+            YGDownloadSegment *segment = [[YGDownloadSegment alloc] init];
+            segment.offset = segmentLength * i;
+            segment.length = (i == segmentCount - 1) ? (contentLength - segment.offset) : segmentLength;
+            [segments addObject:segment];
+        }
+        progress = [NSProgress progressWithTotalUnitCount:contentLength];
+    } else {
+        [segments addObject:[[YGDownloadSegment alloc] init]];
+        progress = [NSProgress progressWithTotalUnitCount:MAX(contentLength, -1)];
+    }
+    
+    YG_NETWORKING_LOCK();
+    BOOL finished = download.isFinished;
+    download.probeTask = nil;
+    download.validator = YGRangeValidatorFromResponse(HTTPResponse);
+    download.contentLength = contentLength;
+    download.segments = [segments copy];
+    download.progress = progress;
+    YG_NETWORKING_UNLOCK();
+    if (finished) {
+        return;
+    }
+    
+    for (YGDownloadSegment *segment in segments) {
+        [self yg_startSegment:segment ofDownload:download];
+    }
+}
+
+- (void)yg_startSegment:(YGDownloadSegment *)segment ofDownload:(YGSegmentedDownload *)download {
+    YGRequest *request = download.request;
+    NSMutableURLRequest *urlRequest = [download.urlRequest mutableCopy];
+    if (segment.length > 0) {
+        [urlRequest setValue:[NSString stringWithFormat:@"bytes=%lld-%lld", segment.offset, segment.offset + segment.length - 1] forHTTPHeaderField:@"Range"];
+        if (download.validator) {
+            // a changed resource answers with 200 instead of mixing two versions into one file.
+            [urlRequest setValue:download.validator forHTTPHeaderField:@"If-Range"];
+        }
+    }
+    
+    AFURLSessionManager *sessionManager = [self yg_getSessionManager:request];
+    __weak __typeof(self)weakSelf = self;
+    NSURLSessionDownloadTask *task = [sessionManager downloadTaskWithRequest:urlRequest
+                                                                    progress:^(NSProgress *segmentProgress) {
+        [weakSelf yg_segment:segment ofDownload:download didReceiveLength:segmentProgress.completedUnitCount totalLength:segmentProgress.totalUnitCount];
+    } destination:^NSURL *(NSURL *targetPath, NSURLResponse *response) {
+        return [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString] isDirectory:NO];
+    } completionHandler:^(NSURLResponse *response, NSURL *filePath, NSError *error) {
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        [strongSelf yg_segment:segment ofDownload:download didCompleteWithResponse:response filePath:filePath error:error];
+    }];
+    [task setBindedRequest:request];
+    
+    YG_NETWORKING_LOCK();
+    BOOL finished = download.isFinished;
+    if (!finished) {
+        segment.task = task;
+    }
+    YG_NETWORKING_UNLOCK();
+    
+    if (finished) {
+        [task cancel];
+        return;
+    }
+    [self yg_scheduleTask:task priority:request.priority];
+}
+
+/**
+ 更新分段的进度并回调合并后的总进度.
+ */
+- (void)yg_segment:(YGDownloadSegment *)segment ofDownload:(YGSegmentedDownload *)download didReceiveLength:(int64_t)receivedLength totalLength:(int64_t)totalLength {
+    YG_NETWORKING_LOCK();
+    NSProgress *progress = download.progress;
+    segment.receivedLength = receivedLength;
+    int64_t completedUnitCount = 0;
+    for (YGDownloadSegment *obj in download.segments) {
+        completedUnitCount += obj.receivedLength;
+    }
+    if (segment.length <= 0 && totalLength > 0) {
+        progress.totalUnitCount = totalLength;
+    }
+    progress.completedUnitCount = completedUnitCount;
+    BOOL finished = download.isFinished;
+    YG_NETWORKING_UNLOCK();
+    
+    if (!finished && download.request.progressBlock) {
+        download.request.progressBlock(progress);
+    }
+}
+
+/**
+ 分段结束, 成功时把分段内容写入预分配文件的对应位置, 失败时按 `downloadSegmentRetryCount` 单独重试该分段.
+ */
+- (void)yg_segment:(YGDownloadSegment *)segment
+        ofDownload:(YGSegmentedDownload *)download
+didCompleteWithResponse:(NSURLResponse *)response
+          filePath:(NSURL *)filePath
+             error:(NSError *)error {
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSInteger statusCode = [response isKindOfClass:[NSHTTPURLResponse class]] ? ((NSHTTPURLResponse *)response).statusCode : 0;
+    if (!error) {
+        long long rangeStart = -1;
+        long long rangeEnd = -1;
+        BOOL validResponse = (segment.length > 0) ? (statusCode == 206 && YGContentRangeFromResponse(response, &rangeStart, &rangeEnd) && rangeStart == segment.offset) : (statusCode >= 200 && statusCode < 300);
+        if (!validResponse) {
+            error = YGUnacceptableResponseError(download.request.url, response);
+        } else if (segment.length > 0 && (rangeEnd != segment.offset + segment.length - 1 || YGFileLengthAtURL(filePath) != segment.length)) {
+            // a short body would leave a hole in the preallocated file, a long one would overwrite the next segment.
+            error = YGIncompleteSegmentError(download.request.url);
+        } else if (segment.length > 0) {
+            [self yg_writeFileAtURL:filePath toFileAtURL:download.partialFileURL offset:segment.offset error:&error];
+        }
+    }
+    
+    YG_NETWORKING_LOCK();
+    BOOL finished = download.isFinished;
+    segment.task = nil;
+    NSUInteger finishedSegmentCount = download.finishedSegmentCount;
+    long long contentLength = download.contentLength;
+    if (!finished && !error) {
+        finishedSegmentCount = ++download.finishedSegmentCount;
+    }
+    YG_NETWORKING_UNLOCK();
+    
+    if (finished) {
+        [fileManager removeItemAtURL:filePath error:nil];
+        return;
+    }
+    
+    if (error) {
+        [fileManager removeItemAtURL:filePath error:nil];
+        NSTimeInterval delay = -1;
+        if (segment.retriedCount < download.request.downloadSegmentRetryCount) {
+            delay = [self.segmentRetryPolicy retryDelayForRequest:download.request error:error attempt:segment.retriedCount + 1];
+        }
+        if (delay < 0) {
+            [self yg_finishSegmentedDownload:download filePath:nil error:error];
+            return;
+        }
+        // retry the failed segment alone, the other segments keep running.
+        segment.retriedCount++;
+        [self yg_segment:segment ofDownload:download didReceiveLength:0 totalLength:0];
+        __weak __typeof(self)weakSelf = self;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), yg_request_completion_callback_queue(), ^{
+            [weakSelf yg_startSegment:segment ofDownload:download];
+        });
+        return;
+    }
+    
+    if (segment.length <= 0) {
+        // single connection fallback, the downloaded file is already complete.
+        NSError *moveError = nil;
+        [fileManager removeItemAtURL:download.destination error:nil];
+        [fileManager moveItemAtURL:filePath toURL:download.destination error:&moveError];
+        [self yg_finishSegmentedDownload:download filePath:(moveError ? nil : download.destination) error:moveError];
+        return;
+    }
+    
+    [fileManager removeItemAtURL:filePath error:nil];
+    if (finishedSegmentCount == download.segments.count) {
+        if (YGFileLengthAtURL(download.partialFileURL) != contentLength) {
+            [self yg_finishSegmentedDownload:download filePath:nil error:YGBadServerResponseError(download.request.url)];
+            return;
+        }
+        NSError *moveError = nil;
+        [fileManager removeItemAtURL:download.destination error:nil];
+        [fileManager moveItemAtURL:download.partialFileURL toURL:download.destination error:&moveError];
+        [self yg_finishSegmentedDownload:download filePath:(moveError ? nil : download.destination) error:moveError];
+    }
+}
+
+/**
+ 结束分段下载, 失败时取消其它分段并删除预分配文件, 每个分段下载只会结束一次.
+ */
+- (void)yg_finishSegmentedDownload:(YGSegmentedDownload *)download filePath:(NSURL *)filePath error:(NSError *)error {
+    NSMutableArray<NSURLSessionTask *> *tasksToCancel = [NSMutableArray array];
+    YG_NETWORKING_LOCK();
+    if (download.isFinished) {
+        YG_NETWORKING_UNLOCK();
+        return;
+    }
+    download.finished = YES;
+    if (self.runningDownloads[download.identifier] == download) {
+        [self.runningDownloads removeObjectForKey:download.identifier];
+    }
+    if (download.probeTask) {
+        [tasksToCancel addObject:download.probeTask];
+        download.probeTask = nil;
+    }
+    for (YGDownloadSegment *segment in download.segments) {
+        if (segment.task) {
+            [tasksToCancel addObject:segment.task];
+            segment.task = nil;
+        }
+    }
+    YGCompletionHandler completionHandler = download.completionHandler;
+    download.completionHandler = nil;
+    YG_NETWORKING_UNLOCK();
+    
+    [tasksToCancel makeObjectsPerformSelector:@selector(cancel)];
+    if (error) {
+        [[NSFileManager defaultManager] removeItemAtURL:download.partialFileURL error:nil];
+    }
+    if (completionHandler) {
+        [self yg_performCallbackForRequest:download.request block:^{
+            completionHandler(filePath, error);
+        }];
+    }
+}
+
+- (BOOL)yg_preallocateFileAtURL:(NSURL *)fileURL length:(long long)length error:(NSError *__autoreleasing *)error {
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    [fileManager removeItemAtURL:fileURL error:nil];
+    if (![fileManager createFileAtPath:fileURL.path contents:nil attributes:nil]) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileWriteUnknownError userInfo:@{NSFilePathErrorKey: fileURL.path}];
+        }
+        return NO;
+    }
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingToURL:fileURL error:error];
+    if (!fileHandle) {
+        return NO;
+    }
+    [fileHandle truncateFileAtOffset:(unsigned long long)length];
+    [fileHandle closeFile];
+    return YES;
+}
+
+/**
+ 把分段的临时文件按块写入预分配文件的 `offset` 位置.
+ */
+- (BOOL)yg_writeFileAtURL:(NSURL *)fileURL toFileAtURL:(NSURL *)targetURL offset:(long long)offset error:(NSError *__autoreleasing *)error {
+    NSFileHandle *readingHandle = [NSFileHandle fileHandleForReadingFromURL:fileURL error:error];
+    NSFileHandle *writingHandle = readingHandle ? [NSFileHandle fileHandleForWritingToURL:targetURL error:error] : nil;
+    BOOL success = (writingHandle != nil);
+    if (success) {
+        @try {
+            [writingHandle seekToFileOffset:(unsigned long long)offset];
+            while (YES) {
+                @autoreleasepool {
+                    NSData *chunk = [readingHandle readDataOfLength:YGFileCopyChunkLength];
+                    if (chunk.length == 0) {
+                        break;
+                    }
+                    [writingHandle writeData:chunk];
+                }
+            }
+        } @catch (NSException *exception) {
+            success = NO;
+            if (error) {
+                *error = [NSError errorWithDomain:NSCocoaErrorDomain
+                                             code:NSFileWriteUnknownError
+                                         userInfo:@{NSLocalizedDescriptionKey: exception.reason ?: @"",
+                                                    NSFilePathErrorKey: targetURL.path ?: @""}];
+            }
+        }
+    }
+    [readingHandle closeFile];
+    [writingHandle closeFile];
+    return success;
+}
+
+#pragma mark - File Upload
+
+/**
+ 以文件作为请求体上传, 由 NSURLSession 从文件流式读取, 内存占用与文件大小无关.
+ */
+- (void)yg_fileUploadTaskWithRequest:(YGRequest *)request
+                   completionHandler:(YGCompletionHandler)completionHandler {
+    NSMutableURLRequest *urlRequest = [NSMutableURLRequest requestWithURL:[self yg_URLForRequest:request]];
+    urlRequest.HTTPMethod = [self yg_HTTPMethodForRequest:request];
+    [self yg_processURLRequest:urlRequest byYGRequest:request];
+    if (![urlRequest valueForHTTPHeaderField:@"Content-Type"]) {
+        [urlRequest setValue:@"application/octet-stream" forHTTPHeaderField:@"Content-Type"];
+    }
+    
+    AFURLSessionManager *sessionManager = [self yg_getSessionManager:request];
+    __weak __typeof(self)weakSelf = self;
+    NSURLSessionUploadTask *uploadTask = [sessionManager uploadTaskWithRequest:urlRequest
+                                                                      fromFile:request.uploadFileURL
+                                                                      progress:request.progressBlock
+                                                             completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        [strongSelf yg_removeIdentifierForRequest:request];
+        [strongSelf yg_processResponse:response
+                                object:responseObject
+                                 error:error
+                               request:request
+                     completionHandler:completionHandler];
+    }];
+    
+    [uploadTask setBindedRequest:request];
+    [self yg_setIdentifierForReqeust:request task:uploadTask sessionManager:sessionManager];
+    [self yg_scheduleTask:uploadTask priority:request.priority];
+}
+
+#pragma mark - Resumable Upload
+
+/**
+ 可续传上传, 有保存的上传地址时先通过 HEAD 协商偏移量, 否则 POST 创建上传, 然后从偏移量开始分块 PATCH.
+ NOTE: 可续传上传使用 `U` 开头的固定 identifier, 失败时保留上传地址, 重试或重新发送时从服务器记录的偏移量继续上传.
+ */
+- (void)yg_resumableUploadTaskWithRequest:(YGRequest *)request
+                        completionHandler:(YGCompletionHandler)completionHandler {
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:request.uploadFileURL.path error:nil];
+    if (!attributes) {
+        [self yg_releaseCircuitProbeForRequest:request];
+        if (completionHandler) {
+            NSError *error = [NSError errorWithDomain:NSCocoaErrorDomain
+                                                 code:NSFileReadNoSuchFileError
+                                             userInfo:@{NSURLErrorKey: request.uploadFileURL ?: [NSNull null]}];
+            dispatch_async(yg_request_completion_callback_queue(), ^{
+                completionHandler(nil, error);
+            });
+        }
+        return;
+    }
+    
+    YGResumableUpload *upload = [[YGResumableUpload alloc] init];
+    upload.request = request;
+    upload.fileURL = request.uploadFileURL;
+    upload.fileLength = (long long)attributes.fileSize;
+    upload.completionHandler = completionHandler;
+    upload.progress = [NSProgress progressWithTotalUnitCount:upload.fileLength];
+    
+    NSURL *uploadURL = [self.uploadResumeStore uploadURLForURL:request.url fileURL:upload.fileURL];
+    
+    upload.identifier = [NSString stringWithFormat:@"U%lu", atomic_fetch_add_explicit(&_resumableUploadCount, 1, memory_order_relaxed) + 1];
+    YG_NETWORKING_LOCK();
+    upload.uploadURL = uploadURL;
+    self.runningUploads[upload.identifier] = upload;
+    YG_NETWORKING_UNLOCK();
+    
+    [request setValue:upload.identifier forKey:@"_identifier"];
+    if (uploadURL) {
+        [self yg_negotiateOffsetForUpload:upload];
+    } else {
+        [self yg_createUpload:upload];
+    }
+}
+
+/**
+ POST 创建上传, 服务器通过 `Location` 返回上传地址.
+ */
+- (void)yg_createUpload:(YGResumableUpload *)upload {
+    YGRequest *request = upload.request;
+    NSMutableURLRequest *urlRequest = [self yg_tusRequestWithURL:[self yg_URLForRequest:request] method:@"POST" forUpload:upload];
+    [urlRequest setValue:[NSString stringWithFormat:@"%lld", upload.fileLength] forHTTPHeaderField:@"Upload-Length"];
+    NSData *fileName = [upload.fileURL.lastPathComponent dataUsingEncoding:NSUTF8StringEncoding];
+    if (fileName.length > 0) {
+        [urlRequest setValue:[NSString stringWithFormat:@"filename %@", [fileName base64EncodedStringWithOptions:0]] forHTTPHeaderField:@"Upload-Metadata"];
+    }
+    
+    __weak __typeof(self)weakSelf = self;
+    [self yg_sendTusRequest:urlRequest bodyFileURL:nil forUpload:upload completionHandler:^(NSHTTPURLResponse *response, id responseObject, NSError *error) {
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        NSString *location = YGHTTPHeaderValueFromResponse(response, @"Location");
+        NSURL *uploadURL = location.length > 0 ? [NSURL URLWithString:location relativeToURL:response.URL].absoluteURL : nil;
+        if (error || response.statusCode != 201 || !uploadURL) {
+            [strongSelf yg_finishResumableUpload:upload responseObject:nil error:error ?: YGBadServerResponseError(request.url)];
+            return;
+        }
+        
+        [strongSelf.uploadResumeStore setUploadURL:uploadURL forURL:request.url fileURL:upload.fileURL];
+        [strongSelf yg_upload:upload didMoveToURL:uploadURL offset:0];
+    }];
+}
+
+/**
+ HEAD 上传地址获取服务器已经接收的偏移量, 上传地址失效时重新创建上传.
+ */
+- (void)yg_negotiateOffsetForUpload:(YGResumableUpload *)upload {
+    YGRequest *request = upload.request;
+    NSURL *uploadURL = upload.uploadURL;
+    NSMutableURLRequest *urlRequest = [self yg_tusRequestWithURL:uploadURL method:@"HEAD" forUpload:upload];
+    urlRequest.cachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+    
+    __weak __typeof(self)weakSelf = self;
+    [self yg_sendTusRequest:urlRequest bodyFileURL:nil forUpload:upload completionHandler:^(NSHTTPURLResponse *response, id responseObject, NSError *error) {
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        NSInteger statusCode = response.statusCode;
+        if (statusCode == 404 || statusCode == 410 || statusCode == 403) {
+            // the server dropped the upload, start over.
+            [strongSelf.uploadResumeStore removeUploadURLForURL:request.url fileURL:upload.fileURL];
+            [strongSelf yg_createUpload:upload];
+            return;
+        }
+        
+        NSString *offsetString = YGHTTPHeaderValueFromResponse(response, @"Upload-Offset");
+        if (error || !offsetString) {
+            [strongSelf yg_finishResumableUpload:upload responseObject:nil error:error ?: YGBadServerResponseError(request.url)];
+            return;
+        }
+        [strongSelf yg_upload:upload didMoveToURL:uploadURL offset:offsetString.longLongValue];
+    }];
+}
+
+/**
+ 从偏移量开始上传下一块, 每块先按块复制到临时文件, 再以文件作为请求体 PATCH.
+ */
+- (void)yg_upload:(YGResumableUpload *)upload didMoveToURL:(NSURL *)uploadURL offset:(long long)offset {
+    YGRequest *request = upload.request;
+    YG_NETWORKING_LOCK();
+    upload.uploadURL = uploadURL;
+    upload.offset = offset;
+    upload.progress.completedUnitCount = offset;
+    NSProgress *progress = upload.progress;
+    YG_NETWORKING_UNLOCK();
+    [request setValue:uploadURL forKey:@"_resumableUploadURL"];
+    YG_NETWORKING_SAFE_BLOCK(request.progressBlock, progress);
+    
+    if (offset >= upload.fileLength) {
+        // the server already had the whole file, there is no final PATCH response to deliver.
+        [self yg_completeUpload:upload response:nil data:nil];
+        return;
+    }
+    
+    long long chunkLength = MIN((long long)MAX(request.uploadChunkSize, 1), upload.fileLength - offset);
+    NSURL *chunkFileURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString] isDirectory:NO];
+    NSError *chunkError = nil;
+    if (![self yg_copyFileAtURL:upload.fileURL range:NSMakeRange((NSUInteger)offset, (NSUInteger)chunkLength) toURL:chunkFileURL error:&chunkError]) {
+        [self yg_finishResumableUpload:upload responseObject:nil error:chunkError];
+        return;
+    }
+    
+    NSMutableURLRequest *urlRequest = [self yg_tusRequestWithURL:uploadURL method:@"PATCH" forUpload:upload];
+    [urlRequest setValue:@"application/offset+octet-stream" forHTTPHeaderField:@"Content-Type"];
+    [urlRequest setValue:[NSString stringWithFormat:@"%lld", offset] forHTTPHeaderField:@"Upload-Offset"];
+    
+    __weak __typeof(self)weakSelf = self;
+    [self yg_sendTusRequest:urlRequest bodyFileURL:chunkFileURL forUpload:upload completionHandler:^(NSHTTPURLResponse *response, id responseObject, NSError *error) {
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        [[NSFileManager defaultManager] removeItemAtURL:chunkFileURL error:nil];
+        if (response.statusCode == 409) {
+            // the offset does not match the server's, negotiate it again.
+            [strongSelf yg_negotiateOffsetForUpload:upload];
+            return;
+        }
+        
+        NSString *offsetString = YGHTTPHeaderValueFromResponse(response, @"Upload-Offset");
+        if (error || !offsetString || offsetString.longLongValue <= offset) {
+            [strongSelf yg_finishResumableUpload:upload responseObject:nil error:error ?: YGBadServerResponseError(request.url)];
+            return;
+        }
+        long long newOffset = offsetString.longLongValue;
+        if (newOffset >= upload.fileLength) {
+            [strongSelf yg_upload:upload didSendLength:newOffset];
+            [strongSelf yg_completeUpload:upload response:response data:responseObject];
+            return;
+        }
+        [strongSelf yg_upload:upload didMoveToURL:uploadURL offset:newOffset];
+    }];
+}
+
+/**
+ 上传的文件已经全部被服务器接收, 按 `responseSerializerType` 解析最后一个 PATCH 请求的响应后结束上传.
+ */
+- (void)yg_completeUpload:(YGResumableUpload *)upload response:(NSHTTPURLResponse *)response data:(NSData *)data {
+    YGRequest *request = upload.request;
+    [self.uploadResumeStore removeUploadURLForURL:request.url fileURL:upload.fileURL];
+    if (!response) {
+        [self yg_finishResumableUpload:upload responseObject:nil error:nil];
+        return;
+    }
+    
+    __weak __typeof(self)weakSelf = self;
+    [self yg_processResponse:response object:data error:nil request:request completionHandler:^(id responseObject, NSError *error) {
+        [weakSelf yg_finishResumableUpload:upload responseObject:responseObject error:error];
+    }];
+}
+
+- (NSMutableURLRequest *)yg_tusRequestWithURL:(NSURL *)URL method:(NSString *)method forUpload:(YGResumableUpload *)upload {
+    NSMutableURLRequest *urlRequest = [NSMutableURLRequest requestWithURL:URL];
+    urlRequest.HTTPMethod = method;
+    [self yg_processURLRequest:urlRequest byYGRequest:upload.request];
+    [urlRequest setValue:@"1.0.0" forHTTPHeaderField:@"Tus-Resumable"];
+    return urlRequest;
+}
+
+/**
+ 发送可续传上传的一个请求, 任务经过调度器排队, 上传结束 (包括被取消) 后不再发送.
+ */
+- (void)yg_sendTusRequest:(NSURLRequest *)urlRequest
+              bodyFileURL:(NSURL *)bodyFileURL
+                forUpload:(YGResumableUpload *)upload
+        completionHandler:(void (^)(NSHTTPURLResponse *response, id responseObject, NSError *error))completionHandler {
+    YGRequest *request = upload.request;
+    AFURLSessionManager *sessionManager = [self yg_getSessionManager:request];
+    void (^taskCompletionHandler)(NSURLResponse *, id, NSError *) = ^(NSURLResponse *response, id responseObject, NSError *error) {
+        completionHandler([response isKindOfClass:[NSHTTPURLResponse class]] ? (NSHTTPURLResponse *)response : nil, responseObject, error);
+    };
+    
+    NSURLSessionTask *task = nil;
+    if (bodyFileURL) {
+        long long offset = [[urlRequest valueForHTTPHeaderField:@"Upload-Offset"] longLongValue];
+        __weak __typeof(self)weakSelf = self;
+        task = [sessionManager uploadTaskWithRequest:urlRequest fromFile:bodyFileURL progress:^(NSProgress *uploadProgress) {
+            [weakSelf yg_upload:upload didSendLength:offset + uploadProgress.completedUnitCount];
+        } completionHandler:taskCompletionHandler];
+    } else {
+        task = [sessionManager dataTaskWithRequest:urlRequest uploadProgress:nil downloadProgress:nil completionHandler:taskCompletionHandler];
+    }
+    [task setBindedRequest:request];
+    
+    YG_NETWORKING_LOCK();
+    BOOL finished = upload.isFinished;
+    if (!finished) {
+        upload.task = task;
+    }
+    YG_NETWORKING_UNLOCK();
+    
+    if (finished) {
+        [task cancel];
+        return;
+    }
+    [self yg_scheduleTask:task priority:request.priority];
+}
+
+- (void)yg_upload:(YGResumableUpload *)upload didSendLength:(int64_t)sentLength {
+    YG_NETWORKING_LOCK();
+    upload.progress.completedUnitCount = sentLength;
+    NSProgress *progress = upload.progress;
+    BOOL finished = upload.isFinished;
+    YG_NETWORKING_UNLOCK();
+    
+    if (!finished) {
+        YG_NETWORKING_SAFE_BLOCK(upload.request.progressBlock, progress);
+    }
+}
+
+/**
+ 结束可续传上传, 每个上传只会结束一次. 成功时的响应对象为最后一个 PATCH 请求解析后的响应.
+ */
+- (void)yg_finishResumableUpload:(YGResumableUpload *)upload responseObject:(id)responseObject error:(NSError *)error {
+    YG_NETWORKING_LOCK();
+    if (upload.isFinished) {
+        YG_NETWORKING_UNLOCK();
+        return;
+    }
+    upload.finished = YES;
+    if (self.runningUploads[upload.identifier] == upload) {
+        [self.runningUploads removeObjectForKey:upload.identifier];
+    }
+    NSURLSessionTask *task = upload.task;
+    upload.task = nil;
+    YGCompletionHandler completionHandler = upload.completionHandler;
+    upload.completionHandler = nil;
+    YG_NETWORKING_UNLOCK();
+    
+    [task cancel];
+    if (completionHandler) {
+        [self yg_performCallbackForRequest:upload.request block:^{
+            completionHandler(responseObject, error);
+        }];
+    }
+}
+
+/**
+ 把文件中 `range` 范围的内容按块复制到新文件.
+ */
+- (BOOL)yg_copyFileAtURL:(NSURL *)fileURL range:(NSRange)range toURL:(NSURL *)targetURL error:(NSError *__autoreleasing *)error {
+    NSFileHandle *readingHandle = [NSFileHandle fileHandleForReadingFromURL:fileURL error:error];
+    if (!readingHandle) {
+        return NO;
+    }
+    [[NSFileManager defaultManager] createFileAtPath:targetURL.path contents:nil attributes:nil];
+    NSFileHandle *writingHandle = [NSFileHandle fileHandleForWritingToURL:targetURL error:error];
+    BOOL success = (writingHandle != nil);
+    if (success) {
+        @try {
+            [readingHandle seekToFileOffset:range.location];
+            NSUInteger remainingLength = range.length;
+            while (remainingLength > 0) {
+                @autoreleasepool {
+                    NSData *chunk = [readingHandle readDataOfLength:MIN(remainingLength, YGFileCopyChunkLength)];
+                    if (chunk.length == 0) {
+                        break;
+                    }
+                    [writingHandle writeData:chunk];
+                    remainingLength -= chunk.length;
+                }
+            }
+            success = (remainingLength == 0);
+        } @catch (NSException *exception) {
+            success = NO;
+        }
+        if (!success && error) {
+            *error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadUnknownError userInfo:@{NSURLErrorKey: fileURL}];
+        }
+    }
+    [readingHandle closeFile];
+    [writingHandle closeFile];
+    return success;
+}
+
+#pragma mark - Scheduler
+
+/**
+ 将任务放入调度器, 有空闲的并发名额 (以及主机的并发名额) 时立即启动, 否则按优先级排队.
+ NOTE: `kYGRequestPriorityCritical` 的任务不受 `maxConcurrentRequestCount` 和 `concurrencyLimiter` 限制, 总是立即启动.
+ */
+- (void)yg_scheduleTask:(NSURLSessionTask *)task priority:(YGRequestPriority)priority {
+    if (priority < kYGRequestPriorityCritical || priority > kYGRequestPriorityBackground) {
+        priority = kYGRequestPriorityNormal;
+    }
+    task.priority = YGTaskPriorityFromRequestPriority(priority);
+    task.scheduleTimestamp = [NSProcessInfo processInfo].systemUptime;
+    
+    BOOL shouldResume = NO;
+    YG_NETWORKING_LOCK();
+    // the first task of a probe request carries the probe token, its result decides a half-open host.
+    YGRequest *request = task.bindedRequest;
+    if (request.circuitProbeToken != 0) {
+        task.circuitProbeToken = request.circuitProbeToken;
+        request.circuitProbeToken = 0;
+    }
+    if (priority == kYGRequestPriorityCritical ||
+        (self.runningTaskCount < _maxConcurrentRequestCount && [self yg_acquireLimiterSlotForTask:task])) {
+        self.runningTaskCount++;
+        shouldResume = YES;
+    } else {
+        [self.pendingLanes[priority] addObject:task];
+    }
+    YG_NETWORKING_UNLOCK();
+    
+    if (shouldResume) {
+        [self yg_resumeTask:task];
+    }
+}
+
+/**
+ 任务结束 (包括在排队中被取消) 时释放并发名额并启动等待中的任务, 由 session 的 `taskDidComplete` 回调调用.
+ */
+- (void)yg_taskDidComplete:(NSURLSessionTask *)task {
+    // a task that never entered the scheduler, e.g. a coalescing task that lost the race, holds no slot.
+    if (task.scheduleTimestamp <= 0) return;
+    
+    NSMutableArray<NSURLSessionTask *> *tasksToResume = [NSMutableArray array];
+    YG_NETWORKING_LOCK();
+    BOOL wasPending = NO;
+    for (NSMutableOrderedSet<NSURLSessionTask *> *lane in self.pendingLanes) {
+        if ([lane containsObject:task]) {
+            [lane removeObject:task];
+            wasPending = YES;
+            break;
         }
     }
+    if (!wasPending && self.runningTaskCount > 0) {
+        self.runningTaskCount--;
+    }
+    [self yg_dequeuePendingTasks:tasksToResume];
+    YG_NETWORKING_UNLOCK();
+    
+    // resumed through the scheduler so the queue wait and the latency seen by the limiter are measured.
+    for (NSURLSessionTask *pendingTask in tasksToResume) {
+        [self yg_resumeTask:pendingTask];
+    }
 }
 
-- (void)addSSLPinningCert:(NSData *)cert {
-    NSParameterAssert(cert);
+/**
+ 启动并发名额变化后可以运行的等待中的任务.
+ */
+- (void)yg_resumePendingTasks {
+    NSMutableArray<NSURLSessionTask *> *tasksToResume = [NSMutableArray array];
+    YG_NETWORKING_LOCK();
+    [self yg_dequeuePendingTasks:tasksToResume];
+    YG_NETWORKING_UNLOCK();
     
-    NSMutableSet *certSet;
-    if (self.securitySessionManager.securityPolicy.pinnedCertificates.count > 0) {
-        certSet = [NSMutableSet setWithSet:self.securitySessionManager.securityPolicy.pinnedCertificates];
-    } else {
-        certSet = [NSMutableSet set];
+    for (NSURLSessionTask *pendingTask in tasksToResume) {
+        [self yg_resumeTask:pendingTask];
     }
-    [certSet addObject:cert];
-    [self.securitySessionManager.securityPolicy setPinnedCertificates:certSet];
 }
 
-- (void)addTwowayAuthenticationPKCS12:(NSData *)p12 keyPassword:(NSString *)password {
-    NSParameterAssert(p12);
-    NSParameterAssert(password);
-    
-    __weak __typeof(self)weakSelf = self;
-    [self.securitySessionManager setSessionDidReceiveAuthenticationChallengeBlock:^NSURLSessionAuthChallengeDisposition(NSURLSession * _Nonnull session, NSURLAuthenticationChallenge * _Nonnull challenge, NSURLCredential *__autoreleasing  _Nullable * _Nullable credential) {
-        __strong __typeof(weakSelf)strongSelf = weakSelf;
-        NSURLSessionAuthChallengeDisposition disposition = NSURLSessionAuthChallengePerformDefaultHandling;
-        if ([challenge.protectionSpace.authenticationMethod isEqualToString:NSURLAuthenticationMethodServerTrust]) {
-            // Server Trust (SSL Pinning)
-            if ([strongSelf.securitySessionManager.securityPolicy evaluateServerTrust:challenge.protectionSpace.serverTrust forDomain:challenge.protectionSpace.host]) {
-                *credential = [NSURLCredential credentialForTrust:challenge.protectionSpace.serverTrust];
-                if (*credential) {
-                    disposition = NSURLSessionAuthChallengeUseCredential;
-                } else {
-                    disposition = NSURLSessionAuthChallengePerformDefaultHandling;
-                }
-            } else {
-                disposition = NSURLSessionAuthChallengeCancelAuthenticationChallenge;
-            }
-        } else if ([challenge.protectionSpace.authenticationMethod isEqualToString:NSURLAuthenticationMethodClientCertificate]) {
-            // Client Certificate (Two-way Authentication)
-            SecIdentityRef identity = NULL;
-            SecTrustRef trust = NULL;
-            
-            if (YGExtractIdentityAndTrustFromPKCS12((__bridge CFDataRef)p12, (__bridge CFStringRef)password, &identity, &trust) == 0) {
-                SecCertificateRef certificate = NULL;
-                SecIdentityCopyCertificate(identity, &certificate);
-                
-                const void *certs[] = { certificate };
-                CFArrayRef certArray = CFArrayCreate(kCFAllocatorDefault, certs, 1, NULL);
-                *credential = [NSURLCredential credentialWithIdentity:identity certificates:(__bridge NSArray *)certArray persistence:NSURLCredentialPersistencePermanent];
-                if (*credential) {
-                    disposition = NSURLSessionAuthChallengeUseCredential;
-                } else {
-                    disposition = NSURLSessionAuthChallengePerformDefaultHandling;
-                }
-                
-                if (certificate) {
-                    CFRelease(certificate);
-                }
-                if (certArray) {
-                    CFRelease(certArray);
+/**
+ 按优先级从高到低取出等待中的任务直到并发名额用完, 需要在持有 `_lock` 的情况下调用.
+ 设置了 `concurrencyLimiter` 时跳过主机并发名额已经用完的任务, 后面发往其他主机的任务可以先启动.
+ */
+- (void)yg_dequeuePendingTasks:(NSMutableArray<NSURLSessionTask *> *)tasksToResume {
+    if (!_concurrencyLimiter) {
+        while (self.runningTaskCount < _maxConcurrentRequestCount) {
+            NSURLSessionTask *task = nil;
+            for (NSMutableOrderedSet<NSURLSessionTask *> *lane in self.pendingLanes) {
+                if (lane.count > 0) {
+                    task = lane.firstObject;
+                    [lane removeObjectAtIndex:0];
+                    break;
                 }
             }
-            
-            if (identity) {
-                CFRelease(identity);
+            if (!task) {
+                break;
             }
-            if (trust) {
-                CFRelease(trust);
+            self.runningTaskCount++;
+            [tasksToResume addObject:task];
+        }
+        return;
+    }
+    
+    NSMutableSet<NSString *> *blockedHosts = [NSMutableSet set];
+    for (NSMutableOrderedSet<NSURLSessionTask *> *lane in self.pendingLanes) {
+        NSUInteger index = 0;
+        while (index < lane.count && self.runningTaskCount < _maxConcurrentRequestCount) {
+            NSURLSessionTask *task = lane[index];
+            NSString *host = task.originalRequest.URL.host.lowercaseString;
+            if ((host && [blockedHosts containsObject:host]) || ![self yg_acquireLimiterSlotForTask:task]) {
+                if (host) {
+                    [blockedHosts addObject:host];
+                }
+                index++;
+                continue;
             }
-        } else {
-            disposition = NSURLSessionAuthChallengePerformDefaultHandling;
+            [lane removeObjectAtIndex:index];
+            self.runningTaskCount++;
+            [tasksToResume addObject:task];
         }
-        
-        return disposition;
-    }];
+    }
 }
 
-#pragma mark - Private Methods
+/**
+ 从 `concurrencyLimiter` 获取任务主机的并发名额, 需要在持有 `_lock` 的情况下调用.
+ 
+ @return 没有设置 `concurrencyLimiter` 或者获取成功时返回 `YES`.
+ */
+- (BOOL)yg_acquireLimiterSlotForTask:(NSURLSessionTask *)task {
+    YGConcurrencyLimiter *limiter = _concurrencyLimiter;
+    if (!limiter) {
+        return YES;
+    }
+    if (![limiter tryAcquireForHost:task.originalRequest.URL.host]) {
+        return NO;
+    }
+    task.bindedLimiter = limiter;
+    return YES;
+}
 
-- (void)yg_dataTaskWithRequest:(YGRequest *)request
-             completionHandler:(YGCompletionHandler)completionHandler {
-    NSString *httpMethod = nil;
-    static dispatch_once_t onceToken;
-    static NSArray *httpMethodArray = nil;
-    dispatch_once(&onceToken, ^{
-        httpMethodArray = @[@"GET", @"POST", @"HEAD", @"DELETE", @"PUT", @"PATCH"];
-    });
-    if (request.httpMethod >= 0 && request.httpMethod < httpMethodArray.count) {
-        httpMethod = httpMethodArray[request.httpMethod];
+- (void)yg_resumeTask:(NSURLSessionTask *)task {
+    task.resumeTimestamp = [NSProcessInfo processInfo].systemUptime;
+    YGRequestHedge *hedge = task.bindedHedge;
+    BOOL isHedgeTask = (hedge && hedge.primaryTask != task);
+    if (task.scheduleTimestamp > 0 && !isHedgeTask) {
+        [task.bindedRequest.metrics setValue:@(task.resumeTimestamp - task.scheduleTimestamp) forKey:@"_queueWaitDuration"];
     }
-    NSAssert(httpMethod.length > 0, @"The HTTP method not found.");
+    [task resume];
     
-    AFURLSessionManager *sessionManager = [self yg_getSessionManager:request];
-    AFHTTPRequestSerializer *requestSerializer = [self yg_getRequestSerializer:request];
-    
-    NSError *serializationError = nil;
-    NSMutableURLRequest *urlRequest = [requestSerializer requestWithMethod:httpMethod
-                                                                 URLString:request.url
-                                                                parameters:request.parameters
-                                                                     error:&serializationError];
+    if (hedge && !isHedgeTask) {
+        // the hedge delay counts from the start of the original task, not from the time it was queued.
+        [self yg_armHedge:hedge resumeTimestamp:task.resumeTimestamp];
+    }
+}
+
+#pragma mark - Circuit Breaker
+
+/**
+ 将任务的结果记录到熔断器, 5xx 响应和服务端故障导致的传输错误记为失败, 其它有响应的结果 (包括 4xx 和解析错误) 记为成功.
+ 取消和设备离线导致的错误不统计, 只释放半开状态的探测名额.
+ NOTE: 半开状态下只有携带探测令牌的任务的结果会改变主机的状态.
+ */
+- (void)yg_recordCircuitBreakerResultForTask:(NSURLSessionTask *)task error:(NSError *)error {
+    YGCircuitBreaker *circuitBreaker = self.circuitBreaker;
+    NSString *host = task.originalRequest.URL.host;
+    if (!circuitBreaker || host.length == 0) return;
     
-    if (serializationError) {
-        if (completionHandler) {
-            dispatch_async(yg_request_completion_callback_queue(), ^{
-                completionHandler(nil, serializationError);
-            });
-        }
+    NSUInteger probeToken = task.circuitProbeToken;
+    NSTimeInterval resumeTimestamp = task.resumeTimestamp;
+    BOOL isCancelled = ([error.domain isEqualToString:NSURLErrorDomain] && error.code == NSURLErrorCancelled);
+    // an offline device says nothing about the host, it must not open every host it called.
+    if (resumeTimestamp <= 0 || isCancelled || YGIsOfflineError(error)) {
+        [circuitBreaker recordCancellationForHost:host probeToken:probeToken];
         return;
     }
     
-    [self yg_processURLRequest:urlRequest byYGRequest:request];
-    
-    NSURLSessionDataTask *dataTask = nil;
-    __weak __typeof(self)weakSelf = self;
-    dataTask = [sessionManager dataTaskWithRequest:urlRequest
-                                    uploadProgress:nil
-                                  downloadProgress:nil
-                                 completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
-                                     __strong __typeof(weakSelf)strongSelf = weakSelf;
-                                     [strongSelf yg_processResponse:response
-                                                             object:responseObject
-                                                              error:error
-                                                            request:request
-                                                  completionHandler:completionHandler];
-                                 }];
-    
-    [self yg_setIdentifierForReqeust:request taskIdentifier:dataTask.taskIdentifier sessionManager:sessionManager];
-    [dataTask setBindedRequest:request];
-    [dataTask resume];
+    NSTimeInterval latency = [NSProcessInfo processInfo].systemUptime - resumeTimestamp;
+    NSInteger statusCode = [task.response isKindOfClass:[NSHTTPURLResponse class]] ? ((NSHTTPURLResponse *)task.response).statusCode : 0;
+    if (statusCode >= 500 || YGIsServerFailureError(error)) {
+        [circuitBreaker recordFailureForHost:host latency:latency probeToken:probeToken];
+    } else {
+        [circuitBreaker recordSuccessForHost:host latency:latency probeToken:probeToken];
+    }
 }
 
-- (void)yg_uploadTaskWithRequest:(YGRequest *)request
-               completionHandler:(YGCompletionHandler)completionHandler {
+/**
+ 请求在进入调度器之前结束时释放它持有的探测令牌, 否则半开状态的主机要等到探测超时才能再次放行请求.
+ */
+- (void)yg_releaseCircuitProbeForRequest:(YGRequest *)request {
+    NSUInteger probeToken = request.circuitProbeToken;
+    if (probeToken == 0) return;
     
-    AFURLSessionManager *sessionManager = [self yg_getSessionManager:request];
-    AFHTTPRequestSerializer *requestSerializer = [self yg_getRequestSerializer:request];
+    request.circuitProbeToken = 0;
+    [self.circuitBreaker recordCancellationForHost:[self yg_URLForRequest:request].host probeToken:probeToken];
+}
+
+#pragma mark - Hedging
+
+/**
+ 原始任务启动后, 经过 `hedgingPolicy` 的对冲延迟发送对冲任务.
+ */
+- (void)yg_armHedge:(YGRequestHedge *)hedge resumeTimestamp:(NSTimeInterval)resumeTimestamp {
+    YG_NETWORKING_LOCK();
+    hedge.primaryResumeTimestamp = resumeTimestamp;
+    YG_NETWORKING_UNLOCK();
     
-    __block NSError *serializationError = nil;
-    NSMutableURLRequest *urlRequest = [requestSerializer multipartFormRequestWithMethod:@"POST"
-                                                                              URLString:request.url
-                                                                             parameters:request.parameters
-                                                              constructingBodyWithBlock:^(id<AFMultipartFormData> formData) {
-        [request.uploadFormDatas enumerateObjectsUsingBlock:^(YGUploadFormData *obj, NSUInteger idx, BOOL *stop) {
-            if (obj.fileData) {
-                if (obj.fileName && obj.mimeType) {
-                    [formData appendPartWithFileData:obj.fileData name:obj.name fileName:obj.fileName mimeType:obj.mimeType];
-                } else {
-                    [formData appendPartWithFormData:obj.fileData name:obj.name];
-                }
-            } else if (obj.fileURL) {
-                NSError *fileError = nil;
-                if (obj.fileName && obj.mimeType) {
-                    [formData appendPartWithFileURL:obj.fileURL name:obj.name fileName:obj.fileName mimeType:obj.mimeType error:&fileError];
-                } else {
-                    [formData appendPartWithFileURL:obj.fileURL name:obj.name error:&fileError];
-                }
-                if (fileError) {
-                    serializationError = fileError;
-                    *stop = YES;
-                }
-            }
-        }];
-    } error:&serializationError];
+    NSTimeInterval delay = [hedge.policy hedgeDelayForHost:hedge.urlRequest.URL.host];
+    __weak __typeof(self)weakSelf = self;
+    __weak YGRequestHedge *weakHedge = hedge;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), yg_request_completion_callback_queue(), ^{
+        [weakSelf yg_launchHedge:weakHedge];
+    });
+}
+
+/**
+ 原始任务还在运行并且对冲预算足够时发送对冲任务.
+ */
+- (void)yg_launchHedge:(YGRequestHedge *)hedge {
+    if (!hedge) return;
     
-    if (serializationError) {
-        if (completionHandler) {
-            dispatch_async(yg_request_completion_callback_queue(), ^{
-                completionHandler(nil, serializationError);
-            });
-        }
-        return;
+    YG_NETWORKING_LOCK();
+    BOOL shouldLaunch = !hedge.finished && !hedge.cancelled && !hedge.hedgeTask && hedge.runningCount > 0 && [hedge.policy.budget tryWithdraw];
+    if (shouldLaunch) {
+        // reserved before the task exists, so a failed original task waits for the hedge.
+        hedge.runningCount++;
     }
+    YG_NETWORKING_UNLOCK();
+    if (!shouldLaunch) return;
     
-    [self yg_processURLRequest:urlRequest byYGRequest:request];
-    
-    NSURLSessionUploadTask *uploadTask = nil;
-    __weak __typeof(self)weakSelf = self;
-    uploadTask = [sessionManager uploadTaskWithStreamedRequest:urlRequest
-                                                      progress:request.progressBlock
-                                             completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
-        __strong __typeof(weakSelf)strongSelf = weakSelf;
-        [strongSelf yg_processResponse:response
-                                object:responseObject
-                                 error:error
-                               request:request
-                     completionHandler:completionHandler];
-    }];
+    YGRequest *request = hedge.request;
+    NSURLSessionDataTask *hedgeTask = [self yg_dataTaskWithURLRequest:hedge.urlRequest
+                                                               request:request
+                                                                stream:nil
+                                                                 hedge:hedge
+                                                        sessionManager:hedge.sessionManager
+                                                     completionHandler:hedge.completionHandler];
+    YG_NETWORKING_LOCK();
+    hedge.hedgeTask = hedgeTask;
+    BOOL abandoned = hedge.finished || hedge.cancelled;
+    YG_NETWORKING_UNLOCK();
     
-    [self yg_setIdentifierForReqeust:request taskIdentifier:uploadTask.taskIdentifier sessionManager:sessionManager];
-    [uploadTask setBindedRequest:request];
-    [uploadTask resume];
+    [request.metrics setValue:@YES forKey:@"_hedged"];
+    // scheduled even when abandoned, the scheduler accounts for every task that completes.
+    [self yg_scheduleTask:hedgeTask priority:request.priority];
+    if (abandoned) {
+        [hedgeTask cancel];
+    }
 }
 
-- (void)yg_downloadTaskWithRequest:(YGRequest *)request
-                 completionHandler:(YGCompletionHandler)completionHandler {
-    NSMutableURLRequest *urlRequest = [NSMutableURLRequest requestWithURL:[NSURL URLWithString:request.url]];
-    [self yg_processURLRequest:urlRequest byYGRequest:request];
-    
-    NSURL *downloadFileSavePath;
-    BOOL isDirectory;
-    if(![[NSFileManager defaultManager] fileExistsAtPath:request.downloadSavePath isDirectory:&isDirectory]) {
-        isDirectory = NO;
+/**
+ 对冲请求的任务完成时决定是否使用它的结果: 先成功完成的任务胜出并取消另一个; 任务失败时如果另一个任务还在运行则等待另一个任务.
+ 
+ @return 使用这个任务的结果时返回 `YES`.
+ */
+- (BOOL)yg_resolveHedge:(YGRequestHedge *)hedge withTask:(NSURLSessionTask *)task error:(NSError *)error {
+    NSURLSessionTask *loserTask = nil;
+    YG_NETWORKING_LOCK();
+    if (hedge.finished || (task != hedge.primaryTask && task != hedge.hedgeTask)) {
+        YG_NETWORKING_UNLOCK();
+        return NO;
     }
-    if (isDirectory) {
-        NSString *fileName = [urlRequest.URL lastPathComponent];
-        downloadFileSavePath = [NSURL fileURLWithPath:[NSString pathWithComponents:@[request.downloadSavePath, fileName]] isDirectory:NO];
-    } else {
-        downloadFileSavePath = [NSURL fileURLWithPath:request.downloadSavePath isDirectory:NO];
+    if (hedge.runningCount > 0) {
+        hedge.runningCount--;
     }
+    if (error && hedge.runningCount > 0) {
+        YG_NETWORKING_UNLOCK();
+        return NO;
+    }
+    hedge.finished = YES;
+    hedge.winnerTask = task;
+    BOOL hedgeWon = (task == hedge.hedgeTask);
+    loserTask = hedgeWon ? hedge.primaryTask : hedge.hedgeTask;
+    NSTimeInterval primaryResumeTimestamp = hedge.primaryResumeTimestamp;
+    YG_NETWORKING_UNLOCK();
     
-    NSURLSessionDownloadTask *downloadTask = nil;
-    AFURLSessionManager *sessionManager = [self yg_getSessionManager:request];
-    downloadTask = [sessionManager downloadTaskWithRequest:urlRequest
-                                                  progress:request.progressBlock
-                                               destination:^NSURL *(NSURL *targetPath, NSURLResponse *response) {
-                                                   return downloadFileSavePath;
-                                               }
-                                         completionHandler:^(NSURLResponse *response, NSURL *filePath, NSError *error) {
-                                                    if (completionHandler) {
-                                                        completionHandler(filePath, error);
-                                                    }
-                                         }];
-    
-    [self yg_setIdentifierForReqeust:request taskIdentifier:downloadTask.taskIdentifier sessionManager:sessionManager];
-    [downloadTask setBindedRequest:request];
-    [downloadTask resume];
+    [loserTask cancel];
+    [hedge.request.metrics setValue:@(hedgeWon) forKey:@"_hedgeWon"];
+    if (!error && primaryResumeTimestamp > 0) {
+        // when the hedge wins this is a lower bound of the original latency, which keeps the percentile from drifting down.
+        [hedge.policy recordLatency:[NSProcessInfo processInfo].systemUptime - primaryResumeTimestamp forHost:hedge.urlRequest.URL.host];
+    }
+    return YES;
 }
 
-- (void)yg_processURLRequest:(NSMutableURLRequest *)urlRequest byYGRequest:(YGRequest *)request {
-    if (request.headers.count > 0) {
-        [request.headers enumerateKeysAndObjectsUsingBlock:^(id field, id value, BOOL * __unused stop) {
-            //if (![urlRequest valueForHTTPHeaderField:field]) {
-                [urlRequest setValue:value forHTTPHeaderField:field];
-            //}
-        }];
-    }
-    urlRequest.timeoutInterval = request.timeoutInterval;
+/**
+ 对冲请求中被取消的任务的系统耗时统计不覆盖胜出任务的统计.
+ */
+- (BOOL)yg_shouldCollectMetricsForTask:(NSURLSessionTask *)task {
+    YGRequestHedge *hedge = task.bindedHedge;
+    if (!hedge) return YES;
+    
+    YG_NETWORKING_LOCK();
+    BOOL lost = hedge.finished && hedge.winnerTask != task;
+    YG_NETWORKING_UNLOCK();
+    return !lost;
 }
 
-- (void)yg_processResponse:(NSURLResponse *)response
-                    object:(id)responseObject
-                     error:(NSError *)error
-                   request:(YGRequest *)request
-         completionHandler:(YGCompletionHandler)completionHandler {
-    NSError *serializationError = nil;
-    if (request.responseSerializerType != kYGResponseSerializerRAW) {
-        AFHTTPResponseSerializer *responseSerializer = [self yg_getResponseSerializer:request];
-        responseObject = [responseSerializer responseObjectForResponse:response data:responseObject error:&serializationError];
+#pragma mark - Concurrency Limiter
+
+/**
+ 释放任务的主机并发名额并把结果记录到限流器: 超时、连接失败和 429/503/504 响应记为丢弃, 其他错误和取消只释放名额.
+ */
+- (void)yg_recordConcurrencyLimiterResultForTask:(NSURLSessionTask *)task error:(NSError *)error {
+    YGConcurrencyLimiter *limiter = task.bindedLimiter;
+    if (!limiter) return;
+    task.bindedLimiter = nil;
+    
+    NSString *host = task.originalRequest.URL.host;
+    NSTimeInterval resumeTimestamp = task.resumeTimestamp;
+    if (resumeTimestamp <= 0) {
+        [limiter releaseForHost:host];
+        return;
     }
     
-    if (completionHandler) {
-        if (serializationError) {
-            completionHandler(nil, serializationError);
-        } else {
-            completionHandler(responseObject, error);
-        }
+    NSInteger statusCode = [task.response isKindOfClass:[NSHTTPURLResponse class]] ? ((NSHTTPURLResponse *)task.response).statusCode : 0;
+    BOOL dropped = statusCode == 429 || statusCode == 503 || statusCode == 504;
+    if ([error.domain isEqualToString:NSURLErrorDomain]) {
+        dropped = dropped || error.code == NSURLErrorTimedOut || error.code == NSURLErrorCannotConnectToHost || error.code == NSURLErrorNetworkConnectionLost;
+    }
+    
+    if (dropped) {
+        [limiter recordDropForHost:host];
+    } else if (error) {
+        [limiter releaseForHost:host];
+    } else {
+        [limiter recordSuccessForHost:host latency:[NSProcessInfo processInfo].systemUptime - resumeTimestamp];
     }
 }
 
+- (void)yg_reachabilityDidChange:(NSNotification *)notification {
+    // failures recorded on the previous network do not describe the hosts on the new one.
+    [self.circuitBreaker reset];
+    
+    YGConcurrencyLimiter *limiter = self.concurrencyLimiter;
+    if (!limiter) return;
+    
+    NSInteger status = [notification.userInfo[AFNetworkingReachabilityNotificationStatusItem] integerValue];
+    [limiter resetWithConnectionType:status];
+    // the initial limit of the new connection type may be larger.
+    [self yg_resumePendingTasks];
+}
+
+#pragma mark -
+
 - (void)yg_setIdentifierForReqeust:(YGRequest *)request
-                    taskIdentifier:(NSUInteger)taskIdentifier
+                              task:(NSURLSessionTask *)task
                     sessionManager:(AFURLSessionManager *)sessionManager {
     NSString *identifier = nil;
     if ([sessionManager isEqual:self.sessionManager]) {
-        identifier = [NSString stringWithFormat:@"+%lu", (unsigned long)taskIdentifier];
+        identifier = [NSString stringWithFormat:@"+%lu", (unsigned long)task.taskIdentifier];
     } else if ([sessionManager isEqual:self.securitySessionManager]) {
-        identifier = [NSString stringWithFormat:@"-%lu", (unsigned long)taskIdentifier];
+        identifier = [NSString stringWithFormat:@"-%lu", (unsigned long)task.taskIdentifier];
     }
     [request setValue:identifier forKey:@"_identifier"];
+    
+    if (identifier) {
+        self.runningTasks[identifier] = task;
+    }
+}
+
+- (void)yg_removeIdentifierForRequest:(YGRequest *)request {
+    NSString *identifier = request.identifier;
+    if (identifier.length == 0) return;
+    
+    [self.runningTasks removeObjectForKey:identifier];
+}
+
+/**
+ 请求的 NSURL，优先使用 YGCenter 拼接 `url` 时生成的 `resolvedURL`.
+ */
+- (NSURL *)yg_URLForRequest:(YGRequest *)request {
+    return request.resolvedURL ?: [NSURL URLWithString:request.url];
 }
 
-- (NSString *)yg_rootDomainNameFromURL:(NSString *)urlString {
-    NSString *host = [[NSURL URLWithString:urlString] host];
+- (NSString *)yg_rootDomainNameFromHost:(NSString *)host {
     // Separate the host into its constituent components, e.g. [@"secure", @"twitter", @"com"]
     NSArray * hostComponents = [host componentsSeparatedByString:@"."];
     if ([hostComponents count] >= 2) {
@@ -506,9 +2796,9 @@ static OSStatus YGExtractIdentityAndTrustFromPKCS12(CFDataRef inPKCS12Data, CFSt
     return host;
 }
 
-- (BOOL)yg_shouldSSLPinningWithURL:(NSString *)urlString {
-    if (urlString && [urlString hasPrefix:@"https"]) {
-        NSString *rootDomainName = [self yg_rootDomainNameFromURL:urlString];
+- (BOOL)yg_shouldSSLPinningWithURL:(NSURL *)URL {
+    if (self.sslPinningHosts.count > 0 && [URL.scheme isEqualToString:@"https"]) {
+        NSString *rootDomainName = [self yg_rootDomainNameFromHost:URL.host];
         if ([self.sslPinningHosts containsObject:rootDomainName]) {
             return YES;
         }
@@ -517,7 +2807,7 @@ static OSStatus YGExtractIdentityAndTrustFromPKCS12(CFDataRef inPKCS12Data, CFSt
 }
 
 - (AFURLSessionManager *)yg_getSessionManager:(YGRequest *)request {
-    if ([self yg_shouldSSLPinningWithURL:request.url]) {
+    if ([self yg_shouldSSLPinningWithURL:[self yg_URLForRequest:request]]) {
         return self.securitySessionManager;
     } else {
         return self.sessionManager;
@@ -552,25 +2842,60 @@ static OSStatus YGExtractIdentityAndTrustFromPKCS12(CFDataRef inPKCS12Data, CFSt
     }
 }
 
+- (void)yg_observeTaskEventsForSessionManager:(AFURLSessionManager *)sessionManager {
+    __weak __typeof(self)weakSelf = self;
+    [sessionManager setTaskDidCompleteBlock:^(NSURLSession *session, NSURLSessionTask *task, NSError *error) {
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        [strongSelf yg_recordCircuitBreakerResultForTask:task error:error];
+        [strongSelf yg_recordConcurrencyLimiterResultForTask:task error:error];
+        [strongSelf yg_taskDidComplete:task];
+    }];
+    if (@available(iOS 10.0, *)) {
+        // delivered before `taskDidComplete`, so the metrics are complete when the response is processed.
+        [sessionManager setTaskDidFinishCollectingMetricsBlock:^(NSURLSession *session, NSURLSessionTask *task, NSURLSessionTaskMetrics *metrics) {
+            if (![weakSelf yg_shouldCollectMetricsForTask:task]) return;
+            [task.bindedRequest.metrics setValue:metrics forKey:@"_taskMetrics"];
+        }];
+    }
+    [sessionManager setDataTaskDidReceiveDataBlock:^(NSURLSession *session, NSURLSessionDataTask *dataTask, NSData *data) {
+        YGResponseStream *stream = dataTask.bindedStream;
+        if (stream) {
+            dispatch_async(stream.queue, ^{
+                [stream.parser appendData:data error:NULL];
+            });
+        }
+    }];
+}
+
 #pragma mark - Accessor
 
+/**
+ session 的配置. session 创建后不能再修改 `protocolClasses`, 所以录制/回放的 protocol 总是放在最前面,
+ 没有设置 `recordReplayTransport` 时它不拦截任何请求.
+ */
+- (NSURLSessionConfiguration *)yg_sessionConfiguration {
+    NSURLSessionConfiguration *configuration = [NSURLSessionConfiguration defaultSessionConfiguration];
+    configuration.protocolClasses = [@[[YGRecordReplayTransport protocolClass]] arrayByAddingObjectsFromArray:configuration.protocolClasses ?: @[]];
+    return configuration;
+}
+
 - (AFURLSessionManager *)sessionManager {
     if (!_sessionManager) {
-        _sessionManager = [[AFURLSessionManager alloc] initWithSessionConfiguration:nil];
+        _sessionManager = [[AFURLSessionManager alloc] initWithSessionConfiguration:[self yg_sessionConfiguration]];
         _sessionManager.responseSerializer = self.afHTTPResponseSerializer;
-        _sessionManager.operationQueue.maxConcurrentOperationCount = 5;
         _sessionManager.completionQueue = yg_request_completion_callback_queue();
+        [self yg_observeTaskEventsForSessionManager:_sessionManager];
     }
     return _sessionManager;
 }
 
 - (AFURLSessionManager *)securitySessionManager {
     if (!_securitySessionManager) {
-        _securitySessionManager = [[AFURLSessionManager alloc] initWithSessionConfiguration:nil];
+        _securitySessionManager = [[AFURLSessionManager alloc] initWithSessionConfiguration:[self yg_sessionConfiguration]];
         _securitySessionManager.responseSerializer = self.afHTTPResponseSerializer;
         _securitySessionManager.securityPolicy = [AFSecurityPolicy policyWithPinningMode:AFSSLPinningModeCertificate];
-        _securitySessionManager.operationQueue.maxConcurrentOperationCount = 5;
         _securitySessionManager.completionQueue = yg_request_completion_callback_queue();
+        [self yg_observeTaskEventsForSessionManager:_securitySessionManager];
     }
     return _securitySessionManager;
 }
@@ -635,4 +2960,32 @@ static OSStatus YGExtractIdentityAndTrustFromPKCS12(CFDataRef inPKCS12Data, CFSt
     return _sslPinningHosts;
 }
 
+- (NSMutableDictionary<NSString *, YGSegmentedDownload *> *)runningDownloads {
+    if (!_runningDownloads) {
+        _runningDownloads = [NSMutableDictionary dictionary];
+    }
+    return _runningDownloads;
+}
+
+- (NSMutableDictionary<NSString *, YGResumableUpload *> *)runningUploads {
+    if (!_runningUploads) {
+        _runningUploads = [NSMutableDictionary dictionary];
+    }
+    return _runningUploads;
+}
+
+- (NSMutableDictionary<NSString *, YGRequest *> *)compressingRequests {
+    if (!_compressingRequests) {
+        _compressingRequests = [NSMutableDictionary dictionary];
+    }
+    return _compressingRequests;
+}
+
+- (NSMutableDictionary<NSString *, YGRequestFlight *> *)runningFlights {
+    if (!_runningFlights) {
+        _runningFlights = [NSMutableDictionary dictionary];
+    }
+    return _runningFlights;
+}
+
 @end
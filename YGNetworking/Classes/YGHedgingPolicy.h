@@ -0,0 +1,85 @@
+//
+//  YGHedgingPolicy.h
+//  YGNetworking
+//
+//  Created by Sun on 2020/5/4.
+//  Copyright © 2020 YGNetworking. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class YGRetryBudget;
+
+/**
+ `YGHedgingPolicy` 是 YGEngine 的对冲请求策略，减少偶尔卡住的连接造成的长尾延迟.
+ 
+ 开启 `YGRequest.hedgingEnabled` 的 GET/HEAD 请求启动后，如果在对冲延迟内没有完成，YGEngine 发送一个相同的请求 (对冲请求)，
+ 使用先成功完成的响应并取消另一个. 对冲延迟默认为按主机统计的最近请求耗时的 `percentile` 分位数 (p95)，
+ 样本不足时使用 `maxDelay`. 对冲请求从 `budget` 中消耗令牌，额外的请求量被限制在总请求量的一定比例以内.
+ */
+@interface YGHedgingPolicy : NSObject
+
+/**
+ 创建并返回一个默认配置的 `YGHedgingPolicy` 对象.
+ */
++ (instancetype)policy;
+
+///---------------------
+/// @name 配置
+///---------------------
+
+/**
+ 固定的对冲延迟(秒)，默认为 `0`，表示按主机统计的耗时分位数计算.
+ */
+@property (nonatomic, assign) NSTimeInterval delay;
+
+/**
+ 计算对冲延迟使用的耗时分位数，默认为 `0.95`.
+ */
+@property (nonatomic, assign) double percentile;
+
+/**
+ 对冲延迟的最小值，默认为 `0.05` 秒，避免延迟很低的主机几乎每个请求都被对冲.
+ */
+@property (nonatomic, assign) NSTimeInterval minDelay;
+
+/**
+ 对冲延迟的最大值，也是样本不足时使用的延迟，默认为 `2` 秒.
+ */
+@property (nonatomic, assign) NSTimeInterval maxDelay;
+
+/**
+ 按分位数计算对冲延迟所需的最少样本数，默认为 `20`.
+ */
+@property (nonatomic, assign) NSUInteger minimumSampleCount;
+
+/**
+ 对冲预算，每个开启对冲的请求存入令牌，每个对冲请求消耗一个令牌，默认为 `[YGRetryBudget budgetWithRatio:0.05 maxTokens:10]`.
+ */
+@property (nonatomic, strong) YGRetryBudget *budget;
+
+///---------------------
+/// @name 统计
+///---------------------
+
+/**
+ 获取发往主机的请求的对冲延迟.
+
+ @param host 请求的主机.
+ @return 对冲延迟(秒)，在 `[minDelay, maxDelay]` 范围内.
+ */
+- (NSTimeInterval)hedgeDelayForHost:(nullable NSString *)host;
+
+/**
+ 记录一个请求的耗时，只保留每个主机最近的样本.
+
+ @param latency 原始请求从启动到完成的耗时(秒)，对冲请求胜出时为到那时为止的耗时.
+ @param host 请求的主机.
+ */
+- (void)recordLatency:(NSTimeInterval)latency forHost:(nullable NSString *)host;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,120 @@
+//
+//  YGHedgingPolicy.m
+//  YGNetworking
+//
+//  Created by Sun on 2020/5/4.
+//  Copyright © 2020 YGNetworking. All rights reserved.
+//
+
+#import "YGHedgingPolicy.h"
+#import "YGRetryPolicy.h"
+#import "YGConst.h"
+
+/// 每个主机保留的最近耗时样本数.
+#define YGHedgingPolicySampleCount 128
+
+#pragma mark - YGHedgingPolicyHost
+
+/**
+ 单个主机最近的耗时样本, 环形缓冲区.
+ */
+@interface YGHedgingPolicyHost : NSObject {
+    @package
+    NSTimeInterval _samples[YGHedgingPolicySampleCount];
+    NSUInteger _count;
+    NSUInteger _next;
+}
+@end
+
+@implementation YGHedgingPolicyHost
+@end
+
+#pragma mark - YGHedgingPolicy
+
+@interface YGHedgingPolicy () {
+    pthread_mutex_t _lock;
+}
+
+@property (nonatomic, strong) NSMutableDictionary<NSString *, YGHedgingPolicyHost *> *hosts;
+
+@end
+
+@implementation YGHedgingPolicy
+
++ (instancetype)policy {
+    return [[[self class] alloc] init];
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    YG_NETWORKING_LOCK_INIT();
+    _hosts = [NSMutableDictionary dictionary];
+    _delay = 0;
+    _percentile = 0.95;
+    _minDelay = 0.05;
+    _maxDelay = 2.0;
+    _minimumSampleCount = 20;
+    _budget = [YGRetryBudget budgetWithRatio:0.05 maxTokens:10];
+    
+    return self;
+}
+
+- (void)dealloc {
+    YG_NETWORKING_LOCK_DESTROY();
+}
+
+#pragma mark - Public Methods
+
+- (NSTimeInterval)hedgeDelayForHost:(NSString *)host {
+    NSTimeInterval minDelay = MAX(self.minDelay, 0);
+    NSTimeInterval maxDelay = MAX(self.maxDelay, minDelay);
+    if (self.delay > 0) {
+        return self.delay;
+    }
+    
+    NSTimeInterval samples[YGHedgingPolicySampleCount];
+    NSUInteger count = 0;
+    YG_NETWORKING_LOCK();
+    YGHedgingPolicyHost *record = host.length > 0 ? self.hosts[host.lowercaseString] : nil;
+    if (record) {
+        count = record->_count;
+        memcpy(samples, record->_samples, sizeof(NSTimeInterval) * count);
+    }
+    YG_NETWORKING_UNLOCK();
+    
+    if (count == 0 || count < self.minimumSampleCount) {
+        return maxDelay;
+    }
+    
+    // sort a copy outside the lock, 128 samples are cheap compared with the request itself.
+    qsort_b(samples, count, sizeof(NSTimeInterval), ^int(const void *a, const void *b) {
+        NSTimeInterval lhs = *(const NSTimeInterval *)a;
+        NSTimeInterval rhs = *(const NSTimeInterval *)b;
+        return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+    });
+    double percentile = MIN(MAX(self.percentile, 0), 1);
+    NSUInteger index = MIN((NSUInteger)ceil(percentile * count), count) - (percentile > 0 ? 1 : 0);
+    return MIN(MAX(samples[index], minDelay), maxDelay);
+}
+
+- (void)recordLatency:(NSTimeInterval)latency forHost:(NSString *)host {
+    if (host.length == 0 || latency <= 0) return;
+    
+    NSString *key = host.lowercaseString;
+    YG_NETWORKING_LOCK();
+    YGHedgingPolicyHost *record = self.hosts[key];
+    if (!record) {
+        record = [[YGHedgingPolicyHost alloc] init];
+        self.hosts[key] = record;
+    }
+    record->_samples[record->_next] = latency;
+    record->_next = (record->_next + 1) % YGHedgingPolicySampleCount;
+    record->_count = MIN(record->_count + 1, YGHedgingPolicySampleCount);
+    YG_NETWORKING_UNLOCK();
+}
+
+@end
@@ -0,0 +1,74 @@
+//
+//  YGJSONStreamParser.h
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `YGJSONStreamParser` 是一个增量的 JSON 解析器，用于在响应数据下载的同时解析响应体.
+ 
+ 解析器逐块扫描追加的数据，根对象为数组或字典时，每当一个顶层元素 (或键值对) 完整到达就立即通过 `NSJSONSerialization` 解析，
+ 并释放已解析部分的原始数据，数据接收完成时只需要解析剩余的尾部. 根对象为其他类型时数据会被缓存到结束时一次性解析.
+ 常见的响应会把列表包在一个字典中 (eg. `{"code": 0, "data": [...]}`)，这时设置 `streamingKeyPath` 为 `data`，
+ 列表的元素也会在到达时被逐个解析，而不是等到整个 `data` 到达后才解析.
+ NOTE: 解析器不是线程安全的，需要在同一个串行队列中调用.
+ */
+@interface YGJSONStreamParser : NSObject
+
+/**
+ 创建并返回一个 `YGJSONStreamParser` 对象.
+
+ @param readingOptions 解析选项，与 `NSJSONSerialization` 相同.
+ */
++ (instancetype)parserWithReadingOptions:(NSJSONReadingOptions)readingOptions;
+
+/**
+ 创建并返回一个 `YGJSONStreamParser` 对象.
+
+ @param readingOptions 解析选项，与 `NSJSONSerialization` 相同.
+ @param streamingKeyPath 需要逐个解析元素的嵌套容器在根字典中的路径，用 `.` 分隔，eg. `data` 或 `data.list`.
+ 路径上的每一级都是字典的 key，路径指向的容器 (数组或字典) 和路径上的字典都按元素 (或键值对) 解析. 为 `nil` 时只逐个解析根对象的元素.
+ */
++ (instancetype)parserWithReadingOptions:(NSJSONReadingOptions)readingOptions streamingKeyPath:(nullable NSString *)streamingKeyPath;
+
+/**
+ 逐个解析元素的嵌套容器的路径.
+ */
+@property (nonatomic, copy, readonly, nullable) NSString *streamingKeyPath;
+
+/**
+ 已经解析的原始数据长度(字节).
+ */
+@property (nonatomic, assign, readonly) NSUInteger parsedByteCount;
+
+/**
+ 当前缓存的未解析数据长度(字节).
+ */
+@property (nonatomic, assign, readonly) NSUInteger bufferedByteCount;
+
+/**
+ 追加数据并解析所有已经完整的顶层元素.
+
+ @param data 新接收的数据块.
+ @param error 数据格式错误时返回的错误，之后追加的数据都会被忽略.
+ @return 没有发生错误时返回 `YES`.
+ */
+- (BOOL)appendData:(NSData *)data error:(NSError * _Nullable __autoreleasing *)error;
+
+/**
+ 结束解析，解析剩余的尾部数据并返回根对象.
+
+ @param error 数据格式错误或数据不完整时返回的错误.
+ @return 解析后的根对象，数据为空或发生错误时返回 `nil`.
+ */
+- (nullable id)finishWithError:(NSError * _Nullable __autoreleasing *)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
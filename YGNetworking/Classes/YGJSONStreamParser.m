@@ -0,0 +1,380 @@
+//
+//  YGJSONStreamParser.m
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import "YGJSONStreamParser.h"
+
+typedef NS_ENUM(NSInteger, YGJSONStreamRootType) {
+    YGJSONStreamRootTypeUnknown,
+    YGJSONStreamRootTypeArray,
+    YGJSONStreamRootTypeObject,
+    YGJSONStreamRootTypeScalar,
+    YGJSONStreamRootTypeFinished,
+};
+
+static inline BOOL YGJSONIsWhitespace(uint8_t c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static NSError * YGJSONStreamError(NSString *description) {
+    return [NSError errorWithDomain:NSCocoaErrorDomain
+                               code:NSPropertyListReadCorruptError
+                           userInfo:@{NSDebugDescriptionErrorKey: description}];
+}
+
+/**
+ 正在逐个解析元素的容器，根对象和 `streamingKeyPath` 上的每个嵌套容器各占一层.
+ */
+@interface YGJSONStreamFrame : NSObject
+
+@property (nonatomic, strong) id container;
+@property (nonatomic, assign) BOOL isArray;
+/// 容器在上一层字典中的 key，根对象为 `nil`.
+@property (nonatomic, copy, nullable) NSString *key;
+/// 下一级需要进入的 `streamingKeyPath` 路径的位置.
+@property (nonatomic, assign) NSUInteger keyPathIndex;
+/// 当前元素在 `_buffer` 中的起始位置.
+@property (nonatomic, assign) NSUInteger elementStart;
+/// 当前键值对的值是已经解析完成的嵌套容器，只允许后面有空白.
+@property (nonatomic, assign) BOOL elementConsumed;
+
+@end
+
+@implementation YGJSONStreamFrame
+@end
+
+@interface YGJSONStreamParser () {
+    NSJSONReadingOptions _readingOptions;
+    NSArray<NSString *> *_keyPathComponents;
+    NSMutableData *_buffer;
+    NSUInteger _scanOffset;     // 下一个需要扫描的字节在 `_buffer` 中的位置
+    NSInteger _depth;           // 在当前元素中嵌套的深度，为 `0` 时位于两个元素之间
+    BOOL _inString;
+    BOOL _escaped;
+    YGJSONStreamRootType _rootType;
+    NSMutableArray<YGJSONStreamFrame *> *_frames;
+    id _root;
+    NSError *_error;
+}
+
+@end
+
+@implementation YGJSONStreamParser
+
++ (instancetype)parserWithReadingOptions:(NSJSONReadingOptions)readingOptions {
+    return [self parserWithReadingOptions:readingOptions streamingKeyPath:nil];
+}
+
++ (instancetype)parserWithReadingOptions:(NSJSONReadingOptions)readingOptions streamingKeyPath:(NSString *)streamingKeyPath {
+    YGJSONStreamParser *parser = [[self alloc] init];
+    parser->_readingOptions = readingOptions;
+    parser->_streamingKeyPath = [streamingKeyPath copy];
+    parser->_keyPathComponents = streamingKeyPath.length > 0 ? [streamingKeyPath componentsSeparatedByString:@"."] : @[];
+    return parser;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _buffer = [NSMutableData data];
+    _frames = [NSMutableArray array];
+    _keyPathComponents = @[];
+    _rootType = YGJSONStreamRootTypeUnknown;
+    
+    return self;
+}
+
+- (NSUInteger)bufferedByteCount {
+    return _buffer.length;
+}
+
+- (BOOL)appendData:(NSData *)data error:(NSError *__autoreleasing *)error {
+    if (!_error && data.length > 0) {
+        [_buffer appendData:data];
+        [self yg_scan];
+    }
+    if (_error) {
+        if (error) *error = _error;
+        return NO;
+    }
+    return YES;
+}
+
+- (id)finishWithError:(NSError *__autoreleasing *)error {
+    id result = nil;
+    if (!_error) {
+        switch (_rootType) {
+            case YGJSONStreamRootTypeUnknown:
+                // empty or whitespace-only body.
+                break;
+            case YGJSONStreamRootTypeScalar: {
+                NSError *parseError = nil;
+                result = [NSJSONSerialization JSONObjectWithData:_buffer options:_readingOptions error:&parseError];
+                _error = parseError;
+                _parsedByteCount += _buffer.length;
+                break;
+            }
+            case YGJSONStreamRootTypeFinished:
+                result = (_readingOptions & NSJSONReadingMutableContainers) ? _root : [_root copy];
+                break;
+            default:
+                _error = YGJSONStreamError(@"Unexpected end of data.");
+                break;
+        }
+    }
+    
+    _buffer = nil;
+    _root = nil;
+    [_frames removeAllObjects];
+    if (_error) {
+        if (error) *error = _error;
+        return nil;
+    }
+    return result;
+}
+
+#pragma mark - Private Methods
+
+- (void)yg_scan {
+    const uint8_t *bytes = _buffer.bytes;
+    NSUInteger length = _buffer.length;
+    NSUInteger i = _scanOffset;
+    
+    for (; i < length && !_error; i++) {
+        uint8_t c = bytes[i];
+        
+        if (_rootType == YGJSONStreamRootTypeUnknown) {
+            if (YGJSONIsWhitespace(c) || c == 0xEF || c == 0xBB || c == 0xBF) {
+                // skip leading whitespace and the UTF-8 BOM.
+                continue;
+            }
+            if (c == '[' || c == '{') {
+                _rootType = (c == '[') ? YGJSONStreamRootTypeArray : YGJSONStreamRootTypeObject;
+                [self yg_pushFrameWithOpeningByte:c key:nil keyPathIndex:0 elementStart:i + 1];
+            } else {
+                // a top-level scalar is buffered and parsed as a whole when finished.
+                _rootType = YGJSONStreamRootTypeScalar;
+                break;
+            }
+            continue;
+        }
+        
+        if (_rootType == YGJSONStreamRootTypeScalar) {
+            break;
+        }
+        
+        if (_rootType == YGJSONStreamRootTypeFinished) {
+            if (!YGJSONIsWhitespace(c)) {
+                _error = YGJSONStreamError(@"Garbage at end.");
+            }
+            continue;
+        }
+        
+        if (_inString) {
+            if (_escaped) {
+                _escaped = NO;
+            } else if (c == '\\') {
+                _escaped = YES;
+            } else if (c == '"') {
+                _inString = NO;
+            }
+            continue;
+        }
+        
+        YGJSONStreamFrame *frame = _frames.lastObject;
+        switch (c) {
+            case '"':
+                _inString = YES;
+                break;
+            case '[':
+            case '{':
+                if (_depth == 0 && !frame.isArray && frame.keyPathIndex < _keyPathComponents.count) {
+                    // the value of a member on the key path is parsed element by element as well.
+                    NSString *key = [self yg_keyOfMemberInRange:NSMakeRange(frame.elementStart, i - frame.elementStart) valueStart:NULL];
+                    if ([key isEqualToString:_keyPathComponents[frame.keyPathIndex]]) {
+                        [self yg_pushFrameWithOpeningByte:c key:key keyPathIndex:frame.keyPathIndex + 1 elementStart:i + 1];
+                        break;
+                    }
+                }
+                _depth++;
+                break;
+            case ']':
+            case '}':
+                if (_depth > 0) {
+                    _depth--;
+                    break;
+                }
+                if ((c == ']') != frame.isArray) {
+                    _error = YGJSONStreamError(@"Badly formed container.");
+                    break;
+                }
+                [self yg_parseElementOfFrame:frame inRange:NSMakeRange(frame.elementStart, i - frame.elementStart) isLast:YES];
+                if (!_error) {
+                    [self yg_popFrameAtOffset:i + 1];
+                }
+                break;
+            case ',':
+                if (_depth == 0) {
+                    [self yg_parseElementOfFrame:frame inRange:NSMakeRange(frame.elementStart, i - frame.elementStart) isLast:NO];
+                    frame.elementStart = i + 1;
+                    frame.elementConsumed = NO;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    _scanOffset = i;
+    
+    if (_error) {
+        _buffer.length = 0;
+        _scanOffset = 0;
+        [_frames removeAllObjects];
+        return;
+    }
+    
+    // release the bytes of the elements which have been parsed, the frames below the top one already consumed theirs.
+    if (_rootType == YGJSONStreamRootTypeScalar || _rootType == YGJSONStreamRootTypeUnknown) {
+        return;
+    }
+    YGJSONStreamFrame *frame = _frames.lastObject;
+    NSUInteger releaseLength = frame ? frame.elementStart : _scanOffset;
+    if (releaseLength > 0) {
+        [_buffer replaceBytesInRange:NSMakeRange(0, releaseLength) withBytes:NULL length:0];
+        _scanOffset -= releaseLength;
+        _parsedByteCount += releaseLength;
+        frame.elementStart = 0;
+    }
+}
+
+- (void)yg_pushFrameWithOpeningByte:(uint8_t)c key:(NSString *)key keyPathIndex:(NSUInteger)keyPathIndex elementStart:(NSUInteger)elementStart {
+    YGJSONStreamFrame *frame = [[YGJSONStreamFrame alloc] init];
+    frame.isArray = (c == '[');
+    frame.container = frame.isArray ? [NSMutableArray array] : [NSMutableDictionary dictionary];
+    frame.key = key;
+    frame.keyPathIndex = keyPathIndex;
+    frame.elementStart = elementStart;
+    [_frames addObject:frame];
+    _depth = 0;
+}
+
+/**
+ 容器结束，根对象结束时解析完成，嵌套容器作为上一层字典当前键值对的值.
+ */
+- (void)yg_popFrameAtOffset:(NSUInteger)offset {
+    YGJSONStreamFrame *frame = _frames.lastObject;
+    [_frames removeLastObject];
+    YGJSONStreamFrame *parent = _frames.lastObject;
+    if (!parent) {
+        _root = frame.container;
+        _rootType = YGJSONStreamRootTypeFinished;
+        return;
+    }
+    
+    BOOL mutableContainers = (_readingOptions & NSJSONReadingMutableContainers) != 0;
+    parent.container[frame.key] = mutableContainers ? frame.container : [frame.container copy];
+    parent.elementStart = offset;
+    parent.elementConsumed = YES;
+}
+
+- (void)yg_parseElementOfFrame:(YGJSONStreamFrame *)frame inRange:(NSRange)range isLast:(BOOL)isLast {
+    const uint8_t *bytes = (const uint8_t *)_buffer.bytes + range.location;
+    BOOL blank = YES;
+    for (NSUInteger i = 0; i < range.length; i++) {
+        if (!YGJSONIsWhitespace(bytes[i])) {
+            blank = NO;
+            break;
+        }
+    }
+    if (frame.elementConsumed) {
+        if (!blank) {
+            _error = YGJSONStreamError(@"Badly formed object member.");
+        }
+        return;
+    }
+    if (blank) {
+        // only an empty container may close without an element, eg. `[]` or `{}`.
+        if (!isLast || [frame.container count] > 0) {
+            _error = YGJSONStreamError(@"Unexpected end of element.");
+        }
+        return;
+    }
+    
+    // the element is parsed in place, `_buffer` is not modified until the scan is over.
+    NSError *parseError = nil;
+    NSJSONReadingOptions options = _readingOptions | NSJSONReadingAllowFragments;
+    if (frame.isArray) {
+        NSData *segment = [NSData dataWithBytesNoCopy:(void *)bytes length:range.length freeWhenDone:NO];
+        id object = [NSJSONSerialization JSONObjectWithData:segment options:options error:&parseError];
+        if (object) {
+            [frame.container addObject:object];
+        } else {
+            _error = parseError ?: YGJSONStreamError(@"Badly formed array element.");
+        }
+    } else {
+        NSUInteger valueStart = 0;
+        NSString *key = [self yg_keyOfMemberInRange:range valueStart:&valueStart];
+        if (!key) {
+            return;
+        }
+        NSData *segment = [NSData dataWithBytesNoCopy:(void *)((const uint8_t *)_buffer.bytes + valueStart) length:NSMaxRange(range) - valueStart freeWhenDone:NO];
+        id object = [NSJSONSerialization JSONObjectWithData:segment options:options error:&parseError];
+        if (object) {
+            frame.container[key] = object;
+        } else {
+            _error = parseError ?: YGJSONStreamError(@"Badly formed object member.");
+        }
+    }
+}
+
+/**
+ 解析 `"key": value` 键值对的 key，并返回值在 `_buffer` 中的起始位置，格式错误时设置 `_error` 并返回 `nil`.
+ */
+- (NSString *)yg_keyOfMemberInRange:(NSRange)range valueStart:(NSUInteger *)valueStart {
+    const uint8_t *bytes = _buffer.bytes;
+    NSUInteger end = NSMaxRange(range);
+    NSUInteger i = range.location;
+    while (i < end && YGJSONIsWhitespace(bytes[i])) i++;
+    NSUInteger keyStart = i;
+    
+    BOOL escaped = NO;
+    BOOL closed = NO;
+    if (i < end && bytes[i] == '"') {
+        for (i++; i < end; i++) {
+            if (escaped) {
+                escaped = NO;
+            } else if (bytes[i] == '\\') {
+                escaped = YES;
+            } else if (bytes[i] == '"') {
+                closed = YES;
+                break;
+            }
+        }
+    }
+    NSUInteger keyEnd = i + 1;
+    if (closed) {
+        for (i++; i < end && YGJSONIsWhitespace(bytes[i]); i++);
+    }
+    if (!closed || i >= end || bytes[i] != ':') {
+        _error = YGJSONStreamError(@"Badly formed object member.");
+        return nil;
+    }
+    
+    NSData *keyData = [NSData dataWithBytesNoCopy:(void *)(bytes + keyStart) length:keyEnd - keyStart freeWhenDone:NO];
+    NSString *key = [NSJSONSerialization JSONObjectWithData:keyData options:NSJSONReadingAllowFragments error:NULL];
+    if (![key isKindOfClass:[NSString class]]) {
+        _error = YGJSONStreamError(@"Badly formed object key.");
+        return nil;
+    }
+    if (valueStart) *valueStart = i + 1;
+    return key;
+}
+
+@end
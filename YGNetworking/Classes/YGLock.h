@@ -0,0 +1,82 @@
+//
+//  YGLock.h
+//  YGNetworking
+//
+//  Created by Sun on 2020/4/28.
+//  Copyright © 2020 YGNetworking. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <pthread.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ 初始化 YGNetworking 内部使用的互斥锁 (`PTHREAD_PRIO_INHERIT`).
+ NOTE: 持有锁的线程优先级较低时会临时提升到等待线程的优先级，主线程等待后台线程持有的锁时不会发生优先级反转;
+ 和 `dispatch_semaphore_t` 不同，锁只能由加锁的线程解锁.
+ */
+FOUNDATION_EXPORT void YGNetworkingLockInit(pthread_mutex_t *lock);
+
+/**
+ 加锁，锁已经被其它线程持有时记录一次竞争后再等待.
+ */
+FOUNDATION_EXPORT void YGNetworkingLock(pthread_mutex_t *lock);
+
+/**
+ 所有 YGNetworking 内部锁累计的竞争次数 (加锁时锁已经被其它线程持有的次数)，用于压力测试和性能分析.
+ */
+FOUNDATION_EXPORT uint64_t YGNetworkingLockContentionCount(void);
+
+/**
+ 将竞争次数清零.
+ */
+FOUNDATION_EXPORT void YGNetworkingResetLockContentionCount(void);
+
+/**
+ `YGShardedDictionary` 是按 key 的哈希值分片的线程安全字典，每个分片有独立的锁，不同分片的读写互不等待.
+
+ YGEngine 的运行任务索引和 YGCenter 的批量/链式请求池使用它，避免所有请求在同一把锁上排队.
+ NOTE: 每个方法只持有一个分片的锁，不会回调外部代码，可以在持有其它锁时调用.
+ */
+@interface YGShardedDictionary<KeyType, ObjectType> : NSObject
+
+/**
+ 使用默认分片数创建，分片数为不小于 CPU 核数的 2 的幂，最少为 `8`.
+ */
+- (instancetype)init;
+
+/**
+ 使用指定的分片数创建，分片数会向上取整为 2 的幂.
+ */
+- (instancetype)initWithShardCount:(NSUInteger)shardCount NS_DESIGNATED_INITIALIZER;
+
+- (nullable ObjectType)objectForKey:(KeyType)key;
+- (void)setObject:(ObjectType)object forKey:(KeyType <NSCopying>)key;
+- (void)removeObjectForKey:(KeyType)key;
+- (void)removeObjectsForKeys:(NSArray<KeyType> *)keys;
+
+/**
+ 返回 key 对应的对象，不存在时插入 `block` 创建的对象，查找和插入是原子的.
+ NOTE: `block` 在持有分片锁时执行，不能访问这个字典.
+ */
+- (ObjectType)objectForKey:(KeyType <NSCopying>)key insertingIfAbsent:(ObjectType (^)(void))block;
+
+/**
+ 移除并返回 key 对应的对象，用于取消等只能处理一次的场景.
+ */
+- (nullable ObjectType)removeAndReturnObjectForKey:(KeyType)key;
+
+- (nullable ObjectType)objectForKeyedSubscript:(KeyType)key;
+- (void)setObject:(nullable ObjectType)object forKeyedSubscript:(KeyType <NSCopying>)key;
+
+/**
+ 所有对象的快照，逐个分片读取，不是某一时刻的一致视图.
+ */
+- (NSArray<ObjectType> *)allObjects;
+
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,207 @@
+//
+//  YGLock.m
+//  YGNetworking
+//
+//  Created by Sun on 2020/4/28.
+//  Copyright © 2020 YGNetworking. All rights reserved.
+//
+
+#import "YGLock.h"
+#import <stdatomic.h>
+#import <stdlib.h>
+
+static atomic_uint_fast64_t YGLockContentionCounter = 0;
+
+void YGNetworkingLockInit(pthread_mutex_t *lock) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_NORMAL);
+    pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+void YGNetworkingLock(pthread_mutex_t *lock) {
+    if (pthread_mutex_trylock(lock) == 0) {
+        return;
+    }
+    // only contended acquisitions touch the shared counter.
+    atomic_fetch_add_explicit(&YGLockContentionCounter, 1, memory_order_relaxed);
+    pthread_mutex_lock(lock);
+}
+
+uint64_t YGNetworkingLockContentionCount(void) {
+    return atomic_load_explicit(&YGLockContentionCounter, memory_order_relaxed);
+}
+
+void YGNetworkingResetLockContentionCount(void) {
+    atomic_store_explicit(&YGLockContentionCounter, 0, memory_order_relaxed);
+}
+
+#pragma mark - YGShardedDictionary
+
+/**
+ 单个分片，按缓存行对齐，相邻分片的锁不会在同一缓存行上互相干扰.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    CFMutableDictionaryRef dictionary;
+} __attribute__((aligned(64))) YGDictionaryShard;
+
+@interface YGShardedDictionary () {
+    YGDictionaryShard *_shards;
+    NSUInteger _shardMask;
+}
+
+@end
+
+@implementation YGShardedDictionary
+
+- (instancetype)init {
+    NSUInteger processorCount = [NSProcessInfo processInfo].activeProcessorCount;
+    return [self initWithShardCount:MAX(processorCount, 8)];
+}
+
+- (instancetype)initWithShardCount:(NSUInteger)shardCount {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    NSUInteger count = 1;
+    while (count < shardCount) {
+        count <<= 1;
+    }
+    void *shards = NULL;
+    if (posix_memalign(&shards, 64, sizeof(YGDictionaryShard) * count) != 0) {
+        return nil;
+    }
+    _shards = shards;
+    _shardMask = count - 1;
+    for (NSUInteger i = 0; i < count; i++) {
+        YGNetworkingLockInit(&_shards[i].lock);
+        _shards[i].dictionary = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (!_shards) return;
+    
+    for (NSUInteger i = 0; i <= _shardMask; i++) {
+        pthread_mutex_destroy(&_shards[i].lock);
+        CFRelease(_shards[i].dictionary);
+    }
+    free(_shards);
+}
+
+#pragma mark - Public Methods
+
+- (id)objectForKey:(id)key {
+    if (!key) return nil;
+    
+    YGDictionaryShard *shard = [self yg_shardForKey:key];
+    YGNetworkingLock(&shard->lock);
+    // retain before unlocking, another thread may remove the object right after.
+    id object = (__bridge id)CFDictionaryGetValue(shard->dictionary, (__bridge const void *)key);
+    pthread_mutex_unlock(&shard->lock);
+    return object;
+}
+
+- (void)setObject:(id)object forKey:(id<NSCopying>)key {
+    if (!key) return;
+    if (!object) {
+        [self removeObjectForKey:key];
+        return;
+    }
+    
+    id copiedKey = [(id)key copy];
+    YGDictionaryShard *shard = [self yg_shardForKey:copiedKey];
+    YGNetworkingLock(&shard->lock);
+    CFDictionarySetValue(shard->dictionary, (__bridge const void *)copiedKey, (__bridge const void *)object);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+- (void)removeObjectForKey:(id)key {
+    if (!key) return;
+    
+    YGDictionaryShard *shard = [self yg_shardForKey:key];
+    YGNetworkingLock(&shard->lock);
+    CFDictionaryRemoveValue(shard->dictionary, (__bridge const void *)key);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+- (void)removeObjectsForKeys:(NSArray *)keys {
+    for (id key in keys) {
+        [self removeObjectForKey:key];
+    }
+}
+
+- (id)objectForKey:(id<NSCopying>)key insertingIfAbsent:(id (^)(void))block {
+    id copiedKey = [(id)key copy];
+    YGDictionaryShard *shard = [self yg_shardForKey:copiedKey];
+    YGNetworkingLock(&shard->lock);
+    id object = (__bridge id)CFDictionaryGetValue(shard->dictionary, (__bridge const void *)copiedKey);
+    if (!object) {
+        object = block();
+        CFDictionarySetValue(shard->dictionary, (__bridge const void *)copiedKey, (__bridge const void *)object);
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return object;
+}
+
+- (id)removeAndReturnObjectForKey:(id)key {
+    if (!key) return nil;
+    
+    YGDictionaryShard *shard = [self yg_shardForKey:key];
+    YGNetworkingLock(&shard->lock);
+    id object = (__bridge id)CFDictionaryGetValue(shard->dictionary, (__bridge const void *)key);
+    if (object) {
+        CFDictionaryRemoveValue(shard->dictionary, (__bridge const void *)key);
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return object;
+}
+
+- (id)objectForKeyedSubscript:(id)key {
+    return [self objectForKey:key];
+}
+
+- (void)setObject:(id)object forKeyedSubscript:(id<NSCopying>)key {
+    [self setObject:object forKey:key];
+}
+
+- (NSArray *)allObjects {
+    NSMutableArray *objects = [NSMutableArray array];
+    for (NSUInteger i = 0; i <= _shardMask; i++) {
+        YGDictionaryShard *shard = &_shards[i];
+        YGNetworkingLock(&shard->lock);
+        [objects addObjectsFromArray:[(__bridge NSDictionary *)shard->dictionary allValues]];
+        pthread_mutex_unlock(&shard->lock);
+    }
+    return [objects copy];
+}
+
+- (NSUInteger)count {
+    NSUInteger count = 0;
+    for (NSUInteger i = 0; i <= _shardMask; i++) {
+        YGDictionaryShard *shard = &_shards[i];
+        YGNetworkingLock(&shard->lock);
+        count += CFDictionaryGetCount(shard->dictionary);
+        pthread_mutex_unlock(&shard->lock);
+    }
+    return count;
+}
+
+#pragma mark - Private Methods
+
+- (YGDictionaryShard *)yg_shardForKey:(id)key {
+    NSUInteger hash = [key hash];
+    // identifiers differ only in a short numeric suffix, mix the hash before masking.
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3b;
+    hash ^= hash >> 16;
+    return &_shards[hash & _shardMask];
+}
+
+@end
@@ -0,0 +1,61 @@
+//
+//  YGModelMapper.h
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ 模型类可以实现 `YGModel` 协议自定义映射规则，协议中的方法都是可选的.
+ */
+@protocol YGModel <NSObject>
+
+@optional
+
+/**
+ 属性名和 JSON key 不同时的映射，eg. `@{@"desc": @"description"}`.
+ */
++ (nullable NSDictionary<NSString *, NSString *> *)modelCustomPropertyMapper;
+
+/**
+ 容器属性 (NSArray/NSDictionary) 中元素的模型类，值可以是 `Class` 或类名，eg. `@{@"builtBy": [YGUser class]}`.
+ */
++ (nullable NSDictionary<NSString *, id> *)modelContainerPropertyGenericClass;
+
+@end
+
+/**
+ `YGModelMapper` 将解码后的 JSON 对象直接映射为模型对象.
+ 
+ 每个模型类的属性信息 (JSON key、setter、类型) 只在第一次映射时通过 runtime 解析一次并缓存，
+ 映射时按缓存的属性列表取值并直接调用 setter，避免 `setValuesForKeysWithDictionary:` 对每个 key 的 selector 查找和装箱.
+ NOTE: 只映射可写的属性，`NSNull` 值会被忽略.
+ */
+@interface YGModelMapper : NSObject
+
+/**
+ 将 JSON 对象映射为模型对象.
+
+ @param JSON 解码后的 JSON 对象，字典映射为一个模型对象，数组映射为模型对象数组.
+ @param modelClass 模型类.
+ @return 映射后的模型对象或模型对象数组，JSON 对象不是字典或数组时返回 `nil`.
+ */
++ (nullable id)modelWithJSON:(nullable id)JSON modelClass:(Class)modelClass;
+
+/**
+ 将字典映射为一个模型对象.
+
+ @param dictionary JSON 字典.
+ @param modelClass 模型类.
+ @return 映射后的模型对象，`dictionary` 不是字典时返回 `nil`.
+ */
++ (nullable id)modelWithDictionary:(nullable NSDictionary *)dictionary modelClass:(Class)modelClass;
+
+@end
+
+NS_ASSUME_NONNULL_END
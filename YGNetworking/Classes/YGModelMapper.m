@@ -0,0 +1,425 @@
+//
+//  YGModelMapper.m
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import "YGModelMapper.h"
+#import "YGLock.h"
+#import <objc/runtime.h>
+#import <objc/message.h>
+
+typedef NS_ENUM(NSUInteger, YGModelPropertyType) {
+    YGModelPropertyTypeUnknown,
+    YGModelPropertyTypeObject,
+    YGModelPropertyTypeBool,
+    YGModelPropertyTypeInt8,
+    YGModelPropertyTypeUInt8,
+    YGModelPropertyTypeInt16,
+    YGModelPropertyTypeUInt16,
+    YGModelPropertyTypeInt32,
+    YGModelPropertyTypeUInt32,
+    YGModelPropertyTypeInt64,
+    YGModelPropertyTypeUInt64,
+    YGModelPropertyTypeFloat,
+    YGModelPropertyTypeDouble,
+};
+
+typedef NS_ENUM(NSUInteger, YGModelObjectType) {
+    YGModelObjectTypeAny,
+    YGModelObjectTypeNSString,
+    YGModelObjectTypeNSMutableString,
+    YGModelObjectTypeNSNumber,
+    YGModelObjectTypeNSDecimalNumber,
+    YGModelObjectTypeNSURL,
+    YGModelObjectTypeNSArray,
+    YGModelObjectTypeNSMutableArray,
+    YGModelObjectTypeNSDictionary,
+    YGModelObjectTypeNSMutableDictionary,
+    YGModelObjectTypeModel,
+};
+
+static YGModelPropertyType YGModelPropertyTypeFromEncoding(const char *encoding) {
+    switch (encoding[0]) {
+        case '@': return YGModelPropertyTypeObject;
+        case 'B': return YGModelPropertyTypeBool;
+        case 'c': return YGModelPropertyTypeInt8;
+        case 'C': return YGModelPropertyTypeUInt8;
+        case 's': return YGModelPropertyTypeInt16;
+        case 'S': return YGModelPropertyTypeUInt16;
+        case 'i': return YGModelPropertyTypeInt32;
+        case 'I': return YGModelPropertyTypeUInt32;
+        case 'l': return YGModelPropertyTypeInt32;
+        case 'L': return YGModelPropertyTypeUInt32;
+        case 'q': return YGModelPropertyTypeInt64;
+        case 'Q': return YGModelPropertyTypeUInt64;
+        case 'f': return YGModelPropertyTypeFloat;
+        case 'd': return YGModelPropertyTypeDouble;
+        default:  return YGModelPropertyTypeUnknown;
+    }
+}
+
+static YGModelObjectType YGModelObjectTypeFromClass(Class cls) {
+    if (!cls) return YGModelObjectTypeAny;
+    // check the mutable subclasses first.
+    if ([cls isSubclassOfClass:[NSMutableString class]]) return YGModelObjectTypeNSMutableString;
+    if ([cls isSubclassOfClass:[NSString class]]) return YGModelObjectTypeNSString;
+    if ([cls isSubclassOfClass:[NSDecimalNumber class]]) return YGModelObjectTypeNSDecimalNumber;
+    if ([cls isSubclassOfClass:[NSNumber class]]) return YGModelObjectTypeNSNumber;
+    if ([cls isSubclassOfClass:[NSURL class]]) return YGModelObjectTypeNSURL;
+    if ([cls isSubclassOfClass:[NSMutableArray class]]) return YGModelObjectTypeNSMutableArray;
+    if ([cls isSubclassOfClass:[NSArray class]]) return YGModelObjectTypeNSArray;
+    if ([cls isSubclassOfClass:[NSMutableDictionary class]]) return YGModelObjectTypeNSMutableDictionary;
+    if ([cls isSubclassOfClass:[NSDictionary class]]) return YGModelObjectTypeNSDictionary;
+    if ([NSBundle bundleForClass:cls] == [NSBundle bundleForClass:[NSObject class]]) return YGModelObjectTypeAny;
+    return YGModelObjectTypeModel;
+}
+
+static NSNumber * YGModelNumberFromValue(id value) {
+    if ([value isKindOfClass:[NSNumber class]]) return value;
+    if ([value isKindOfClass:[NSString class]]) {
+        static NSCharacterSet *floatingPointCharacterSet = nil;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+            floatingPointCharacterSet = [NSCharacterSet characterSetWithCharactersInString:@".eE"];
+        });
+        NSString *string = value;
+        if ([string rangeOfCharacterFromSet:floatingPointCharacterSet].location != NSNotFound) {
+            return @(string.doubleValue);
+        }
+        NSString *lowercaseString = string.lowercaseString;
+        if ([lowercaseString isEqualToString:@"true"] || [lowercaseString isEqualToString:@"yes"]) return @YES;
+        if ([lowercaseString isEqualToString:@"false"] || [lowercaseString isEqualToString:@"no"]) return @NO;
+        return @(string.longLongValue);
+    }
+    return nil;
+}
+
+#pragma mark - YGModelPropertyMeta
+
+/**
+ 模型类单个可写属性的缓存信息.
+ */
+@interface YGModelPropertyMeta : NSObject {
+    @package
+    NSString *_name;
+    NSString *_JSONKey;
+    SEL _setter;
+    YGModelPropertyType _type;
+    YGModelObjectType _objectType;
+    Class _cls;
+    Class _genericClass;
+}
+@end
+
+@implementation YGModelPropertyMeta
+@end
+
+#pragma mark - YGModelClassMeta
+
+/**
+ 模型类的缓存信息, 包括子类和父类 (不包括 NSObject) 声明的所有可写属性.
+ */
+@interface YGModelClassMeta : NSObject {
+    @package
+    NSArray<YGModelPropertyMeta *> *_properties;
+}
+
++ (instancetype)metaWithClass:(Class)cls;
+
+@end
+
+@implementation YGModelClassMeta
+
++ (instancetype)metaWithClass:(Class)cls {
+    static CFMutableDictionaryRef metaCache;
+    static pthread_mutex_t lock;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        metaCache = CFDictionaryCreateMutable(CFAllocatorGetDefault(), 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+        YGNetworkingLockInit(&lock);
+    });
+    
+    YGNetworkingLock(&lock);
+    YGModelClassMeta *meta = (__bridge YGModelClassMeta *)CFDictionaryGetValue(metaCache, (__bridge const void *)cls);
+    pthread_mutex_unlock(&lock);
+    
+    if (!meta) {
+        meta = [[YGModelClassMeta alloc] initWithClass:cls];
+        YGNetworkingLock(&lock);
+        CFDictionarySetValue(metaCache, (__bridge const void *)cls, (__bridge const void *)meta);
+        pthread_mutex_unlock(&lock);
+    }
+    return meta;
+}
+
+- (instancetype)initWithClass:(Class)cls {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    NSDictionary<NSString *, NSString *> *customMapper = nil;
+    if ([cls respondsToSelector:@selector(modelCustomPropertyMapper)]) {
+        customMapper = [(id<YGModel>)cls modelCustomPropertyMapper];
+    }
+    NSDictionary<NSString *, id> *genericMapper = nil;
+    if ([cls respondsToSelector:@selector(modelContainerPropertyGenericClass)]) {
+        genericMapper = [(id<YGModel>)cls modelContainerPropertyGenericClass];
+    }
+    
+    NSMutableArray<YGModelPropertyMeta *> *properties = [NSMutableArray array];
+    NSMutableSet<NSString *> *propertyNames = [NSMutableSet set];
+    for (Class currentClass = cls; currentClass && currentClass != [NSObject class]; currentClass = class_getSuperclass(currentClass)) {
+        unsigned int count = 0;
+        objc_property_t *propertyList = class_copyPropertyList(currentClass, &count);
+        for (unsigned int i = 0; i < count; i++) {
+            YGModelPropertyMeta *property = [self yg_propertyMetaWithProperty:propertyList[i] ofClass:cls customMapper:customMapper genericMapper:genericMapper];
+            // a property redeclared by a subclass wins.
+            if (property && ![propertyNames containsObject:property->_name]) {
+                [propertyNames addObject:property->_name];
+                [properties addObject:property];
+            }
+        }
+        free(propertyList);
+    }
+    _properties = [properties copy];
+    
+    return self;
+}
+
+- (YGModelPropertyMeta *)yg_propertyMetaWithProperty:(objc_property_t)property
+                                             ofClass:(Class)cls
+                                        customMapper:(NSDictionary<NSString *, NSString *> *)customMapper
+                                       genericMapper:(NSDictionary<NSString *, id> *)genericMapper {
+    NSString *name = @(property_getName(property));
+    NSString *typeEncoding = nil;
+    NSString *setterName = nil;
+    BOOL readonly = NO;
+    
+    unsigned int count = 0;
+    objc_property_attribute_t *attributes = property_copyAttributeList(property, &count);
+    for (unsigned int i = 0; i < count; i++) {
+        switch (attributes[i].name[0]) {
+            case 'T': typeEncoding = @(attributes[i].value); break;
+            case 'S': setterName = @(attributes[i].value); break;
+            case 'R': readonly = YES; break;
+            default: break;
+        }
+    }
+    free(attributes);
+    
+    if (readonly || typeEncoding.length == 0) {
+        return nil;
+    }
+    
+    YGModelPropertyType type = YGModelPropertyTypeFromEncoding(typeEncoding.UTF8String);
+    if (type == YGModelPropertyTypeUnknown) {
+        return nil;
+    }
+    
+    if (!setterName) {
+        setterName = [NSString stringWithFormat:@"set%@%@:", [name substringToIndex:1].uppercaseString, [name substringFromIndex:1]];
+    }
+    SEL setter = NSSelectorFromString(setterName);
+    if (![cls instancesRespondToSelector:setter]) {
+        return nil;
+    }
+    
+    YGModelPropertyMeta *meta = [[YGModelPropertyMeta alloc] init];
+    meta->_name = name;
+    meta->_JSONKey = customMapper[name] ?: name;
+    meta->_setter = setter;
+    meta->_type = type;
+    
+    if (type == YGModelPropertyTypeObject) {
+        // @"ClassName" or @"ClassName<Protocol>", a plain @ is `id`.
+        if (typeEncoding.length > 3) {
+            NSString *className = [typeEncoding substringWithRange:NSMakeRange(2, typeEncoding.length - 3)];
+            NSRange protocolRange = [className rangeOfString:@"<"];
+            if (protocolRange.location != NSNotFound) {
+                className = [className substringToIndex:protocolRange.location];
+            }
+            meta->_cls = className.length > 0 ? NSClassFromString(className) : nil;
+        }
+        meta->_objectType = YGModelObjectTypeFromClass(meta->_cls);
+        
+        id genericClass = genericMapper[name];
+        if ([genericClass isKindOfClass:[NSString class]]) {
+            genericClass = NSClassFromString(genericClass);
+        }
+        if (class_isMetaClass(object_getClass(genericClass))) {
+            meta->_genericClass = genericClass;
+        }
+    }
+    return meta;
+}
+
+@end
+
+#pragma mark - YGModelMapper
+
+@implementation YGModelMapper
+
++ (id)modelWithJSON:(id)JSON modelClass:(Class)modelClass {
+    if (!modelClass) return nil;
+    
+    if ([JSON isKindOfClass:[NSDictionary class]]) {
+        return [self modelWithDictionary:JSON modelClass:modelClass];
+    }
+    if ([JSON isKindOfClass:[NSArray class]]) {
+        return [self yg_modelArrayWithArray:JSON modelClass:modelClass];
+    }
+    return nil;
+}
+
++ (id)modelWithDictionary:(NSDictionary *)dictionary modelClass:(Class)modelClass {
+    if (!modelClass || ![dictionary isKindOfClass:[NSDictionary class]]) return nil;
+    
+    YGModelClassMeta *classMeta = [YGModelClassMeta metaWithClass:modelClass];
+    id model = [[modelClass alloc] init];
+    for (YGModelPropertyMeta *property in classMeta->_properties) {
+        id value = dictionary[property->_JSONKey];
+        if (value && value != (id)kCFNull) {
+            [self yg_setValue:value forProperty:property ofModel:model];
+        }
+    }
+    return model;
+}
+
+#pragma mark - Private Methods
+
++ (NSArray *)yg_modelArrayWithArray:(NSArray *)array modelClass:(Class)modelClass {
+    NSMutableArray *models = [NSMutableArray arrayWithCapacity:array.count];
+    for (id element in array) {
+        id model = [self modelWithDictionary:element modelClass:modelClass];
+        if (model) {
+            [models addObject:model];
+        }
+    }
+    return models;
+}
+
++ (void)yg_setValue:(id)value forProperty:(YGModelPropertyMeta *)property ofModel:(id)model {
+    SEL setter = property->_setter;
+    
+    if (property->_type != YGModelPropertyTypeObject) {
+        NSNumber *number = YGModelNumberFromValue(value);
+        if (!number) return;
+        
+        switch (property->_type) {
+            case YGModelPropertyTypeBool:
+                ((void (*)(id, SEL, bool))(void *)objc_msgSend)(model, setter, number.boolValue);
+                break;
+            case YGModelPropertyTypeInt8:
+                ((void (*)(id, SEL, int8_t))(void *)objc_msgSend)(model, setter, number.charValue);
+                break;
+            case YGModelPropertyTypeUInt8:
+                ((void (*)(id, SEL, uint8_t))(void *)objc_msgSend)(model, setter, number.unsignedCharValue);
+                break;
+            case YGModelPropertyTypeInt16:
+                ((void (*)(id, SEL, int16_t))(void *)objc_msgSend)(model, setter, number.shortValue);
+                break;
+            case YGModelPropertyTypeUInt16:
+                ((void (*)(id, SEL, uint16_t))(void *)objc_msgSend)(model, setter, number.unsignedShortValue);
+                break;
+            case YGModelPropertyTypeInt32:
+                ((void (*)(id, SEL, int32_t))(void *)objc_msgSend)(model, setter, number.intValue);
+                break;
+            case YGModelPropertyTypeUInt32:
+                ((void (*)(id, SEL, uint32_t))(void *)objc_msgSend)(model, setter, number.unsignedIntValue);
+                break;
+            case YGModelPropertyTypeInt64:
+                ((void (*)(id, SEL, int64_t))(void *)objc_msgSend)(model, setter, number.longLongValue);
+                break;
+            case YGModelPropertyTypeUInt64:
+                ((void (*)(id, SEL, uint64_t))(void *)objc_msgSend)(model, setter, number.unsignedLongLongValue);
+                break;
+            case YGModelPropertyTypeFloat:
+                ((void (*)(id, SEL, float))(void *)objc_msgSend)(model, setter, number.floatValue);
+                break;
+            case YGModelPropertyTypeDouble:
+                ((void (*)(id, SEL, double))(void *)objc_msgSend)(model, setter, number.doubleValue);
+                break;
+            default:
+                break;
+        }
+        return;
+    }
+    
+    id object = nil;
+    switch (property->_objectType) {
+        case YGModelObjectTypeNSString:
+        case YGModelObjectTypeNSMutableString:
+            if ([value isKindOfClass:[NSString class]]) {
+                object = value;
+            } else if ([value isKindOfClass:[NSNumber class]]) {
+                object = [value stringValue];
+            }
+            if (object && property->_objectType == YGModelObjectTypeNSMutableString) {
+                object = [object mutableCopy];
+            }
+            break;
+        case YGModelObjectTypeNSNumber:
+            object = YGModelNumberFromValue(value);
+            break;
+        case YGModelObjectTypeNSDecimalNumber:
+            if ([value isKindOfClass:[NSNumber class]]) {
+                object = [NSDecimalNumber decimalNumberWithDecimal:[value decimalValue]];
+            } else if ([value isKindOfClass:[NSString class]]) {
+                object = [NSDecimalNumber decimalNumberWithString:value];
+            }
+            break;
+        case YGModelObjectTypeNSURL:
+            if ([value isKindOfClass:[NSURL class]]) {
+                object = value;
+            } else if ([value isKindOfClass:[NSString class]]) {
+                object = [NSURL URLWithString:value];
+            }
+            break;
+        case YGModelObjectTypeNSArray:
+        case YGModelObjectTypeNSMutableArray:
+            if ([value isKindOfClass:[NSArray class]]) {
+                object = property->_genericClass ? [self yg_modelArrayWithArray:value modelClass:property->_genericClass] : value;
+                object = (property->_objectType == YGModelObjectTypeNSMutableArray) ? [object mutableCopy] : object;
+            }
+            break;
+        case YGModelObjectTypeNSDictionary:
+        case YGModelObjectTypeNSMutableDictionary:
+            if ([value isKindOfClass:[NSDictionary class]]) {
+                object = value;
+                if (property->_genericClass) {
+                    NSMutableDictionary *models = [NSMutableDictionary dictionaryWithCapacity:[value count]];
+                    [(NSDictionary *)value enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+                        id model = [self modelWithDictionary:obj modelClass:property->_genericClass];
+                        if (model) {
+                            models[key] = model;
+                        }
+                    }];
+                    object = models;
+                }
+                object = (property->_objectType == YGModelObjectTypeNSMutableDictionary) ? [object mutableCopy] : object;
+            }
+            break;
+        case YGModelObjectTypeModel:
+            if ([value isKindOfClass:property->_cls]) {
+                object = value;
+            } else if ([value isKindOfClass:[NSDictionary class]]) {
+                object = [self modelWithDictionary:value modelClass:property->_cls];
+            }
+            break;
+        default:
+            if (!property->_cls || [value isKindOfClass:property->_cls]) {
+                object = value;
+            }
+            break;
+    }
+    
+    if (object) {
+        ((void (*)(id, SEL, id))(void *)objc_msgSend)(model, setter, object);
+    }
+}
+
+@end
@@ -13,5 +13,18 @@
 #import "YGRequest.h"
 #import "YGCenter.h"
 #import "YGEngine.h"
+#import "YGCache.h"
+#import "YGRetryPolicy.h"
+#import "YGCircuitBreaker.h"
+#import "YGJSONStreamParser.h"
+#import "YGRequestMetrics.h"
+#import "YGModelMapper.h"
+#import "YGDownloadResumeStore.h"
+#import "YGUploadResumeStore.h"
+#import "YGLock.h"
+#import "YGOfflineQueue.h"
+#import "YGConcurrencyLimiter.h"
+#import "YGHedgingPolicy.h"
+#import "YGRecordReplayTransport.h"
 
 #endif /* YGNetworking_h */
@@ -0,0 +1,143 @@
+//
+//  YGOfflineQueue.h
+//  YGNetworking
+//
+//  Created by Sun on 2020/4/30.
+//  Copyright © 2020 YGNetworking. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class YGRequest;
+
+/**
+ `YGOfflineQueue` 是 YGCenter 持有的持久化离线请求队列，保存 `durable` 为 `YES` 的请求，网络恢复后由 YGCenter 按顺序重放.
+ 
+ 队列使用预写日志 (write-ahead log) 保存: 入队和出队都只在日志末尾追加一条记录并同步到磁盘，应用重启后按顺序读取日志恢复队列.
+ 已出队的记录超过一定数量并且多于队列中的请求时，把队列中的请求重写到新的日志文件并原子替换 (压缩).
+ 
+ 持久化的内容是请求的配置 (url、HTTP 方法、请求头、参数、序列化类型等)，不包括回调 block:
+ 本次运行中入队的请求重放时调用原来的回调，应用重启后恢复的请求只调用 YGCenter 的 `offlineReplayBlock`.
+ NOTE: 参数、请求头和 `userInfo` 必须是合法的 JSON 对象，否则请求不会入队.
+ */
+@interface YGOfflineQueue : NSObject
+
+///---------------------
+/// @name 初始化
+///---------------------
+
+/**
+ 创建并返回一个 `YGOfflineQueue` 对象，目录位于 `Library/Application Support/com.ygnetworking.offline`.
+ NOTE: 离线请求需要在应用重启后继续发送，不使用会被系统清理的 `Library/Caches` 目录.
+ */
++ (instancetype)queue;
+
+/**
+ 创建并返回一个 `YGOfflineQueue` 对象.
+
+ @param path 保存队列日志的目录路径.
+ */
++ (instancetype)queueWithPath:(NSString *)path;
+
+- (instancetype)initWithPath:(NSString *)path NS_DESIGNATED_INITIALIZER;
+
+/**
+ 保存队列日志的目录路径.
+ */
+@property (nonatomic, copy, readonly) NSString *path;
+
+///---------------------
+/// @name 配置
+///---------------------
+
+/**
+ 重放时同时发送的最大请求数，默认为 `2`. 请求总是按入队顺序发送，需要严格按顺序完成时设置为 `1`.
+ */
+@property (nonatomic, assign) NSUInteger maxConcurrentReplayCount;
+
+/**
+ 队列中的最大请求数，队列已满时新的请求不会入队，按原来的错误结束，默认为 `1000`.
+ */
+@property (nonatomic, assign) NSUInteger maxRequestCount;
+
+///---------------------
+/// @name 状态
+///---------------------
+
+/**
+ 队列中的请求数 (深度)，包括正在重放的请求.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ 队列中最早的请求已经等待的时间(秒)，队列为空时为 `0`. 入队时间使用系统时间记录，应用重启后依然有效.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval oldestRequestAge;
+
+/**
+ 重放是否已经暂停，重放的请求再次因为网络错误失败时暂停，直到调用 `-resumeReplay`.
+ */
+@property (nonatomic, assign, readonly, getter=isReplayPaused) BOOL replayPaused;
+
+///---------------------
+/// @name 入队和重放
+///---------------------
+
+/**
+ 请求入队并同步写入磁盘.
+
+ @param request 处理后的请求，`url` 不能为空.
+ @return 请求在队列中的标识，同时设置为请求的 `offlineEntryIdentifier`; 请求不能序列化、队列已满或写入失败时返回 `nil`.
+ */
+- (nullable NSString *)enqueueRequest:(YGRequest *)request;
+
+/**
+ 按入队顺序取出下一个等待重放的请求并标记为正在重放，请求留在队列中直到调用 `-finishRequest:` 或 `-requeueRequest:`.
+ NOTE: 正在重放的请求数达到 `maxConcurrentReplayCount` 或重放已经暂停时返回 `nil`.
+ 应用重启后恢复的请求由队列重新创建，没有回调 block，也没有经过 YGCenter 的处理.
+ */
+- (nullable YGRequest *)dequeueRequest;
+
+/**
+ 请求重放结束 (成功或者不需要再重放的失败)，从队列中删除.
+ */
+- (void)finishRequest:(YGRequest *)request;
+
+/**
+ 重放的请求因为网络错误失败，放回原来的位置等待下一次重放，并暂停重放.
+
+ @return 请求已经不在队列中 (被取消或者被 `-removeAllRequests` 删除) 时返回 `NO`.
+ */
+- (BOOL)requeueRequest:(YGRequest *)request;
+
+/**
+ 恢复重放，YGCenter 在网络恢复时调用.
+ */
+- (void)resumeReplay;
+
+/**
+ 获取队列中的请求.
+
+ @param identifier 请求在队列中的标识.
+ @return 队列中的请求，不存在时返回 `nil`.
+ */
+- (nullable YGRequest *)requestWithIdentifier:(NSString *)identifier;
+
+/**
+ 删除等待重放的请求，用于取消请求.
+
+ @param identifier 请求在队列中的标识.
+ @return 被删除的请求，请求不存在或者正在重放时返回 `nil`.
+ */
+- (nullable YGRequest *)removeRequestWithIdentifier:(NSString *)identifier;
+
+/**
+ 删除队列中的所有请求，正在重放的请求结束后不会再放回队列.
+ */
+- (void)removeAllRequests;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,422 @@
+//
+//  YGOfflineQueue.m
+//  YGNetworking
+//
+//  Created by Sun on 2020/4/30.
+//  Copyright © 2020 YGNetworking. All rights reserved.
+//
+
+#import "YGOfflineQueue.h"
+#import "YGRequest.h"
+#import "YGConst.h"
+#import <fcntl.h>
+#import <unistd.h>
+
+static NSString * const YGOfflineQueueLogFileName = @"queue.log";
+
+/// 已出队的记录达到这个数量并且多于队列中的请求时压缩日志.
+static NSUInteger const YGOfflineQueueCompactionThreshold = 64;
+
+static NSDictionary * YGOfflineRecordFromRequest(YGRequest *request) {
+    NSMutableDictionary *record = [NSMutableDictionary dictionary];
+    record[@"url"] = request.url;
+    record[@"method"] = @(request.httpMethod);
+    record[@"requestSerializer"] = @(request.requestSerializerType);
+    record[@"responseSerializer"] = @(request.responseSerializerType);
+    record[@"compression"] = @(request.requestCompressionType);
+    record[@"compressionThreshold"] = @(request.requestCompressionThreshold);
+    record[@"priority"] = @(request.priority);
+    record[@"timeout"] = @(request.timeoutInterval);
+    record[@"retryCount"] = @(request.retryCount);
+    record[@"useGeneralHeaders"] = @(request.useGeneralHeaders);
+    record[@"useGeneralParameters"] = @(request.useGeneralParameters);
+    record[@"parameters"] = request.parameters;
+    record[@"headers"] = request.headers;
+    record[@"idempotencyKey"] = request.idempotencyKey;
+    record[@"group"] = request.group;
+    record[@"userInfo"] = request.userInfo;
+    return [NSJSONSerialization isValidJSONObject:record] ? [record copy] : nil;
+}
+
+static YGRequest * YGOfflineRequestFromRecord(NSDictionary *record) {
+    YGRequest *request = [YGRequest request];
+    request.url = record[@"url"];
+    request.httpMethod = [record[@"method"] integerValue];
+    request.requestSerializerType = [record[@"requestSerializer"] integerValue];
+    request.responseSerializerType = [record[@"responseSerializer"] integerValue];
+    request.requestCompressionType = [record[@"compression"] integerValue];
+    request.requestCompressionThreshold = [record[@"compressionThreshold"] unsignedIntegerValue];
+    request.priority = [record[@"priority"] integerValue];
+    request.timeoutInterval = [record[@"timeout"] doubleValue];
+    request.retryCount = [record[@"retryCount"] unsignedIntegerValue];
+    request.useGeneralHeaders = [record[@"useGeneralHeaders"] boolValue];
+    request.useGeneralParameters = [record[@"useGeneralParameters"] boolValue];
+    request.parameters = record[@"parameters"];
+    request.headers = record[@"headers"];
+    request.idempotencyKey = record[@"idempotencyKey"];
+    request.group = record[@"group"];
+    request.userInfo = record[@"userInfo"];
+    request.durable = YES;
+    return request;
+}
+
+#pragma mark - YGOfflineQueueEntry
+
+@interface YGOfflineQueueEntry : NSObject
+
+@property (nonatomic, copy) NSString *identifier;
+/// 序列化后的请求配置.
+@property (nonatomic, copy) NSDictionary *record;
+/// 入队时间，自 1970 年起的秒数.
+@property (nonatomic, assign) NSTimeInterval enqueueTime;
+/// 本次运行中入队或者已经恢复的请求对象.
+@property (nonatomic, strong, nullable) YGRequest *request;
+@property (nonatomic, assign, getter=isReplaying) BOOL replaying;
+
+@end
+
+@implementation YGOfflineQueueEntry
+
+- (NSDictionary *)logRecord {
+    return @{@"op": @"add", @"id": self.identifier, @"time": @(self.enqueueTime), @"request": self.record};
+}
+
+@end
+
+#pragma mark - YGOfflineQueue
+
+@interface YGOfflineQueue () {
+    pthread_mutex_t _lock;
+    int _fileDescriptor;
+    NSUInteger _deadRecordCount;
+    NSUInteger _replayingCount;
+    BOOL _replayPaused;
+}
+
+/// 按入队顺序排列的请求.
+@property (nonatomic, strong) NSMutableArray<YGOfflineQueueEntry *> *entries;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, YGOfflineQueueEntry *> *entryMap;
+@property (nonatomic, copy) NSString *logPath;
+
+@end
+
+@implementation YGOfflineQueue
+
++ (instancetype)queue {
+    return [[[self class] alloc] init];
+}
+
++ (instancetype)queueWithPath:(NSString *)path {
+    return [[[self class] alloc] initWithPath:path];
+}
+
+- (instancetype)init {
+    NSString *supportPath = NSSearchPathForDirectoriesInDomains(NSApplicationSupportDirectory, NSUserDomainMask, YES).firstObject;
+    return [self initWithPath:[supportPath stringByAppendingPathComponent:@"com.ygnetworking.offline"]];
+}
+
+- (instancetype)initWithPath:(NSString *)path {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _path = [path copy];
+    _logPath = [_path stringByAppendingPathComponent:YGOfflineQueueLogFileName];
+    _maxConcurrentReplayCount = 2;
+    _maxRequestCount = 1000;
+    _entries = [NSMutableArray array];
+    _entryMap = [NSMutableDictionary dictionary];
+    _fileDescriptor = -1;
+    YG_NETWORKING_LOCK_INIT();
+    
+    [[NSFileManager defaultManager] createDirectoryAtPath:_path withIntermediateDirectories:YES attributes:nil error:nil];
+    [self yg_loadLog];
+    
+    return self;
+}
+
+- (void)dealloc {
+    if (_fileDescriptor >= 0) {
+        close(_fileDescriptor);
+    }
+    YG_NETWORKING_LOCK_DESTROY();
+}
+
+#pragma mark - Public Methods
+
+- (NSString *)enqueueRequest:(YGRequest *)request {
+    if (request.url.length == 0) return nil;
+    
+    NSDictionary *record = YGOfflineRecordFromRequest(request);
+    if (!record) return nil;
+    
+    YGOfflineQueueEntry *entry = [[YGOfflineQueueEntry alloc] init];
+    entry.identifier = [@"Q" stringByAppendingString:[NSUUID UUID].UUIDString];
+    entry.record = record;
+    entry.enqueueTime = [[NSDate date] timeIntervalSince1970];
+    entry.request = request;
+    
+    YG_NETWORKING_LOCK();
+    BOOL enqueued = self.entries.count < self.maxRequestCount && [self yg_appendLogRecord:[entry logRecord]];
+    if (enqueued) {
+        [self.entries addObject:entry];
+        self.entryMap[entry.identifier] = entry;
+        [request setValue:entry.identifier forKey:@"_offlineEntryIdentifier"];
+    }
+    YG_NETWORKING_UNLOCK();
+    
+    return enqueued ? entry.identifier : nil;
+}
+
+- (YGRequest *)dequeueRequest {
+    YGRequest *request = nil;
+    YG_NETWORKING_LOCK();
+    if (!_replayPaused && _replayingCount < MAX(self.maxConcurrentReplayCount, 1)) {
+        for (YGOfflineQueueEntry *entry in self.entries) {
+            if (entry.isReplaying) continue;
+            
+            if (!entry.request) {
+                entry.request = [self yg_requestForEntry:entry];
+            }
+            entry.replaying = YES;
+            _replayingCount++;
+            request = entry.request;
+            break;
+        }
+    }
+    YG_NETWORKING_UNLOCK();
+    return request;
+}
+
+- (void)finishRequest:(YGRequest *)request {
+    NSString *identifier = request.offlineEntryIdentifier;
+    if (!identifier) return;
+    
+    YG_NETWORKING_LOCK();
+    [self yg_removeEntryWithIdentifier:identifier];
+    // the entry may already be gone after `-removeAllRequests`.
+    [request setValue:nil forKey:@"_offlineEntryIdentifier"];
+    YG_NETWORKING_UNLOCK();
+}
+
+- (BOOL)requeueRequest:(YGRequest *)request {
+    NSString *identifier = request.offlineEntryIdentifier;
+    if (!identifier) return NO;
+    
+    YG_NETWORKING_LOCK();
+    YGOfflineQueueEntry *entry = self.entryMap[identifier];
+    if (entry.isReplaying) {
+        entry.replaying = NO;
+        _replayingCount--;
+        // the network is still unusable, replaying the following requests would fail the same way.
+        _replayPaused = YES;
+    }
+    YG_NETWORKING_UNLOCK();
+    return entry != nil;
+}
+
+- (void)resumeReplay {
+    YG_NETWORKING_LOCK();
+    _replayPaused = NO;
+    YG_NETWORKING_UNLOCK();
+}
+
+- (YGRequest *)requestWithIdentifier:(NSString *)identifier {
+    if (!identifier) return nil;
+    
+    YG_NETWORKING_LOCK();
+    YGOfflineQueueEntry *entry = self.entryMap[identifier];
+    if (entry && !entry.request) {
+        entry.request = [self yg_requestForEntry:entry];
+    }
+    YGRequest *request = entry.request;
+    YG_NETWORKING_UNLOCK();
+    return request;
+}
+
+- (YGRequest *)removeRequestWithIdentifier:(NSString *)identifier {
+    if (!identifier) return nil;
+    
+    YGRequest *request = nil;
+    YG_NETWORKING_LOCK();
+    YGOfflineQueueEntry *entry = self.entryMap[identifier];
+    if (entry && !entry.isReplaying) {
+        request = entry.request ?: [self yg_requestForEntry:entry];
+        [self yg_removeEntryWithIdentifier:identifier];
+    }
+    YG_NETWORKING_UNLOCK();
+    return request;
+}
+
+- (void)removeAllRequests {
+    YG_NETWORKING_LOCK();
+    [self.entries removeAllObjects];
+    [self.entryMap removeAllObjects];
+    _replayingCount = 0;
+    _deadRecordCount = 0;
+    if (_fileDescriptor >= 0) {
+        ftruncate(_fileDescriptor, 0);
+        fsync(_fileDescriptor);
+    }
+    YG_NETWORKING_UNLOCK();
+}
+
+#pragma mark - Accessor
+
+- (NSUInteger)count {
+    YG_NETWORKING_LOCK();
+    NSUInteger count = self.entries.count;
+    YG_NETWORKING_UNLOCK();
+    return count;
+}
+
+- (NSTimeInterval)oldestRequestAge {
+    YG_NETWORKING_LOCK();
+    NSTimeInterval enqueueTime = self.entries.firstObject.enqueueTime;
+    NSUInteger count = self.entries.count;
+    YG_NETWORKING_UNLOCK();
+    return count > 0 ? MAX([[NSDate date] timeIntervalSince1970] - enqueueTime, 0) : 0;
+}
+
+- (BOOL)isReplayPaused {
+    YG_NETWORKING_LOCK();
+    BOOL replayPaused = _replayPaused;
+    YG_NETWORKING_UNLOCK();
+    return replayPaused;
+}
+
+#pragma mark - Private Methods
+
+/**
+ 创建恢复的请求对象，请求的 `identifier` 在发送前为队列中的标识.
+ */
+- (YGRequest *)yg_requestForEntry:(YGOfflineQueueEntry *)entry {
+    YGRequest *request = YGOfflineRequestFromRecord(entry.record);
+    [request setValue:entry.identifier forKey:@"_identifier"];
+    [request setValue:entry.identifier forKey:@"_offlineEntryIdentifier"];
+    return request;
+}
+
+/**
+ 删除请求并追加出队记录，必须在持有 `_lock` 时调用.
+ */
+- (void)yg_removeEntryWithIdentifier:(NSString *)identifier {
+    YGOfflineQueueEntry *entry = self.entryMap[identifier];
+    if (!entry) return;
+    
+    if (entry.isReplaying) {
+        _replayingCount--;
+    }
+    [self.entries removeObjectIdenticalTo:entry];
+    [self.entryMap removeObjectForKey:identifier];
+    [entry.request setValue:nil forKey:@"_offlineEntryIdentifier"];
+    
+    if ([self yg_appendLogRecord:@{@"op": @"remove", @"id": identifier}]) {
+        _deadRecordCount++;
+    }
+    if (_deadRecordCount >= YGOfflineQueueCompactionThreshold && _deadRecordCount > self.entries.count) {
+        [self yg_compactLog];
+    }
+}
+
+/**
+ 读取日志恢复队列. 日志的每一行是一条 JSON 记录，应用在写入时退出可能留下不完整的最后一行，解析失败的行被忽略.
+ */
+- (void)yg_loadLog {
+    NSData *data = [NSData dataWithContentsOfFile:self.logPath options:NSDataReadingMappedIfSafe error:nil];
+    const char *bytes = data.bytes;
+    NSUInteger length = data.length;
+    NSUInteger lineStart = 0;
+    BOOL needsCompaction = NO;
+    
+    while (lineStart < length) {
+        const char *newline = memchr(bytes + lineStart, '\n', length - lineStart);
+        NSUInteger lineEnd = newline ? (NSUInteger)(newline - bytes) : length;
+        NSData *lineData = [data subdataWithRange:NSMakeRange(lineStart, lineEnd - lineStart)];
+        lineStart = lineEnd + 1;
+        
+        NSDictionary *logRecord = lineData.length > 0 ? [NSJSONSerialization JSONObjectWithData:lineData options:0 error:nil] : nil;
+        NSString *identifier = [logRecord isKindOfClass:[NSDictionary class]] ? logRecord[@"id"] : nil;
+        if (![identifier isKindOfClass:[NSString class]]) {
+            needsCompaction = YES;
+            continue;
+        }
+        
+        if ([logRecord[@"op"] isEqualToString:@"add"] && [logRecord[@"request"] isKindOfClass:[NSDictionary class]]) {
+            if (self.entryMap[identifier]) continue;
+            
+            YGOfflineQueueEntry *entry = [[YGOfflineQueueEntry alloc] init];
+            entry.identifier = identifier;
+            entry.record = logRecord[@"request"];
+            entry.enqueueTime = [logRecord[@"time"] doubleValue];
+            [self.entries addObject:entry];
+            self.entryMap[identifier] = entry;
+        } else {
+            YGOfflineQueueEntry *entry = self.entryMap[identifier];
+            if (entry) {
+                [self.entries removeObjectIdenticalTo:entry];
+                [self.entryMap removeObjectForKey:identifier];
+            }
+            needsCompaction = YES;
+        }
+    }
+    
+    if (needsCompaction) {
+        [self yg_compactLog];
+    } else {
+        [self yg_openLog];
+    }
+}
+
+- (void)yg_openLog {
+    if (_fileDescriptor >= 0) {
+        close(_fileDescriptor);
+    }
+    _fileDescriptor = open(self.logPath.fileSystemRepresentation, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+}
+
+/**
+ 追加一条记录并同步到磁盘，写入失败时截断写入的部分，不会把后面的记录接在不完整的行后面.
+ */
+- (BOOL)yg_appendLogRecord:(NSDictionary *)logRecord {
+    if (_fileDescriptor < 0) return NO;
+    
+    NSMutableData *data = [[NSJSONSerialization dataWithJSONObject:logRecord options:0 error:nil] mutableCopy];
+    if (!data) return NO;
+    [data appendBytes:"\n" length:1];
+    
+    off_t offset = lseek(_fileDescriptor, 0, SEEK_END);
+    const char *bytes = data.bytes;
+    NSUInteger written = 0;
+    while (written < data.length) {
+        ssize_t result = write(_fileDescriptor, bytes + written, data.length - written);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            ftruncate(_fileDescriptor, offset);
+            return NO;
+        }
+        written += result;
+    }
+    return fsync(_fileDescriptor) == 0;
+}
+
+/**
+ 把队列中的请求写入新的日志文件并原子替换旧的日志.
+ */
+- (void)yg_compactLog {
+    NSMutableData *data = [NSMutableData data];
+    for (YGOfflineQueueEntry *entry in self.entries) {
+        NSData *lineData = [NSJSONSerialization dataWithJSONObject:[entry logRecord] options:0 error:nil];
+        if (!lineData) continue;
+        [data appendData:lineData];
+        [data appendBytes:"\n" length:1];
+    }
+    // keep appending to the old log if the new one can not be written, it still replays to the same queue.
+    if ([data writeToFile:self.logPath options:NSDataWritingAtomic error:nil]) {
+        _deadRecordCount = 0;
+    }
+    [self yg_openLog];
+}
+
+@end
@@ -0,0 +1,104 @@
+//
+//  YGRecordReplayTransport.h
+//  YGNetworking
+//
+//  Created by Sun on 2020/5/6.
+//  Copyright © 2020 YGNetworking. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "YGConst.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `YGRecordReplayTransport` 是 YGEngine 在 URL 加载系统 (NSURLProtocol) 层面的录制/回放传输，用于没有网络时可重复的性能测试和回归测试.
+ 
+ 录制模式下请求照常发往服务端，请求和响应 (状态码、响应头、响应体、错误和耗时) 被记录下来，调用 `-saveWithError:` 写入存档文件;
+ 回放模式下请求不会发出，由存档中匹配的响应按录制时的耗时 (乘以 `latencyScale`) 返回.
+ 请求仍然经过 YGCenter 和 YGEngine 的全部处理 (处理 block、序列化、调度、解码和回调)，只有网络被替换.
+ 
+ 请求按 HTTP 方法、完整的 URL 和请求体的摘要匹配，不比较请求头. 同一个请求录制了多次时按录制的顺序循环回放.
+ 存档是一个 JSON 文件: `{"version": 1, "entries": [...]}`，每个条目包含 `method`、`url`、`bodyDigest`、`statusCode`、
+ `headers`、`body` (base64)、`responseDelay` (收到响应头的耗时)、`duration` (总耗时) 和可选的 `error` (`domain` 和 `code`).
+ 
+ NOTE: NSURLProtocol 只能按类注册，同一时间只有 `activeTransport` 生效，设置 YGEngine 的 `recordReplayTransport` 时会同时设置它.
+ */
+@interface YGRecordReplayTransport : NSObject
+
+///---------------------
+/// @name 初始化
+///---------------------
+
+/**
+ 创建并返回一个录制模式的 `YGRecordReplayTransport` 对象.
+
+ @param path 存档文件的路径，调用 `-saveWithError:` 时写入.
+ */
++ (instancetype)recorderWithArchivePath:(NSString *)path;
+
+/**
+ 创建并返回一个回放模式的 `YGRecordReplayTransport` 对象.
+
+ @param path 存档文件的路径.
+ @param error 存档不存在或者格式错误时返回的错误.
+ @return 读取存档失败时返回 `nil`.
+ */
++ (nullable instancetype)replayerWithArchivePath:(NSString *)path error:(NSError * _Nullable __autoreleasing *)error;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ 传输的模式.
+ */
+@property (nonatomic, assign, readonly) YGRecordReplayMode mode;
+
+/**
+ 存档文件的路径.
+ */
+@property (nonatomic, copy, readonly) NSString *archivePath;
+
+///---------------------
+/// @name 回放
+///---------------------
+
+/**
+ 回放时耗时的倍数，默认为 `1` (按录制时的耗时返回)，为 `0` 时立即返回.
+ */
+@property (nonatomic, assign) double latencyScale;
+
+///---------------------
+/// @name 录制
+///---------------------
+
+/**
+ 已经录制 (或者存档中) 的条目数.
+ */
+@property (nonatomic, assign, readonly) NSUInteger entryCount;
+
+/**
+ 把录制的条目写入存档文件.
+
+ @param error 写入失败时返回的错误.
+ @return 写入成功时返回 `YES`，回放模式下不写入并返回 `NO`.
+ */
+- (BOOL)saveWithError:(NSError * _Nullable __autoreleasing *)error;
+
+///---------------------
+/// @name URL 加载系统
+///---------------------
+
+/**
+ 拦截请求的 NSURLProtocol 子类，YGEngine 把它放在 session 配置的 `protocolClasses` 最前面.
+ 自定义的 NSURLSession 也需要回放时把它加入自己的配置.
+ */
++ (Class)protocolClass;
+
+/**
+ 当前生效的传输，为 `nil` 时 `protocolClass` 不拦截任何请求.
+ */
+@property (class, nonatomic, strong, nullable) YGRecordReplayTransport *activeTransport;
+
+@end
+
+NS_ASSUME_NONNULL_END
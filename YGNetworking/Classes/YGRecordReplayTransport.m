@@ -0,0 +1,542 @@
+//
+//  YGRecordReplayTransport.m
+//  YGNetworking
+//
+//  Created by Sun on 2020/5/6.
+//  Copyright © 2020 YGNetworking. All rights reserved.
+//
+
+#import "YGRecordReplayTransport.h"
+#import <CommonCrypto/CommonDigest.h>
+
+static NSString * const YGRecordReplayArchiveVersionKey = @"version";
+static NSString * const YGRecordReplayArchiveEntriesKey = @"entries";
+static const NSInteger YGRecordReplayArchiveVersion = 1;
+
+static pthread_mutex_t YGActiveTransportLock = PTHREAD_MUTEX_INITIALIZER;
+static YGRecordReplayTransport *YGActiveTransport = nil;
+
+static NSData * YGRecordReplayBodyOfRequest(NSURLRequest *request) {
+    if (request.HTTPBody) return request.HTTPBody;
+    
+    // NSURLSession hands the body to protocols as a stream.
+    NSInputStream *stream = request.HTTPBodyStream;
+    if (!stream) return nil;
+    
+    NSMutableData *body = [NSMutableData data];
+    uint8_t buffer[16 * 1024];
+    [stream open];
+    while (YES) {
+        NSInteger length = [stream read:buffer maxLength:sizeof(buffer)];
+        if (length <= 0) break;
+        [body appendBytes:buffer length:length];
+    }
+    [stream close];
+    return body;
+}
+
+static NSString * YGRecordReplayDigestOfData(NSData *data) {
+    if (data.length == 0) return @"";
+    
+    unsigned char digest[CC_MD5_DIGEST_LENGTH];
+    CC_MD5(data.bytes, (CC_LONG)data.length, digest);
+    NSMutableString *string = [NSMutableString stringWithCapacity:CC_MD5_DIGEST_LENGTH * 2];
+    for (int i = 0; i < CC_MD5_DIGEST_LENGTH; i++) {
+        [string appendFormat:@"%02x", digest[i]];
+    }
+    return string;
+}
+
+static NSString * YGRecordReplayKey(NSString *method, NSString *url, NSString *bodyDigest) {
+    return [NSString stringWithFormat:@"%@ %@ %@", method.uppercaseString ?: @"GET", url ?: @"", bodyDigest ?: @""];
+}
+
+#pragma mark - YGRecordReplayEntry
+
+/**
+ 存档中的一个请求和它的响应.
+ */
+@interface YGRecordReplayEntry : NSObject
+
+@property (nonatomic, copy) NSString *method;
+@property (nonatomic, copy) NSString *url;
+@property (nonatomic, copy) NSString *bodyDigest;
+@property (nonatomic, assign) NSInteger statusCode;
+@property (nonatomic, copy) NSDictionary<NSString *, NSString *> *headers;
+@property (nonatomic, copy) NSData *body;
+@property (nonatomic, assign) NSTimeInterval responseDelay;
+@property (nonatomic, assign) NSTimeInterval duration;
+@property (nonatomic, strong, nullable) NSError *error;
+
+- (nullable instancetype)initWithDictionary:(NSDictionary *)dictionary;
+- (NSDictionary *)dictionaryRepresentation;
+- (NSString *)key;
+
+@end
+
+@implementation YGRecordReplayEntry
+
+- (instancetype)initWithDictionary:(NSDictionary *)dictionary {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    if (![dictionary isKindOfClass:[NSDictionary class]] ||
+        ![dictionary[@"method"] isKindOfClass:[NSString class]] ||
+        ![dictionary[@"url"] isKindOfClass:[NSString class]]) {
+        return nil;
+    }
+    _method = dictionary[@"method"];
+    _url = dictionary[@"url"];
+    _bodyDigest = [dictionary[@"bodyDigest"] isKindOfClass:[NSString class]] ? dictionary[@"bodyDigest"] : @"";
+    _statusCode = [dictionary[@"statusCode"] integerValue] ?: 200;
+    _headers = [dictionary[@"headers"] isKindOfClass:[NSDictionary class]] ? dictionary[@"headers"] : @{};
+    _body = [dictionary[@"body"] isKindOfClass:[NSString class]] ? [[NSData alloc] initWithBase64EncodedString:dictionary[@"body"] options:0] : nil;
+    _responseDelay = MAX([dictionary[@"responseDelay"] doubleValue], 0);
+    _duration = MAX([dictionary[@"duration"] doubleValue], _responseDelay);
+    NSDictionary *error = dictionary[@"error"];
+    if ([error isKindOfClass:[NSDictionary class]] && [error[@"domain"] isKindOfClass:[NSString class]]) {
+        _error = [NSError errorWithDomain:error[@"domain"] code:[error[@"code"] integerValue] userInfo:@{NSURLErrorFailingURLStringErrorKey: _url}];
+    }
+    return self;
+}
+
+- (NSDictionary *)dictionaryRepresentation {
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionary];
+    dictionary[@"method"] = self.method;
+    dictionary[@"url"] = self.url;
+    dictionary[@"bodyDigest"] = self.bodyDigest ?: @"";
+    dictionary[@"statusCode"] = @(self.statusCode);
+    dictionary[@"headers"] = self.headers ?: @{};
+    dictionary[@"body"] = [self.body base64EncodedStringWithOptions:0] ?: @"";
+    dictionary[@"responseDelay"] = @(self.responseDelay);
+    dictionary[@"duration"] = @(self.duration);
+    if (self.error) {
+        dictionary[@"error"] = @{@"domain": self.error.domain, @"code": @(self.error.code)};
+    }
+    return dictionary;
+}
+
+- (NSString *)key {
+    return YGRecordReplayKey(self.method, self.url, self.bodyDigest);
+}
+
+@end
+
+#pragma mark - YGRecordReplayTransport
+
+@interface YGRecordReplayTransport () {
+    pthread_mutex_t _lock;
+}
+
+@property (nonatomic, strong) NSMutableArray<YGRecordReplayEntry *> *entries;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSMutableArray<YGRecordReplayEntry *> *> *entriesByKey;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *replayIndexes;
+
+- (void)yg_addEntry:(YGRecordReplayEntry *)entry;
+- (nullable YGRecordReplayEntry *)yg_nextEntryForKey:(NSString *)key;
+
+@end
+
+#pragma mark - YGRecordReplayURLProtocol
+
+/**
+ 拦截 YGEngine 请求的 NSURLProtocol, 录制模式下通过 `YGRecordReplayForwarder` 转发请求, 回放模式下返回存档中的响应.
+ NOTE: 对 client 的回调都在调用 `-startLoading` 的线程中执行, `_stopped` 只在这个线程中读写.
+ */
+@interface YGRecordReplayURLProtocol : NSURLProtocol {
+    YGRecordReplayTransport *_transport;
+    NSThread *_clientThread;
+    NSArray<NSString *> *_modes;
+    BOOL _stopped;
+    
+    NSString *_bodyDigest;
+    NSURLSessionDataTask *_dataTask;
+    NSTimeInterval _startTimestamp;
+    NSTimeInterval _responseDelay;
+    NSHTTPURLResponse *_response;
+    NSMutableData *_data;
+}
+
+- (void)yg_forwarderDidReceiveResponse:(NSURLResponse *)response;
+- (void)yg_forwarderDidReceiveData:(NSData *)data;
+- (void)yg_forwarderDidCompleteWithError:(NSError *)error;
+
+@end
+
+#pragma mark - YGRecordReplayForwarder
+
+/**
+ 录制模式下发送请求的 session, session 的配置中没有 `YGRecordReplayURLProtocol`, 请求不会再次被拦截.
+ */
+@interface YGRecordReplayForwarder : NSObject <NSURLSessionDataDelegate> {
+    pthread_mutex_t _lock;
+}
+
+@property (nonatomic, strong) NSURLSession *session;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, YGRecordReplayURLProtocol *> *protocols;
+
+@end
+
+@implementation YGRecordReplayForwarder
+
++ (instancetype)sharedForwarder {
+    static YGRecordReplayForwarder *forwarder = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        forwarder = [[YGRecordReplayForwarder alloc] init];
+    });
+    return forwarder;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    YG_NETWORKING_LOCK_INIT();
+    _protocols = [NSMutableDictionary dictionary];
+    NSURLSessionConfiguration *configuration = [NSURLSessionConfiguration defaultSessionConfiguration];
+    // record what the network does, not what the URL cache has.
+    configuration.URLCache = nil;
+    NSOperationQueue *delegateQueue = [[NSOperationQueue alloc] init];
+    delegateQueue.maxConcurrentOperationCount = 1;
+    delegateQueue.name = @"com.ygnetworking.recordreplay.forwarder";
+    _session = [NSURLSession sessionWithConfiguration:configuration delegate:self delegateQueue:delegateQueue];
+    
+    return self;
+}
+
+- (NSURLSessionDataTask *)dataTaskWithRequest:(NSURLRequest *)request protocol:(YGRecordReplayURLProtocol *)protocol {
+    NSURLSessionDataTask *dataTask = [self.session dataTaskWithRequest:request];
+    YG_NETWORKING_LOCK();
+    self.protocols[@(dataTask.taskIdentifier)] = protocol;
+    YG_NETWORKING_UNLOCK();
+    return dataTask;
+}
+
+- (YGRecordReplayURLProtocol *)yg_protocolForTask:(NSURLSessionTask *)task remove:(BOOL)remove {
+    YG_NETWORKING_LOCK();
+    YGRecordReplayURLProtocol *protocol = self.protocols[@(task.taskIdentifier)];
+    if (remove) {
+        [self.protocols removeObjectForKey:@(task.taskIdentifier)];
+    }
+    YG_NETWORKING_UNLOCK();
+    return protocol;
+}
+
+#pragma mark - NSURLSessionDataDelegate
+
+- (void)URLSession:(NSURLSession *)session
+          dataTask:(NSURLSessionDataTask *)dataTask
+didReceiveResponse:(NSURLResponse *)response
+ completionHandler:(void (^)(NSURLSessionResponseDisposition))completionHandler {
+    [[self yg_protocolForTask:dataTask remove:NO] yg_forwarderDidReceiveResponse:response];
+    completionHandler(NSURLSessionResponseAllow);
+}
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveData:(NSData *)data {
+    [[self yg_protocolForTask:dataTask remove:NO] yg_forwarderDidReceiveData:data];
+}
+
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task didCompleteWithError:(NSError *)error {
+    [[self yg_protocolForTask:task remove:YES] yg_forwarderDidCompleteWithError:error];
+}
+
+@end
+
+@implementation YGRecordReplayURLProtocol
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request {
+    NSString *scheme = request.URL.scheme.lowercaseString;
+    return YGRecordReplayTransport.activeTransport && ([scheme isEqualToString:@"http"] || [scheme isEqualToString:@"https"]);
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request {
+    return request;
+}
+
+- (void)startLoading {
+    _transport = YGRecordReplayTransport.activeTransport;
+    _clientThread = [NSThread currentThread];
+    NSString *currentMode = [NSRunLoop currentRunLoop].currentMode;
+    _modes = (currentMode && ![currentMode isEqualToString:NSDefaultRunLoopMode]) ? @[NSDefaultRunLoopMode, currentMode] : @[NSDefaultRunLoopMode];
+    
+    if (!_transport) {
+        // the transport was removed after the task was created.
+        [self.client URLProtocol:self didFailWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]];
+        return;
+    }
+    
+    NSData *body = YGRecordReplayBodyOfRequest(self.request);
+    _bodyDigest = YGRecordReplayDigestOfData(body);
+    if (_transport.mode == kYGRecordReplayModeReplay) {
+        NSString *key = YGRecordReplayKey(self.request.HTTPMethod, self.request.URL.absoluteString, _bodyDigest);
+        [self yg_replayEntry:[_transport yg_nextEntryForKey:key]];
+        return;
+    }
+    
+    NSMutableURLRequest *request = [self.request mutableCopy];
+    if (body) {
+        request.HTTPBodyStream = nil;
+        request.HTTPBody = body;
+    }
+    _data = [NSMutableData data];
+    _startTimestamp = [NSProcessInfo processInfo].systemUptime;
+    _dataTask = [[YGRecordReplayForwarder sharedForwarder] dataTaskWithRequest:request protocol:self];
+    [_dataTask resume];
+}
+
+- (void)stopLoading {
+    _stopped = YES;
+    [_dataTask cancel];
+}
+
+#pragma mark - Replay
+
+- (void)yg_replayEntry:(YGRecordReplayEntry *)entry {
+    if (!entry) {
+        NSError *error = [NSError errorWithDomain:YGErrorDomain
+                                             code:kYGErrorReplayMissing
+                                         userInfo:@{NSLocalizedDescriptionKey: [NSString stringWithFormat:@"No recorded response for %@ %@.", self.request.HTTPMethod, self.request.URL.absoluteString],
+                                                    NSURLErrorFailingURLStringErrorKey: self.request.URL.absoluteString ?: @""}];
+        [self.client URLProtocol:self didFailWithError:error];
+        return;
+    }
+    
+    double latencyScale = MAX(_transport.latencyScale, 0);
+    NSTimeInterval responseDelay = entry.responseDelay * latencyScale;
+    NSTimeInterval bodyDelay = (entry.duration - entry.responseDelay) * latencyScale;
+    NSHTTPURLResponse *response = entry.error ? nil : [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                                                                   statusCode:entry.statusCode
+                                                                                  HTTPVersion:@"HTTP/1.1"
+                                                                                 headerFields:entry.headers];
+    __weak __typeof(self)weakSelf = self;
+    [self yg_performAfterDelay:responseDelay block:^{
+        __strong __typeof(weakSelf)strongSelf = weakSelf;
+        if (response) {
+            [strongSelf.client URLProtocol:strongSelf didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+        }
+        // chained rather than scheduled together, so the body never overtakes the response.
+        [strongSelf yg_performAfterDelay:bodyDelay block:^{
+            __strong __typeof(weakSelf)strongSelf = weakSelf;
+            if (entry.error) {
+                [strongSelf.client URLProtocol:strongSelf didFailWithError:entry.error];
+                return;
+            }
+            if (entry.body.length > 0) {
+                [strongSelf.client URLProtocol:strongSelf didLoadData:entry.body];
+            }
+            [strongSelf.client URLProtocolDidFinishLoading:strongSelf];
+        }];
+    }];
+}
+
+#pragma mark - Record
+
+- (void)yg_forwarderDidReceiveResponse:(NSURLResponse *)response {
+    _responseDelay = [NSProcessInfo processInfo].systemUptime - _startTimestamp;
+    _response = [response isKindOfClass:[NSHTTPURLResponse class]] ? (NSHTTPURLResponse *)response : nil;
+    [self yg_performAfterDelay:0 block:^{
+        [self.client URLProtocol:self didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+    }];
+}
+
+- (void)yg_forwarderDidReceiveData:(NSData *)data {
+    [_data appendData:data];
+    [self yg_performAfterDelay:0 block:^{
+        [self.client URLProtocol:self didLoadData:data];
+    }];
+}
+
+- (void)yg_forwarderDidCompleteWithError:(NSError *)error {
+    BOOL cancelled = [error.domain isEqualToString:NSURLErrorDomain] && error.code == NSURLErrorCancelled;
+    if (!cancelled) {
+        YGRecordReplayEntry *entry = [[YGRecordReplayEntry alloc] init];
+        entry.method = self.request.HTTPMethod ?: @"GET";
+        entry.url = self.request.URL.absoluteString;
+        entry.bodyDigest = _bodyDigest;
+        entry.statusCode = _response.statusCode;
+        NSMutableDictionary<NSString *, NSString *> *headers = [_response.allHeaderFields mutableCopy] ?: [NSMutableDictionary dictionary];
+        // the body is stored decoded, its original encoding and length no longer apply.
+        for (NSString *field in headers.allKeys) {
+            if ([field caseInsensitiveCompare:@"Content-Encoding"] == NSOrderedSame || [field caseInsensitiveCompare:@"Content-Length"] == NSOrderedSame) {
+                [headers removeObjectForKey:field];
+            }
+        }
+        entry.headers = headers;
+        entry.body = _data;
+        entry.duration = [NSProcessInfo processInfo].systemUptime - _startTimestamp;
+        entry.responseDelay = MIN(_responseDelay, entry.duration);
+        entry.error = error;
+        [_transport yg_addEntry:entry];
+    }
+    
+    [self yg_performAfterDelay:0 block:^{
+        if (error) {
+            [self.client URLProtocol:self didFailWithError:error];
+        } else {
+            [self.client URLProtocolDidFinishLoading:self];
+        }
+    }];
+}
+
+#pragma mark - Private Methods
+
+- (void)yg_performAfterDelay:(NSTimeInterval)delay block:(dispatch_block_t)block {
+    if (delay <= 0) {
+        [self performSelector:@selector(yg_performBlock:) onThread:_clientThread withObject:[block copy] waitUntilDone:NO modes:_modes];
+        return;
+    }
+    __weak __typeof(self)weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        [weakSelf yg_performAfterDelay:0 block:block];
+    });
+}
+
+- (void)yg_performBlock:(dispatch_block_t)block {
+    if (_stopped) return;
+    block();
+}
+
+@end
+
+#pragma mark - YGRecordReplayTransport
+
+@implementation YGRecordReplayTransport
+
++ (instancetype)recorderWithArchivePath:(NSString *)path {
+    NSParameterAssert(path);
+    return [[self alloc] yg_initWithMode:kYGRecordReplayModeRecord archivePath:path];
+}
+
++ (instancetype)replayerWithArchivePath:(NSString *)path error:(NSError * _Nullable __autoreleasing *)error {
+    NSParameterAssert(path);
+    
+    NSData *data = [NSData dataWithContentsOfFile:path options:0 error:error];
+    if (!data) return nil;
+    NSDictionary *archive = [NSJSONSerialization JSONObjectWithData:data options:0 error:error];
+    if (!archive) return nil;
+    
+    NSArray *entries = [archive isKindOfClass:[NSDictionary class]] ? archive[YGRecordReplayArchiveEntriesKey] : nil;
+    if (![entries isKindOfClass:[NSArray class]] || [archive[YGRecordReplayArchiveVersionKey] integerValue] != YGRecordReplayArchiveVersion) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:@{NSFilePathErrorKey: path}];
+        }
+        return nil;
+    }
+    
+    YGRecordReplayTransport *transport = [[self alloc] yg_initWithMode:kYGRecordReplayModeReplay archivePath:path];
+    for (NSDictionary *dictionary in entries) {
+        YGRecordReplayEntry *entry = [[YGRecordReplayEntry alloc] initWithDictionary:dictionary];
+        if (entry) {
+            [transport yg_addEntry:entry];
+        }
+    }
+    return transport;
+}
+
+- (instancetype)yg_initWithMode:(YGRecordReplayMode)mode archivePath:(NSString *)path {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    YG_NETWORKING_LOCK_INIT();
+    _mode = mode;
+    _archivePath = [path copy];
+    _latencyScale = 1.0;
+    _entries = [NSMutableArray array];
+    _entriesByKey = [NSMutableDictionary dictionary];
+    _replayIndexes = [NSMutableDictionary dictionary];
+    
+    return self;
+}
+
+- (void)dealloc {
+    YG_NETWORKING_LOCK_DESTROY();
+}
+
+#pragma mark - Public Methods
+
+- (NSUInteger)entryCount {
+    YG_NETWORKING_LOCK();
+    NSUInteger count = self.entries.count;
+    YG_NETWORKING_UNLOCK();
+    return count;
+}
+
+- (BOOL)saveWithError:(NSError * _Nullable __autoreleasing *)error {
+    if (self.mode != kYGRecordReplayModeRecord) return NO;
+    
+    NSMutableArray<NSDictionary *> *entries = [NSMutableArray array];
+    YG_NETWORKING_LOCK();
+    for (YGRecordReplayEntry *entry in self.entries) {
+        [entries addObject:[entry dictionaryRepresentation]];
+    }
+    YG_NETWORKING_UNLOCK();
+    
+    NSData *data = [NSJSONSerialization dataWithJSONObject:@{YGRecordReplayArchiveVersionKey: @(YGRecordReplayArchiveVersion),
+                                                             YGRecordReplayArchiveEntriesKey: entries}
+                                                   options:0
+                                                     error:error];
+    if (!data) return NO;
+    
+    NSString *directory = [self.archivePath stringByDeletingLastPathComponent];
+    if (directory.length > 0 && ![[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:error]) {
+        return NO;
+    }
+    return [data writeToFile:self.archivePath options:NSDataWritingAtomic error:error];
+}
+
++ (Class)protocolClass {
+    return [YGRecordReplayURLProtocol class];
+}
+
++ (YGRecordReplayTransport *)activeTransport {
+    pthread_mutex_lock(&YGActiveTransportLock);
+    YGRecordReplayTransport *transport = YGActiveTransport;
+    pthread_mutex_unlock(&YGActiveTransportLock);
+    return transport;
+}
+
++ (void)setActiveTransport:(YGRecordReplayTransport *)activeTransport {
+    pthread_mutex_lock(&YGActiveTransportLock);
+    YGActiveTransport = activeTransport;
+    pthread_mutex_unlock(&YGActiveTransportLock);
+}
+
+#pragma mark - Private Methods
+
+- (void)yg_addEntry:(YGRecordReplayEntry *)entry {
+    NSString *key = [entry key];
+    YG_NETWORKING_LOCK();
+    [self.entries addObject:entry];
+    NSMutableArray<YGRecordReplayEntry *> *entries = self.entriesByKey[key];
+    if (!entries) {
+        entries = [NSMutableArray array];
+        self.entriesByKey[key] = entries;
+    }
+    [entries addObject:entry];
+    YG_NETWORKING_UNLOCK();
+}
+
+/**
+ 按录制的顺序循环返回匹配的条目, 回放的请求数多于录制的请求数时可以反复回放同一个存档.
+ */
+- (YGRecordReplayEntry *)yg_nextEntryForKey:(NSString *)key {
+    YG_NETWORKING_LOCK();
+    NSArray<YGRecordReplayEntry *> *entries = self.entriesByKey[key];
+    YGRecordReplayEntry *entry = nil;
+    if (entries.count > 0) {
+        NSUInteger index = [self.replayIndexes[key] unsignedIntegerValue];
+        entry = entries[index % entries.count];
+        self.replayIndexes[key] = @(index + 1);
+    }
+    YG_NETWORKING_UNLOCK();
+    return entry;
+}
+
+@end
@@ -11,7 +11,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class YGUploadFormData;
+@class YGUploadFormData, YGRequestMetrics;
 
 /**
  `YGRequest` 是被 `YGCenter` 调用的所有网络请求的基础类.
@@ -45,12 +45,18 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, copy, nullable) NSString *url;
 
 /**
- 请求参数， 如果 `useGeneralParameters` 属性为 `YES` (默认为 YES)，YGCenter 中的 `generalParameters` 将会追加到 `parameters` 里.
+ `url` 解析后的 NSURL，由 YGCenter 通过 `server` 和 `api` 拼接 `url` 时一并生成，YGEngine 直接使用它创建请求，不再重新解析 `url`.
+ NOTE: 设置 `url` 时会被重置为 `nil`，此时 YGEngine 会解析 `url`.
+ */
+@property (nonatomic, strong, readonly, nullable) NSURL *resolvedURL;
+
+/**
+ 请求参数， 如果 `useGeneralParameters` 属性为 `YES` (默认为 YES)，YGCenter 中的 `generalParameters` 将会在序列化时和 `parameters` 合并 (`mergedParameters`).
  */
 @property (nonatomic, strong, nullable) NSDictionary<NSString *, id> *parameters;
 
 /**
- 请求头，如果 `useGeneralHeaders` 属性为 `YES` (默认为 YES)，YGCenter 中的 `generalHeaders` 将会追加道 `headers` 里.
+ 请求头，如果 `useGeneralHeaders` 属性为 `YES` (默认为 YES)，YGCenter 中的 `generalHeaders` 将会在序列化时和 `headers` 合并 (`mergedHeaders`).
  */
 @property (nonatomic, strong, nullable) NSDictionary<NSString *, NSString *> *headers;
 
@@ -64,6 +70,28 @@ NS_ASSUME_NONNULL_BEGIN
 /// 是否把 YGCenter 中的 `generalParameters` 追加到请求的 `parameters` 里，默认为 `YES`.
 @property (nonatomic, assign) BOOL useGeneralParameters;
 
+/**
+ 请求处理时 YGCenter 通用参数的快照，`useGeneralParameters` 为 `NO` 时为 `nil`.
+ NOTE: 快照是不可变的，由所有请求共享，序列化时才和 `parameters` 合并.
+ */
+@property (nonatomic, copy, readonly, nullable) NSDictionary<NSString *, id> *generalParameters;
+
+/**
+ 请求处理时 YGCenter 通用头的快照，`useGeneralHeaders` 为 `NO` 时为 `nil`.
+ */
+@property (nonatomic, copy, readonly, nullable) NSDictionary<NSString *, NSString *> *generalHeaders;
+
+/**
+ 合并后的请求参数，`parameters` 中的值会覆盖 `generalParameters` 中相同 key 的值.
+ NOTE: 任意一方为空时直接返回另一方，不会创建新的字典.
+ */
+@property (nonatomic, copy, readonly, nullable) NSDictionary<NSString *, id> *mergedParameters;
+
+/**
+ 合并后的请求头，`headers` 中的值会覆盖 `generalHeaders` 中相同 field 的值.
+ */
+@property (nonatomic, copy, readonly, nullable) NSDictionary<NSString *, NSString *> *mergedHeaders;
+
 /**
  请求类型: Normal, Upload 或 Download, 默认为 `kYGRequestNormal`.
  */
@@ -79,11 +107,28 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, assign) YGRequestSerializerType requestSerializerType;
 
+/**
+ 请求体压缩类型，默认为 YGCenter 的 `requestCompressionType`，具体查看 `YGRequestCompressionType` 枚举.
+ NOTE: 只压缩序列化后长度不小于 `requestCompressionThreshold` 的请求体，压缩在 YGEngine 的私有队列中执行，压缩后更长时发送原始数据.
+ 这个属性只对 `requestType` 为 `kYGRequestNormal` 的请求有效果，服务器需要支持解压对应的 `Content-Encoding`.
+ */
+@property (nonatomic, assign) YGRequestCompressionType requestCompressionType;
+
+/**
+ 请求体压缩的最小长度(字节)，默认为 YGCenter 的 `requestCompressionThreshold`.
+ */
+@property (nonatomic, assign) NSUInteger requestCompressionThreshold;
+
 /**
  请求响应体序列化类型，默认为 `kYGResponseSerializerJSON`，具体查看 `YGResponseSerializerType` 枚举.
  */
 @property (nonatomic, assign) YGResponseSerializerType responseSerializerType;
 
+/**
+ 请求优先级，默认为 `kYGRequestPriorityNormal`，具体查看 `YGRequestPriority` 枚举.
+ */
+@property (nonatomic, assign) YGRequestPriority priority;
+
 /**
  请求超时时间，默认为 `60` 秒.
  */
@@ -91,14 +136,126 @@ NS_ASSUME_NONNULL_BEGIN
 
 /**
  当错误发生时的重试次数，默认为 `0`.
+ NOTE: 是否重试以及重试的间隔由 YGCenter 的 `retryPolicy` 和 `retryBudget` 决定.
  */
 @property (nonatomic, assign) NSUInteger retryCount;
 
+/**
+ 请求已经重试的次数.
+ */
+@property (nonatomic, assign, readonly) NSUInteger retriedCount;
+
+/**
+ 是否与正在运行的相同请求 (HTTP 方法、URL、请求头和响应体序列化类型都相同) 合并，合并后共享同一个网络任务和同一个解析后的响应对象.
+ 默认为 YGCenter 的 `coalescingEnabled`.
+ NOTE: 这个属性只对 `requestType` 为 `kYGRequestNormal` 且 HTTP 方法为 GET/HEAD 的请求有效果.
+ */
+@property (nonatomic, assign) BOOL coalescingEnabled;
+
+/**
+ 是否开启对冲请求，默认为 `NO`. 开启后请求在 YGEngine `hedgingPolicy` 的对冲延迟内没有完成时，再发送一个相同的请求，
+ 使用先完成的响应并取消另一个，避免一个卡住的连接让请求等待到 `timeoutInterval`.
+ NOTE: 这个属性只对 `requestType` 为 `kYGRequestNormal` 且 HTTP 方法为 GET/HEAD 的请求有效果，
+ 与 `coalescingEnabled` 或 `responseStreamingEnabled` 同时开启时不会对冲.
+ */
+@property (nonatomic, assign) BOOL hedgingEnabled;
+
+/**
+ 是否在接收响应数据的同时增量解析 JSON 响应体，默认为 `NO`.
+ 开启后顶层数组元素 (或字典键值对) 在到达时就被解析并释放原始数据，响应结束时只需解析剩余的尾部，适用于数据量较大的列表响应.
+ NOTE: 这个属性只对 `requestType` 为 `kYGRequestNormal` 且 `responseSerializerType` 为 `kYGResponseSerializerJSON` 的请求有效果.
+ */
+@property (nonatomic, assign) BOOL responseStreamingEnabled;
+
+/**
+ 增量解析时需要逐个解析元素的嵌套容器在根字典中的路径，默认为 `nil`，只逐个解析根对象的元素.
+ 响应把列表包在字典中时 (eg. `{"code": 0, "data": [...]}`) 设置为 `data`，多级路径用 `.` 分隔，具体查看 `YGJSONStreamParser`.
+ NOTE: 这个属性只在开启 `responseStreamingEnabled` 时有效果.
+ */
+@property (nonatomic, copy, nullable) NSString *responseStreamingKeyPath;
+
+/**
+ 响应对象映射的模型类，默认为 `nil`. 设置后经过 YGCenter 响应处理的字典会被映射为该类的实例，数组会被映射为该类实例的数组，
+ 成功回调中收到的是映射后的模型对象，具体查看 `YGModelMapper`.
+ NOTE: 映射在 YGEngine 的解码队列中执行，缓存中保存的仍然是映射前的对象.
+ */
+@property (nonatomic, strong, nullable) Class responseModelClass;
+
+/**
+ 请求的缓存策略，默认为 `kYGRequestCachePolicyNetworkOnly`，具体查看 `YGRequestCachePolicy` 枚举.
+ NOTE: 这个属性只在 `requestType` 为 `kYGRequestNormal` 时有效果.
+ */
+@property (nonatomic, assign) YGRequestCachePolicy cachePolicy;
+
+/**
+ 缓存的有效时间，默认为 `300` 秒.
+ */
+@property (nonatomic, assign) NSTimeInterval cacheTimeInterval;
+
+/**
+ 参与生成缓存 key 的请求头名称 (不区分大小写)，类似 HTTP 的 `Vary` 响应头，默认为 `nil`，表示使用 `Accept` 和 `Accept-Language`.
+ 响应内容随其他请求头变化时在这里列出，这些请求头不同的请求不会互相命中缓存.
+ */
+@property (nonatomic, copy, nullable) NSArray<NSString *> *cacheVaryHeaders;
+
+/**
+ 是否读写带有身份信息 (`Authorization` 或 `Cookie` 请求头) 的请求的缓存，默认为 `NO`，这类请求不读写缓存.
+ 开启后身份信息的摘要参与生成缓存 key，不同身份的响应不会互相命中缓存.
+ NOTE: 由 NSURLSession 从 `NSHTTPCookieStorage` 附加的 Cookie 不在请求头中，不参与判断.
+ */
+@property (nonatomic, assign) BOOL cachesAuthorizedResponse;
+
+/**
+ 请求的缓存 key，当请求发送时被 YGCenter 根据 HTTP 方法、`url`、`parameters` 和 `cacheVaryHeaders` 中的请求头生成.
+ 带有身份信息且没有开启 `cachesAuthorizedResponse` 的请求为 `nil`.
+ */
+@property (nonatomic, copy, readonly, nullable) NSString *cacheKey;
+
+/**
+ 当前回调的响应数据是否来自缓存，在成功回调中读取.
+ */
+@property (nonatomic, assign, readonly) BOOL responseFromCache;
+
+/**
+ 请求在 YGNetworking 内部和网络协议各阶段的耗时，请求创建时被 YGCenter 创建，每次发送时被 YGEngine 重新创建，
+ 在回调 (包括 `finishedBlock`) 中读取，具体查看 `YGRequestMetrics`.
+ */
+@property (nonatomic, strong, readonly, nullable) YGRequestMetrics *metrics;
+
 /**
  当前请求的用户信息，可以用来区分具有相同上下文的请求，如果为 `nil` (默认为 nil)，将使用 YGCenter 中的 `generalUserInfo`.
  */
 @property (nonatomic, strong, nullable) NSDictionary *userInfo;
 
+/**
+ 请求所在的分组，通过 `-[YGCenter cancelRequestsInGroup:]` 一次取消分组中所有正在运行的请求，默认为 `nil`.
+ */
+@property (nonatomic, copy, nullable) NSString *group;
+
+/**
+ 请求的所有者，所有者释放时 YGCenter 自动取消请求，例如设置为发起请求的页面，默认为 `nil`.
+ NOTE: 弱引用，不会延长所有者的生命周期.
+ */
+@property (nonatomic, weak, nullable) id owner;
+
+/**
+ 是否为持久请求，默认为 `NO`. 开启后，网络不可用时发送或者因为网络错误 (断网、连接失败、超时等) 失败的请求会进入 YGCenter 的
+ `offlineQueue`，在网络恢复后按顺序重放，回调在重放结束后才被调用. 主机熔断 (`kYGErrorCircuitOpen`) 的请求同样进入队列，
+ 经过熔断器的冷却时间后重放.
+ NOTE: 只有 `requestType` 为 `kYGRequestNormal`，并且 HTTP 方法是幂等的 (GET/HEAD/PUT/DELETE) 或者设置了 `idempotencyKey` 的请求会进入队列.
+ */
+@property (nonatomic, assign) BOOL durable;
+
+/**
+ 请求的幂等键，设置后通过 `Idempotency-Key` 请求头发送，服务器据此识别重放的重复请求，默认为 `nil`.
+ */
+@property (nonatomic, copy, nullable) NSString *idempotencyKey;
+
+/**
+ 请求在 YGCenter 的 `offlineQueue` 中的标识，请求不在离线队列中时为 `nil`.
+ */
+@property (nonatomic, copy, readonly, nullable) NSString *offlineEntryIdentifier;
+
 /**
  请求成功的回调，当请求成功完成时调用，block 将在 YGCenter 设置的 `callbackQueue` 中被执行.
  */
@@ -131,12 +288,51 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, strong, nullable) NSMutableArray<YGUploadFormData *> *uploadFormDatas;
 
+/**
+ 以原始文件作为请求体上传的文件 URL，默认为 `nil`. 设置后不再构造 multipart 表单，`uploadFormDatas` 和 `parameters` 会被忽略，
+ 文件由 NSURLSession 流式读取，内存占用与文件大小无关. 请求使用 `httpMethod` 发送，没有设置 `Content-Type` 时为 `application/octet-stream`.
+ NOTE: 这个属性只在 `requestType` 为 `kYGRequestUpload` 时有效果.
+ */
+@property (nonatomic, strong, nullable) NSURL *uploadFileURL;
+
+/**
+ 是否使用可续传的分块上传协议 (tus 1.0) 上传 `uploadFileURL`，默认为 `NO`.
+ 开启后先向 `url` POST 创建上传，再按 `uploadChunkSize` 分块 PATCH 到服务器返回的上传地址. 上传地址会被持久化，
+ 失败或应用重启后重新发送相同的请求时，通过 HEAD 协商服务器已接收的偏移量后继续上传.
+ 成功回调中的响应对象为最后一个 PATCH 请求的响应按 `responseSerializerType` 解析的结果，上传地址通过 `resumableUploadURL` 获取.
+ NOTE: 上传在之前已经全部被服务器接收时 (HEAD 返回的偏移量等于文件长度)，没有最后一个 PATCH 请求，响应对象为 `nil`.
+ */
+@property (nonatomic, assign) BOOL resumableUploadEnabled;
+
+/**
+ 可续传上传的上传地址，服务器创建上传或者协商偏移量后被 YGEngine 设置.
+ */
+@property (nonatomic, strong, readonly, nullable) NSURL *resumableUploadURL;
+
+/**
+ 可续传上传每块的长度(字节)，默认为 `5MB`.
+ */
+@property (nonatomic, assign) NSUInteger uploadChunkSize;
+
 /**
  下载文件的本地保存路径，默认为 `nil`.
  NOTE: 这个属性只在 `requestType` 为 `kYGRequestDownload` 时有效果.
  */
 @property (nonatomic, copy, nullable) NSString *downloadSavePath;
 
+/**
+ 分段下载的分段个数，默认为 `1` (不分段).
+ 大于 `1` 时先发送 HEAD 请求探测文件长度，服务器支持 Range 时将文件分成多个字节范围同时下载，并写入预分配文件的对应位置，
+ `progressBlock` 回调合并后的总进度. 服务器不支持 Range 或文件太小时退化为单个连接下载.
+ NOTE: 这个属性只在 `requestType` 为 `kYGRequestDownload` 时有效果，分段下载不使用 YGEngine 的断点存储.
+ */
+@property (nonatomic, assign) NSUInteger downloadSegmentCount;
+
+/**
+ 分段下载中每个分段失败后单独重试的次数，默认为 `3`.
+ */
+@property (nonatomic, assign) NSUInteger downloadSegmentRetryCount;
+
 ///----------------------------------------------------
 /// @name 添加上传文件表单数据的便捷方法
 ///----------------------------------------------------
@@ -160,8 +356,39 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, strong, readonly) NSMutableArray *requestArray;
 @property (nonatomic, strong, readonly) NSMutableArray *responseArray;
 
+/**
+ 批量请求所在的分组和所有者，作用同 YGRequest 的 `group` 和 `owner`，取消时取消整个批量请求.
+ */
+@property (nonatomic, copy, nullable) NSString *group;
+@property (nonatomic, weak, nullable) id owner;
+
+/**
+ 同时运行的最大请求数，`0` 表示同时发送所有请求，默认为 `0`.
+ NOTE: 大于 `0` 时 YGCenter 先发送前 `maxConcurrent` 个请求，每结束一个再发送下一个 (滑动窗口)，避免大量请求同时进入 YGEngine.
+ */
+@property (nonatomic, assign) NSUInteger maxConcurrent;
+
+/**
+ 记录 `requestArray` 中指定位置的请求的结果，所有请求都结束时调用批量请求的回调并返回 `YES`.
+ */
+- (BOOL)onFinishedRequestAtIndex:(NSUInteger)index response:(nullable id)responseObject error:(nullable NSError *)error;
+
+/**
+ NOTE: 需要在 `requestArray` 中查找请求的位置，已知位置时使用 `-onFinishedRequestAtIndex:response:error:`.
+ */
 - (BOOL)onFinishedOneRequest:(YGRequest *)request response:(nullable id)responseObject error:(nullable NSError *)error;
 
+/**
+ 返回下一个待发送请求的位置，所有请求都已经发送或批量请求已经取消时返回 `NSNotFound`.
+ */
+- (NSUInteger)nextPendingRequestIndex;
+
+/**
+ 取消还未发送的请求，返回它们在 `requestArray` 中的范围，之后 `-nextPendingRequestIndex` 返回 `NSNotFound`.
+ NOTE: 调用者需要通过 `-onFinishedRequestAtIndex:response:error:` 结束这些请求，批量请求的回调才会被调用.
+ */
+- (NSRange)cancelPendingRequests;
+
 @end
 
 #pragma mark - YGChainRequest
@@ -175,6 +402,12 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, copy, readonly) NSString *identifier;
 @property (nonatomic, strong, readonly) YGRequest *runningRequest;
 
+/**
+ 链式请求所在的分组和所有者，作用同 YGRequest 的 `group` 和 `owner`，取消时取消整个链式请求.
+ */
+@property (nonatomic, copy, nullable) NSString *group;
+@property (nonatomic, weak, nullable) id owner;
+
 - (YGChainRequest *)onFirst:(YGRequestConfigBlock)firstBlock;
 - (YGChainRequest *)onNext:(YGBCNextBlock)nextBlock;
 
@@ -182,6 +415,112 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+#pragma mark - YGGraphRequest
+
+///------------------------------------------------------
+/// @name YGGraphNode 是图请求中的节点
+///------------------------------------------------------
+
+@interface YGGraphNode : NSObject
+
+/**
+ 节点的名字，在图中唯一，也是回调中结果的 key.
+ */
+@property (nonatomic, copy, readonly) NSString *name;
+
+/**
+ 节点依赖的节点的名字.
+ */
+@property (nonatomic, copy, readonly) NSArray<NSString *> *dependencies;
+
+/**
+ 节点请求失败时的处理策略，默认为 `kYGGraphNodeFailureFailFast`.
+ */
+@property (nonatomic, assign) YGGraphNodeFailurePolicy failurePolicy;
+
+/**
+ 失败策略为 `kYGGraphNodeFailureFallback` 时使用的结果，为 `nil` 时使用 `NSNull`.
+ */
+@property (nonatomic, strong, nullable) id fallbackResponseObject;
+
+/**
+ 节点的请求，节点开始运行时创建.
+ */
+@property (nonatomic, strong, readonly, nullable) YGRequest *request;
+
+@end
+
+///------------------------------------------------------
+/// @name YGGraphRequest 是按依赖关系运行请求的类
+///------------------------------------------------------
+
+/**
+ `YGGraphRequest` 中的节点声明依赖的节点，没有依赖关系的节点同时运行，节点在依赖的节点都成功后开始运行，并通过配置 block 获得它们的结果.
+ 批量请求相当于没有依赖的图，链式请求相当于每个节点依赖前一个节点的图.
+ 
+ NOTE: 同时可以运行的节点按添加的顺序开始运行; 依赖不存在或形成环时 `YGCenter` 不会发送图请求.
+ */
+@interface YGGraphRequest : NSObject
+
+@property (nonatomic, copy, readonly) NSString *identifier;
+
+/**
+ 图请求所在的分组和所有者，作用同 YGRequest 的 `group` 和 `owner`，取消时取消整个图请求.
+ */
+@property (nonatomic, copy, nullable) NSString *group;
+@property (nonatomic, weak, nullable) id owner;
+
+/**
+ 同时运行的最大节点数，`0` 表示不限制，默认为 `0`.
+ */
+@property (nonatomic, assign) NSUInteger maxConcurrent;
+
+/**
+ 按添加顺序排列的节点.
+ */
+@property (nonatomic, copy, readonly) NSArray<YGGraphNode *> *nodes;
+
+/**
+ 添加一个节点，返回的节点可以继续设置失败策略.
+
+ @param name 节点的名字，不能和已有的节点重复.
+ @param dependencies 依赖的节点的名字.
+ @param configBlock 依赖的节点都结束后配置节点的请求.
+ @return 添加的节点.
+ */
+- (YGGraphNode *)addNode:(NSString *)name
+            dependencies:(nullable NSArray<NSString *> *)dependencies
+                  config:(YGGraphNodeConfigBlock)configBlock;
+
+/**
+ 检查依赖关系，依赖不存在或形成环时返回 `NO`.
+ */
+- (BOOL)validateDependencies;
+
+/**
+ 返回可以开始运行的节点并创建它们的请求，受 `maxConcurrent` 限制; 图请求已经结束或取消时返回空数组.
+ NOTE: 节点的配置 block 在调用者的线程中执行.
+ */
+- (NSArray<YGGraphNode *> *)dequeueReadyNodes;
+
+/**
+ 记录节点的结果并按失败策略处理，所有节点都结束时调用图请求的回调并返回 `YES`.
+ */
+- (BOOL)onFinishedNode:(YGGraphNode *)node response:(nullable id)responseObject error:(nullable NSError *)error;
+
+/**
+ 取消图请求，还未运行的节点以 `NSURLErrorCancelled` 错误结束，没有正在运行的节点时调用图请求的回调并返回 `YES`.
+ NOTE: 调用者需要取消 `runningRequests` 中的请求.
+ */
+- (BOOL)cancel;
+
+/**
+ 正在运行的节点的请求.
+ */
+@property (nonatomic, copy, readonly) NSArray<YGRequest *> *runningRequests;
+
+@end
+
 #pragma mark - YGUploadFormData
 
 /**
@@ -10,6 +10,15 @@
 
 //#define YGMEMORYLOG
 
+static NSDictionary * YGMergeDictionaries(NSDictionary *generalDictionary, NSDictionary *dictionary) {
+    if (generalDictionary.count == 0) return dictionary;
+    if (dictionary.count == 0) return generalDictionary;
+    
+    NSMutableDictionary *mergedDictionary = [generalDictionary mutableCopy];
+    [mergedDictionary addEntriesFromDictionary:dictionary];
+    return mergedDictionary;
+}
+
 @interface YGRequest ()
 
 @end
@@ -30,7 +39,10 @@
     _requestType = kYGRequestNormal;
     _httpMethod = kYGHTTPMethodPOST;
     _requestSerializerType = kYGRequestSerializerRAW;
+    _requestCompressionType = kYGRequestCompressionNone;
+    _requestCompressionThreshold = 1024;
     _responseSerializerType = kYGResponseSerializerJSON;
+    _priority = kYGRequestPriorityNormal;
     _timeoutInterval = 60.0;
     
     _useGeneralServer = YES;
@@ -38,6 +50,20 @@
     _useGeneralParameters = YES;
     
     _retryCount = 0;
+    _retriedCount = 0;
+    _coalescingEnabled = NO;
+    _hedgingEnabled = NO;
+    _responseStreamingEnabled = NO;
+    _durable = NO;
+    
+    _cachePolicy = kYGRequestCachePolicyNetworkOnly;
+    _cacheTimeInterval = 300.0;
+    
+    _resumableUploadEnabled = NO;
+    _uploadChunkSize = 5 * 1024 * 1024;
+    
+    _downloadSegmentCount = 1;
+    _downloadSegmentRetryCount = 3;
     
 #ifdef YGMEMORYLOG
     NSLog(@"%@: %s", self, __FUNCTION__);
@@ -46,6 +72,20 @@
     return self;
 }
 
+- (void)setUrl:(NSString *)url {
+    _url = [url copy];
+    // the resolved URL belongs to the previous url.
+    _resolvedURL = nil;
+}
+
+- (NSDictionary<NSString *, id> *)mergedParameters {
+    return YGMergeDictionaries(self.generalParameters, self.parameters);
+}
+
+- (NSDictionary<NSString *, NSString *> *)mergedHeaders {
+    return YGMergeDictionaries(self.generalHeaders, self.headers);
+}
+
 - (void)cleanCallbackBlocks {
     _successBlock = nil;
     _failureBlock = nil;
@@ -91,8 +131,9 @@
 #pragma mark - YGBatchRequest
 
 @interface YGBatchRequest () {
-    dispatch_semaphore_t _lock;
+    pthread_mutex_t _lock;
     NSUInteger _finishedCount;
+    NSUInteger _nextPendingIndex;
     BOOL _failed;
 }
 
@@ -112,7 +153,7 @@
     
     _failed = NO;
     _finishedCount = 0;
-    _lock = dispatch_semaphore_create(1);
+    YG_NETWORKING_LOCK_INIT();
 
     _requestArray = [NSMutableArray array];
     _responseArray = [NSMutableArray array];
@@ -125,9 +166,17 @@
 }
 
 - (BOOL)onFinishedOneRequest:(YGRequest *)request response:(id)responseObject error:(NSError *)error {
+    NSUInteger index = [_requestArray indexOfObjectIdenticalTo:request];
+    if (index == NSNotFound) return NO;
+    
+    return [self onFinishedRequestAtIndex:index response:responseObject error:error];
+}
+
+- (BOOL)onFinishedRequestAtIndex:(NSUInteger)index response:(id)responseObject error:(NSError *)error {
+    if (index >= _requestArray.count) return NO;
+    
     BOOL isFinished = NO;
     YG_NETWORKING_LOCK();
-    NSUInteger index = [_requestArray indexOfObject:request];
     if (responseObject) {
         [_responseArray replaceObjectAtIndex:index withObject:responseObject];
     } else {
@@ -153,17 +202,37 @@
     return isFinished;
 }
 
+- (NSUInteger)nextPendingRequestIndex {
+    NSUInteger index = NSNotFound;
+    YG_NETWORKING_LOCK();
+    if (_nextPendingIndex < _requestArray.count) {
+        index = _nextPendingIndex++;
+    }
+    YG_NETWORKING_UNLOCK();
+    return index;
+}
+
+- (NSRange)cancelPendingRequests {
+    YG_NETWORKING_LOCK();
+    NSUInteger count = _requestArray.count;
+    NSRange range = NSMakeRange(MIN(_nextPendingIndex, count), count - MIN(_nextPendingIndex, count));
+    _nextPendingIndex = count;
+    YG_NETWORKING_UNLOCK();
+    return range;
+}
+
 - (void)cleanCallbackBlocks {
     _batchSuccessBlock = nil;
     _batchFailureBlock = nil;
     _batchFinishedBlock = nil;
 }
 
-#ifdef YGMEMORYLOG
 - (void)dealloc {
+    YG_NETWORKING_LOCK_DESTROY();
+#ifdef YGMEMORYLOG
     NSLog(@"%@: %s", self, __FUNCTION__);
-}
 #endif
+}
 
 @end
 
@@ -269,6 +338,351 @@
 
 @end
 
+#pragma mark - YGGraphRequest
+
+typedef NS_ENUM(NSInteger, YGGraphNodeState) {
+    YGGraphNodeStatePending,
+    YGGraphNodeStateRunning,
+    YGGraphNodeStateFinished,
+};
+
+@interface YGGraphNode ()
+
+@property (nonatomic, copy, readwrite) NSString *name;
+@property (nonatomic, copy, readwrite) NSArray<NSString *> *dependencies;
+@property (nonatomic, strong, readwrite) YGRequest *request;
+@property (nonatomic, copy) YGGraphNodeConfigBlock configBlock;
+
+/// 以下属性都需要在持有 YGGraphRequest `_lock` 的情况下访问.
+@property (nonatomic, assign) YGGraphNodeState state;
+@property (nonatomic, assign) NSUInteger remainingDependencyCount;
+@property (nonatomic, strong) NSMutableArray<NSString *> *dependentNames;
+
+@end
+
+@implementation YGGraphNode
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _failurePolicy = kYGGraphNodeFailureFailFast;
+    _state = YGGraphNodeStatePending;
+    _dependentNames = [NSMutableArray array];
+    
+    return self;
+}
+
+@end
+
+@interface YGGraphRequest () {
+    pthread_mutex_t _lock;
+    NSUInteger _runningCount;
+    NSUInteger _finishedCount;
+    BOOL _failed;
+    BOOL _cancelled;
+    BOOL _finished;
+}
+
+@property (nonatomic, strong) NSMutableArray<YGGraphNode *> *nodeArray;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, YGGraphNode *> *nodeMap;
+/// 节点依赖的节点都成功后加入，按加入的顺序开始运行.
+@property (nonatomic, strong) NSMutableArray<YGGraphNode *> *readyQueue;
+/// 已经结束的节点的结果，失败和被跳过的节点为 NSError.
+@property (nonatomic, strong) NSMutableDictionary<NSString *, id> *responseObjects;
+
+@property (nonatomic, copy) YGGraphSuccessBlock graphSuccessBlock;
+@property (nonatomic, copy) YGGraphFailureBlock graphFailureBlock;
+@property (nonatomic, copy) YGGraphFinishedBlock graphFinishedBlock;
+
+@end
+
+@implementation YGGraphRequest
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    YG_NETWORKING_LOCK_INIT();
+    _nodeArray = [NSMutableArray array];
+    _nodeMap = [NSMutableDictionary dictionary];
+    _readyQueue = [NSMutableArray array];
+    _responseObjects = [NSMutableDictionary dictionary];
+    
+#ifdef YGMEMORYLOG
+    NSLog(@"%@: %s", self, __FUNCTION__);
+#endif
+    
+    return self;
+}
+
+- (NSArray<YGGraphNode *> *)nodes {
+    return [_nodeArray copy];
+}
+
+- (YGGraphNode *)addNode:(NSString *)name
+            dependencies:(NSArray<NSString *> *)dependencies
+                  config:(YGGraphNodeConfigBlock)configBlock {
+    NSAssert(name.length > 0, @"The name of a graph node can't be empty.");
+    NSAssert(_nodeMap[name] == nil, @"The graph node `%@` already exists.", name);
+    NSAssert(configBlock != nil, @"The config block for graph node can't be nil.");
+    
+    YGGraphNode *node = [[YGGraphNode alloc] init];
+    node.name = name;
+    node.dependencies = [[NSOrderedSet orderedSetWithArray:dependencies ?: @[]] array];
+    node.configBlock = configBlock;
+    [_nodeArray addObject:node];
+    _nodeMap[name] = node;
+    return node;
+}
+
+- (BOOL)validateDependencies {
+    if (_nodeMap.count != _nodeArray.count) return NO;
+    
+    [_readyQueue removeAllObjects];
+    for (YGGraphNode *node in _nodeArray) {
+        [node.dependentNames removeAllObjects];
+    }
+    for (YGGraphNode *node in _nodeArray) {
+        node.remainingDependencyCount = node.dependencies.count;
+        for (NSString *dependency in node.dependencies) {
+            YGGraphNode *dependencyNode = _nodeMap[dependency];
+            if (!dependencyNode || dependencyNode == node) {
+                return NO;
+            }
+            [dependencyNode.dependentNames addObject:node.name];
+        }
+        if (node.remainingDependencyCount == 0) {
+            [_readyQueue addObject:node];
+        }
+    }
+    
+    // Kahn's algorithm, every node is visited only when the graph has no cycle.
+    NSMutableDictionary<NSString *, NSNumber *> *inDegrees = [NSMutableDictionary dictionaryWithCapacity:_nodeArray.count];
+    for (YGGraphNode *node in _nodeArray) {
+        inDegrees[node.name] = @(node.dependencies.count);
+    }
+    NSMutableArray<YGGraphNode *> *queue = [_readyQueue mutableCopy];
+    NSUInteger visitedCount = 0;
+    while (queue.count > 0) {
+        YGGraphNode *node = queue.firstObject;
+        [queue removeObjectAtIndex:0];
+        visitedCount++;
+        for (NSString *dependentName in node.dependentNames) {
+            NSUInteger inDegree = inDegrees[dependentName].unsignedIntegerValue - 1;
+            inDegrees[dependentName] = @(inDegree);
+            if (inDegree == 0) {
+                [queue addObject:_nodeMap[dependentName]];
+            }
+        }
+    }
+    return visitedCount == _nodeArray.count;
+}
+
+- (NSArray<YGGraphNode *> *)dequeueReadyNodes {
+    NSMutableArray<YGGraphNode *> *readyNodes = [NSMutableArray array];
+    NSMutableArray<NSDictionary *> *dependencyResponsesArray = [NSMutableArray array];
+    YG_NETWORKING_LOCK();
+    while (!_cancelled && !_finished && _readyQueue.count > 0 && (_maxConcurrent == 0 || _runningCount < _maxConcurrent)) {
+        YGGraphNode *node = _readyQueue.firstObject;
+        [_readyQueue removeObjectAtIndex:0];
+        node.state = YGGraphNodeStateRunning;
+        _runningCount++;
+        
+        NSMutableDictionary<NSString *, id> *dependencyResponses = [NSMutableDictionary dictionaryWithCapacity:node.dependencies.count];
+        for (NSString *dependency in node.dependencies) {
+            dependencyResponses[dependency] = _responseObjects[dependency];
+        }
+        [readyNodes addObject:node];
+        [dependencyResponsesArray addObject:dependencyResponses];
+    }
+    YG_NETWORKING_UNLOCK();
+    if (readyNodes.count == 0) return readyNodes;
+    
+    // the config blocks are user code, run them outside the lock.
+    NSMutableArray<YGRequest *> *requests = [NSMutableArray arrayWithCapacity:readyNodes.count];
+    [readyNodes enumerateObjectsUsingBlock:^(YGGraphNode *node, NSUInteger idx, BOOL *stop) {
+        YGRequest *request = [YGRequest request];
+        node.configBlock(request, dependencyResponsesArray[idx]);
+        [requests addObject:request];
+    }];
+    
+    NSMutableArray<YGGraphNode *> *startedNodes = [NSMutableArray arrayWithCapacity:readyNodes.count];
+    BOOL isFinished = NO;
+    YG_NETWORKING_LOCK();
+    [readyNodes enumerateObjectsUsingBlock:^(YGGraphNode *node, NSUInteger idx, BOOL *stop) {
+        if (self->_cancelled) {
+            // cancelled while configuring, the node is never sent.
+            [self yg_finishNode:node withError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]];
+            self->_runningCount--;
+        } else {
+            node.request = requests[idx];
+            [startedNodes addObject:node];
+        }
+    }];
+    isFinished = [self yg_markFinishedIfNeeded];
+    YG_NETWORKING_UNLOCK();
+    
+    if (isFinished) {
+        [self yg_executeCallbackBlocks];
+    }
+    return startedNodes;
+}
+
+- (BOOL)onFinishedNode:(YGGraphNode *)node response:(id)responseObject error:(NSError *)error {
+    YG_NETWORKING_LOCK();
+    if (node.state != YGGraphNodeStateRunning || _nodeMap[node.name] != node) {
+        YG_NETWORKING_UNLOCK();
+        return NO;
+    }
+    
+    _runningCount--;
+    if (!responseObject && !_cancelled && node.failurePolicy == kYGGraphNodeFailureFallback) {
+        responseObject = node.fallbackResponseObject ?: [NSNull null];
+    }
+    if (responseObject) {
+        node.state = YGGraphNodeStateFinished;
+        _finishedCount++;
+        _responseObjects[node.name] = responseObject;
+        for (NSString *dependentName in node.dependentNames) {
+            YGGraphNode *dependentNode = _nodeMap[dependentName];
+            if (dependentNode.state == YGGraphNodeStatePending && --dependentNode.remainingDependencyCount == 0) {
+                [_readyQueue addObject:dependentNode];
+            }
+        }
+    } else {
+        [self yg_finishNode:node withError:error];
+        if (!_cancelled && node.failurePolicy == kYGGraphNodeFailureFailFast) {
+            [self yg_cancelPendingNodes];
+        } else {
+            [self yg_skipDependentsOfNode:node];
+        }
+    }
+    BOOL isFinished = [self yg_markFinishedIfNeeded];
+    YG_NETWORKING_UNLOCK();
+    
+    if (isFinished) {
+        [self yg_executeCallbackBlocks];
+    }
+    return isFinished;
+}
+
+- (BOOL)cancel {
+    YG_NETWORKING_LOCK();
+    BOOL isFinished = NO;
+    if (!_cancelled && !_finished) {
+        [self yg_cancelPendingNodes];
+        isFinished = [self yg_markFinishedIfNeeded];
+    }
+    YG_NETWORKING_UNLOCK();
+    
+    if (isFinished) {
+        [self yg_executeCallbackBlocks];
+    }
+    return isFinished;
+}
+
+- (NSArray<YGRequest *> *)runningRequests {
+    NSMutableArray<YGRequest *> *runningRequests = [NSMutableArray array];
+    YG_NETWORKING_LOCK();
+    for (YGGraphNode *node in _nodeArray) {
+        if (node.state == YGGraphNodeStateRunning && node.request) {
+            [runningRequests addObject:node.request];
+        }
+    }
+    YG_NETWORKING_UNLOCK();
+    return runningRequests;
+}
+
+- (void)cleanCallbackBlocks {
+    _graphSuccessBlock = nil;
+    _graphFailureBlock = nil;
+    _graphFinishedBlock = nil;
+}
+
+- (void)dealloc {
+    YG_NETWORKING_LOCK_DESTROY();
+#ifdef YGMEMORYLOG
+    NSLog(@"%@: %s", self, __FUNCTION__);
+#endif
+}
+
+#pragma mark - Private Methods
+
+/**
+ 以错误结束节点，需要在持有 `_lock` 的情况下调用.
+ */
+- (void)yg_finishNode:(YGGraphNode *)node withError:(NSError *)error {
+    node.state = YGGraphNodeStateFinished;
+    _finishedCount++;
+    _failed = YES;
+    _responseObjects[node.name] = error ?: [NSNull null];
+}
+
+/**
+ 以 `NSURLErrorCancelled` 错误结束所有还未运行的节点，需要在持有 `_lock` 的情况下调用.
+ */
+- (void)yg_cancelPendingNodes {
+    _cancelled = YES;
+    [_readyQueue removeAllObjects];
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil];
+    for (YGGraphNode *node in _nodeArray) {
+        if (node.state == YGGraphNodeStatePending) {
+            [self yg_finishNode:node withError:error];
+        }
+    }
+}
+
+/**
+ 以 `kYGErrorGraphDependencyFailed` 错误跳过所有直接和间接依赖节点的节点，需要在持有 `_lock` 的情况下调用.
+ */
+- (void)yg_skipDependentsOfNode:(YGGraphNode *)node {
+    NSMutableArray<YGGraphNode *> *stack = [NSMutableArray arrayWithObject:node];
+    while (stack.count > 0) {
+        YGGraphNode *failedNode = stack.lastObject;
+        [stack removeLastObject];
+        for (NSString *dependentName in failedNode.dependentNames) {
+            YGGraphNode *dependentNode = _nodeMap[dependentName];
+            if (dependentNode.state != YGGraphNodeStatePending) continue;
+            
+            NSString *description = [NSString stringWithFormat:@"The dependency `%@` of graph node `%@` failed.", failedNode.name, dependentName];
+            [self yg_finishNode:dependentNode withError:[NSError errorWithDomain:YGErrorDomain
+                                                                            code:kYGErrorGraphDependencyFailed
+                                                                        userInfo:@{NSLocalizedDescriptionKey: description}]];
+            [stack addObject:dependentNode];
+        }
+    }
+}
+
+/**
+ 所有节点都结束时标记图请求结束并返回 `YES`，只会返回一次，需要在持有 `_lock` 的情况下调用.
+ */
+- (BOOL)yg_markFinishedIfNeeded {
+    if (_finished || _finishedCount < _nodeArray.count) {
+        return NO;
+    }
+    _finished = YES;
+    return YES;
+}
+
+- (void)yg_executeCallbackBlocks {
+    NSDictionary<NSString *, id> *responseObjects = [_responseObjects copy];
+    if (!_failed) {
+        YG_NETWORKING_SAFE_BLOCK(_graphSuccessBlock, responseObjects);
+        YG_NETWORKING_SAFE_BLOCK(_graphFinishedBlock, responseObjects, nil);
+    } else {
+        YG_NETWORKING_SAFE_BLOCK(_graphFailureBlock, responseObjects);
+        YG_NETWORKING_SAFE_BLOCK(_graphFinishedBlock, nil, responseObjects);
+    }
+    [self cleanCallbackBlocks];
+}
+
+@end
+
 #pragma mark - YGUploadFormData
 
 @implementation YGUploadFormData
@@ -0,0 +1,135 @@
+//
+//  YGRequestMetrics.h
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `YGRequestMetrics` 记录一个 YGRequest 在 YGNetworking 内部各阶段和网络协议各阶段的耗时，由 YGCenter 在请求创建时创建，YGEngine 在请求发送时填充.
+ NOTE: 重试时会重新创建 (保留配置和预处理的耗时)，合并的请求共享同一个对象.
+ */
+@interface YGRequestMetrics : NSObject
+
+///---------------------------
+/// @name YGNetworking 的阶段
+///---------------------------
+
+/**
+ 执行 `sendRequest:` 配置 block 的耗时(秒)，批量请求和链式请求为 `0`.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval configDuration;
+
+/**
+ YGCenter 预处理请求 (通用参数、通用 header、url 拼接和 `requestProcessBlock`) 的耗时(秒).
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval processDuration;
+
+/**
+ 请求序列化为 `NSURLRequest` 的耗时(秒).
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval serializationDuration;
+
+/**
+ 任务在 YGEngine 的优先级队列中等待并发名额的时间(秒).
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval queueWaitDuration;
+
+/**
+ 响应数据在解码队列中等待的时间(秒).
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval decodeWaitDuration;
+
+/**
+ 响应数据解码的耗时(秒)，流式解析的请求只包括解析尾部数据的耗时.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval decodeDuration;
+
+/**
+ 响应对象映射为 `responseModelClass` 实例的耗时(秒)，没有设置 `responseModelClass` 时为 `0`.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval mappingDuration;
+
+/**
+ 回调从派发到 `callbackQueue` 至开始执行的时间(秒)，没有设置 `callbackQueue` 时为 `0`.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval callbackDispatchDuration;
+
+/**
+ 请求体压缩的耗时(秒)，请求体没有被压缩时为 `0`.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval compressionDuration;
+
+/**
+ 序列化后请求体的原始长度(字节)，只在请求体参与压缩时记录.
+ */
+@property (nonatomic, assign, readonly) int64_t requestBodyLength;
+
+/**
+ 压缩后实际发送的请求体长度(字节)，请求体没有被压缩时为 `0`.
+ */
+@property (nonatomic, assign, readonly) int64_t compressedRequestBodyLength;
+
+/**
+ 请求体压缩节省的字节数，请求体没有被压缩时为 `0`.
+ */
+@property (nonatomic, assign, readonly) int64_t compressionSavedByteCount;
+
+/**
+ 是否发送了对冲请求，请求没有开启 `hedgingEnabled` 或者在对冲延迟内完成时为 `NO`.
+ */
+@property (nonatomic, assign, readonly) BOOL hedged;
+
+/**
+ 响应是否来自对冲请求，为 `YES` 时 `taskMetrics` 也来自对冲请求.
+ */
+@property (nonatomic, assign, readonly) BOOL hedgeWon;
+
+///---------------------------
+/// @name 网络协议的阶段
+///---------------------------
+
+/**
+ 系统收集的任务耗时，iOS 10 以下、请求命中缓存或者没有创建任务时为 `nil`.
+ NOTE: 分段下载和可续传上传由多个任务组成，只记录最后完成的任务.
+ */
+@property (nonatomic, strong, readonly, nullable) NSURLSessionTaskMetrics *taskMetrics API_AVAILABLE(ios(10.0));
+
+/**
+ 以下耗时(秒)取自 `taskMetrics` 的最后一个 transaction (重定向之后的请求)，没有对应阶段时为 `0`.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval domainLookupDuration;     //!< DNS 解析.
+@property (nonatomic, assign, readonly) NSTimeInterval connectDuration;          //!< TCP 连接，包括 TLS 握手.
+@property (nonatomic, assign, readonly) NSTimeInterval secureConnectionDuration; //!< TLS 握手.
+@property (nonatomic, assign, readonly) NSTimeInterval requestDuration;          //!< 发送请求头和请求体.
+@property (nonatomic, assign, readonly) NSTimeInterval waitingDuration;          //!< 请求发送完成至收到第一个字节.
+@property (nonatomic, assign, readonly) NSTimeInterval responseDuration;         //!< 接收响应体.
+
+/**
+ 任务从创建到完成的总耗时(秒)，包括重定向.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval taskDuration;
+
+/**
+ 任务的重定向次数.
+ */
+@property (nonatomic, assign, readonly) NSUInteger redirectCount;
+
+/**
+ 最后一个 transaction 使用的协议，例如 `http/1.1`、`h2`，未知时为 `nil`.
+ */
+@property (nonatomic, copy, readonly, nullable) NSString *networkProtocolName;
+
+/**
+ 最后一个 transaction 是否复用了已有的连接.
+ */
+@property (nonatomic, assign, readonly, getter=isReusedConnection) BOOL reusedConnection;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,117 @@
+//
+//  YGRequestMetrics.m
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import "YGRequestMetrics.h"
+
+static NSTimeInterval YGIntervalBetweenDates(NSDate *startDate, NSDate *endDate) {
+    if (!startDate || !endDate) return 0;
+    return MAX([endDate timeIntervalSinceDate:startDate], 0);
+}
+
+@implementation YGRequestMetrics
+
+- (int64_t)compressionSavedByteCount {
+    return self.compressedRequestBodyLength > 0 ? self.requestBodyLength - self.compressedRequestBodyLength : 0;
+}
+
+#pragma mark - Task Metrics
+
+- (NSURLSessionTaskTransactionMetrics *)yg_lastTransactionMetrics API_AVAILABLE(ios(10.0)) {
+    return self.taskMetrics.transactionMetrics.lastObject;
+}
+
+- (NSTimeInterval)domainLookupDuration {
+    if (@available(iOS 10.0, *)) {
+        NSURLSessionTaskTransactionMetrics *metrics = [self yg_lastTransactionMetrics];
+        return YGIntervalBetweenDates(metrics.domainLookupStartDate, metrics.domainLookupEndDate);
+    }
+    return 0;
+}
+
+- (NSTimeInterval)connectDuration {
+    if (@available(iOS 10.0, *)) {
+        NSURLSessionTaskTransactionMetrics *metrics = [self yg_lastTransactionMetrics];
+        return YGIntervalBetweenDates(metrics.connectStartDate, metrics.connectEndDate);
+    }
+    return 0;
+}
+
+- (NSTimeInterval)secureConnectionDuration {
+    if (@available(iOS 10.0, *)) {
+        NSURLSessionTaskTransactionMetrics *metrics = [self yg_lastTransactionMetrics];
+        return YGIntervalBetweenDates(metrics.secureConnectionStartDate, metrics.secureConnectionEndDate);
+    }
+    return 0;
+}
+
+- (NSTimeInterval)requestDuration {
+    if (@available(iOS 10.0, *)) {
+        NSURLSessionTaskTransactionMetrics *metrics = [self yg_lastTransactionMetrics];
+        return YGIntervalBetweenDates(metrics.requestStartDate, metrics.requestEndDate);
+    }
+    return 0;
+}
+
+- (NSTimeInterval)waitingDuration {
+    if (@available(iOS 10.0, *)) {
+        NSURLSessionTaskTransactionMetrics *metrics = [self yg_lastTransactionMetrics];
+        return YGIntervalBetweenDates(metrics.requestEndDate, metrics.responseStartDate);
+    }
+    return 0;
+}
+
+- (NSTimeInterval)responseDuration {
+    if (@available(iOS 10.0, *)) {
+        NSURLSessionTaskTransactionMetrics *metrics = [self yg_lastTransactionMetrics];
+        return YGIntervalBetweenDates(metrics.responseStartDate, metrics.responseEndDate);
+    }
+    return 0;
+}
+
+- (NSTimeInterval)taskDuration {
+    if (@available(iOS 10.0, *)) {
+        return self.taskMetrics.taskInterval.duration;
+    }
+    return 0;
+}
+
+- (NSUInteger)redirectCount {
+    if (@available(iOS 10.0, *)) {
+        return self.taskMetrics.redirectCount;
+    }
+    return 0;
+}
+
+- (NSString *)networkProtocolName {
+    if (@available(iOS 10.0, *)) {
+        return [self yg_lastTransactionMetrics].networkProtocolName;
+    }
+    return nil;
+}
+
+- (BOOL)isReusedConnection {
+    if (@available(iOS 10.0, *)) {
+        return [self yg_lastTransactionMetrics].isReusedConnection;
+    }
+    return NO;
+}
+
+#pragma mark -
+
+- (NSString *)description {
+    NSMutableString *description = [NSMutableString stringWithFormat:@"<%@: %p> config: %.3fms, process: %.3fms, serialization: %.3fms, compression: %.3fms (saved %lld bytes), queue wait: %.3fms", NSStringFromClass([self class]), self, self.configDuration * 1000, self.processDuration * 1000, self.serializationDuration * 1000, self.compressionDuration * 1000, self.compressionSavedByteCount, self.queueWaitDuration * 1000];
+    if (@available(iOS 10.0, *)) {
+        if (self.taskMetrics) {
+            [description appendFormat:@", dns: %.3fms, connect: %.3fms, tls: %.3fms, request: %.3fms, waiting: %.3fms, response: %.3fms, task: %.3fms (%@, redirects: %lu, reused: %@)", self.domainLookupDuration * 1000, self.connectDuration * 1000, self.secureConnectionDuration * 1000, self.requestDuration * 1000, self.waitingDuration * 1000, self.responseDuration * 1000, self.taskDuration * 1000, self.networkProtocolName ?: @"unknown", (unsigned long)self.redirectCount, self.isReusedConnection ? @"YES" : @"NO"];
+        }
+    }
+    [description appendFormat:@", decode wait: %.3fms, decode: %.3fms, mapping: %.3fms, callback dispatch: %.3fms", self.decodeWaitDuration * 1000, self.decodeDuration * 1000, self.mappingDuration * 1000, self.callbackDispatchDuration * 1000];
+    return description;
+}
+
+@end
@@ -0,0 +1,105 @@
+//
+//  YGRetryPolicy.h
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class YGRequest;
+
+/**
+ `YGRetryPolicy` 协议决定一个失败的请求是否重试以及重试前等待的时间，YGCenter 在 `YGRequest.retryCount` 大于 `0` 时询问它.
+ */
+@protocol YGRetryPolicy <NSObject>
+
+/**
+ 返回请求第 `attempt` 次重试前需要等待的时间.
+
+ @param request 失败的 YGRequest 对象.
+ @param error 请求失败的错误.
+ @param attempt 即将进行的重试次数，从 `1` 开始.
+ @return 等待时间(秒)，返回负数表示不重试.
+ */
+- (NSTimeInterval)retryDelayForRequest:(YGRequest *)request error:(NSError *)error attempt:(NSUInteger)attempt;
+
+@end
+
+#pragma mark - YGExponentialBackoffRetryPolicy
+
+/**
+ `YGExponentialBackoffRetryPolicy` 是 YGCenter 默认的重试策略: 带 full jitter 的指数退避.
+ 
+ 第 n 次重试的等待时间在 `[0, min(maxDelay, baseDelay * 2^(n-1))]` 中随机选取，避免所有客户端在服务端故障时同步重试.
+ 只有超时、连接断开、5xx 和 429 错误会被重试，429/503 响应带有 `Retry-After` 头时按服务端要求的时间等待.
+ */
+@interface YGExponentialBackoffRetryPolicy : NSObject <YGRetryPolicy>
+
+/**
+ 创建并返回一个默认配置的 `YGExponentialBackoffRetryPolicy` 对象.
+ */
++ (instancetype)policy;
+
+/**
+ 第一次重试的退避上限，默认为 `0.5` 秒.
+ */
+@property (nonatomic, assign) NSTimeInterval baseDelay;
+
+/**
+ 退避时间的最大值，默认为 `30` 秒. `Retry-After` 超过此值时不再重试.
+ */
+@property (nonatomic, assign) NSTimeInterval maxDelay;
+
+/**
+ 判断错误是否可以重试，子类可以重写以扩展可重试的错误.
+
+ @param error 请求失败的错误.
+ @return 是否可以重试.
+ */
+- (BOOL)isRetryableError:(NSError *)error;
+
+@end
+
+#pragma mark - YGRetryBudget
+
+/**
+ `YGRetryBudget` 是 YGCenter 的重试预算，一个令牌桶: 每个发出的请求存入 `ratio` 个令牌，每次重试消耗一个令牌，
+ 令牌不足时不再重试，从而把重试请求限制在总请求量的 `ratio` 比例以内.
+ */
+@interface YGRetryBudget : NSObject
+
+/**
+ 创建并返回一个 `YGRetryBudget` 对象.
+
+ @param ratio 重试请求占总请求量的最大比例，eg. `0.1` 表示最多 10%.
+ @param maxTokens 令牌桶的容量，也是初始令牌数，决定允许的突发重试个数.
+ */
++ (instancetype)budgetWithRatio:(double)ratio maxTokens:(double)maxTokens;
+
+@property (nonatomic, assign, readonly) double ratio;
+@property (nonatomic, assign, readonly) double maxTokens;
+
+/**
+ 当前剩余的令牌数.
+ */
+@property (nonatomic, assign, readonly) double availableTokens;
+
+/**
+ 记录一个发出的请求，存入 `ratio` 个令牌.
+ */
+- (void)deposit;
+
+/**
+ 尝试为一次重试取出一个令牌.
+
+ @return 令牌足够时返回 `YES`.
+ */
+- (BOOL)tryWithdraw;
+
+@end
+
+NS_ASSUME_NONNULL_END
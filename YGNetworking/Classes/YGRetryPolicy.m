@@ -0,0 +1,175 @@
+//
+//  YGRetryPolicy.m
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import "YGRetryPolicy.h"
+#import "YGConst.h"
+
+#if __has_include(<AFNetworking/AFNetworking.h>)
+#import <AFNetworking/AFURLResponseSerialization.h>
+#else
+#import "AFURLResponseSerialization.h"
+#endif
+
+#pragma mark - YGExponentialBackoffRetryPolicy
+
+@implementation YGExponentialBackoffRetryPolicy
+
++ (instancetype)policy {
+    return [[[self class] alloc] init];
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _baseDelay = 0.5;
+    _maxDelay = 30.0;
+    
+    return self;
+}
+
+- (NSTimeInterval)retryDelayForRequest:(YGRequest *)request error:(NSError *)error attempt:(NSUInteger)attempt {
+    if (![self isRetryableError:error]) {
+        return -1;
+    }
+    
+    // honor the `Retry-After` header sent along with 429/503 responses.
+    NSTimeInterval retryAfter = [self yg_retryAfterIntervalForError:error];
+    if (retryAfter > 0) {
+        return retryAfter <= self.maxDelay ? retryAfter : -1;
+    }
+    
+    // full jitter: random between 0 and the capped exponential backoff.
+    double exponent = MIN((double)(MAX(attempt, 1) - 1), 32.0);
+    NSTimeInterval cap = MIN(self.maxDelay, self.baseDelay * pow(2.0, exponent));
+    return cap * ((double)arc4random() / UINT32_MAX);
+}
+
+- (BOOL)isRetryableError:(NSError *)error {
+    if ([error.domain isEqualToString:NSURLErrorDomain]) {
+        switch (error.code) {
+            case NSURLErrorTimedOut:
+            case NSURLErrorNetworkConnectionLost:
+            case NSURLErrorCannotConnectToHost:
+                return YES;
+            default:
+                break;
+        }
+    }
+    
+    NSInteger statusCode = [self yg_HTTPResponseForError:error].statusCode;
+    if (statusCode == 429) {
+        return YES;
+    }
+    // 501 Not Implemented and 505 HTTP Version Not Supported will never succeed on retry.
+    return statusCode >= 500 && statusCode <= 599 && statusCode != 501 && statusCode != 505;
+}
+
+#pragma mark - Private Methods
+
+- (NSHTTPURLResponse *)yg_HTTPResponseForError:(NSError *)error {
+    id response = error.userInfo[AFNetworkingOperationFailingURLResponseErrorKey];
+    return [response isKindOfClass:[NSHTTPURLResponse class]] ? response : nil;
+}
+
+- (NSTimeInterval)yg_retryAfterIntervalForError:(NSError *)error {
+    NSHTTPURLResponse *response = [self yg_HTTPResponseForError:error];
+    if (response.statusCode != 429 && response.statusCode != 503) {
+        return 0;
+    }
+    
+    NSString *retryAfter = response.allHeaderFields[@"Retry-After"];
+    if (![retryAfter isKindOfClass:[NSString class]] || retryAfter.length == 0) {
+        return 0;
+    }
+    
+    // Retry-After: <delay-seconds> | <HTTP-date>
+    NSScanner *scanner = [NSScanner scannerWithString:retryAfter];
+    double seconds = 0;
+    if ([scanner scanDouble:&seconds] && scanner.isAtEnd) {
+        return MAX(seconds, 0);
+    }
+    
+    static NSDateFormatter *dateFormatter = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        dateFormatter = [[NSDateFormatter alloc] init];
+        dateFormatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+        dateFormatter.timeZone = [NSTimeZone timeZoneWithAbbreviation:@"GMT"];
+        dateFormatter.dateFormat = @"EEE, dd MMM yyyy HH:mm:ss zzz";
+    });
+    NSDate *date = [dateFormatter dateFromString:retryAfter];
+    return date ? MAX([date timeIntervalSinceNow], 0) : 0;
+}
+
+@end
+
+#pragma mark - YGRetryBudget
+
+@interface YGRetryBudget () {
+    pthread_mutex_t _lock;
+    double _tokens;
+}
+
+@end
+
+@implementation YGRetryBudget
+
++ (instancetype)budgetWithRatio:(double)ratio maxTokens:(double)maxTokens {
+    YGRetryBudget *budget = [[YGRetryBudget alloc] init];
+    budget->_ratio = MAX(ratio, 0);
+    budget->_maxTokens = MAX(maxTokens, 1);
+    budget->_tokens = budget->_maxTokens;
+    return budget;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    YG_NETWORKING_LOCK_INIT();
+    _ratio = 0.1;
+    _maxTokens = 10;
+    _tokens = _maxTokens;
+    
+    return self;
+}
+
+- (void)dealloc {
+    YG_NETWORKING_LOCK_DESTROY();
+}
+
+- (double)availableTokens {
+    YG_NETWORKING_LOCK();
+    double tokens = _tokens;
+    YG_NETWORKING_UNLOCK();
+    return tokens;
+}
+
+- (void)deposit {
+    YG_NETWORKING_LOCK();
+    _tokens = MIN(_tokens + _ratio, _maxTokens);
+    YG_NETWORKING_UNLOCK();
+}
+
+- (BOOL)tryWithdraw {
+    BOOL succeed = NO;
+    YG_NETWORKING_LOCK();
+    if (_tokens >= 1) {
+        _tokens -= 1;
+        succeed = YES;
+    }
+    YG_NETWORKING_UNLOCK();
+    return succeed;
+}
+
+@end
@@ -0,0 +1,78 @@
+//
+//  YGUploadResumeStore.h
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `YGUploadResumeStore` 是 YGEngine 持有的可续传上传记录，按 `url` 和上传文件 (路径、长度和修改时间) 保存服务器创建的上传地址.
+ 
+ 上传进度由服务器记录，续传时通过 HEAD 请求上传地址协商已上传的偏移量，因此只需要持久化上传地址，应用重启后依然可以续传.
+ 上传文件被修改后会生成不同的 key，不会续传到旧的上传地址.
+ */
+@interface YGUploadResumeStore : NSObject
+
+///---------------------
+/// @name 初始化
+///---------------------
+
+/**
+ 创建并返回一个 `YGUploadResumeStore` 对象，目录位于 `Library/Caches/com.ygnetworking.upload.resume`.
+ */
++ (instancetype)store;
+
+/**
+ 创建并返回一个 `YGUploadResumeStore` 对象.
+
+ @param path 保存上传记录的目录路径.
+ */
++ (instancetype)storeWithPath:(NSString *)path;
+
+- (instancetype)initWithPath:(NSString *)path NS_DESIGNATED_INITIALIZER;
+
+/**
+ 保存上传记录的目录路径.
+ */
+@property (nonatomic, copy, readonly) NSString *path;
+
+///---------------------
+/// @name 读写
+///---------------------
+
+/**
+ 获取上传文件对应的上传地址.
+
+ @param url 创建上传的地址.
+ @param fileURL 上传文件的本地 URL.
+ @return 服务器创建的上传地址，不存在时返回 `nil`.
+ */
+- (nullable NSURL *)uploadURLForURL:(NSString *)url fileURL:(NSURL *)fileURL;
+
+/**
+ 保存上传文件对应的上传地址.
+
+ @param uploadURL 服务器创建的上传地址.
+ @param url 创建上传的地址.
+ @param fileURL 上传文件的本地 URL.
+ */
+- (void)setUploadURL:(NSURL *)uploadURL forURL:(NSString *)url fileURL:(NSURL *)fileURL;
+
+/**
+ 删除上传文件对应的上传地址，上传完成或服务器上的上传已经失效时调用.
+ */
+- (void)removeUploadURLForURL:(NSString *)url fileURL:(NSURL *)fileURL;
+
+/**
+ 删除所有上传记录.
+ */
+- (void)removeAllUploadURLs;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,118 @@
+//
+//  YGUploadResumeStore.m
+//  YGNetworking
+//
+//  Created by Sun on 2019/4/25.
+//  Copyright © 2019 YGNetworking. All rights reserved.
+//
+
+#import "YGUploadResumeStore.h"
+#import "YGConst.h"
+#import <CommonCrypto/CommonDigest.h>
+
+static NSString * YGUploadResumeFileNameForKey(NSString *key) {
+    const char *str = key.UTF8String;
+    unsigned char digest[CC_MD5_DIGEST_LENGTH];
+    CC_MD5(str, (CC_LONG)strlen(str), digest);
+    NSMutableString *fileName = [NSMutableString stringWithCapacity:CC_MD5_DIGEST_LENGTH * 2];
+    for (int i = 0; i < CC_MD5_DIGEST_LENGTH; i++) {
+        [fileName appendFormat:@"%02x", digest[i]];
+    }
+    return fileName;
+}
+
+@interface YGUploadResumeStore () {
+    pthread_mutex_t _lock;
+}
+
+@end
+
+@implementation YGUploadResumeStore
+
++ (instancetype)store {
+    return [[[self class] alloc] init];
+}
+
++ (instancetype)storeWithPath:(NSString *)path {
+    return [[[self class] alloc] initWithPath:path];
+}
+
+- (instancetype)init {
+    NSString *cachesPath = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES).firstObject;
+    return [self initWithPath:[cachesPath stringByAppendingPathComponent:@"com.ygnetworking.upload.resume"]];
+}
+
+- (instancetype)initWithPath:(NSString *)path {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _path = [path copy];
+    YG_NETWORKING_LOCK_INIT();
+    
+    [[NSFileManager defaultManager] createDirectoryAtPath:_path withIntermediateDirectories:YES attributes:nil error:nil];
+    
+    return self;
+}
+
+- (void)dealloc {
+    YG_NETWORKING_LOCK_DESTROY();
+}
+
+#pragma mark - Public Methods
+
+- (NSURL *)uploadURLForURL:(NSString *)url fileURL:(NSURL *)fileURL {
+    NSString *filePath = [self yg_filePathForURL:url fileURL:fileURL];
+    if (!filePath) return nil;
+    
+    YG_NETWORKING_LOCK();
+    NSString *uploadURLString = [NSString stringWithContentsOfFile:filePath encoding:NSUTF8StringEncoding error:nil];
+    YG_NETWORKING_UNLOCK();
+    
+    return uploadURLString.length > 0 ? [NSURL URLWithString:uploadURLString] : nil;
+}
+
+- (void)setUploadURL:(NSURL *)uploadURL forURL:(NSString *)url fileURL:(NSURL *)fileURL {
+    NSString *filePath = [self yg_filePathForURL:url fileURL:fileURL];
+    NSString *uploadURLString = uploadURL.absoluteString;
+    if (!filePath || uploadURLString.length == 0) return;
+    
+    YG_NETWORKING_LOCK();
+    [uploadURLString writeToFile:filePath atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    YG_NETWORKING_UNLOCK();
+}
+
+- (void)removeUploadURLForURL:(NSString *)url fileURL:(NSURL *)fileURL {
+    NSString *filePath = [self yg_filePathForURL:url fileURL:fileURL];
+    if (!filePath) return;
+    
+    YG_NETWORKING_LOCK();
+    [[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
+    YG_NETWORKING_UNLOCK();
+}
+
+- (void)removeAllUploadURLs {
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    YG_NETWORKING_LOCK();
+    [fileManager removeItemAtPath:self.path error:nil];
+    [fileManager createDirectoryAtPath:self.path withIntermediateDirectories:YES attributes:nil error:nil];
+    YG_NETWORKING_UNLOCK();
+}
+
+#pragma mark - Private Methods
+
+/**
+ 上传记录的文件路径, key 包含上传文件的长度和修改时间, 文件被修改后不会续传到旧的上传地址.
+ */
+- (NSString *)yg_filePathForURL:(NSString *)url fileURL:(NSURL *)fileURL {
+    if (url.length == 0 || !fileURL.isFileURL) return nil;
+    
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:fileURL.path error:nil];
+    if (!attributes) return nil;
+    
+    NSString *key = [NSString stringWithFormat:@"%@\n%@\n%llu\n%f", url, fileURL.path, attributes.fileSize, attributes.fileModificationDate.timeIntervalSince1970];
+    return [self.path stringByAppendingPathComponent:YGUploadResumeFileNameForKey(key)];
+}
+
+@end